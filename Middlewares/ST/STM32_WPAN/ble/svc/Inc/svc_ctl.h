@@ -100,7 +100,22 @@ typedef PACKED(struct) _evt_blecore_aci
 
   typedef SVCCTL_EvtAckStatus_t (*SVC_CTL_p_EvtHandler_t)(void *p_evt);
 
+  typedef struct
+  {
+    uint16_t Ecode;        /**< ACI event code routed */
+    uint16_t StartHandle;  /**< First attribute handle routed */
+    uint16_t EndHandle;    /**< Last attribute handle routed */
+    uint32_t Calls;        /**< Number of events given to the handler */
+    uint32_t Hits;         /**< Number of events acknowledged by the handler */
+  } SVCCTL_RouteStats_t;
+
   /* Exported constants --------------------------------------------------------*/
+  /**
+   * Handle range of a route matching any event of its event code, whatever its parameters
+   */
+#define SVCCTL_ROUTE_HANDLE_FIRST                      (0x0000)
+#define SVCCTL_ROUTE_HANDLE_LAST                       (0xFFFF)
+
   /* External variables --------------------------------------------------------*/
   /* Exported macros -----------------------------------------------------------*/
 
@@ -160,6 +175,39 @@ typedef PACKED(struct) _evt_blecore_aci
    */
 void SVCCTL_RegisterHandler( SVC_CTL_p_EvtHandler_t pfBLE_SVC_Event_Handler );
 
+  /**
+   * @brief  This API registers a handler for one ACI event code and a range of attribute handles. A routed event is
+   *         only given to the handlers registered for its event code, found with a lookup in a table sorted by event
+   *         code, so that the dispatch cost does not grow with the number of services. The handlers of an event code
+   *         are called in their registration order until one of them acknowledges the event. An event acknowledged
+   *         by none of them is then given to the handlers registered with the other APIs, except the service and
+   *         client handlers having routes: those only get the events routed to them, whatever the registration order.
+   *         The handle range applies to the events whose parameters start with the Connection_Handle followed by the
+   *         attribute handle (ACI_GATT_ATTRIBUTE_MODIFIED, ACI_GATT_READ_PERMIT_REQ, ACI_GATT_WRITE_PERMIT_REQ,
+   *         ACI_GATT_NOTIFICATION, ACI_GATT_INDICATION...). Any other event code shall be registered with the range
+   *         SVCCTL_ROUTE_HANDLE_FIRST..SVCCTL_ROUTE_HANDLE_LAST.
+   *         This handler is called in the TL_BLE_HCI_UserEvtProc() context
+   *
+   * @param  Ecode: ACI event code, as ACI_GATT_ATTRIBUTE_MODIFIED_VSEVT_CODE
+   * @param  StartHandle: First attribute handle of the range
+   * @param  EndHandle: Last attribute handle of the range
+   * @param  pfBLE_SVC_Event_Handler: Handler called for the events matching the route
+   * @retval 0 when registered, 1 when the table of BLE_CFG_ROUTE_MAX_NBR routes is full
+   */
+  uint8_t SVCCTL_RegisterRoute( uint16_t Ecode,
+                                uint16_t StartHandle,
+                                uint16_t EndHandle,
+                                SVC_CTL_p_EvtHandler_t pfBLE_SVC_Event_Handler );
+
+  /**
+   * @brief  This API reads the counters of a route
+   *
+   * @param  Index: Index of the route, routes being sorted by event code
+   * @param  p_Stats: Counters of the route
+   * @retval 0 when the route exists, 1 otherwise
+   */
+  uint8_t SVCCTL_GetRouteStats( uint8_t Index, SVCCTL_RouteStats_t *p_Stats );
+
   /**
    * @brief  This API is used to resume the User Event Flow that has been stopped in return of SVCCTL_UserEvtRx()
    *
@@ -26,6 +26,10 @@ typedef struct
 {
 #if (BLE_CFG_SVC_MAX_NBR_CB > 0)
 SVC_CTL_p_EvtHandler_t SVCCTL__SvcHandlerTab[BLE_CFG_SVC_MAX_NBR_CB];
+#if (BLE_CFG_ROUTE_MAX_NBR > 0)
+/* Set when the handler has routes, it then only gets the events routed to it */
+uint8_t SVCCTL__SvcHandlerRouted[BLE_CFG_SVC_MAX_NBR_CB];
+#endif
 #endif
 uint8_t NbreOfRegisteredHandler;
 } SVCCTL_EvtHandler_t;
@@ -34,6 +38,10 @@ typedef struct
 {
 #if (BLE_CFG_CLT_MAX_NBR_CB > 0)
 SVC_CTL_p_EvtHandler_t SVCCTL_CltHandlerTable[BLE_CFG_CLT_MAX_NBR_CB];
+#if (BLE_CFG_ROUTE_MAX_NBR > 0)
+/* Set when the handler has routes, it then only gets the events routed to it */
+uint8_t SVCCTL_CltHandlerRouted[BLE_CFG_CLT_MAX_NBR_CB];
+#endif
 #endif
 uint8_t NbreOfRegisteredHandler;
 } SVCCTL_CltHandler_t;
@@ -47,16 +55,45 @@ uint8_t NbreOfRegisteredHandler;
 } SVCCTL_Handler_t;
 
 /* Private defines -----------------------------------------------------------*/
+#ifndef BLE_CFG_ROUTE_MAX_NBR
+#define BLE_CFG_ROUTE_MAX_NBR  0
+#endif
+
+#if (BLE_CFG_ROUTE_MAX_NBR > 0)
+typedef struct
+{
+SVCCTL_RouteStats_t Stats;
+SVC_CTL_p_EvtHandler_t pfHandler;
+} SVCCTL_Route_t;
+
+typedef struct
+{
+/* Sorted by event code, in registration order for a same event code */
+SVCCTL_Route_t SVCCTL_RouteTable[BLE_CFG_ROUTE_MAX_NBR];
+uint8_t NbreOfRegisteredRoute;
+} SVCCTL_Router_t;
+#endif
+
 #define SVCCTL_EGID_EVT_MASK   0xFF00
 #define SVCCTL_GATT_EVT_TYPE   0x0C00
 
+/* Size of the event code, Connection_Handle and attribute handle of a routed event */
+#define SVCCTL_ROUTE_HANDLE_EVT_SIZE   6
+
 /* Private macros ------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 SVCCTL_EvtHandler_t SVCCTL_EvtHandler;
 SVCCTL_CltHandler_t SVCCTL_CltHandler;
 SVCCTL_Handler_t SVCCTL_Handler;
+#if (BLE_CFG_ROUTE_MAX_NBR > 0)
+static SVCCTL_Router_t SVCCTL_Router;
+#endif
 
 /* Private functions ----------------------------------------------------------*/
+#if (BLE_CFG_ROUTE_MAX_NBR > 0)
+static SVCCTL_EvtAckStatus_t SVCCTL_Route( void *pckt, hci_event_pckt *event_pckt );
+static uint8_t SVCCTL_IsRouted( SVC_CTL_p_EvtHandler_t pfHandler );
+#endif
 /* Weak functions -------------------------------------------------------------*/
 
 /* Functions Definition ------------------------------------------------------*/
@@ -70,6 +107,9 @@ void SVCCTL_Init( void )
   SVCCTL_EvtHandler.NbreOfRegisteredHandler = 0;
   SVCCTL_CltHandler.NbreOfRegisteredHandler = 0;
   SVCCTL_Handler.NbreOfRegisteredHandler = 0;
+#if (BLE_CFG_ROUTE_MAX_NBR > 0)
+  SVCCTL_Router.NbreOfRegisteredRoute = 0;
+#endif
 
   return;
 }
@@ -83,6 +123,9 @@ void SVCCTL_RegisterSvcHandler( SVC_CTL_p_EvtHandler_t pfBLE_SVC_Service_Event_H
 {
 #if (BLE_CFG_SVC_MAX_NBR_CB > 0)
   SVCCTL_EvtHandler.SVCCTL__SvcHandlerTab[SVCCTL_EvtHandler.NbreOfRegisteredHandler] = pfBLE_SVC_Service_Event_Handler;
+#if (BLE_CFG_ROUTE_MAX_NBR > 0)
+  SVCCTL_EvtHandler.SVCCTL__SvcHandlerRouted[SVCCTL_EvtHandler.NbreOfRegisteredHandler] = SVCCTL_IsRouted(pfBLE_SVC_Service_Event_Handler);
+#endif
   SVCCTL_EvtHandler.NbreOfRegisteredHandler++;
 #else
   (void)(pfBLE_SVC_Service_Event_Handler);
@@ -100,6 +143,9 @@ void SVCCTL_RegisterCltHandler( SVC_CTL_p_EvtHandler_t pfBLE_SVC_Client_Event_Ha
 {
 #if (BLE_CFG_CLT_MAX_NBR_CB > 0)
   SVCCTL_CltHandler.SVCCTL_CltHandlerTable[SVCCTL_CltHandler.NbreOfRegisteredHandler] = pfBLE_SVC_Client_Event_Handler;
+#if (BLE_CFG_ROUTE_MAX_NBR > 0)
+  SVCCTL_CltHandler.SVCCTL_CltHandlerRouted[SVCCTL_CltHandler.NbreOfRegisteredHandler] = SVCCTL_IsRouted(pfBLE_SVC_Client_Event_Handler);
+#endif
   SVCCTL_CltHandler.NbreOfRegisteredHandler++;
 #else
   (void)(pfBLE_SVC_Client_Event_Handler);
@@ -125,6 +171,97 @@ void SVCCTL_RegisterHandler( SVC_CTL_p_EvtHandler_t pfBLE_SVC_Event_Handler )
   return;
 }
 
+/**
+ * @brief  Route registration
+ * @param  Ecode: ACI event code
+ * @param  StartHandle: First attribute handle of the range
+ * @param  EndHandle: Last attribute handle of the range
+ * @param  pfBLE_SVC_Event_Handler: Handler of the route
+ * @retval 0 when registered, 1 when the table is full
+ */
+uint8_t SVCCTL_RegisterRoute( uint16_t Ecode,
+                              uint16_t StartHandle,
+                              uint16_t EndHandle,
+                              SVC_CTL_p_EvtHandler_t pfBLE_SVC_Event_Handler )
+{
+#if (BLE_CFG_ROUTE_MAX_NBR > 0)
+  uint8_t index;
+
+  if (SVCCTL_Router.NbreOfRegisteredRoute >= BLE_CFG_ROUTE_MAX_NBR)
+  {
+    return 1;
+  }
+
+  /* Inserted after the routes of the same event code */
+  index = SVCCTL_Router.NbreOfRegisteredRoute;
+  while ((index > 0) && (SVCCTL_Router.SVCCTL_RouteTable[index - 1].Stats.Ecode > Ecode))
+  {
+    SVCCTL_Router.SVCCTL_RouteTable[index] = SVCCTL_Router.SVCCTL_RouteTable[index - 1];
+    index--;
+  }
+  SVCCTL_Router.SVCCTL_RouteTable[index].Stats.Ecode = Ecode;
+  SVCCTL_Router.SVCCTL_RouteTable[index].Stats.StartHandle = StartHandle;
+  SVCCTL_Router.SVCCTL_RouteTable[index].Stats.EndHandle = EndHandle;
+  SVCCTL_Router.SVCCTL_RouteTable[index].Stats.Calls = 0;
+  SVCCTL_Router.SVCCTL_RouteTable[index].Stats.Hits = 0;
+  SVCCTL_Router.SVCCTL_RouteTable[index].pfHandler = pfBLE_SVC_Event_Handler;
+  SVCCTL_Router.NbreOfRegisteredRoute++;
+
+  /* A service or client handler with routes no longer gets the events that are not routed to it */
+#if (BLE_CFG_SVC_MAX_NBR_CB > 0)
+  for (index = 0; index < SVCCTL_EvtHandler.NbreOfRegisteredHandler; index++)
+  {
+    if (SVCCTL_EvtHandler.SVCCTL__SvcHandlerTab[index] == pfBLE_SVC_Event_Handler)
+    {
+      SVCCTL_EvtHandler.SVCCTL__SvcHandlerRouted[index] = 1;
+    }
+  }
+#endif
+#if (BLE_CFG_CLT_MAX_NBR_CB > 0)
+  for (index = 0; index < SVCCTL_CltHandler.NbreOfRegisteredHandler; index++)
+  {
+    if (SVCCTL_CltHandler.SVCCTL_CltHandlerTable[index] == pfBLE_SVC_Event_Handler)
+    {
+      SVCCTL_CltHandler.SVCCTL_CltHandlerRouted[index] = 1;
+    }
+  }
+#endif
+
+  return 0;
+#else
+  (void)(Ecode);
+  (void)(StartHandle);
+  (void)(EndHandle);
+  (void)(pfBLE_SVC_Event_Handler);
+
+  return 1;
+#endif
+}
+
+/**
+ * @brief  Route counters
+ * @param  Index: Index of the route
+ * @param  p_Stats: Counters of the route
+ * @retval 0 when the route exists, 1 otherwise
+ */
+uint8_t SVCCTL_GetRouteStats( uint8_t Index, SVCCTL_RouteStats_t *p_Stats )
+{
+#if (BLE_CFG_ROUTE_MAX_NBR > 0)
+  if (Index >= SVCCTL_Router.NbreOfRegisteredRoute)
+  {
+    return 1;
+  }
+  *p_Stats = SVCCTL_Router.SVCCTL_RouteTable[Index].Stats;
+
+  return 0;
+#else
+  (void)(Index);
+  (void)(p_Stats);
+
+  return 1;
+#endif
+}
+
 SVCCTL_UserEvtFlowStatus_t SVCCTL_UserEvtRx( void *pckt )
 {
   hci_event_pckt *event_pckt;
@@ -144,6 +281,15 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_UserEvtRx( void *pckt )
     {
       blecore_evt = (evt_blecore_aci*) event_pckt->data;
 
+#if (BLE_CFG_ROUTE_MAX_NBR > 0)
+      /* The handlers registered for the event code are tried first */
+      event_notification_status = SVCCTL_Route(pckt, event_pckt);
+      if (event_notification_status != SVCCTL_EvtNotAck)
+      {
+        break;
+      }
+#endif
+
       switch ((blecore_evt->ecode) & SVCCTL_EGID_EVT_MASK)
       {
         case SVCCTL_GATT_EVT_TYPE:
@@ -151,6 +297,12 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_UserEvtRx( void *pckt )
           /* For Service event handler */
           for (index = 0; index < SVCCTL_EvtHandler.NbreOfRegisteredHandler; index++)
           {
+#if (BLE_CFG_ROUTE_MAX_NBR > 0)
+            if (SVCCTL_EvtHandler.SVCCTL__SvcHandlerRouted[index] != 0)
+            {
+              continue;
+            }
+#endif
             event_notification_status = SVCCTL_EvtHandler.SVCCTL__SvcHandlerTab[index](pckt);
             /**
              * When a GATT event has been acknowledged by a Service, there is no need to call the other registered handlers
@@ -170,6 +322,12 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_UserEvtRx( void *pckt )
           event_notification_status = SVCCTL_EvtNotAck;
           for(index = 0; index <SVCCTL_CltHandler.NbreOfRegisteredHandler; index++)
           {
+#if (BLE_CFG_ROUTE_MAX_NBR > 0)
+            if (SVCCTL_CltHandler.SVCCTL_CltHandlerRouted[index] != 0)
+            {
+              continue;
+            }
+#endif
             event_notification_status = SVCCTL_CltHandler.SVCCTL_CltHandlerTable[index](pckt);
             /**
              * When a GATT event has been acknowledged by a Client, there is no need to call the other registered handlers
@@ -251,4 +409,91 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_UserEvtRx( void *pckt )
   return (return_status);
 }
 
+#if (BLE_CFG_ROUTE_MAX_NBR > 0)
+/**
+ * @brief  Give an event to the handlers registered for its event code and attribute handle
+ * @param  pckt: The user event received from the BLE core device
+ * @param  event_pckt: The vendor specific event in the packet
+ * @retval Ack: SVCCTL_EvtNotAck when no handler has acknowledged the event
+ */
+static SVCCTL_EvtAckStatus_t SVCCTL_Route( void *pckt, hci_event_pckt *event_pckt )
+{
+  evt_blecore_aci *blecore_evt = (evt_blecore_aci*) event_pckt->data;
+  SVCCTL_EvtAckStatus_t event_notification_status = SVCCTL_EvtNotAck;
+  SVCCTL_Route_t *p_route;
+  uint16_t ecode = blecore_evt->ecode;
+  uint16_t handle = 0;
+  uint8_t handle_valid;
+  uint8_t low = 0;
+  uint8_t high = SVCCTL_Router.NbreOfRegisteredRoute;
+  uint8_t mid;
+
+  /* First route of the event code */
+  while (low < high)
+  {
+    mid = (low + high) / 2;
+    if (SVCCTL_Router.SVCCTL_RouteTable[mid].Stats.Ecode < ecode)
+    {
+      low = mid + 1;
+    }
+    else
+    {
+      high = mid;
+    }
+  }
+
+  handle_valid = (event_pckt->plen >= SVCCTL_ROUTE_HANDLE_EVT_SIZE);
+  if (handle_valid != 0)
+  {
+    handle = (uint16_t)blecore_evt->data[2] | ((uint16_t)blecore_evt->data[3] << 8);
+  }
+
+  for (; low < SVCCTL_Router.NbreOfRegisteredRoute; low++)
+  {
+    p_route = &SVCCTL_Router.SVCCTL_RouteTable[low];
+    if (p_route->Stats.Ecode != ecode)
+    {
+      break;
+    }
+    if ((p_route->Stats.StartHandle != SVCCTL_ROUTE_HANDLE_FIRST) || (p_route->Stats.EndHandle != SVCCTL_ROUTE_HANDLE_LAST))
+    {
+      if ((handle_valid == 0) || (handle < p_route->Stats.StartHandle) || (handle > p_route->Stats.EndHandle))
+      {
+        continue;
+      }
+    }
+
+    p_route->Stats.Calls++;
+    event_notification_status = p_route->pfHandler(pckt);
+    if (event_notification_status != SVCCTL_EvtNotAck)
+    {
+      p_route->Stats.Hits++;
+      break;
+    }
+  }
+
+  return event_notification_status;
+}
+
+/**
+ * @brief  Check if a handler has been registered with at least one route
+ * @param  pfHandler: Handler to look for
+ * @retval 1 when the handler has routes, 0 otherwise
+ */
+static uint8_t SVCCTL_IsRouted( SVC_CTL_p_EvtHandler_t pfHandler )
+{
+  uint8_t index;
+
+  for (index = 0; index < SVCCTL_Router.NbreOfRegisteredRoute; index++)
+  {
+    if (SVCCTL_Router.SVCCTL_RouteTable[index].pfHandler == pfHandler)
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+#endif
+
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
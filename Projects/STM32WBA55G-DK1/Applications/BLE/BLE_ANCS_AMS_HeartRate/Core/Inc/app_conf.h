@@ -174,8 +174,10 @@
  *  - 2*DTM_NUM_LINK, if client configuration descriptor is used
  *  - 2, if extended properties is used
  *  The total amount of memory needed is the sum of the above quantities for each attribute.
+ *  The Heart Rate Measurement value holds up to HRS_HRME_MAX_LENGTH (105) octets instead of 23,
+ *  the default size of 1344 is increased by the 82 extra octets.
  */
-#define CFG_BLE_ATT_VALUE_ARRAY_SIZE    (1344)
+#define CFG_BLE_ATT_VALUE_ARRAY_SIZE    (1426)
 
 /**
  * depth of the PREPARE WRITE queue when PREPARE WRITE REQUEST
@@ -200,10 +202,12 @@
 
 /**
  * Connection Oriented Channel parameters
+ *  Only the heart rate log export accepts channels, one per link at most,
+ *  so the channel contexts of the full host are sized to the links.
  */
-#define CFG_BLE_COC_NBR_MAX           (64)
+#define CFG_BLE_COC_NBR_MAX           (CFG_BLE_NUM_LINK)
 #define CFG_BLE_COC_MPS_MAX           (248)
-#define CFG_BLE_COC_INITIATOR_NBR_MAX (32)
+#define CFG_BLE_COC_INITIATOR_NBR_MAX (1)
 
 /**
  * PHY preferences
@@ -213,7 +217,18 @@
 #define CFG_PHY_PREF_RX               (HCI_RX_PHYS_LE_2M_PREF)
 
 /* USER CODE BEGIN BLE_Stack */
+/**
+ * Data length requested at connection bring-up
+ */
+#define CFG_BLE_LINK_MAX_TX_OCTETS    (251)
+#define CFG_BLE_LINK_MAX_TX_TIME      (2120)
 
+/**
+ * Throughput probe of the connection bring-up
+ *  When set to 1, the bytes received by the GATT client during the discovery are
+ *  accounted and the effective bytes per connection event are logged.
+ */
+#define CFG_BLE_LINK_PROBE            (1)
 /* USER CODE END BLE_Stack */
 
 /******************************************************************************
@@ -245,11 +260,29 @@ typedef enum
   CFG_LPM_APP,
   CFG_LPM_LOG,
   /* USER CODE BEGIN CFG_LPM_Id_t */
+  CFG_LPM_PKA,
+  CFG_LPM_CRC,
 
   /* USER CODE END CFG_LPM_Id_t */
 } CFG_LPM_Id_t;
 
 /* USER CODE BEGIN Low_Power 1 */
+/**
+ * Energy accounting
+ *  Time spent in run and sleep modes (sleep needs a CFG_LPM_LEVEL), with the
+ *  radio active and in each sequencer task, turned into an estimated charge
+ *  with the currents below and reported on the trace every
+ *  CFG_ENERGY_ACCT_REPORT_PERIOD_MS.
+ *  The radio time is split per activity with the end of radio activity event,
+ *  enabled for the activities of CFG_ENERGY_ACCT_RADIO_ACTIVITY_MASK. Each
+ *  event wakes the host up: 0 only keeps the total radio time.
+ */
+#define CFG_ENERGY_ACCT_SUPPORTED            (1)
+#define CFG_ENERGY_ACCT_REPORT_PERIOD_MS     (60000U)
+#define CFG_ENERGY_ACCT_RADIO_ACTIVITY_MASK  (0x0006U)  /* Advertising and peripheral connection */
+#define CFG_ENERGY_ACCT_RUN_UA               (3500U)
+#define CFG_ENERGY_ACCT_SLEEP_UA             (1200U)
+#define CFG_ENERGY_ACCT_RADIO_UA             (3500U)   /* Added while the radio is active */
 
 /* USER CODE END Low_Power 1 */
 
@@ -261,6 +294,22 @@ typedef enum
 #define RTC_PREDIV_A ((1<<(15-RTC_N_PREDIV_S))-1)
 
 /* USER CODE BEGIN RTC */
+/**
+ * Wall clock, kept on the RTC and disciplined from the Current Time Service
+ * of the phone. The drift of the RTC is estimated from the references received
+ * over CFG_WALL_CLOCK_MIN_INTERVAL_S, a reference CFG_WALL_CLOCK_STEP_MS away
+ * from the clock being applied as a step. The time is read from the phone once
+ * the error bound of the clock reaches CFG_WALL_CLOCK_MAX_ERROR_MS, the bound
+ * growing at CFG_WALL_CLOCK_DRIFT_BOUND_PPB until the drift is estimated, at
+ * the last residual drift, at least CFG_WALL_CLOCK_RESIDUAL_PPB, afterwards.
+ */
+#define CFG_WALL_CLOCK_SUPPORTED              (1)
+#define CFG_WALL_CLOCK_MIN_INTERVAL_S         (600U)
+#define CFG_WALL_CLOCK_STEP_MS                (2000U)
+#define CFG_WALL_CLOCK_MAX_ERROR_MS           (1000U)
+#define CFG_WALL_CLOCK_DRIFT_BOUND_PPB        (50000U)
+#define CFG_WALL_CLOCK_RESIDUAL_PPB           (2000U)
+#define CFG_WALL_CLOCK_MAX_DRIFT_PPB          (500000)
 
 /* USER CODE END RTC */
 
@@ -321,14 +370,22 @@ typedef enum
   CFG_TASK_BPKA,
   CFG_TASK_AMM_BCKGND,
   CFG_TASK_FLASH_MANAGER_BCKGND,
+  CFG_TASK_SNVMA_BCKGND,
   CFG_TASK_BLE_TIMER_BCKGND,
   /* USER CODE BEGIN CFG_Task_Id_t */
   CFG_TASK_JOYSTICK_ID,
   CFG_TASK_MEAS_REQ_ID,
+  CFG_TASK_HRS_SEND_ID,
   CFG_TASK_ADV_LP_REQ_ID,
   CFG_TASK_START_NOTIF_ID,
   CFG_TASK_MENU_PRINT_ID,
   CFG_TASK_CLIENT_TIMER_ID,
+  CFG_TASK_CONN_PARAM_ID,
+  /* GATT discovery workers, one per link so that links are discovered concurrently */
+  CFG_TASK_DISCOVER_LINK_ID,
+  CFG_TASK_DISCOVER_LINK_LAST_ID = CFG_TASK_DISCOVER_LINK_ID + CFG_BLE_NUM_LINK - 1,
+  /* Queued GATT operations of all the links */
+  CFG_TASK_GATT_OP_ID,
   
   /* AMS Task */
   CFG_TASK_GATT_CLIENT_TO_AMS_ID,
@@ -336,6 +393,11 @@ typedef enum
   /* ANCS Task */
   CFG_TASK_GATT_CLIENT_TO_ANCS_ID,
   CFG_TASK_ANCS_GET_DETAIL_ID,
+  /* Heart rate history log */
+  CFG_TASK_HRS_LOG_ID,
+  CFG_TASK_HRS_LOG_EXPORT_ID,
+  CFG_TASK_ENERGY_ACCT_ID,
+  CFG_TASK_CRC_ID,
   
   /* USER CODE END CFG_Task_Id_t */
   CFG_TASK_NBR /* Shall be LAST in the list */
@@ -369,6 +431,9 @@ typedef enum
   /* USER CODE BEGIN CFG_IdleEvt_Id_t */
   CFG_IDLEEVT_GATT_CMD_TO_AMS_COMPLETE,
   CFG_IDLEEVT_GATT_CMD_TO_ANCS_COMPLETE,
+  /* GATT procedure complete, one event per link */
+  CFG_IDLEEVT_PROC_GATT_LINK_COMPLETE,
+  CFG_IDLEEVT_PROC_GATT_LINK_COMPLETE_LAST = CFG_IDLEEVT_PROC_GATT_LINK_COMPLETE + CFG_BLE_NUM_LINK - 1,
 
   /* USER CODE END CFG_IdleEvt_Id_t */
 } CFG_IdleEvt_Id_t;
@@ -406,6 +471,12 @@ typedef enum
 #define CFG_SNVMA_START_ADDRESS       (FLASH_BASE + (FLASH_PAGE_SIZE * (CFG_SNVMA_START_SECTOR_ID)))
 
 /* USER CODE BEGIN NVM_Configuration */
+/* Heart rate history log, in the pages just below the SNVMA ones */
+#define CFG_HRS_LOG_NBR_SECTORS       (4u)
+
+#define CFG_HRS_LOG_START_SECTOR_ID   (CFG_SNVMA_START_SECTOR_ID - CFG_HRS_LOG_NBR_SECTORS)
+
+#define CFG_HRS_LOG_START_ADDRESS     (FLASH_BASE + (FLASH_PAGE_SIZE * (CFG_HRS_LOG_START_SECTOR_ID)))
 
 /* USER CODE END NVM_Configuration */
 
@@ -416,7 +487,22 @@ typedef enum
 #define CFG_BLEPLAT_NVM_MAX_SIZE            ((2048/8)-4)
 
 /* USER CODE BEGIN BLEPLAT_Configuration */
+/**
+ * BLE stack timers
+ *  Number of timers the stack can run at the same time, and delay in ms
+ *  between an expiry and its handling above which the expiry is counted late.
+ */
+#define CFG_BLE_TIMER_NBR                   (16U)
+#define CFG_BLE_TIMER_LATE_THRESHOLD        (5U)
 
+/**
+ * P-256 key pairs precomputed at idle time
+ *  Number of pairs kept ready (0 to disable), lifetime in ms of a pair not
+ *  used, and minimum time in us to the next radio event to start a pair.
+ */
+#define CFG_BPKA_PAIR_NBR                   (2U)
+#define CFG_BPKA_PAIR_LIFETIME_MS           (15U * 60U * 1000U)
+#define CFG_BPKA_RADIO_MARGIN_US            (5000U)
 /* USER CODE END BLEPLAT_Configuration */
 
 /******************************************************************************
@@ -443,6 +529,17 @@ typedef enum
 
 #define CFG_SCM_SUPPORTED            (1)
 
+/**
+ * Dynamic clock scaling, voting for the application (SCM_USER_APP)
+ *  The PLL is requested before a task once the sequencer has been busy for
+ *  CFG_DVFS_BURST_US without idle, or when the task usually runs that long.
+ *  HSE 16 MHz, at voltage range 2, is requested back once no burst has been
+ *  seen for CFG_DVFS_HOLD_MS or when the coming idle lasts at least as long.
+ */
+#define CFG_DVFS_SUPPORTED           (1)
+#define CFG_DVFS_BURST_US            (2000U)
+#define CFG_DVFS_HOLD_MS             (20U)
+
 /******************************************************************************
  * HW RADIO configuration
  ******************************************************************************/
@@ -484,6 +581,14 @@ typedef enum
 #define CFG_HW_RNG_POOL_SIZE                (32)
 
 /* USER CODE BEGIN HW_RNG_Configuration */
+/* Random numbers served by an AES-128 CTR_DRBG seeded from the RNG pool */
+#define CFG_CTR_DRBG_SUPPORTED              (1)
+
+/* Generates, each refilling the reserve, between two reseeds */
+#define CFG_CTR_DRBG_RESEED_INTERVAL        (1024U)
+
+/* Bytes generated ahead, multiple of 16 */
+#define CFG_CTR_DRBG_RESERVE_SIZE           (64U)
 
 /* USER CODE END HW_RNG_Configuration */
 
@@ -515,6 +620,19 @@ typedef enum
 #define CFG_JOYSTICK_SUPPORTED                  (1)
 #define CFG_LCD_SUPPORTED                       (1)
 
+/**
+ * Joystick events
+ * A key is reported once stable for CFG_JOY_DEBOUNCE_MS and long pressed after
+ * CFG_JOY_LONG_PRESS_MS. UP and DOWN are then repeated every CFG_JOY_REPEAT_MS.
+ * Repeats of a key not yet consumed are coalesced up to CFG_JOY_REPEAT_PENDING_MAX.
+ */
+#define CFG_JOY_DEBOUNCE_MS                     (30U)
+#define CFG_JOY_LONG_PRESS_MS                   (500U)
+#define CFG_JOY_REPEAT_MS                       (120U)
+#define CFG_JOY_REPEAT_PENDING_MAX              (3U)
+#define CFG_JOY_EVT_QUEUE_SIZE                  (8U)
+#define CFG_JOY_LATENCY_REPORT_NBR              (16U)   /* Screen updates per latency report */
+
 /**
  * Overwrite some configuration imposed by Low Power level selected.
  */
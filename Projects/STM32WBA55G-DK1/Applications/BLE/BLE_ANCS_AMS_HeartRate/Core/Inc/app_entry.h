@@ -31,7 +31,7 @@ extern "C" {
 /* Private includes ----------------------------------------------------------*/
 #include "app_common.h"
 /* USER CODE BEGIN Includes */
-
+#include "stm32_seq.h"
 /* USER CODE END Includes */
 
 /* Exported types ------------------------------------------------------------*/
@@ -62,7 +62,10 @@ uint32_t MX_APPE_Init(void *p_param);
 void MX_APPE_Process(void);
 
 /* USER CODE BEGIN EFP */
-
+void APPE_SEQ_RegTask( UTIL_SEQ_bm_t TaskId_bm, uint32_t Flags, void (*Task)( void ) );
+#if (CFG_JOYSTICK_SUPPORTED == 1)
+void APPE_Joystick_IRQHandler( void );
+#endif /* CFG_JOYSTICK_SUPPORTED */
 /* USER CODE END EFP */
 
 #ifdef __cplusplus
@@ -64,6 +64,7 @@ void RADIO_IRQHandler(void);
 void HASH_IRQHandler(void);
 /* USER CODE BEGIN EFP */
 void ADC4_IRQHandler(void);
+void GPDMA1_Channel2_IRQHandler(void);
 /* USER CODE END EFP */
 
 #ifdef __cplusplus
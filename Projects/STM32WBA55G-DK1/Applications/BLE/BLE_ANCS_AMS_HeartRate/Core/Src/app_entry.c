@@ -54,21 +54,81 @@
 #include "stm32_lcd.h"
 #endif /* CFG_LCD_SUPPORTED */
 #include "app_menu.h"
+#include "energy_acct.h"
+#include "ble_timer.h"
+#include "dvfs.h"
+#include "crc_ctrl.h"
+#include "wall_clock.h"
+#include "baes.h"
+#if (CFG_CTR_DRBG_SUPPORTED == 1)
+#include "ctr_drbg.h"
+#endif /* CFG_CTR_DRBG_SUPPORTED */
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
 
 /* USER CODE BEGIN PTD */
+#if (CFG_JOYSTICK_SUPPORTED == 1)
+typedef enum
+{
+  JOY_EVT_PRESS,
+  JOY_EVT_LONG_PRESS,
+  JOY_EVT_REPEAT,
+} Joystick_EvtType_t;
+
+typedef enum
+{
+  JOY_STATE_RELEASED,
+  JOY_STATE_DEBOUNCE,
+  JOY_STATE_PRESSED,
+  JOY_STATE_HELD,
+} Joystick_State_t;
+
+typedef struct
+{
+  JOYPin_TypeDef  Key;
+  uint8_t         Type;         /* Joystick_EvtType_t of the first event */
+  uint8_t         Count;        /* Events coalesced, including the first one */
+  uint32_t        Time;         /* Time of the first event, in ms */
+} Joystick_Evt_t;
 
+typedef struct
+{
+  uint32_t        Events;       /* Events detected */
+  uint32_t        Coalesced;    /* Events merged into a pending one */
+  uint32_t        Dropped;      /* Repeats dropped or queue full */
+  uint32_t        Updates;      /* Screen updates measured */
+  uint32_t        LatencySumMs;
+  uint32_t        LatencyMaxMs;
+} Joystick_Stats_t;
+#endif /* CFG_JOYSTICK_SUPPORTED */
 /* USER CODE END PTD */
 
 /* Private defines -----------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+#if (CFG_JOYSTICK_SUPPORTED == 1)
+/* ADC level above which no key is pressed, low threshold of the BSP analog watchdog */
+#define JOY_RELEASE_LEVEL         (0xE1FU)
+#define JOY_LEVEL_MAX             (0xFFFU)
+
+/* Keys repeated while held */
+#define JOY_REPEAT_KEYS           (JOY_UP | JOY_DOWN)
+#endif /* CFG_JOYSTICK_SUPPORTED */
 
+/* Sequencer tasks run through a trampoline measuring them */
+#if (CFG_ENERGY_ACCT_SUPPORTED == 1) || ((CFG_DVFS_SUPPORTED == 1) && (CFG_SCM_SUPPORTED == 1))
+#define APPE_SEQ_TRAMPOLINE       (1)
+#else
+#define APPE_SEQ_TRAMPOLINE       (0)
+#endif /* (CFG_ENERGY_ACCT_SUPPORTED == 1) || ((CFG_DVFS_SUPPORTED == 1) && (CFG_SCM_SUPPORTED == 1)) */
+#define APPE_SEQ_TASK_MAX         (32U)  /* One task per bit of UTIL_SEQ_bm_t */
 /* USER CODE END PD */
 
 /* Private macros ------------------------------------------------------------*/
 /* USER CODE BEGIN PM */
+#if (APPE_SEQ_TRAMPOLINE == 1)
+#define APPE_SEQ_TASK_TRAMPOLINE(id)  static void APPE_SEQ_Task##id( void ) { APPE_SEQ_RunTask(id##U); }
+#endif /* APPE_SEQ_TRAMPOLINE */
 
 /* USER CODE END PM */
 
@@ -78,9 +138,9 @@
 /* USER CODE END PC */
 
 /* Private variables ---------------------------------------------------------*/
-#if ( CFG_LPM_LEVEL != 0)
+#if ( CFG_LPM_LEVEL != 0) || (CFG_BPKA_PAIR_NBR > 0)
 static bool system_startup_done = FALSE;
-#endif /* ( CFG_LPM_LEVEL != 0) */
+#endif /* ( CFG_LPM_LEVEL != 0) || (CFG_BPKA_PAIR_NBR > 0) */
 
 #if (CFG_LOG_SUPPORTED != 0)
 /* Log configuration */
@@ -113,8 +173,25 @@ static AMM_InitParameters_t ammInitConfig =
 
 /* USER CODE BEGIN PV */
 #if (CFG_JOYSTICK_SUPPORTED == 1)
-JOYPin_TypeDef Joystick_Event;
+static UTIL_TIMER_Object_t Joystick_Timer;
+static Joystick_State_t Joystick_State;
+static JOYPin_TypeDef Joystick_Key;
+static uint32_t Joystick_PressTime;
+
+/* Events detected under interrupt, consumed by the joystick task */
+static Joystick_Evt_t a_JoystickEvt[CFG_JOY_EVT_QUEUE_SIZE];
+static uint8_t Joystick_EvtHead;
+static uint8_t Joystick_EvtCount;
+
+static uint8_t Joystick_LatencyPending;
+static uint32_t Joystick_LatencyStart;
+static Joystick_Stats_t Joystick_Stats;
 #endif /* CFG_JOYSTICK_SUPPORTED */
+
+#if (APPE_SEQ_TRAMPOLINE == 1)
+/* Task registered by APPE_SEQ_RegTask(), run by the trampoline of its index */
+static void (*a_APPE_SEQ_TaskCb[APPE_SEQ_TASK_MAX])( void );
+#endif /* APPE_SEQ_TRAMPOLINE */
 /* USER CODE END PV */
 
 /* Global variables ----------------------------------------------------------*/
@@ -170,6 +247,16 @@ static void LCD_Init( void );
 #if (CFG_JOYSTICK_SUPPORTED == 1)
 static void Joystick_Init( uint8_t wkup_mode );
 static void Joystick_ActionHandle(void);
+static void Joystick_TimerCb( void *arg );
+static void Joystick_Process( uint8_t Timeout );
+static JOYPin_TypeDef Joystick_Decode( uint32_t Level );
+static void Joystick_SetWindow( uint8_t Pressed );
+static void Joystick_EvtPush( JOYPin_TypeDef Key, Joystick_EvtType_t Type, uint32_t Time );
+static uint8_t Joystick_EvtPop( Joystick_Evt_t *p_Evt );
+#if (CFG_LCD_SUPPORTED == 1)
+static void Joystick_MenuPrintTask( void );
+static void Joystick_LatencyUpdate( void );
+#endif /* CFG_LCD_SUPPORTED */
 #endif /* CFG_JOYSTICK_SUPPORTED */
 /* USER CODE END PFP */
 
@@ -208,27 +295,41 @@ uint32_t MX_APPE_Init(void *p_param)
   AMM_Init (&ammInitConfig);
 
   /* Register the AMM background task */
-  UTIL_SEQ_RegTask(1U << CFG_TASK_AMM_BCKGND, UTIL_SEQ_RFU, AMM_BackgroundProcess);
+  APPE_SEQ_RegTask(1U << CFG_TASK_AMM_BCKGND, UTIL_SEQ_RFU, AMM_BackgroundProcess);
   /* Initialize the Simple NVM Arbiter */
   SNVMA_Init ((uint32_t *)CFG_SNVMA_START_ADDRESS);
 
+  /* Register the Simple NVM Arbiter background task */
+  APPE_SEQ_RegTask(1U << CFG_TASK_SNVMA_BCKGND, UTIL_SEQ_RFU, SNVMA_BackgroundProcess);
+
   /* Register the flash manager task */
-  UTIL_SEQ_RegTask(1U << CFG_TASK_FLASH_MANAGER_BCKGND, UTIL_SEQ_RFU, FM_BackgroundProcess);
+  APPE_SEQ_RegTask(1U << CFG_TASK_FLASH_MANAGER_BCKGND, UTIL_SEQ_RFU, FM_BackgroundProcess);
 
   /* USER CODE BEGIN APPE_Init_1 */
+#if (CFG_ENERGY_ACCT_SUPPORTED == 1)
+  ENERGY_ACCT_Init();
+#endif /* CFG_ENERGY_ACCT_SUPPORTED */
+#if (CFG_WALL_CLOCK_SUPPORTED == 1)
+  WALL_CLOCK_Init();
+#endif /* CFG_WALL_CLOCK_SUPPORTED */
 #if (CFG_LED_SUPPORTED == 1)
   Led_Init();
 #endif
 #if (CFG_LCD_SUPPORTED == 1)
   LCD_Init();
-  UTIL_SEQ_RegTask(1U << CFG_TASK_MENU_PRINT_ID, UTIL_SEQ_RFU, Menu_Print_Task);
+#if (CFG_JOYSTICK_SUPPORTED == 1)
+  APPE_SEQ_RegTask(1U << CFG_TASK_MENU_PRINT_ID, UTIL_SEQ_RFU, Joystick_MenuPrintTask);
+#else
+  APPE_SEQ_RegTask(1U << CFG_TASK_MENU_PRINT_ID, UTIL_SEQ_RFU, Menu_Print_Task);
+#endif /* CFG_JOYSTICK_SUPPORTED */
 #endif /* CFG_LCD_SUPPORTED */
 #if (CFG_JOYSTICK_SUPPORTED == 1)
   Joystick_Init(0);
 #endif
+  APPE_SEQ_RegTask(1U << CFG_TASK_CRC_ID, UTIL_SEQ_RFU, CRCCTRL_JobProcess);
 
   /* USER CODE END APPE_Init_1 */
-  UTIL_SEQ_RegTask(1U << CFG_TASK_BPKA, UTIL_SEQ_RFU, BPKA_BG_Process);
+  APPE_SEQ_RegTask(1U << CFG_TASK_BPKA, UTIL_SEQ_RFU, BPKA_BG_Process);
 
   BPKA_Reset( );
 
@@ -247,9 +348,14 @@ uint32_t MX_APPE_Init(void *p_param)
   FD_SetStatus (FD_FLASHACCESS_RFTS_BYPASS, LL_FLASH_DISABLE);
 
   /* USER CODE BEGIN APPE_Init_2 */
+#if (CFG_CTR_DRBG_SUPPORTED == 1)
+  /* Instantiate the DRBG here, the link layer only draws from it */
+  CTR_DRBG_Init();
+#endif /* CFG_CTR_DRBG_SUPPORTED */
+
 #if (CFG_JOYSTICK_SUPPORTED == 1)
   /* Register Button Tasks */
-  UTIL_SEQ_RegTask(1U << CFG_TASK_JOYSTICK_ID, UTIL_SEQ_RFU, Joystick_ActionHandle);
+  APPE_SEQ_RegTask(1U << CFG_TASK_JOYSTICK_ID, UTIL_SEQ_RFU, Joystick_ActionHandle);
 #endif /* CFG_JOYSTICK_SUPPORTED */
   /* USER CODE END APPE_Init_2 */
   APP_DEBUG_SIGNAL_RESET(APP_APPE_INIT);
@@ -258,34 +364,64 @@ uint32_t MX_APPE_Init(void *p_param)
 
 /* USER CODE BEGIN FD */
 #if (CFG_JOYSTICK_SUPPORTED == 1)
+/**
+ * @brief  Apply the joystick events to the menu. Navigation events merged while
+ *         the task was waiting are applied in one go, the screen being printed
+ *         once afterwards.
+ */
 static void Joystick_ActionHandle(void)
 {
-  if (Joystick_Event == JOY_SEL)
-  {
-    
-  }
-  else if (Joystick_Event == JOY_UP)
-  {
-    Menu_Up();
-  }
-  else if (Joystick_Event == JOY_RIGHT)
-  {
-    Menu_Right();
-  }
-  else if (Joystick_Event == JOY_DOWN)
-  {
-    Menu_Down();
-  }
-  else if (Joystick_Event == JOY_LEFT)
+  Joystick_Evt_t evt;
+  uint8_t index;
+
+  while (Joystick_EvtPop(&evt) != 0U)
   {
-    Menu_Left();
+    APP_BLE_ConnParam_Traffic(APP_BLE_ALL_LINKS, APP_BLE_TRAFFIC_UI);
+
+    for (index = 0; index < evt.Count; index++)
+    {
+      if (evt.Key == JOY_UP)
+      {
+        Menu_Up();
+      }
+      else if (evt.Key == JOY_DOWN)
+      {
+        Menu_Down();
+      }
+      else if ((evt.Key == JOY_RIGHT) && (evt.Type == JOY_EVT_PRESS))
+      {
+        Menu_Right();
+      }
+      else if ((evt.Key == JOY_LEFT) && (evt.Type == JOY_EVT_PRESS))
+      {
+        Menu_Left();
+      }
+    }
+
+#if (CFG_LCD_SUPPORTED == 1)
+    /* Measure from the press up to the end of the screen update it requested */
+    if ((Joystick_LatencyPending == 0U) && (UTIL_SEQ_IsSchedulableTask(1U << CFG_TASK_MENU_PRINT_ID) != 0U))
+    {
+      Joystick_LatencyStart = evt.Time;
+      Joystick_LatencyPending = 1U;
+    }
+#endif /* CFG_LCD_SUPPORTED */
   }
 }
 
-void BSP_JOY_Callback(JOY_TypeDef JOY, JOYPin_TypeDef JoyPin)
+/**
+ * @brief  ADC4 interrupt, the analog watchdog reports the joystick leaving the
+ *         window of the current state.
+ */
+void APPE_Joystick_IRQHandler( void )
 {
-  Joystick_Event = JoyPin;
-  UTIL_SEQ_SetTask( 1U << CFG_TASK_JOYSTICK_ID, CFG_SEQ_PRIO_0);
+  ADC_TypeDef *p_adc = hjoy_adc[JOY1].Instance;
+
+  if ((LL_ADC_IsEnabledIT_AWD1(p_adc) != 0U) && (LL_ADC_IsActiveFlag_AWD1(p_adc) != 0U))
+  {
+    LL_ADC_ClearFlag_AWD1(p_adc);
+    Joystick_Process(0U);
+  }
 }
 #endif /* CFG_JOYSTICK_SUPPORTED */
 /* USER CODE END FD */
@@ -337,9 +473,9 @@ static void System_Init( void )
   Serial_CMD_Interpreter_Init();
 #endif  /* (CFG_LOG_SUPPORTED != 0) */
 
-#if ( CFG_LPM_LEVEL != 0)
+#if ( CFG_LPM_LEVEL != 0) || (CFG_BPKA_PAIR_NBR > 0)
   system_startup_done = TRUE;
-#endif /* ( CFG_LPM_LEVEL != 0) */
+#endif /* ( CFG_LPM_LEVEL != 0) || (CFG_BPKA_PAIR_NBR > 0) */
 
   return;
 }
@@ -359,6 +495,12 @@ static void SystemPower_Config(void)
   scm_init();
 #endif /* CFG_SCM_SUPPORTED */
 
+  /* USER CODE BEGIN SystemPower_Config_SCM */
+#if (CFG_DVFS_SUPPORTED == 1) && (CFG_SCM_SUPPORTED == 1)
+  DVFS_Init();
+#endif /* (CFG_DVFS_SUPPORTED == 1) && (CFG_SCM_SUPPORTED == 1) */
+  /* USER CODE END SystemPower_Config_SCM */
+
 #if (CFG_DEBUGGER_LEVEL == 0)
   /* Pins used by SerialWire Debug are now analog input */
   GPIO_InitTypeDef DbgIOsInit = {0};
@@ -402,7 +544,7 @@ static void RNG_Init(void)
 {
   HW_RNG_Start();
 
-  UTIL_SEQ_RegTask(1U << CFG_TASK_HW_RNG, UTIL_SEQ_RFU, (void (*)(void))HW_RNG_Process);
+  APPE_SEQ_RegTask(1U << CFG_TASK_HW_RNG, UTIL_SEQ_RFU, (void (*)(void))HW_RNG_Process);
 }
 
 static void AMM_WrapperInit (uint32_t * const p_PoolAddr, const uint32_t PoolSize)
@@ -477,6 +619,10 @@ static void Joystick_Init( uint8_t wkup_mode )
   }
   else
   {
+    /* The analog watchdog of the BSP detects the press, the timer the debounce, long press and repeat */
+    Joystick_State = JOY_STATE_RELEASED;
+    UTIL_TIMER_Create(&Joystick_Timer, 0, UTIL_TIMER_ONESHOT, &Joystick_TimerCb, 0);
+
     BSP_JOY_Init(JOY1, JOY_MODE_IT, JOY_ALL);
     /* reconfiguration of the ADC4 interrupt priority */
     HAL_NVIC_DisableIRQ(ADC4_IRQn);
@@ -490,6 +636,266 @@ static void Joystick_Init( uint8_t wkup_mode )
     LL_ADC_REG_StartConversion(hjoy_adc[JOY1].Instance);
   }
 }
+
+static void Joystick_TimerCb( void *arg )
+{
+  Joystick_Process(1U);
+}
+
+/**
+ * @brief  Joystick state machine, run under interrupt.
+ * @param  Timeout: 1 on the expiry of the joystick timer, 0 on the analog watchdog
+ * @retval None
+ */
+static void Joystick_Process( uint8_t Timeout )
+{
+  JOYPin_TypeDef key = Joystick_Decode(LL_ADC_REG_ReadConversionData12(hjoy_adc[JOY1].Instance));
+  uint32_t now = UTIL_TIMER_GetCurrentTime();
+
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  switch (Joystick_State)
+  {
+    case JOY_STATE_RELEASED:
+    {
+      if (Timeout == 0U)
+      {
+        /* Let the level settle, the watchdog is not needed meanwhile */
+        LL_ADC_DisableIT_AWD1(hjoy_adc[JOY1].Instance);
+        Joystick_Key = key;
+        Joystick_PressTime = now;
+        Joystick_State = JOY_STATE_DEBOUNCE;
+        (void)UTIL_TIMER_StartWithPeriod(&Joystick_Timer, CFG_JOY_DEBOUNCE_MS);
+      }
+      break;
+    }
+    case JOY_STATE_DEBOUNCE:
+    {
+      if (key == JOY_NONE)
+      {
+        /* Glitch, back to the press detection */
+        Joystick_State = JOY_STATE_RELEASED;
+        Joystick_SetWindow(0U);
+      }
+      else if (key != Joystick_Key)
+      {
+        Joystick_Key = key;
+        (void)UTIL_TIMER_StartWithPeriod(&Joystick_Timer, CFG_JOY_DEBOUNCE_MS);
+      }
+      else
+      {
+        Joystick_EvtPush(key, JOY_EVT_PRESS, Joystick_PressTime);
+        Joystick_State = JOY_STATE_PRESSED;
+        Joystick_SetWindow(1U);
+        (void)UTIL_TIMER_StartWithPeriod(&Joystick_Timer, CFG_JOY_LONG_PRESS_MS);
+      }
+      break;
+    }
+    case JOY_STATE_PRESSED:
+    case JOY_STATE_HELD:
+    {
+      if ((Timeout == 0U) || (key != Joystick_Key))
+      {
+        /* Released, a key reached without release is detected again from the press window */
+        (void)UTIL_TIMER_Stop(&Joystick_Timer);
+        Joystick_State = JOY_STATE_RELEASED;
+        Joystick_SetWindow(0U);
+      }
+      else if ((key & JOY_REPEAT_KEYS) != 0U)
+      {
+        Joystick_EvtPush(key, (Joystick_State == JOY_STATE_PRESSED) ? JOY_EVT_LONG_PRESS : JOY_EVT_REPEAT, now);
+        Joystick_State = JOY_STATE_HELD;
+        (void)UTIL_TIMER_StartWithPeriod(&Joystick_Timer, CFG_JOY_REPEAT_MS);
+      }
+      else if (Joystick_State == JOY_STATE_PRESSED)
+      {
+        Joystick_EvtPush(key, JOY_EVT_LONG_PRESS, now);
+        Joystick_State = JOY_STATE_HELD;
+      }
+      break;
+    }
+  }
+
+  UTILS_EXIT_CRITICAL_SECTION();
+}
+
+/* Key from the ADC level, with the levels of BSP_JOY_GetState */
+static JOYPin_TypeDef Joystick_Decode( uint32_t Level )
+{
+  JOYPin_TypeDef key;
+
+  if (Level >= JOY_RELEASE_LEVEL)
+  {
+    key = JOY_NONE;
+  }
+  else if (Level >= 2800U)
+  {
+    key = JOY_DOWN;
+  }
+  else if (Level >= 2000U)
+  {
+    key = JOY_RIGHT;
+  }
+  else if (Level >= 1200U)
+  {
+    key = JOY_LEFT;
+  }
+  else if (Level >= 400U)
+  {
+    key = JOY_UP;
+  }
+  else
+  {
+    key = JOY_SEL;
+  }
+
+  return key;
+}
+
+/**
+ * @brief  Set the analog watchdog window, the level leaving it on the next
+ *         press or on the release of the key.
+ * @param  Pressed: 1 to detect the release, 0 to detect a press
+ * @retval None
+ */
+static void Joystick_SetWindow( uint8_t Pressed )
+{
+  ADC_TypeDef *p_adc = hjoy_adc[JOY1].Instance;
+
+  /* Thresholds are only written with no conversion on going */
+  LL_ADC_REG_StopConversion(p_adc);
+  while(LL_ADC_REG_IsConversionOngoing(p_adc) != 0);
+
+  if (Pressed != 0U)
+  {
+    LL_ADC_ConfigAnalogWDThresholds(p_adc, LL_ADC_AWD1, JOY_RELEASE_LEVEL - 1U, 0U);
+  }
+  else
+  {
+    LL_ADC_ConfigAnalogWDThresholds(p_adc, LL_ADC_AWD1, JOY_LEVEL_MAX, JOY_RELEASE_LEVEL);
+  }
+
+  LL_ADC_ClearFlag_AWD1(p_adc);
+  LL_ADC_EnableIT_AWD1(p_adc);
+  LL_ADC_REG_StartConversion(p_adc);
+}
+
+/**
+ * @brief  Queue an event, called under interrupt. UP and DOWN following a
+ *         pending event of the same key are merged into it, repeats beyond
+ *         CFG_JOY_REPEAT_PENDING_MAX being dropped so that the menu does not
+ *         keep scrolling after the release when the screen lags behind.
+ * @param  Key: key of the event
+ * @param  Type: Joystick_EvtType_t
+ * @param  Time: time of the event, in ms
+ * @retval None
+ */
+static void Joystick_EvtPush( JOYPin_TypeDef Key, Joystick_EvtType_t Type, uint32_t Time )
+{
+  Joystick_Evt_t *p_evt;
+
+  Joystick_Stats.Events++;
+
+  p_evt = &a_JoystickEvt[(Joystick_EvtHead + Joystick_EvtCount + CFG_JOY_EVT_QUEUE_SIZE - 1U) % CFG_JOY_EVT_QUEUE_SIZE];
+  if ((Joystick_EvtCount != 0U) && (p_evt->Key == Key) && ((Key & JOY_REPEAT_KEYS) != 0U))
+  {
+    if (((Type == JOY_EVT_PRESS) || (p_evt->Count < CFG_JOY_REPEAT_PENDING_MAX)) && (p_evt->Count < UINT8_MAX))
+    {
+      p_evt->Count++;
+      Joystick_Stats.Coalesced++;
+    }
+    else
+    {
+      Joystick_Stats.Dropped++;
+    }
+  }
+  else if (Joystick_EvtCount < CFG_JOY_EVT_QUEUE_SIZE)
+  {
+    p_evt = &a_JoystickEvt[(Joystick_EvtHead + Joystick_EvtCount) % CFG_JOY_EVT_QUEUE_SIZE];
+    p_evt->Key = Key;
+    p_evt->Type = (uint8_t)Type;
+    p_evt->Count = 1U;
+    p_evt->Time = Time;
+    Joystick_EvtCount++;
+  }
+  else
+  {
+    Joystick_Stats.Dropped++;
+  }
+
+  UTIL_SEQ_SetTask(1U << CFG_TASK_JOYSTICK_ID, CFG_SEQ_PRIO_0);
+}
+
+static uint8_t Joystick_EvtPop( Joystick_Evt_t *p_Evt )
+{
+  uint8_t status = 0U;
+
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  if (Joystick_EvtCount != 0U)
+  {
+    *p_Evt = a_JoystickEvt[Joystick_EvtHead];
+    Joystick_EvtHead = (Joystick_EvtHead + 1U) % CFG_JOY_EVT_QUEUE_SIZE;
+    Joystick_EvtCount--;
+    status = 1U;
+  }
+
+  UTILS_EXIT_CRITICAL_SECTION();
+
+  return status;
+}
+
+#if (CFG_LCD_SUPPORTED == 1)
+/**
+ * @brief  Screen update task, closing the latency measurement of the joystick
+ *         event which requested it.
+ */
+static void Joystick_MenuPrintTask( void )
+{
+  Menu_Print_Task();
+
+  if (Joystick_LatencyPending != 0U)
+  {
+    Joystick_LatencyUpdate();
+  }
+}
+
+/**
+ * @brief  End of the screen update following a joystick event, the press to
+ *         screen latency is reported every CFG_JOY_LATENCY_REPORT_NBR updates.
+ */
+static void Joystick_LatencyUpdate( void )
+{
+  uint32_t latency = UTIL_TIMER_GetElapsedTime(Joystick_LatencyStart);
+  Joystick_Stats_t stats;
+
+  Joystick_LatencyPending = 0U;
+
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  Joystick_Stats.Updates++;
+  Joystick_Stats.LatencySumMs += latency;
+  if (latency > Joystick_Stats.LatencyMaxMs)
+  {
+    Joystick_Stats.LatencyMaxMs = latency;
+  }
+  stats = Joystick_Stats;
+  if (stats.Updates >= CFG_JOY_LATENCY_REPORT_NBR)
+  {
+    Joystick_Stats = (Joystick_Stats_t){0};
+  }
+
+  UTILS_EXIT_CRITICAL_SECTION();
+
+  if (stats.Updates >= CFG_JOY_LATENCY_REPORT_NBR)
+  {
+    LOG_INFO_APP(">>== Joystick press to screen: %d ms average, %d ms max\n",
+                 stats.LatencySumMs / stats.Updates, stats.LatencyMaxMs);
+    LOG_INFO_APP(">>== Joystick events: %d, coalesced %d, dropped %d\n",
+                 stats.Events, stats.Coalesced, stats.Dropped);
+  }
+}
+#endif /* CFG_LCD_SUPPORTED */
 #endif  /* CFG_JOYSTICK_SUPPORTED */
 /* USER CODE END FD_LOCAL_FUNCTIONS */
 
@@ -522,7 +928,23 @@ void UTIL_SEQ_Idle( void )
 void UTIL_SEQ_PreIdle( void )
 {
   /* USER CODE BEGIN UTIL_SEQ_PreIdle_1 */
-
+#if (CFG_DVFS_SUPPORTED == 1) && (CFG_SCM_SUPPORTED == 1)
+  DVFS_PreIdle();
+#endif /* (CFG_DVFS_SUPPORTED == 1) && (CFG_SCM_SUPPORTED == 1) */
+#if (CFG_BPKA_PAIR_NBR > 0)
+  /* Keep P-256 key pairs ready, before the modes are voted for below */
+  if (system_startup_done != FALSE)
+  {
+    BPKA_Precompute();
+  }
+#endif /* CFG_BPKA_PAIR_NBR */
+#if (CFG_LPM_LEVEL != 0) && (CFG_LPM_STDBY_SUPPORTED == 1)
+  /* Do not enter standby with postponed NVM writes, the flush schedules a task which cancels the idle */
+  if ((system_startup_done != FALSE) && (UTIL_LPM_GetMode() == UTIL_LPM_OFFMODE))
+  {
+    (void)SNVMA_Flush();
+  }
+#endif /* (CFG_LPM_LEVEL != 0) && (CFG_LPM_STDBY_SUPPORTED == 1) */
   /* USER CODE END UTIL_SEQ_PreIdle_1 */
 #if ( CFG_LPM_LEVEL != 0)
   LL_PWR_ClearFlag_STOP();
@@ -552,7 +974,9 @@ void UTIL_SEQ_PreIdle( void )
 void UTIL_SEQ_PostIdle( void )
 {
   /* USER CODE BEGIN UTIL_SEQ_PostIdle_1 */
-
+#if (CFG_DVFS_SUPPORTED == 1) && (CFG_SCM_SUPPORTED == 1)
+  DVFS_PostIdle();
+#endif /* (CFG_DVFS_SUPPORTED == 1) && (CFG_SCM_SUPPORTED == 1) */
   /* USER CODE END UTIL_SEQ_PostIdle_1 */
 #if ( CFG_LPM_LEVEL != 0)
   LL_AHB5_GRP1_EnableClock(LL_AHB5_GRP1_PERIPH_RADIO);
@@ -563,6 +987,7 @@ void UTIL_SEQ_PostIdle( void )
 #if (CFG_JOYSTICK_SUPPORTED == 1)
   if(JOY_StandbyExitFlag == 1){
     BSP_JOY_Init(JOY1, JOY_MODE_IT, JOY_ALL);
+    Joystick_State = JOY_STATE_RELEASED;
     JOY_StandbyExitFlag = 0;
   }
   ADC_Low_Threshold = LL_ADC_GetAnalogWDThresholds(ADC4, LL_ADC_AWD1, LL_ADC_AWD_THRESHOLD_LOW);
@@ -573,6 +998,105 @@ void UTIL_SEQ_PostIdle( void )
   return;
 }
 
+/* USER CODE BEGIN UTIL_SEQ_Task */
+#if (APPE_SEQ_TRAMPOLINE == 1)
+/**
+ * @brief  Run a sequencer task between the measurements of the DVFS and of
+ *         the energy accounting. Tasks run from UTIL_SEQ_WaitEvt() nest.
+ * @param  TaskId: index of the task
+ * @retval None
+ */
+static void APPE_SEQ_RunTask( uint32_t TaskId )
+{
+#if (CFG_DVFS_SUPPORTED == 1) && (CFG_SCM_SUPPORTED == 1)
+  DVFS_TaskStart(TaskId);
+#endif /* (CFG_DVFS_SUPPORTED == 1) && (CFG_SCM_SUPPORTED == 1) */
+#if (CFG_ENERGY_ACCT_SUPPORTED == 1)
+  ENERGY_ACCT_TaskStart(TaskId);
+#endif /* CFG_ENERGY_ACCT_SUPPORTED */
+
+  a_APPE_SEQ_TaskCb[TaskId]();
+
+#if (CFG_ENERGY_ACCT_SUPPORTED == 1)
+  ENERGY_ACCT_TaskEnd(TaskId);
+#endif /* CFG_ENERGY_ACCT_SUPPORTED */
+#if (CFG_DVFS_SUPPORTED == 1) && (CFG_SCM_SUPPORTED == 1)
+  DVFS_TaskEnd(TaskId);
+#endif /* (CFG_DVFS_SUPPORTED == 1) && (CFG_SCM_SUPPORTED == 1) */
+}
+
+APPE_SEQ_TASK_TRAMPOLINE(0)
+APPE_SEQ_TASK_TRAMPOLINE(1)
+APPE_SEQ_TASK_TRAMPOLINE(2)
+APPE_SEQ_TASK_TRAMPOLINE(3)
+APPE_SEQ_TASK_TRAMPOLINE(4)
+APPE_SEQ_TASK_TRAMPOLINE(5)
+APPE_SEQ_TASK_TRAMPOLINE(6)
+APPE_SEQ_TASK_TRAMPOLINE(7)
+APPE_SEQ_TASK_TRAMPOLINE(8)
+APPE_SEQ_TASK_TRAMPOLINE(9)
+APPE_SEQ_TASK_TRAMPOLINE(10)
+APPE_SEQ_TASK_TRAMPOLINE(11)
+APPE_SEQ_TASK_TRAMPOLINE(12)
+APPE_SEQ_TASK_TRAMPOLINE(13)
+APPE_SEQ_TASK_TRAMPOLINE(14)
+APPE_SEQ_TASK_TRAMPOLINE(15)
+APPE_SEQ_TASK_TRAMPOLINE(16)
+APPE_SEQ_TASK_TRAMPOLINE(17)
+APPE_SEQ_TASK_TRAMPOLINE(18)
+APPE_SEQ_TASK_TRAMPOLINE(19)
+APPE_SEQ_TASK_TRAMPOLINE(20)
+APPE_SEQ_TASK_TRAMPOLINE(21)
+APPE_SEQ_TASK_TRAMPOLINE(22)
+APPE_SEQ_TASK_TRAMPOLINE(23)
+APPE_SEQ_TASK_TRAMPOLINE(24)
+APPE_SEQ_TASK_TRAMPOLINE(25)
+APPE_SEQ_TASK_TRAMPOLINE(26)
+APPE_SEQ_TASK_TRAMPOLINE(27)
+APPE_SEQ_TASK_TRAMPOLINE(28)
+APPE_SEQ_TASK_TRAMPOLINE(29)
+APPE_SEQ_TASK_TRAMPOLINE(30)
+APPE_SEQ_TASK_TRAMPOLINE(31)
+
+static void (* const a_APPE_SEQ_Trampoline[APPE_SEQ_TASK_MAX])( void ) =
+{
+  APPE_SEQ_Task0, APPE_SEQ_Task1, APPE_SEQ_Task2, APPE_SEQ_Task3,
+  APPE_SEQ_Task4, APPE_SEQ_Task5, APPE_SEQ_Task6, APPE_SEQ_Task7,
+  APPE_SEQ_Task8, APPE_SEQ_Task9, APPE_SEQ_Task10, APPE_SEQ_Task11,
+  APPE_SEQ_Task12, APPE_SEQ_Task13, APPE_SEQ_Task14, APPE_SEQ_Task15,
+  APPE_SEQ_Task16, APPE_SEQ_Task17, APPE_SEQ_Task18, APPE_SEQ_Task19,
+  APPE_SEQ_Task20, APPE_SEQ_Task21, APPE_SEQ_Task22, APPE_SEQ_Task23,
+  APPE_SEQ_Task24, APPE_SEQ_Task25, APPE_SEQ_Task26, APPE_SEQ_Task27,
+  APPE_SEQ_Task28, APPE_SEQ_Task29, APPE_SEQ_Task30, APPE_SEQ_Task31
+};
+#endif /* APPE_SEQ_TRAMPOLINE */
+
+/**
+ * @brief  Register a sequencer task, as UTIL_SEQ_RegTask() does. When the
+ *         tasks are measured, the sequencer is given the trampoline of each
+ *         task index instead, which runs the task between the measurements.
+ * @param  TaskId_bm: task(s) to register
+ * @param  Flags: UTIL_SEQ_RFU
+ * @param  Task: function of the task(s)
+ * @retval None
+ */
+void APPE_SEQ_RegTask( UTIL_SEQ_bm_t TaskId_bm, uint32_t Flags, void (*Task)( void ) )
+{
+#if (APPE_SEQ_TRAMPOLINE == 1)
+  for (uint32_t index = 0; index < APPE_SEQ_TASK_MAX; index++)
+  {
+    if ((TaskId_bm & (1UL << index)) != 0U)
+    {
+      a_APPE_SEQ_TaskCb[index] = Task;
+      UTIL_SEQ_RegTask(1UL << index, Flags, a_APPE_SEQ_Trampoline[index]);
+    }
+  }
+#else
+  UTIL_SEQ_RegTask(TaskId_bm, Flags, Task);
+#endif /* APPE_SEQ_TRAMPOLINE */
+}
+/* USER CODE END UTIL_SEQ_Task */
+
 void BPKACB_Process( void )
 {
   UTIL_SEQ_SetTask(1U << CFG_TASK_BPKA, CFG_SEQ_PRIO_0);
@@ -606,6 +1130,12 @@ void FM_ProcessRequest (void)
   UTIL_SEQ_SetTask(1U << CFG_TASK_FLASH_MANAGER_BCKGND, CFG_SEQ_PRIO_0);
 }
 
+void SNVMA_ProcessRequest (void)
+{
+  /* Schedule the background process */
+  UTIL_SEQ_SetTask(1U << CFG_TASK_SNVMA_BCKGND, CFG_SEQ_PRIO_0);
+}
+
 #if ((CFG_LOG_SUPPORTED == 0) && (CFG_LPM_LEVEL != 0))
 /* RNG module turn off HSI clock when traces are not used and low power used */
 void RNG_KERNEL_CLK_OFF(void)
@@ -658,5 +1188,34 @@ void UTIL_ADV_TRACE_PostSendHook(void)
 #endif /* (CFG_LOG_SUPPORTED != 0) */
 
 /* USER CODE BEGIN FD_WRAP_FUNCTIONS */
+/**
+ * @brief Callback used by the CRC controller to report or start a CRC job
+ */
+void CRCCTRL_JobProcessReq( void )
+{
+  UTIL_SEQ_SetTask(1U << CFG_TASK_CRC_ID, CFG_SEQ_PRIO_0);
+}
+
+#if (CFG_ENERGY_ACCT_SUPPORTED == 1)
+/**
+ * @brief Callback used by the energy accounting at the end of its periodic
+ *        report: the statistics of the other modules are logged with it
+ */
+void ENERGY_ACCTCB_Report( void )
+{
+  BLE_TIMER_LogStats();
+  APP_BLE_LogRouteStats();
+  BAES_LogStats();
+#if (CFG_BPKA_PAIR_NBR > 0)
+  BPKA_LogStats();
+#endif /* CFG_BPKA_PAIR_NBR */
+#if (CFG_WALL_CLOCK_SUPPORTED == 1)
+  WALL_CLOCK_LogStats();
+#endif /* CFG_WALL_CLOCK_SUPPORTED */
+#if (CFG_CTR_DRBG_SUPPORTED == 1)
+  CTR_DRBG_LogStats();
+#endif /* CFG_CTR_DRBG_SUPPORTED */
+}
+#endif /* CFG_ENERGY_ACCT_SUPPORTED */
 
 /* USER CODE END FD_WRAP_FUNCTIONS */
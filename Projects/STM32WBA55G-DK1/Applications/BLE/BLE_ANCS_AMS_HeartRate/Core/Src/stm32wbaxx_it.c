@@ -27,6 +27,8 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "stm32wba55g_discovery.h"
+#include "crc_ctrl_conf.h"
+#include "app_entry.h"
 /* USER CODE END Includes */
 
 /* External functions --------------------------------------------------------*/
@@ -360,11 +362,25 @@ void ADC4_IRQHandler(void)
 {
   /* USER CODE BEGIN ADC4_IRQn 0 */
 #if (CFG_JOYSTICK_SUPPORTED == 1)
-  BSP_JOY_IRQHandler(JOY1,(JOYPin_TypeDef) 0);
+  APPE_Joystick_IRQHandler();
 #endif /* CFG_JOYSTICK_SUPPORTED */
   /* USER CODE END ADC4_IRQn 0 */
   /* USER CODE BEGIN ADC4_IRQn 1 */
 
   /* USER CODE END ADC4_IRQn 1 */
 }
+
+/**
+  * @brief This function handles GPDMA1 Channel 2 global interrupt.
+  */
+void GPDMA1_Channel2_IRQHandler(void)
+{
+  /* USER CODE BEGIN GPDMA1_Channel2_IRQn 0 */
+
+  /* USER CODE END GPDMA1_Channel2_IRQn 0 */
+  CRCCTRL_DMA_IRQHandler();
+  /* USER CODE BEGIN GPDMA1_Channel2_IRQn 1 */
+
+  /* USER CODE END GPDMA1_Channel2_IRQn 1 */
+}
 /* USER CODE END 1 */
@@ -23,33 +23,65 @@
 #include "dbg_trace.h"
 #include "uuid.h"
 #include "stm32_seq.h"
+#include "app_entry.h"
 #include "dbg_trace.h"
 #include "ble.h"
+#include "stm32_timer.h"
 
 /* Private includes ----------------------------------------------------------*/
 #include "ams_app.h"
 #include "app_menu.h"
+#include "gatt_client_app.h"
 
 /* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  /* Set once the AMS notifications have been requested on the link */
+  bool Active;
+  bool Remote_Cmd_Available[(RemoteCommandID) Nb_of_RemoteCommand];
+  char SingerName[100];
+  char SongName[100];
+  AMS_State_t State;
+  /* Indexed by TrackAttributeID, for the Artist and the Title:
+   * hash of the truncated value whose full value is cached, 0 if none,
+   * and full value reads in flight, only the result of the last one is kept */
+  uint32_t a_TruncatedHash[TrackAttributeIDTitle + 1];
+  uint8_t a_FetchPending[TrackAttributeIDTitle + 1];
+} AMS_Link_t;
+
+/* Value of an entity update, or a field of it, pointing in the notification */
+typedef struct
+{
+  const uint8_t *p_Data;
+  uint16_t Length;
+} AMS_Field_t;
 
 /* Private defines ------------------------------------------------------------*/
+/* Progress bar on the media control page, between brackets */
+#define AMS_PROGRESS_BAR_LENGTH       (11)
+
 #define UNPACK_2_BYTE_PARAMETER(ptr)  \
         (uint16_t)((uint16_t)(*((uint8_t *)ptr))) |   \
         (uint16_t)((((uint16_t)(*((uint8_t *)ptr + 1))) << 8))
 
+/* Largest value parsed, in thousandths, about 24 days as a time */
+#define AMS_MILLI_MAX                 (2000000000UL)
+
 /* Private macros -------------------------------------------------------------*/
+#define AMS_ABS(x)                    (((x) < 0) ? -(x) : (x))
 
 /* Private variables ---------------------------------------------------------*/
-static bool Remote_Cmd_Available[(RemoteCommandID) Nb_of_RemoteCommand] = {false};
-static char SingerName[100] = {0};
-static char SongName[100] = {0};
+static AMS_Link_t a_AmsLink[CFG_BLE_NUM_LINK];
+/* Link shown on the media control page, the one with the latest track update */
+static uint8_t Ams_UiLink;
+/* Links waiting for the AMS notifications request */
+static uint8_t Ams_StartPending;
 static int Sub_SingerIndex;
 static int Sub_SongIndex;
 
 /* Global variables ----------------------------------------------------------*/
 gatt_client_interface_ams_t gatt_client_interface_ams;
-AMS_init_data_t AMS_init_data;
-static int Volume = 0;
+AMS_init_data_t AMS_init_data[CFG_BLE_NUM_LINK];
 extern Menu_Content_Text_t media_text;
 extern Menu_Content_Text_t volume_text;
 extern Menu_Page_t *p_media_control_menu;
@@ -58,11 +90,24 @@ extern Menu_Page_t *p_media_control_menu;
 /* Private function prototypes -----------------------------------------------*/
 /* Used to log notif value */
 static void gatt_client_to_ams(void);
-static void send_gatt_cmd_to_client(AMSCmdToGatt_t, uint16_t, uint8_t, uint8_t*);
+static void send_gatt_cmd_to_client(uint8_t, AMSCmdToGatt_t, uint16_t, uint8_t, uint8_t*);
+static void ams_gatt_cmd_cb(uint8_t Link, uint8_t OpId, GATT_CLIENT_APP_OpStatus_t Status,
+                            const uint8_t *p_Data, uint16_t Length, void *p_Context);
 
 static void AMS_Show_Notif_Entity_Update(void);
+static void AMS_Next_Field(AMS_Field_t *p_Value, AMS_Field_t *p_Field);
+static uint8_t AMS_Parse_Milli(const AMS_Field_t *p_Field, int32_t *p_Milli);
+static void AMS_Copy_Name(const AMS_Field_t *p_Field, char *p_Dst, uint16_t Size);
+static uint32_t AMS_Hash(const AMS_Field_t *p_Field);
+static void AMS_Update_Name(uint8_t Link, TrackAttributeID AttrID, const AMS_Field_t *p_Value, uint8_t Truncated);
+static void ams_entity_attribute_cb(uint8_t Link, uint8_t OpId, GATT_CLIENT_APP_OpStatus_t Status,
+                                    const uint8_t *p_Data, uint16_t Length, void *p_Context);
+static uint32_t AMS_Get_Position(const AMS_State_t *p_State);
+static uint8_t AMS_Ui_Position(void);
 static void AMS_Update_Available_Remote_Cmd(void);
-static void AMS_Retrieve_Value_Cmd(EntityID Entity, uint8_t AttributID);
+static void AMS_Retrieve_Value_Cmd(uint8_t Link, EntityID Entity, TrackAttributeID AttributID);
+static void AMS_Disconnect(uint8_t Link);
+static void AMS_Ui_Refresh(void);
 static void ams_start_notification(void);
 /* Functions Definition ------------------------------------------------------*/
 /**
@@ -72,8 +117,25 @@ static void ams_start_notification(void);
  */
 void AMS_APP_Init(void)
 {
-  UTIL_SEQ_RegTask(1U << CFG_TASK_GATT_CLIENT_TO_AMS_ID, UTIL_SEQ_RFU, gatt_client_to_ams);
-  UTIL_SEQ_RegTask(1U << CFG_TASK_AMS_START_NOTIF_ID, UTIL_SEQ_RFU, ams_start_notification);
+  APPE_SEQ_RegTask(1U << CFG_TASK_GATT_CLIENT_TO_AMS_ID, UTIL_SEQ_RFU, gatt_client_to_ams);
+  APPE_SEQ_RegTask(1U << CFG_TASK_AMS_START_NOTIF_ID, UTIL_SEQ_RFU, ams_start_notification);
+  for (uint8_t link = 0; link < CFG_BLE_NUM_LINK; link++)
+  {
+    AMS_Disconnect(link);
+  }
+  return;
+}
+
+/**
+ * @brief  Request the AMS notifications once the link is discovered
+ * @param  Link: Index of the link
+ * @retval None
+ */
+void AMS_APP_Start(uint8_t Link)
+{
+  a_AmsLink[Link].Active = true;
+  Ams_StartPending |= (1U << Link);
+  UTIL_SEQ_SetTask(1U << CFG_TASK_AMS_START_NOTIF_ID, CFG_SEQ_PRIO_0);
   return;
 }
 
@@ -83,11 +145,11 @@ static void gatt_client_to_ams(void)
   switch ( gatt_client_interface_ams.GattCmdToAMS )
   {
     case AMS_START_NOTIF :
-      UTIL_SEQ_SetTask(1U << CFG_TASK_AMS_START_NOTIF_ID, CFG_SEQ_PRIO_0);
+      AMS_APP_Start(gatt_client_interface_ams.Link);
       break;
     case AMS_INIT_HANDLE:
     {
-      memcpy(&AMS_init_data, gatt_client_interface_ams.p_Payload, gatt_client_interface_ams.l_payload);
+      memcpy(&AMS_init_data[gatt_client_interface_ams.Link], gatt_client_interface_ams.p_Payload, gatt_client_interface_ams.l_payload);
       break;
     }
     case AMS_RECEIVE_NOTIF:
@@ -107,10 +169,7 @@ static void gatt_client_to_ams(void)
   }
   case AMS_DECONNECTION:
   {
-    strcpy(SongName, "    Media    ");
-    strcpy(media_text.Lines[0], "    Media    ");
-    strcpy(SingerName, "   Control   ");
-    strcpy(media_text.Lines[1], "   Control   ");
+    AMS_Disconnect(gatt_client_interface_ams.Link);
     break;
   }  
   default:
@@ -119,10 +178,11 @@ static void gatt_client_to_ams(void)
   UTIL_SEQ_SetEvt(1U << CFG_IDLEEVT_GATT_CMD_TO_AMS_COMPLETE); // This should have been implemented earlier, after data have been processed
 };
 
-static void send_gatt_cmd_to_client(AMSCmdToGatt_t AMSCmdToGatt, uint16_t char_UUID, uint8_t l_payload, uint8_t *p_Payload)
+static void send_gatt_cmd_to_client(uint8_t Link, AMSCmdToGatt_t AMSCmdToGatt, uint16_t char_UUID, uint8_t l_payload, uint8_t *p_Payload)
 {
-  tBleStatus result = BLE_STATUS_SUCCESS;  
+  uint8_t op_id;
   uint16_t CharValueHdle;
+  AMS_init_data_t *p_init_data = &AMS_init_data[Link];
   
   switch ( AMSCmdToGatt )
   {
@@ -130,17 +190,17 @@ static void send_gatt_cmd_to_client(AMSCmdToGatt_t AMSCmdToGatt, uint16_t char_U
     CharValueHdle = 0;
     if ( char_UUID == AMS_ENTITY_ATTRIBUTE_CHAR_UUID)
     {
-      CharValueHdle = *(AMS_init_data.EntityAttributeCharValueHdle);
+      CharValueHdle = *(p_init_data->EntityAttributeCharValueHdle);
       LOG_INFO_APP("Write AMS Entity Attribute Char");
     }
     else if ( char_UUID == AMS_REMOTE_COMMAND_CHAR_UUID)
     {
-      CharValueHdle = *(AMS_init_data.RemoteCommandCharValueHdle);
+      CharValueHdle = *(p_init_data->RemoteCommandCharValueHdle);
       LOG_INFO_APP("Write AMS Remote Command Char");
     }
     else if ( char_UUID == AMS_ENTITY_UPDATE_CHAR_UUID)
     {
-      CharValueHdle = *(AMS_init_data.EntityUpdateCharValueHdle);
+      CharValueHdle = *(p_init_data->EntityUpdateCharValueHdle);
       LOG_INFO_APP("Write AMS Entity Update Char");
     }
     
@@ -149,26 +209,23 @@ static void send_gatt_cmd_to_client(AMSCmdToGatt_t AMSCmdToGatt, uint16_t char_U
       LOG_INFO_APP("PROC_GATT_WRITE_AMS_CHAR failed, UUID=%x not found \n", char_UUID);
       return;
     }
-    result = aci_gatt_write_char_value( *(AMS_init_data.connHdl),
-                        CharValueHdle,
-                        l_payload,
-                        (uint8_t *) p_Payload);        
+    /* Queued, the result is given to ams_gatt_cmd_cb */
+    op_id = GATT_CLIENT_APP_Op_Write(Link, CharValueHdle, l_payload, p_Payload, ams_gatt_cmd_cb, NULL);
     
-    if (result == BLE_STATUS_SUCCESS)
+    if (op_id != GATT_CLIENT_APP_OP_INVALID_ID)
     {
-      LOG_INFO_APP(" Successfully\n");      
-      UTIL_SEQ_WaitEvt(1U << CFG_IDLEEVT_PROC_GATT_COMPLETE);
+      LOG_INFO_APP(" queued as operation %d\n", op_id);      
     }
     else
     {
-      LOG_INFO_APP(" NOT SUCCESSFULLY status = 0x%02X\n", result);
+      LOG_INFO_APP(" NOT queued\n");
     }      
     break;
   case READ_AMS_CHAR:
     CharValueHdle = 0;
     if ( char_UUID == AMS_ENTITY_ATTRIBUTE_CHAR_UUID)
     {
-      CharValueHdle = *(AMS_init_data.EntityAttributeCharValueHdle);
+      CharValueHdle = *(p_init_data->EntityAttributeCharValueHdle);
     }
     if (CharValueHdle == 0)
     {
@@ -176,17 +233,15 @@ static void send_gatt_cmd_to_client(AMSCmdToGatt_t AMSCmdToGatt, uint16_t char_U
       return;
     }    
 
-    result = aci_gatt_read_char_value( *(AMS_init_data.connHdl),
-                                       CharValueHdle);
+    op_id = GATT_CLIENT_APP_Op_Read(Link, CharValueHdle, ams_gatt_cmd_cb, NULL);
     
-    if (result == BLE_STATUS_SUCCESS)
+    if (op_id != GATT_CLIENT_APP_OP_INVALID_ID)
     {
-      UTIL_SEQ_WaitEvt(1U << CFG_IDLEEVT_PROC_GATT_COMPLETE);
-      LOG_INFO_APP("Read AMS Char Successfully | UUID=%x\n\n", char_UUID);
+      LOG_INFO_APP("Read AMS Char queued | UUID=%x\n\n", char_UUID);
     }
     else
     {
-      LOG_INFO_APP("Entity Update cmd NOK status =0x%02X | UUID=%x\n\n", result, char_UUID);
+      LOG_INFO_APP("Entity Update cmd NOT queued | UUID=%x\n\n", char_UUID);
     }
     break;
   default:
@@ -200,20 +255,27 @@ static void send_gatt_cmd_to_client(AMSCmdToGatt_t AMSCmdToGatt, uint16_t char_U
  *************************************************************/
 static void AMS_Show_Notif_Entity_Update(void){
   gatt_client_interface_ams_t *p_Notif = &gatt_client_interface_ams;
+  uint8_t link = p_Notif->Link;
+  AMS_Link_t *p_link = &a_AmsLink[link];
+  AMS_State_t *p_state = &p_link->State;
+  AMS_Field_t value;
+  AMS_Field_t field;
+  int32_t milli;
+
+  /* Entity ID, Attribute ID and Entity Update Flags precede the value */
+  if (p_Notif->l_payload < 3)
+  {
+    LOG_INFO_APP("      [AMS] Entity update too short (%d)\n", p_Notif->l_payload);
+    return;
+  }
+
   EntityID entID = (EntityID) p_Notif->p_Payload[0];
   uint8_t AttrID = p_Notif->p_Payload[1];
   uint8_t TruncatedFlag = p_Notif->p_Payload[2];
-  
-  char Notif_Value[257] = {'\0'};
-  memcpy(Notif_Value, &(p_Notif->p_Payload[3]), p_Notif->l_payload);
-  Notif_Value[p_Notif->l_payload - 3] = '\0'; 
-                 
-  UTIL_SEQ_SetEvt(1U << CFG_IDLEEVT_GATT_CMD_TO_AMS_COMPLETE);  
-    
-  if (TruncatedFlag & ENTITY_UPDATE_FLAG_TRUNCATED)
-  {
-    AMS_Retrieve_Value_Cmd(entID,AttrID);
-  }
+
+  /* The value is parsed in place, it is not NUL terminated */
+  value.p_Data = &(p_Notif->p_Payload[3]);
+  value.Length = p_Notif->l_payload - 3;
 
   switch ( entID )
   {
@@ -221,36 +283,71 @@ static void AMS_Show_Notif_Entity_Update(void){
         switch ( (PlayerAttributeID) AttrID )
         {
           case PlayerAttributeIDName:
-            LOG_INFO_APP("      [AMS] New App Name                     : %s\n", Notif_Value);
+            LOG_INFO_APP("      [AMS] New App Name                     : %.*s\n", value.Length, value.p_Data);
             break;
           case PlayerAttributeIDPlaybackInfo:
-            LOG_INFO_APP("      [AMS] Playback Info                    :"); 
-           switch ( (PlaybackState) (strtok((char *) Notif_Value, ",")[0] - '0'))
-           {
-           case PlaybackStatePaused : 
-             LOG_INFO_APP("     PAUSED      |");
-             break;
-           case PlaybackStatePlaying : 
-             LOG_INFO_APP("     PLAYING     |");
-             break;
-           case PlaybackStateRewinding :
-             LOG_INFO_APP("     REWIDING    |");
-             break;
-           case PlaybackStateFastForwarding :
-             LOG_INFO_APP(" FAST FORWARDING |");
-             break;             
-           default: 
-             LOG_INFO_APP(" Unknown Playback State |");
-             break;             
-           }
-           LOG_INFO_APP(" Play Back Rate : %s |", strtok(NULL, ",")); 
-           LOG_INFO_APP(" Elapsed Time : %s sec \n", strtok(NULL, ","));
+            /* PlaybackState,PlaybackRate,ElapsedTime
+             * The position is rebased now, in case a field is missing */
+            LOG_INFO_APP("      [AMS] Playback Info                    :");
+            p_state->ElapsedTime = AMS_Get_Position(p_state);
+            p_state->ElapsedStamp = UTIL_TIMER_GetCurrentTime();
+            AMS_Next_Field(&value, &field);
+            if (AMS_Parse_Milli(&field, &milli) != 0)
+            {
+              p_state->State = (PlaybackState) (milli / 1000);
+            }
+            switch (p_state->State)
+            {
+            case PlaybackStatePaused : 
+              LOG_INFO_APP("     PAUSED      |");
+              break;
+            case PlaybackStatePlaying : 
+              LOG_INFO_APP("     PLAYING     |");
+              break;
+            case PlaybackStateRewinding :
+              LOG_INFO_APP("     REWIDING    |");
+              break;
+            case PlaybackStateFastForwarding :
+              LOG_INFO_APP(" FAST FORWARDING |");
+              break;             
+            default: 
+              LOG_INFO_APP(" Unknown Playback State |");
+              break;             
+            }
+            AMS_Next_Field(&value, &field);
+            if (AMS_Parse_Milli(&field, &milli) != 0)
+            {
+              p_state->PlaybackRate = milli;
+            }
+            AMS_Next_Field(&value, &field);
+            if ((AMS_Parse_Milli(&field, &milli) != 0) && (milli >= 0))
+            {
+              p_state->ElapsedTime = (uint32_t) milli;
+            }
+            LOG_INFO_APP(" Play Back Rate : %s%d.%03d |",
+                         (p_state->PlaybackRate < 0) ? "-" : "",
+                         (int) (AMS_ABS(p_state->PlaybackRate) / 1000),
+                         (int) (AMS_ABS(p_state->PlaybackRate) % 1000));
+            LOG_INFO_APP(" Elapsed Time : %d.%03d sec \n",
+                         (int) (p_state->ElapsedTime / 1000),
+                         (int) (p_state->ElapsedTime % 1000));
+            /* The position is then extrapolated locally, the phone is not polled */
+            if ((link == Ams_UiLink) && (AMS_Ui_Position() != 0))
+            {
+              UTIL_SEQ_SetTask( 1U << CFG_TASK_MENU_PRINT_ID, CFG_SEQ_PRIO_0);
+            }
             break;
           case PlayerAttributeIDVolume:
-            LOG_INFO_APP("      [AMS] New Volume                       : %s\n", Notif_Value);
-            Volume = (int) (atof(Notif_Value) * 100.0);
-            snprintf(volume_text.Lines[0], 5, "%d%%", Volume);
-            UTIL_SEQ_SetTask( 1U << CFG_TASK_MENU_PRINT_ID, CFG_SEQ_PRIO_0);
+            LOG_INFO_APP("      [AMS] New Volume                       : %.*s\n", value.Length, value.p_Data);
+            if ((AMS_Parse_Milli(&value, &milli) != 0) && (milli >= 0))
+            {
+              p_state->Volume = (uint16_t) MIN(milli, 1000);
+            }
+            if (link == Ams_UiLink)
+            {
+              snprintf(volume_text.Lines[0], 5, "%d%%", (int) ((p_state->Volume + 5) / 10));
+              UTIL_SEQ_SetTask( 1U << CFG_TASK_MENU_PRINT_ID, CFG_SEQ_PRIO_0);
+            }
             break;      
           default:
             LOG_INFO_APP("      [AMS] Unknown Player Attribute ID %d\n", AttrID);
@@ -260,19 +357,32 @@ static void AMS_Show_Notif_Entity_Update(void){
       
       
     case EntityIDQueue:
+        /* All the queue attributes are integers */
+        if ((AMS_Parse_Milli(&value, &milli) == 0) || (milli < 0))
+        {
+          milli = -1000;
+        }
         switch ( (QueueAttributeID ) AttrID )
         {
           case QueueAttributeIDIndex:
-            LOG_INFO_APP("      [AMS] New Queue Attribute Index        : %s\n", Notif_Value);
+            LOG_INFO_APP("      [AMS] New Queue Attribute Index        : %.*s\n", value.Length, value.p_Data);
+            if (milli >= 0)
+            {
+              p_state->QueueIndex = (uint16_t) MIN(milli / 1000, UINT16_MAX);
+            }
             break;
             
           case QueueAttributeIDCount:
-            LOG_INFO_APP("      [AMS] New Queue Attribute Count        : %s\n", Notif_Value);
+            LOG_INFO_APP("      [AMS] New Queue Attribute Count        : %.*s\n", value.Length, value.p_Data);
+            if (milli >= 0)
+            {
+              p_state->QueueCount = (uint16_t) MIN(milli / 1000, UINT16_MAX);
+            }
             break;
             
           case QueueAttributeIDShuffleMode:
             LOG_INFO_APP("      [AMS] New Queue Attribute Shuffle Mode :");
-            switch ( Notif_Value[0] - '0')
+            switch (milli / 1000)
              {
              case SHUFFLE_MODE_OFF : 
                LOG_INFO_APP(" Shuffle Mode Off \n");
@@ -287,11 +397,15 @@ static void AMS_Show_Notif_Entity_Update(void){
                LOG_INFO_APP(" Unknown Shuffle Mode \n");
                break;             
              }
+            if (milli >= 0)
+            {
+              p_state->ShuffleMode = (uint8_t) MIN(milli / 1000, UINT8_MAX);
+            }
             break;
             
           case QueueAttributeIDRepeatMode:
             LOG_INFO_APP("      [AMS] New Queue Attribute Repeat Mode  :");
-            switch ( Notif_Value[0] - '0')
+            switch (milli / 1000)
              {
              case REPEAT_MODE_OFF : 
                LOG_INFO_APP(" Repeat Mode Off \n");
@@ -306,6 +420,10 @@ static void AMS_Show_Notif_Entity_Update(void){
                LOG_INFO_APP(" Unknown Repeat Mode \n");
                break;             
              }            
+            if (milli >= 0)
+            {
+              p_state->RepeatMode = (uint8_t) MIN(milli / 1000, UINT8_MAX);
+            }
             break;
           default:
             LOG_INFO_APP("      [AMS] Unknown Queue Attribute ID %d\n", AttrID);
@@ -315,33 +433,32 @@ static void AMS_Show_Notif_Entity_Update(void){
       
       
     case EntityIDTrack:
-        switch ( (QueueAttributeID ) AttrID )
+        switch ( (TrackAttributeID) AttrID )
         {
           case TrackAttributeIDArtist:
-            LOG_INFO_APP("      [AMS] New Track Attribute Artist       : %s\n", Notif_Value);
-            Sub_SingerIndex = -2;
-            cpy_ext_utf8_data((char *) Notif_Value, SingerName, strlen((char *) Notif_Value) + 1);
-            //strcpy(SingerName, (char *) Notif_Value);
-            strncpy(media_text.Lines[1], SingerName, 13);
-            UTIL_SEQ_SetTask( 1U << CFG_TASK_MENU_PRINT_ID, CFG_SEQ_PRIO_0);
+            LOG_INFO_APP("      [AMS] New Track Attribute Artist       : %.*s\n", value.Length, value.p_Data);
+            AMS_Update_Name(link, TrackAttributeIDArtist, &value, TruncatedFlag & ENTITY_UPDATE_FLAG_TRUNCATED);
             break;
             
           case TrackAttributeIDAlbum:
-            LOG_INFO_APP("      [AMS] New Track Attribute Album        : %s\n", Notif_Value);
+            LOG_INFO_APP("      [AMS] New Track Attribute Album        : %.*s\n", value.Length, value.p_Data);
             break;
             
           case TrackAttributeIDTitle:
-            LOG_INFO_APP("      [AMS] New Track Attribute Title        : %s\n", Notif_Value);
-            Sub_SongIndex = -2;
-            memset(SongName, '\0' , 100);
-            cpy_ext_utf8_data((char *) Notif_Value, SongName, strlen((char *) Notif_Value) + 1);
-            //strcpy(SongName, (char *) Notif_Value);
-            strncpy(media_text.Lines[0], SongName, 13);
-            UTIL_SEQ_SetTask( 1U << CFG_TASK_MENU_PRINT_ID, CFG_SEQ_PRIO_0);
+            LOG_INFO_APP("      [AMS] New Track Attribute Title        : %.*s\n", value.Length, value.p_Data);
+            AMS_Update_Name(link, TrackAttributeIDTitle, &value, TruncatedFlag & ENTITY_UPDATE_FLAG_TRUNCATED);
             break;
             
           case TrackAttributeIDDuration:
-            LOG_INFO_APP("      [AMS] New Track Attribute Duration     : %s\n",Notif_Value);
+            LOG_INFO_APP("      [AMS] New Track Attribute Duration     : %.*s\n", value.Length, value.p_Data);
+            if ((AMS_Parse_Milli(&value, &milli) != 0) && (milli >= 0))
+            {
+              p_state->Duration = (uint32_t) milli;
+            }
+            if ((link == Ams_UiLink) && (AMS_Ui_Position() != 0))
+            {
+              UTIL_SEQ_SetTask( 1U << CFG_TASK_MENU_PRINT_ID, CFG_SEQ_PRIO_0);
+            }
             break;
             
           default:
@@ -357,13 +474,326 @@ static void AMS_Show_Notif_Entity_Update(void){
   }
 }
 
+/**
+ * @brief  Split the next comma separated field off a value
+ * @param  p_Value: Remaining value, consumed up to the comma included
+ * @param  p_Field: Field found, p_Data is NULL once the value is exhausted
+ * @retval None
+ */
+static void AMS_Next_Field(AMS_Field_t *p_Value, AMS_Field_t *p_Field)
+{
+  uint16_t index = 0;
+
+  if (p_Value->p_Data == NULL)
+  {
+    p_Field->p_Data = NULL;
+    p_Field->Length = 0;
+    return;
+  }
+
+  while ((index < p_Value->Length) && (p_Value->p_Data[index] != ','))
+  {
+    index++;
+  }
+  p_Field->p_Data = p_Value->p_Data;
+  p_Field->Length = index;
+
+  if (index < p_Value->Length)
+  {
+    p_Value->p_Data += index + 1;
+    p_Value->Length -= index + 1;
+  }
+  else
+  {
+    p_Value->p_Data = NULL;
+    p_Value->Length = 0;
+  }
+}
+
+/**
+ * @brief  Parse a decimal number, as "-12.345", into thousandths
+ * @param  p_Field: Field to parse, not NUL terminated
+ * @param  p_Milli: Value in thousandths, saturated to +/-AMS_MILLI_MAX
+ * @retval 1 if the field is a number, 0 otherwise
+ */
+static uint8_t AMS_Parse_Milli(const AMS_Field_t *p_Field, int32_t *p_Milli)
+{
+  const uint8_t *p_data = p_Field->p_Data;
+  uint16_t length = p_Field->Length;
+  uint16_t index = 0;
+  uint32_t integer = 0;
+  uint32_t fraction = 0;
+  uint8_t nb_frac = 0;
+  uint8_t nb_digits = 0;
+  bool negative = false;
+
+  if (p_data == NULL)
+  {
+    return 0;
+  }
+
+  if ((index < length) && ((p_data[index] == '-') || (p_data[index] == '+')))
+  {
+    negative = (p_data[index] == '-');
+    index++;
+  }
+  while ((index < length) && (p_data[index] >= '0') && (p_data[index] <= '9'))
+  {
+    if (integer <= (AMS_MILLI_MAX / 1000))
+    {
+      integer = integer * 10 + (p_data[index] - '0');
+    }
+    nb_digits++;
+    index++;
+  }
+  if ((index < length) && (p_data[index] == '.'))
+  {
+    index++;
+    while ((index < length) && (p_data[index] >= '0') && (p_data[index] <= '9'))
+    {
+      /* Digits beyond the thousandth are dropped */
+      if (nb_frac < 3)
+      {
+        fraction = fraction * 10 + (p_data[index] - '0');
+        nb_frac++;
+      }
+      nb_digits++;
+      index++;
+    }
+  }
+  if ((nb_digits == 0) || (index != length))
+  {
+    return 0;
+  }
+
+  for (; nb_frac < 3; nb_frac++)
+  {
+    fraction *= 10;
+  }
+  if (integer > (AMS_MILLI_MAX / 1000))
+  {
+    integer = AMS_MILLI_MAX / 1000;
+    fraction = 0;
+  }
+  *p_Milli = (int32_t) (integer * 1000 + fraction);
+  if (negative)
+  {
+    *p_Milli = -*p_Milli;
+  }
+
+  return 1;
+}
+
+/**
+ * @brief  Copy a track name field for the display, truncated to the buffer
+ * @param  p_Field: Field to copy, UTF-8, not NUL terminated
+ * @param  p_Dst: Destination, NUL terminated
+ * @param  Size: Size of the destination
+ * @retval None
+ */
+static void AMS_Copy_Name(const AMS_Field_t *p_Field, char *p_Dst, uint16_t Size)
+{
+  memset(p_Dst, '\0', Size);
+  /* cpy_ext_utf8_data writes at most one character per input byte, and drops a code point cut by the truncation */
+  cpy_ext_utf8_data((char *) p_Field->p_Data, p_Dst, MIN(p_Field->Length, Size - 1));
+}
+
+/**
+ * @brief  FNV-1a hash of a field, to recognize a truncated value already seen
+ * @param  p_Field: Field to hash
+ * @retval Hash, never 0
+ */
+static uint32_t AMS_Hash(const AMS_Field_t *p_Field)
+{
+  uint32_t hash = 2166136261UL;
+
+  for (uint16_t index = 0; index < p_Field->Length; index++)
+  {
+    hash ^= p_Field->p_Data[index];
+    hash *= 16777619UL;
+  }
+
+  return (hash != 0) ? hash : 1;
+}
+
+/**
+ * @brief  Update the Artist or the Title of a link
+ *         A truncated value is shown until its full value has been read. The
+ *         full value is read once per track: the phone sends the same
+ *         truncated value again on each update of the track entity.
+ * @param  Link: Index of the link
+ * @param  AttrID: TrackAttributeIDArtist or TrackAttributeIDTitle
+ * @param  p_Value: Value received
+ * @param  Truncated: Non zero if the value has been truncated by the phone
+ * @retval None
+ */
+static void AMS_Update_Name(uint8_t Link, TrackAttributeID AttrID, const AMS_Field_t *p_Value, uint8_t Truncated)
+{
+  AMS_Link_t *p_link = &a_AmsLink[Link];
+  char *p_name = (AttrID == TrackAttributeIDArtist) ? p_link->SingerName : p_link->SongName;
+  uint32_t hash = 0;
+
+  if (Truncated != 0)
+  {
+    hash = AMS_Hash(p_Value);
+    if (hash == p_link->a_TruncatedHash[AttrID])
+    {
+      LOG_INFO_APP("      [AMS] Full value cached\n");
+      if (Link != Ams_UiLink)
+      {
+        Ams_UiLink = Link;
+        AMS_Ui_Refresh();
+      }
+      return;
+    }
+  }
+
+  p_link->a_TruncatedHash[AttrID] = hash;
+  AMS_Copy_Name(p_Value, p_name, sizeof(p_link->SongName));
+  if (Truncated != 0)
+  {
+    AMS_Retrieve_Value_Cmd(Link, EntityIDTrack, AttrID);
+  }
+
+  /* The media control page follows the phone playing the latest track */
+  Ams_UiLink = Link;
+  AMS_Ui_Refresh();
+}
+
+/**
+ * @brief  Result of the read of the Entity Attribute characteristic
+ * @param  Link: Index of the link
+ * @param  OpId: Identifier of the read
+ * @param  Status: Status of the read
+ * @param  p_Data: Full value of the attribute
+ * @param  Length: Length of the value
+ * @param  p_Context: TrackAttributeID of the value
+ * @retval None
+ */
+static void ams_entity_attribute_cb(uint8_t Link, uint8_t OpId, GATT_CLIENT_APP_OpStatus_t Status,
+                                    const uint8_t *p_Data, uint16_t Length, void *p_Context)
+{
+  AMS_Link_t *p_link = &a_AmsLink[Link];
+  TrackAttributeID attr = (TrackAttributeID) (uintptr_t) p_Context;
+  AMS_Field_t value;
+
+  if (p_link->a_FetchPending[attr] > 0)
+  {
+    p_link->a_FetchPending[attr]--;
+  }
+  /* Superseded by a later update of the same attribute */
+  if ((p_link->Active != true) ||
+      (p_link->a_FetchPending[attr] != 0) ||
+      (p_link->a_TruncatedHash[attr] == 0))
+  {
+    return;
+  }
+  if (Status != GATT_CLIENT_APP_OP_SUCCESS)
+  {
+    LOG_INFO_APP("AMS link %d operation %d NOK status =%d\n", Link, OpId, Status);
+    /* Fetched again on the next update */
+    p_link->a_TruncatedHash[attr] = 0;
+    return;
+  }
+
+  value.p_Data = p_Data;
+  value.Length = Length;
+  LOG_INFO_APP("      [AMS] Full Track Attribute %d          : %.*s\n", attr, value.Length, value.p_Data);
+  AMS_Copy_Name(&value,
+                (attr == TrackAttributeIDArtist) ? p_link->SingerName : p_link->SongName,
+                sizeof(p_link->SongName));
+  if (Link == Ams_UiLink)
+  {
+    AMS_Ui_Refresh();
+  }
+}
+
+/**
+ * @brief  Extrapolate the playback position from the last Playback Info
+ * @param  p_State: Media state of the link
+ * @retval Position in ms, bounded by the track duration when known
+ */
+static uint32_t AMS_Get_Position(const AMS_State_t *p_State)
+{
+  int64_t position = p_State->ElapsedTime;
+
+  /* The rate is 0 when paused, negative when rewinding */
+  position += ((int64_t) UTIL_TIMER_GetElapsedTime(p_State->ElapsedStamp) * p_State->PlaybackRate) / 1000;
+  if (position < 0)
+  {
+    position = 0;
+  }
+  if ((p_State->Duration != 0) && (position > p_State->Duration))
+  {
+    position = p_State->Duration;
+  }
+
+  return (uint32_t) position;
+}
+
+/**
+ * @brief  Format the position and the progress bar of the media control page
+ * @param  None
+ * @retval 1 if the text has changed and must be redrawn, 0 otherwise
+ */
+static uint8_t AMS_Ui_Position(void)
+{
+  AMS_Link_t *p_link = &a_AmsLink[Ams_UiLink];
+  char time_line[MENU_CONTROL_MAX_LINE_LEN] = {'\0'};
+  char bar_line[MENU_CONTROL_MAX_LINE_LEN] = {'\0'};
+  uint32_t position;
+  uint32_t duration;
+  uint32_t filled = 0;
+  uint8_t changed = 0;
+
+  if (p_link->Active == true)
+  {
+    /* Shown to the second, it is redrawn only when the second changes */
+    position = AMS_Get_Position(&p_link->State) / 1000;
+    duration = p_link->State.Duration / 1000;
+    if (duration != 0)
+    {
+      snprintf(time_line, sizeof(time_line), "%d:%02d / %d:%02d",
+               (int) (position / 60), (int) (position % 60),
+               (int) (duration / 60), (int) (duration % 60));
+      filled = (position * AMS_PROGRESS_BAR_LENGTH) / duration;
+    }
+    else
+    {
+      snprintf(time_line, sizeof(time_line), "%d:%02d", (int) (position / 60), (int) (position % 60));
+    }
+    bar_line[0] = '[';
+    memset(&bar_line[1], '=', filled);
+    memset(&bar_line[1 + filled], '-', AMS_PROGRESS_BAR_LENGTH - filled);
+    bar_line[AMS_PROGRESS_BAR_LENGTH + 1] = ']';
+    bar_line[AMS_PROGRESS_BAR_LENGTH + 2] = '\0';
+  }
+
+  if (strcmp(media_text.Lines[2], time_line) != 0)
+  {
+    strcpy(media_text.Lines[2], time_line);
+    changed = 1;
+  }
+  if (strcmp(media_text.Lines[3], bar_line) != 0)
+  {
+    strcpy(media_text.Lines[3], bar_line);
+    changed = 1;
+  }
+
+  return changed;
+}
+
 static void AMS_Update_Available_Remote_Cmd(void)
 {
   gatt_client_interface_ams_t *p_Notif = &gatt_client_interface_ams;
-  memset(Remote_Cmd_Available, false, (RemoteCommandID) Nb_of_RemoteCommand);
+  AMS_Link_t *p_link = &a_AmsLink[p_Notif->Link];
+  memset(p_link->Remote_Cmd_Available, false, (RemoteCommandID) Nb_of_RemoteCommand);
   for (uint8_t index = 0; index < p_Notif->l_payload; index++)
   {
-    Remote_Cmd_Available[p_Notif->p_Payload[index]] = true;
+    if (p_Notif->p_Payload[index] < Nb_of_RemoteCommand)
+    {
+      p_link->Remote_Cmd_Available[p_Notif->p_Payload[index]] = true;
+    }
   }
  
   UTIL_SEQ_SetEvt(1U << CFG_IDLEEVT_GATT_CMD_TO_AMS_COMPLETE);
@@ -372,53 +802,142 @@ static void AMS_Update_Available_Remote_Cmd(void)
 static void ams_start_notification(void)
 {
   uint8_t CmdStartNotification[5] = {0, 0, 1, 2, 3};
-  LOG_INFO_APP("AMS request player notification --> ");
-  send_gatt_cmd_to_client(WRITE_AMS_CHAR, AMS_ENTITY_UPDATE_CHAR_UUID, 4, &(CmdStartNotification[0]));
-  
-  LOG_INFO_APP("AMS request queue notification --> ");
-  CmdStartNotification[0] = 1;
-  send_gatt_cmd_to_client(WRITE_AMS_CHAR, AMS_ENTITY_UPDATE_CHAR_UUID, 5, &(CmdStartNotification[0]));
-  
-  LOG_INFO_APP("AMS request AMS track notification --> ");
-  CmdStartNotification[0] = 2;
-  send_gatt_cmd_to_client(WRITE_AMS_CHAR, AMS_ENTITY_UPDATE_CHAR_UUID, 5, &(CmdStartNotification[0]));
+
+  /* The writes are queued on each link, the links do not wait for each other */
+  for (uint8_t link = 0; link < CFG_BLE_NUM_LINK; link++)
+  {
+    if ((Ams_StartPending & (1U << link)) != 0)
+    {
+      Ams_StartPending &= ~(1U << link);
+
+      LOG_INFO_APP("AMS link %d request player notification --> ", link);
+      CmdStartNotification[0] = 0;
+      send_gatt_cmd_to_client(link, WRITE_AMS_CHAR, AMS_ENTITY_UPDATE_CHAR_UUID, 4, &(CmdStartNotification[0]));
+      
+      LOG_INFO_APP("AMS link %d request queue notification --> ", link);
+      CmdStartNotification[0] = 1;
+      send_gatt_cmd_to_client(link, WRITE_AMS_CHAR, AMS_ENTITY_UPDATE_CHAR_UUID, 5, &(CmdStartNotification[0]));
+      
+      LOG_INFO_APP("AMS link %d request AMS track notification --> ", link);
+      CmdStartNotification[0] = 2;
+      send_gatt_cmd_to_client(link, WRITE_AMS_CHAR, AMS_ENTITY_UPDATE_CHAR_UUID, 5, &(CmdStartNotification[0]));
+    }
+  }
+}
+
+static void ams_gatt_cmd_cb(uint8_t Link, uint8_t OpId, GATT_CLIENT_APP_OpStatus_t Status,
+                            const uint8_t *p_Data, uint16_t Length, void *p_Context)
+{
+  UNUSED(p_Data);
+  UNUSED(Length);
+  UNUSED(p_Context);
+
+  if (Status != GATT_CLIENT_APP_OP_SUCCESS)
+  {
+    LOG_INFO_APP("AMS link %d operation %d NOK status =%d\n", Link, OpId, Status);
+  }
 }
 
 void AMS_Remote_Cmd(RemoteCommandID RemoteCommand)
 {
-  if (Remote_Cmd_Available[RemoteCommand] != true)
+  /* Commands go to the phone shown on the media control page */
+  if ((a_AmsLink[Ams_UiLink].Active != true) ||
+      (a_AmsLink[Ams_UiLink].Remote_Cmd_Available[RemoteCommand] != true))
   {
     LOG_INFO_APP("This Remote Command isn't available on that app\n");
     return;
   }
   uint8_t RemoteCmdAtt = RemoteCommand;
-  LOG_INFO_APP("AMS command --> ");
-  send_gatt_cmd_to_client(WRITE_AMS_CHAR, AMS_REMOTE_COMMAND_CHAR_UUID, 1, &RemoteCmdAtt);
+  LOG_INFO_APP("AMS link %d command --> ", Ams_UiLink);
+  send_gatt_cmd_to_client(Ams_UiLink, WRITE_AMS_CHAR, AMS_REMOTE_COMMAND_CHAR_UUID, 1, &RemoteCmdAtt);
 }
 
-static void AMS_Retrieve_Value_Cmd(EntityID Entity, uint8_t AttributID)
+static void AMS_Retrieve_Value_Cmd(uint8_t Link, EntityID Entity, TrackAttributeID AttributID)
 {
   uint8_t EntityCmdAtt[2] = {Entity, AttributID};
+  uint16_t CharValueHdle = *(AMS_init_data[Link].EntityAttributeCharValueHdle);
+
   LOG_INFO_APP("AMS retrieve value --> ");
-  send_gatt_cmd_to_client(WRITE_AMS_CHAR, AMS_ENTITY_ATTRIBUTE_CHAR_UUID, 2, EntityCmdAtt);
+  send_gatt_cmd_to_client(Link, WRITE_AMS_CHAR, AMS_ENTITY_ATTRIBUTE_CHAR_UUID, 2, EntityCmdAtt);
+
+  /* Queued after the write on the link, the long read returns the full value */
+  if ((CharValueHdle != 0) &&
+      (GATT_CLIENT_APP_Op_Read_Long(Link, CharValueHdle, ams_entity_attribute_cb,
+                                    (void *) (uintptr_t) AttributID) != GATT_CLIENT_APP_OP_INVALID_ID))
+  {
+    a_AmsLink[Link].a_FetchPending[AttributID]++;
+  }
 }
 
-void ams_update_singer_song_name(void)
+static void AMS_Disconnect(uint8_t Link)
+{
+  AMS_Link_t *p_link = &a_AmsLink[Link];
+
+  p_link->Active = false;
+  Ams_StartPending &= ~(1U << Link);
+  memset(p_link->Remote_Cmd_Available, false, (RemoteCommandID) Nb_of_RemoteCommand);
+  strcpy(p_link->SongName, "    Media    ");
+  strcpy(p_link->SingerName, "   Control   ");
+  memset(&p_link->State, 0, sizeof(p_link->State));
+  memset(p_link->a_TruncatedHash, 0, sizeof(p_link->a_TruncatedHash));
+  memset(p_link->a_FetchPending, 0, sizeof(p_link->a_FetchPending));
+
+  if (Link == Ams_UiLink)
+  {
+    /* Show another phone still connected, if any */
+    for (uint8_t link = 0; link < CFG_BLE_NUM_LINK; link++)
+    {
+      if (a_AmsLink[link].Active == true)
+      {
+        Ams_UiLink = link;
+        break;
+      }
+    }
+    AMS_Ui_Refresh();
+  }
+}
+
+static void AMS_Ui_Refresh(void)
+{
+  AMS_Link_t *p_link = &a_AmsLink[Ams_UiLink];
+
+  Sub_SongIndex = -2;
+  Sub_SingerIndex = -2;
+  strncpy(media_text.Lines[0], p_link->SongName, 13);
+  strncpy(media_text.Lines[1], p_link->SingerName, 13);
+  AMS_Ui_Position();
+  UTIL_SEQ_SetTask( 1U << CFG_TASK_MENU_PRINT_ID, CFG_SEQ_PRIO_0);
+}
+
+/**
+ * @brief  Scroll the long track names and update the position, on each screen refresh
+ * @param  None
+ * @retval 1 if the media control page is shown and its text has changed, 0 otherwise
+ */
+uint8_t ams_update_singer_song_name(void)
 {
   Menu_Page_t *Current_Menu = Menu_GetActivePage();
+  char *SongName = a_AmsLink[Ams_UiLink].SongName;
+  char *SingerName = a_AmsLink[Ams_UiLink].SingerName;
+  uint8_t changed = 0;
+
   if (Current_Menu == p_media_control_menu)
   {
+    changed = AMS_Ui_Position();
+
     uint8_t refresh_index = (strlen(SongName) > strlen(SingerName)) ? strlen(SongName) : strlen(SingerName) ;
     if (strlen(SongName) > 13)
     {
       if ((Sub_SongIndex >= 0) && (Sub_SongIndex + 13 <= strlen(SongName)))
       {
         strncpy(media_text.Lines[0], &(SongName[Sub_SongIndex]), 13);
+        changed = 1;
       }
       else if (Sub_SongIndex + 10 == refresh_index)
       {
         Sub_SongIndex = -2;
         strncpy(media_text.Lines[0], SongName, 13);
+        changed = 1;
       }  
       Sub_SongIndex++;
     }
@@ -428,13 +947,17 @@ void ams_update_singer_song_name(void)
       if ((Sub_SingerIndex >= 0) && (Sub_SingerIndex + 13 <= strlen(SingerName)))
       {
         strncpy(media_text.Lines[1], &(SingerName[Sub_SingerIndex]), 13);
+        changed = 1;
       }
       else if (Sub_SingerIndex + 10 == refresh_index)
       {
         Sub_SingerIndex = -2;
         strncpy(media_text.Lines[1], SingerName, 13);
+        changed = 1;
       }  
       Sub_SingerIndex++;
     }
   }
+
+  return changed;
 }
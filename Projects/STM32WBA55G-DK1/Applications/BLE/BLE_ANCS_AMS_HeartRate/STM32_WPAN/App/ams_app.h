@@ -57,6 +57,7 @@ typedef struct{
 
 typedef struct{
   GattCmdToAMS_t GattCmdToAMS;
+  uint8_t Link;
   uint16_t char_UUID;
   uint8_t l_payload;
   uint8_t p_Payload[MAX_DATA_LENGTH_TO_ANCS];
@@ -159,7 +160,26 @@ typedef enum {
 } TrackAttributeID;
 
 /* USER CODE BEGIN ET */
-
+/**
+  * Media state of a phone, as parsed from the entity updates.
+  * The AMS values are decimal strings, they are kept in fixed point:
+  * rates and volume in thousandths, times in milliseconds.
+  * ElapsedStamp is the local time ElapsedTime has been received at, the
+  * position is extrapolated from it with PlaybackRate.
+  */
+typedef struct
+{
+  PlaybackState State;
+  int32_t       PlaybackRate;
+  uint32_t      ElapsedTime;
+  uint32_t      ElapsedStamp;
+  uint32_t      Duration;
+  uint16_t      Volume;
+  uint16_t      QueueIndex;
+  uint16_t      QueueCount;
+  uint8_t       ShuffleMode;
+  uint8_t       RepeatMode;
+} AMS_State_t;
 /* USER CODE END ET */
 
 /* Exported constants --------------------------------------------------------*/
@@ -181,10 +201,11 @@ typedef enum {
 
 /* USER CODE BEGIN EFP */
 void AMS_APP_Init(void);
+void AMS_APP_Start(uint8_t Link);
 void start_ams_notif(void);
 void AMS_Remote_Cmd(RemoteCommandID RemoteCommand);
 
-void ams_update_singer_song_name(void);
+uint8_t ams_update_singer_song_name(void);
 /* USER CODE END EFP */
 
 
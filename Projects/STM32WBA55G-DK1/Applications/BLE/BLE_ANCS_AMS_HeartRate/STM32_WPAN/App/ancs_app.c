@@ -23,9 +23,11 @@
 #include "dbg_trace.h"
 #include "uuid.h"
 #include "stm32_seq.h"
+#include "app_entry.h"
 #include "ble.h"
 #include "stm32_timer.h"
 #include "ancs_app.h"
+#include "gatt_client_app.h"
 #include "app_menu.h"
 /* Private includes ----------------------------------------------------------*/
 
@@ -57,7 +59,7 @@ static UTIL_TIMER_Object_t Wait_Notification_Init_Id;
 
 /* Global variables ----------------------------------------------------------*/
 gatt_client_interface_ancs_t gatt_client_interface_ancs;
-ANCS_init_data_t ANCS_init_data;
+ANCS_init_data_t ANCS_init_data[CFG_BLE_NUM_LINK];
 
 extern Menu_Content_Text_t notif_display_text;
 extern Menu_Content_Text_t notif_control_text;
@@ -71,7 +73,9 @@ extern Menu_Icon_t answer_call_icon;
 /* Private function prototypes -----------------------------------------------*/
 /* Used to log notif value */
 static void gatt_client_to_ancs(void);
-static void send_gatt_cmd_to_client(ANCSCmdToGatt_t, uint16_t, uint8_t, uint8_t*);
+static uint8_t send_gatt_cmd_to_client(uint8_t, ANCSCmdToGatt_t, uint16_t, uint8_t, uint8_t*);
+static void ancs_gatt_cmd_cb(uint8_t Link, uint8_t OpId, GATT_CLIENT_APP_OpStatus_t Status,
+                             const uint8_t *p_Data, uint16_t Length, void *p_Context);
 
 static void ANCS_Show_Notif_Source_Update(void);
 static void ANCS_Show_Notif_Data_Source(void);
@@ -82,7 +86,7 @@ static void ANCS_Display_Notif(Notif_List_t *Notif);
 static void ANCS_Display_Notif_List(void);
 static void ANCS_Display_App_Name_List(void);
 
-static Notif_List_t *retrieve_notif_in_list_UID(tListNode *Notif_HeadList, uint32_t UID);
+static Notif_List_t *retrieve_notif_in_list_UID(tListNode *Notif_HeadList, uint8_t Link, uint32_t UID);
 static void Update_AppName(tListNode *Notif_HeadList, char *, uint16_t, char *, uint16_t);
 static uint8_t retrieve_notif_index(tListNode *Node);
 
@@ -96,8 +100,8 @@ static void Wait_Notification_Init_cb(void *arg);
 void ANCS_APP_Init(void)
 {
   
-  UTIL_SEQ_RegTask(1U << CFG_TASK_GATT_CLIENT_TO_ANCS_ID, UTIL_SEQ_RFU, gatt_client_to_ancs);
-  UTIL_SEQ_RegTask(1U << CFG_TASK_ANCS_GET_DETAIL_ID, UTIL_SEQ_RFU, ANCS_get_detail);
+  APPE_SEQ_RegTask(1U << CFG_TASK_GATT_CLIENT_TO_ANCS_ID, UTIL_SEQ_RFU, gatt_client_to_ancs);
+  APPE_SEQ_RegTask(1U << CFG_TASK_ANCS_GET_DETAIL_ID, UTIL_SEQ_RFU, ANCS_get_detail);
   reset_app_name_list();
   LST_init_head(&Notif_HeadList);
   
@@ -116,7 +120,7 @@ static void gatt_client_to_ancs(void)
   {
   case ANCS_INIT_HANDLE:
   {
-    memcpy(&ANCS_init_data, gatt_client_interface_ancs.p_Payload, gatt_client_interface_ancs.l_payload);
+    memcpy(&ANCS_init_data[gatt_client_interface_ancs.Link], gatt_client_interface_ancs.p_Payload, gatt_client_interface_ancs.l_payload);
     break;
   }    
   case ANCS_RECEIVE_NOTIF:
@@ -135,11 +139,20 @@ static void gatt_client_to_ancs(void)
      }
     break;   
   case ANCS_DECONNECTION :
+    /* Only the notifications of the disconnected phone are dropped */
     for (uint8_t index = 0; index < MAX_NBR_OF_NOTIF; index++)
     {
-      removed_notif(&(Notif_List[index]));
+      if ( ((List_used & (1 << index)) != 0) &&
+           (Notif_List[index].Link == gatt_client_interface_ancs.Link) )
+      {
+        if (Notif_Displayed == &Notif_List[index])
+        {
+          Notif_Displayed = NULL;
+        }
+        removed_notif(&(Notif_List[index]));
+      }
     }
-    ANCS_init_data.app_init = false;
+    ANCS_init_data[gatt_client_interface_ancs.Link].app_init = false;
     break;
   default:
     break;
@@ -148,10 +161,11 @@ static void gatt_client_to_ancs(void)
   return;
 };
 
-static void send_gatt_cmd_to_client(ANCSCmdToGatt_t ANCSCmdToGatt, uint16_t char_UUID, uint8_t l_payload, uint8_t *p_Payload)
+static uint8_t send_gatt_cmd_to_client(uint8_t Link, ANCSCmdToGatt_t ANCSCmdToGatt, uint16_t char_UUID, uint8_t l_payload, uint8_t *p_Payload)
 {
-  tBleStatus result = BLE_STATUS_SUCCESS;  
+  uint8_t op_id = GATT_CLIENT_APP_OP_INVALID_ID;
   uint16_t CharValueHdle;
+  ANCS_init_data_t *p_init_data = &ANCS_init_data[Link];
   
   switch ( ANCSCmdToGatt )
   {
@@ -159,35 +173,49 @@ static void send_gatt_cmd_to_client(ANCSCmdToGatt_t ANCSCmdToGatt, uint16_t char
     CharValueHdle = 0;
       if ( char_UUID == ANCS_CONTROL_POINT_CHAR_UUID)
       {
-        CharValueHdle = *(ANCS_init_data.CtrlPointCharValueHdle);
+        CharValueHdle = *(p_init_data->CtrlPointCharValueHdle);
         LOG_INFO_APP("Write ANCS Control Point Char");
       }
       
       if (CharValueHdle == 0)
       {
         LOG_INFO_APP("PROC_GATT_WRITE_ANCS_CHAR failed, UUID=%x not found \n", char_UUID);
-        return;
+        return op_id;
       }
     
-      result = aci_gatt_write_char_value( *(ANCS_init_data.connHdl),
-                          CharValueHdle,
-                          l_payload,
-                          (uint8_t *) p_Payload);        
+      /* Queued, the result is given to ancs_gatt_cmd_cb */
+      op_id = GATT_CLIENT_APP_Op_Write(Link, CharValueHdle, l_payload, p_Payload, ancs_gatt_cmd_cb, NULL);
       
-      if (result == BLE_STATUS_SUCCESS)
+      if (op_id != GATT_CLIENT_APP_OP_INVALID_ID)
       {
-        LOG_INFO_APP(" Successfully\n");
-        UTIL_SEQ_WaitEvt(1U << CFG_IDLEEVT_PROC_GATT_COMPLETE);
+        LOG_INFO_APP(" queued as operation %d\n", op_id);
       }
       else
       {
-        LOG_INFO_APP(" NOT SUCCESSFULLY status =0x%02X\n", result);
+        LOG_INFO_APP(" NOT queued\n");
       }    
     break;
   default:
     break;
   }
+  return op_id;
 };
+
+static void ancs_gatt_cmd_cb(uint8_t Link, uint8_t OpId, GATT_CLIENT_APP_OpStatus_t Status,
+                             const uint8_t *p_Data, uint16_t Length, void *p_Context)
+{
+  UNUSED(p_Data);
+  UNUSED(Length);
+  UNUSED(p_Context);
+
+  if (Status != GATT_CLIENT_APP_OP_SUCCESS)
+  {
+    LOG_INFO_APP("ANCS link %d operation %d NOK status =%d\n", Link, OpId, Status);
+  }
+  /* A slot is free in the queue of the link, for the details not requested yet */
+  UTIL_SEQ_SetTask(1U << CFG_TASK_ANCS_GET_DETAIL_ID, CFG_SEQ_PRIO_0);
+  return;
+}
 /*************************************************************
  *
  * LOCAL FUNCTIONS
@@ -229,6 +257,7 @@ static void ANCS_Show_Notif_Source_Update(void)
           //LOG_INFO_APP(" List_used add : %d --> index %d\n", List_used, Notif_index);
           LST_insert_tail(&Notif_HeadList, &Notif_List[Notif_index].Node);
           Notif = &Notif_List[Notif_index];
+          Notif->Link = p_Notif->Link;
           break;
         }
       }
@@ -238,7 +267,7 @@ static void ANCS_Show_Notif_Source_Update(void)
     case EventIDNotificationModified:
     {
       LOG_INFO_APP("New Notif modified");
-      Notif = retrieve_notif_in_list_UID(&Notif_HeadList, NotificationUID);
+      Notif = retrieve_notif_in_list_UID(&Notif_HeadList, p_Notif->Link, NotificationUID);
       if (Notif == NULL)
       {
         LOG_INFO_APP("Erreur : Impossible to retrieve the Notif with UID : %x\n",NotificationUID);
@@ -250,7 +279,7 @@ static void ANCS_Show_Notif_Source_Update(void)
       
     case EventIDNotificationRemoved:
     {
-      Notif = retrieve_notif_in_list_UID(&Notif_HeadList, NotificationUID);
+      Notif = retrieve_notif_in_list_UID(&Notif_HeadList, p_Notif->Link, NotificationUID);
       if (Notif == NULL)
       {
         LOG_INFO_APP("Erreur : Impossible to retrieve the Notif with UID : %x\n",NotificationUID);
@@ -362,7 +391,7 @@ static void ANCS_Show_Notif_Source_Update(void)
     Notif->retrieve_more_data_flag = true;
     Notif->Data_To_retrieve = CommandIDGetNotificationAttributes; 
 
-    if (ANCS_init_data.app_init == false)
+    if (ANCS_init_data[Notif->Link].app_init == false)
     {
       UTIL_TIMER_Start(&Wait_Notification_Init_Id);
     }
@@ -443,8 +472,8 @@ static void ANCS_Show_Notif_Data_Source(void)
                                            ((uint32_t) p_Notif->p_Payload[p_index]) );
     p_index += 4;
     
-    Notif = retrieve_notif_in_list_UID(&Notif_HeadList, NotificationUID);
-    if (Notif->UID == RESET_UID)
+    Notif = retrieve_notif_in_list_UID(&Notif_HeadList, p_Notif->Link, NotificationUID);
+    if ((Notif == NULL) || (Notif->UID == RESET_UID))
     {
       LOG_INFO_APP("Unknown UID : %d\n",NotificationUID);
       return;
@@ -591,13 +620,23 @@ static void ANCS_get_detail(void)
   uint8_t tab[MAX_CHAR_LENGTH + 3] = {'\0'};           //Max size happens for CommandIDGetAppAttributes => App ID length = MAX_CHAR_LENGTH + '\0' + command ID + Attribut ID
                                                        //                                                    Nb of bytes = MAX_CHAR_LENGTH +  1   +     1      +      1
   uint8_t AppID_size;
+  uint8_t link;
+  uint8_t op_id;
+  bool wait_init = false;
   
   for (index = 0; index < MAX_NBR_OF_NOTIF; index ++)  //Retrieve the detail for all notif
   {
     if ( (List_used >> index) & 1)                     //Retrieve the detail for the activ notif only
     {
-      if (Notif_List[index].retrieve_more_data_flag == true)
+      link = Notif_List[index].Link;
+      if ((Notif_List[index].retrieve_more_data_flag == true) && (ANCS_init_data[link].app_init == false))
       {
+        /* Notifications of a phone not yet discovered are retrieved later */
+        wait_init = true;
+      }
+      else if (Notif_List[index].retrieve_more_data_flag == true)
+      {
+        op_id = GATT_CLIENT_APP_OP_INVALID_ID;
         if (Notif_List[index].Data_To_retrieve == CommandIDGetNotificationAttributes)
         {
           tab[0]  = CommandIDGetNotificationAttributes;
@@ -618,7 +657,7 @@ static void ANCS_get_detail(void)
           tab[16] = NotificationAttributeIDNegativeActionLabel;
           
           LOG_INFO_APP("ANCS retrieve notif data --> ");
-          send_gatt_cmd_to_client(WRITE_ANCS_CHAR, ANCS_CONTROL_POINT_CHAR_UUID, 17, tab);
+          op_id = send_gatt_cmd_to_client(link, WRITE_ANCS_CHAR, ANCS_CONTROL_POINT_CHAR_UUID, 17, tab);
         }
         else if (Notif_List[index].Data_To_retrieve == CommandIDGetAppAttributes)
         {
@@ -630,11 +669,22 @@ static void ANCS_get_detail(void)
           tab[AppID_size + 1] = AppAttributeIDDisplayName;
 
           LOG_INFO_APP("ANCS retrieve app name --> ");
-          send_gatt_cmd_to_client(WRITE_ANCS_CHAR, ANCS_CONTROL_POINT_CHAR_UUID, AppID_size + 3, tab);      
+          op_id = send_gatt_cmd_to_client(link, WRITE_ANCS_CHAR, ANCS_CONTROL_POINT_CHAR_UUID, AppID_size + 3, tab);      
+        }
+
+        if (op_id != GATT_CLIENT_APP_OP_INVALID_ID)
+        {
+          /* Requested once, the next run after a free slot takes the remaining ones */
+          Notif_List[index].retrieve_more_data_flag = false;
         }
       }
     }
   }
+
+  if (wait_init == true)
+  {
+    UTIL_TIMER_Start(&Wait_Notification_Init_Id);
+  }
 }
 
 void ANCS_Perform_Notification_Action(ActionID_t ActionID)
@@ -669,15 +719,16 @@ void ANCS_Perform_Notification_Action(ActionID_t ActionID)
   tab[5] = ActionID;  
   
   LOG_INFO_APP("ANCS perform action --> ");
-  send_gatt_cmd_to_client(WRITE_ANCS_CHAR, ANCS_CONTROL_POINT_CHAR_UUID, 6, tab);      
+  send_gatt_cmd_to_client(Notif_Displayed->Link, WRITE_ANCS_CHAR, ANCS_CONTROL_POINT_CHAR_UUID, 6, tab);      
 }
 
-static Notif_List_t *retrieve_notif_in_list_UID(tListNode *Notif_HeadList, uint32_t UID)
+static Notif_List_t *retrieve_notif_in_list_UID(tListNode *Notif_HeadList, uint8_t Link, uint32_t UID)
 {
   Notif_List_t *currentNode = (Notif_List_t*)Notif_HeadList->next;
   while((tListNode *)currentNode != Notif_HeadList)
   {
-    if(currentNode->UID == UID)
+    /* UIDs are only unique per phone */
+    if((currentNode->Link == Link) && (currentNode->UID == UID))
     {
       return currentNode;
     }
@@ -945,10 +996,14 @@ static void ANCS_Display_Notif(Notif_List_t *Notif)
 static void ANCS_Display_Notif_List(void)
 {
   uint8_t nb_of_item = LST_get_size(&Notif_HeadList);
+  uint8_t index = 0;
+  Notif_List_t *currentNode = (Notif_List_t*)Notif_HeadList.next;
   LOG_INFO_APP("==> Display Notif List : %d items\n", nb_of_item);
-  for (uint8_t index = 0; index < nb_of_item; index++)
+  while((tListNode *)currentNode != &Notif_HeadList)
   {
-    LOG_INFO_APP("      %2d/%2d : App name : %20s | Title : %20s | Message : %20s \n", index + 1, nb_of_item, Notif_List[index].AppName, Notif_List[index].Title, Notif_List[index].Message);
+    index++;
+    LOG_INFO_APP("      %2d/%2d : Link %d | App name : %20s | Title : %20s | Message : %20s \n", index, nb_of_item, currentNode->Link, currentNode->AppName, currentNode->Title, currentNode->Message);
+    LST_get_next_node((tListNode *)currentNode, (tListNode **)&currentNode);
   }
 };
 
@@ -964,14 +1019,8 @@ static void ANCS_Display_App_Name_List(void)
 
 static void Wait_Notification_Init_cb(void *arg)
 {
-  if (ANCS_init_data.app_init == false)
-  {
-    UTIL_TIMER_Start(&Wait_Notification_Init_Id);
-  }
-  else
-  {
-    UTIL_SEQ_SetTask(1U << CFG_TASK_ANCS_GET_DETAIL_ID, CFG_SEQ_PRIO_0);    
-  }
+  /* ANCS_get_detail restarts the timer while a phone is still not ready */
+  UTIL_SEQ_SetTask(1U << CFG_TASK_ANCS_GET_DETAIL_ID, CFG_SEQ_PRIO_0);    
   return;  
 }
 /* USER CODE END LF */
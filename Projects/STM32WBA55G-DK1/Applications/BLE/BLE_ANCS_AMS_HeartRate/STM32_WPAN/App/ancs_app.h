@@ -46,6 +46,7 @@ typedef enum {
 
 typedef struct{
   GattCmdToANCS_t GattCmdToANCS;
+  uint8_t Link;
   uint16_t char_UUID;
   uint8_t l_payload;
   uint8_t p_Payload[256];
@@ -165,6 +166,7 @@ typedef enum {
 typedef struct{
   tListNode     Node;
 
+  uint8_t       Link;                     /* Index of the link the notification comes from */
   uint8_t       evtFlag;
   CategoryID_t  catID;
   uint32_t      UID;
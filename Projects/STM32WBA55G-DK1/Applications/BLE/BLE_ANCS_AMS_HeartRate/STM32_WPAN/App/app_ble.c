@@ -47,11 +47,57 @@
 #include "stm32_lcd.h"
 #endif /* CFG_LCD_SUPPORTED */
 #include "app_menu.h"
+#include "hrs_log.h"
+#include "energy_acct.h"
+#include "app_entry.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
 /* USER CODE BEGIN PTD */
+typedef struct
+{
+  uint16_t IntervalMin;
+  uint16_t IntervalMax;
+  uint16_t Latency;
+  uint16_t Timeout;
+}ConnParamSet_t;
+
+typedef struct
+{
+  UTIL_TIMER_Object_t Timer_Id;
+  uint8_t Connected;
+  APP_BLE_ConnParamSet_t Applied;
+  /* Set requested to the central, APP_BLE_CONN_PARAM_NBR when none */
+  APP_BLE_ConnParamSet_t Pending;
+  uint32_t PendingTime;
+  uint32_t AppliedTime;
+  uint8_t BurstSeen;
+  uint32_t LastBurstTime;
+  uint8_t StreamingSeen;
+  uint32_t LastStreamingTime;
+  /* Delay before a set rejected by the central is requested again */
+  uint32_t a_Backoff[APP_BLE_CONN_PARAM_CENTRAL];
+  uint32_t a_BackoffStart[APP_BLE_CONN_PARAM_CENTRAL];
+  APP_BLE_ConnParamStats_t Stats;
+}ConnParamMgr_t;
 
+typedef struct
+{
+  uint8_t Running;
+  /* Index of the link the probe has been started for */
+  uint8_t Index;
+  uint32_t StartTime;
+  uint32_t Bytes;
+  uint32_t Packets;
+}LinkProbe_t;
+
+typedef struct
+{
+  /* APP_BLE_INVALID_CONN_HDL when the link is free */
+  uint16_t ConnHdl;
+  APP_BLE_LinkInfo_t LinkInfo;
+  ConnParamMgr_t ConnParam;
+}AppBleLink_t;
 /* USER CODE END PTD */
 
 /* Security parameters structure */
@@ -159,6 +205,13 @@ typedef struct
 
 /* USER CODE BEGIN PD */
 #define ADV_TIMEOUT_MS                 (60 * 1000)
+
+/* Connection parameter manager */
+#define CONN_PARAM_FAST_HOLD_MS        (3000)   /* Fast set kept after the last burst of traffic */
+#define CONN_PARAM_STREAMING_HOLD_MS   (5000)   /* Streaming set kept after the last streaming traffic */
+#define CONN_PARAM_BACKOFF_MIN_MS      (5000)
+#define CONN_PARAM_BACKOFF_MAX_MS      (160000)
+#define CONN_PARAM_RESP_TIMEOUT_MS     (30000)  /* L2CAP signaling timeout */
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -204,7 +257,23 @@ static uint32_t gatt_buffer[DIVC(BLE_GATT_BUF_SIZE, 4)];
 static BleStack_init_t pInitParams;
 
 /* USER CODE BEGIN PV */
+/* Sets follow the Apple accessory design guidelines: multiples of 15 ms, Interval Max * (Latency + 1) <= 2 s */
+static const ConnParamSet_t a_ConnParamSets[APP_BLE_CONN_PARAM_CENTRAL] =
+{
+  [APP_BLE_CONN_PARAM_FAST]      = {CONN_INT_MS(15),  CONN_INT_MS(30),  0, CONN_SUP_TIMEOUT_MS(2000)},
+  [APP_BLE_CONN_PARAM_STREAMING] = {CONN_INT_MS(120), CONN_INT_MS(150), 0, CONN_SUP_TIMEOUT_MS(4000)},
+  [APP_BLE_CONN_PARAM_IDLE]      = {CONN_INT_MS(390), CONN_INT_MS(420), 3, CONN_SUP_TIMEOUT_MS(6000)},
+};
+
+static const char * const a_ConnParamSetName[APP_BLE_CONN_PARAM_NBR] =
+{
+  "fast", "streaming", "idle", "central"
+};
 
+static AppBleLink_t a_AppBleLink[CFG_BLE_NUM_LINK];
+#if (CFG_BLE_LINK_PROBE != 0)
+static LinkProbe_t LinkProbe;
+#endif /* CFG_BLE_LINK_PROBE != 0 */
 /* USER CODE END PV */
 
 /* Global variables ----------------------------------------------------------*/
@@ -227,14 +296,25 @@ static uint8_t HOST_BLE_Init(void);
 static void fill_advData(uint8_t *p_adv_data, uint8_t tab_size, const uint8_t*p_bd_addr);
 static void APP_BLE_AdvLowPower_timCB(void *arg);
 static void APP_BLE_AdvLowPower(void);
+static uint8_t Link_Alloc(uint16_t ConnHdl);
+static uint8_t Link_Count(void);
+static void Link_Start(uint8_t Index, uint16_t ConnInterval);
+static void ConnParam_Start(uint8_t Index);
+static void ConnParam_Stop(uint8_t Index);
+static void ConnParam_Updated(uint8_t Index, uint8_t Status, uint16_t Interval, uint16_t Latency);
+static void ConnParam_Rejected(ConnParamMgr_t *p_Mgr);
+static void ConnParam_Account(ConnParamMgr_t *p_Mgr);
+static APP_BLE_ConnParamSet_t ConnParam_Target(ConnParamMgr_t *p_Mgr);
+static uint8_t ConnParam_IsBackingOff(ConnParamMgr_t *p_Mgr, APP_BLE_ConnParamSet_t Set);
+static void ConnParam_timCB(void *arg);
+static void ConnParam_Evaluate(uint8_t Index);
+static void ConnParam_Process(void);
 /* USER CODE END PFP */
 
 /* External variables --------------------------------------------------------*/
 
 /* USER CODE BEGIN EV */
-#if (CFG_JOYSTICK_SUPPORTED == 1)
-extern JOYPin_TypeDef Joystick_Event;
-#endif /* CFG_JOYSTICK_SUPPORTED */
+
 /* USER CODE END EV */
 
 /* Functions Definition ------------------------------------------------------*/
@@ -246,8 +326,8 @@ void APP_BLE_Init(void)
 
   LST_init_head(&BleAsynchEventQueue);
 
-  UTIL_SEQ_RegTask(1U << CFG_TASK_BLE_HOST, UTIL_SEQ_RFU, BleStack_Process_BG);
-  UTIL_SEQ_RegTask(1U << CFG_TASK_HCI_ASYNCH_EVT_ID, UTIL_SEQ_RFU, Ble_UserEvtRx);
+  APPE_SEQ_RegTask(1U << CFG_TASK_BLE_HOST, UTIL_SEQ_RFU, BleStack_Process_BG);
+  APPE_SEQ_RegTask(1U << CFG_TASK_HCI_ASYNCH_EVT_ID, UTIL_SEQ_RFU, Ble_UserEvtRx);
 
   /* NVM emulation in RAM initialization */
   NVM_Init(buffer_nvm, 0, CFG_BLEPLAT_NVM_MAX_SIZE);
@@ -300,7 +380,7 @@ void APP_BLE_Init(void)
     /* Start to Advertise to accept a connection */
     APP_BLE_Procedure_Gap_Peripheral(PROC_GAP_PERIPH_ADVERTISE_START_FAST);
 
-    UTIL_SEQ_RegTask(1<<CFG_TASK_ADV_LP_REQ_ID, UTIL_SEQ_RFU, APP_BLE_AdvLowPower);
+    APPE_SEQ_RegTask(1<<CFG_TASK_ADV_LP_REQ_ID, UTIL_SEQ_RFU, APP_BLE_AdvLowPower);
     /**
     * Create timer to enter Low Power Advertising
     */
@@ -309,6 +389,16 @@ void APP_BLE_Init(void)
                       UTIL_TIMER_ONESHOT,
                       &APP_BLE_AdvLowPower_timCB, 0);
     UTIL_TIMER_Start(&(bleAppContext.TimerAdvLowPower_Id));
+
+    APPE_SEQ_RegTask(1U << CFG_TASK_CONN_PARAM_ID, UTIL_SEQ_RFU, ConnParam_Process);
+    for (uint8_t index = 0; index < CFG_BLE_NUM_LINK; index++)
+    {
+      a_AppBleLink[index].ConnHdl = APP_BLE_INVALID_CONN_HDL;
+      UTIL_TIMER_Create(&(a_AppBleLink[index].ConnParam.Timer_Id),
+                        CONN_PARAM_FAST_HOLD_MS,
+                        UTIL_TIMER_ONESHOT,
+                        &ConnParam_timCB, (void *)(uint32_t)index);
+    }
     /* USER CODE END APP_BLE_Init_3 */
 
     /**
@@ -319,6 +409,9 @@ void APP_BLE_Init(void)
   /* USER CODE BEGIN APP_BLE_Init_2 */
   bleAppContext.connIntervalFlag = 0;
   Menu_Config();
+#if (CFG_ENERGY_ACCT_SUPPORTED == 1) && (CFG_ENERGY_ACCT_RADIO_ACTIVITY_MASK != 0)
+  (void)aci_hal_set_radio_activity_mask(CFG_ENERGY_ACCT_RADIO_ACTIVITY_MASK);
+#endif /* (CFG_ENERGY_ACCT_SUPPORTED == 1) && (CFG_ENERGY_ACCT_RADIO_ACTIVITY_MASK != 0) */
   /* USER CODE END APP_BLE_Init_2 */
 
   return;
@@ -334,6 +427,7 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
   p_event_pckt = (hci_event_pckt*) ((hci_uart_pckt *) p_Pckt)->data;
   UNUSED(ret);
   /* USER CODE BEGIN SVCCTL_App_Notification */
+  uint8_t link_index;
 
   /* USER CODE END SVCCTL_App_Notification */
 
@@ -359,8 +453,16 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
       gap_cmd_resp_release();
 
       /* USER CODE BEGIN EVT_DISCONN_COMPLETE_1 */
+      link_index = APP_BLE_Get_Link_Index(p_disconnection_complete_event->Connection_Handle);
+      if (link_index < CFG_BLE_NUM_LINK)
+      {
+        ConnParam_Stop(link_index);
+        a_AppBleLink[link_index].ConnHdl = APP_BLE_INVALID_CONN_HDL;
+      }
       GATT_CLIENT_APP_ConnHandle_Notif_evt_t disconn_evt = {PEER_DISCON_HANDLE_EVT, p_disconnection_complete_event->Connection_Handle};
       GATT_CLIENT_APP_Notification(&disconn_evt);
+      /* The device may be powered off once the phone is gone, do not keep the NVM writes postponed */
+      (void)SNVMA_Flush();
       /* USER CODE END EVT_DISCONN_COMPLETE_1 */
       HRSHandleNotification.EvtOpcode = HRS_DISCON_HANDLE_EVT;
       DISHandleNotification.EvtOpcode = DIS_DISCON_HANDLE_EVT;
@@ -369,10 +471,26 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
       HRS_APP_EvtRx(&HRSHandleNotification);
       DIS_APP_EvtRx(&DISHandleNotification);
       /* USER CODE BEGIN EVT_DISCONN_COMPLETE */
-
+      if (Link_Count() != 0)
+      {
+        /* Another phone is still connected, it becomes the legacy link */
+        for (link_index = 0; link_index < CFG_BLE_NUM_LINK; link_index++)
+        {
+          if (a_AppBleLink[link_index].ConnHdl != APP_BLE_INVALID_CONN_HDL)
+          {
+            bleAppContext.BleApplicationContext_legacy.connectionHandle = a_AppBleLink[link_index].ConnHdl;
+            break;
+          }
+        }
+        /* Advertising may still run in low power mode, restart it in fast mode */
+        APP_BLE_Procedure_Gap_Peripheral(PROC_GAP_PERIPH_ADVERTISE_STOP);
+      }
       APP_BLE_Procedure_Gap_Peripheral(PROC_GAP_PERIPH_ADVERTISE_START_FAST);
       UTIL_TIMER_StartWithPeriod(&bleAppContext.TimerAdvLowPower_Id, ADV_TIMEOUT_MS);
-      Menu_SetWaitConnPage();
+      if (Link_Count() == 0)
+      {
+        Menu_SetWaitConnPage();
+      }
       /* USER CODE END EVT_DISCONN_COMPLETE */
       break; /* HCI_DISCONNECTION_COMPLETE_EVT_CODE */
     }
@@ -400,6 +518,18 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
           UNUSED(p_conn_update_complete);
 
           /* USER CODE BEGIN EVT_LE_CONN_UPDATE_COMPLETE */
+          link_index = APP_BLE_Get_Link_Index(p_conn_update_complete->Connection_Handle);
+          if (link_index < CFG_BLE_NUM_LINK)
+          {
+            if (p_conn_update_complete->Status == 0x00)
+            {
+              a_AppBleLink[link_index].LinkInfo.ConnInterval = p_conn_update_complete->Conn_Interval;
+            }
+            ConnParam_Updated(link_index,
+                              p_conn_update_complete->Status,
+                              p_conn_update_complete->Conn_Interval,
+                              p_conn_update_complete->Conn_Latency);
+          }
           GATT_CLIENT_APP_ConnHandle_Notif_evt_t conn_evt = {PEER_CONN_HANDLE_EVT, p_conn_update_complete->Connection_Handle};
           GATT_CLIENT_APP_Notification(&conn_evt);
           /* USER CODE END EVT_LE_CONN_UPDATE_COMPLETE */
@@ -414,7 +544,16 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
           gap_cmd_resp_release();
 
           /* USER CODE BEGIN EVT_LE_PHY_UPDATE_COMPLETE */
-
+          link_index = APP_BLE_Get_Link_Index(p_le_phy_update_complete->Connection_Handle);
+          if ((p_le_phy_update_complete->Status == 0x00) && (link_index < CFG_BLE_NUM_LINK))
+          {
+            a_AppBleLink[link_index].LinkInfo.TxPhy = p_le_phy_update_complete->TX_PHY;
+            a_AppBleLink[link_index].LinkInfo.RxPhy = p_le_phy_update_complete->RX_PHY;
+          }
+          LOG_INFO_APP(">>== HCI_LE_PHY_UPDATE_COMPLETE_SUBEVT_CODE - status: 0x%02X, TX PHY: %d, RX PHY: %d\n",
+                       p_le_phy_update_complete->Status,
+                       p_le_phy_update_complete->TX_PHY,
+                       p_le_phy_update_complete->RX_PHY);
           /* USER CODE END EVT_LE_PHY_UPDATE_COMPLETE */
           break;
         }
@@ -458,7 +597,24 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
           HRS_APP_EvtRx(&HRSHandleNotification);
           DIS_APP_EvtRx(&DISHandleNotification);
           /* USER CODE BEGIN HCI_EVT_LE_ENHANCED_CONN_COMPLETE */
-          Menu_SetConnectingPage();
+          link_index = Link_Alloc(p_enhanced_conn_complete->Connection_Handle);
+          if (link_index < CFG_BLE_NUM_LINK)
+          {
+            GATT_CLIENT_APP_Set_Conn_Handle(link_index, p_enhanced_conn_complete->Connection_Handle);
+            GATT_CLIENT_APP_Set_Peer_Address(link_index, p_enhanced_conn_complete->Peer_Address_Type, p_enhanced_conn_complete->Peer_Address);
+            Link_Start(link_index, p_enhanced_conn_complete->Conn_Interval);
+            ConnParam_Start(link_index);
+          }
+          if (Link_Count() == 1)
+          {
+            Menu_SetConnectingPage();
+          }
+          if (Link_Count() < CFG_BLE_NUM_LINK)
+          {
+            /* Stay connectable for the next phone */
+            APP_BLE_Procedure_Gap_Peripheral(PROC_GAP_PERIPH_ADVERTISE_START_FAST);
+            UTIL_TIMER_StartWithPeriod(&bleAppContext.TimerAdvLowPower_Id, ADV_TIMEOUT_MS);
+          }
           /* USER CODE END HCI_EVT_LE_ENHANCED_CONN_COMPLETE */
           break; /* HCI_LE_ENHANCED_CONNECTION_COMPLETE_SUBEVT_CODE */
         }
@@ -516,8 +672,24 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
             LOG_INFO_APP("===>> aci_gap_slave_security_req - Success\n");
           }
 
-          GATT_CLIENT_APP_Set_Conn_Handle(0, p_conn_complete->Connection_Handle);
-          Menu_SetConnectingPage();
+          link_index = Link_Alloc(p_conn_complete->Connection_Handle);
+          if (link_index < CFG_BLE_NUM_LINK)
+          {
+            GATT_CLIENT_APP_Set_Conn_Handle(link_index, p_conn_complete->Connection_Handle);
+            GATT_CLIENT_APP_Set_Peer_Address(link_index, p_conn_complete->Peer_Address_Type, p_conn_complete->Peer_Address);
+            Link_Start(link_index, p_conn_complete->Conn_Interval);
+            ConnParam_Start(link_index);
+          }
+          if (Link_Count() == 1)
+          {
+            Menu_SetConnectingPage();
+          }
+          if (Link_Count() < CFG_BLE_NUM_LINK)
+          {
+            /* Stay connectable for the next phone */
+            APP_BLE_Procedure_Gap_Peripheral(PROC_GAP_PERIPH_ADVERTISE_START_FAST);
+            UTIL_TIMER_StartWithPeriod(&bleAppContext.TimerAdvLowPower_Id, ADV_TIMEOUT_MS);
+          }
           /* USER CODE END HCI_EVT_LE_CONN_COMPLETE */
           break; /* HCI_LE_CONNECTION_COMPLETE_SUBEVT_CODE */
         }
@@ -532,7 +704,21 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
           break; /* HCI_LE_ADVERTISING_REPORT_SUBEVT_CODE */
         }
         /* USER CODE BEGIN SUBEVENT */
-
+        case HCI_LE_DATA_LENGTH_CHANGE_SUBEVT_CODE:
+        {
+          hci_le_data_length_change_event_rp0 *p_data_length_change;
+          p_data_length_change = (hci_le_data_length_change_event_rp0 *) p_meta_evt->data;
+          link_index = APP_BLE_Get_Link_Index(p_data_length_change->Connection_Handle);
+          if (link_index < CFG_BLE_NUM_LINK)
+          {
+            a_AppBleLink[link_index].LinkInfo.MaxTxOctets = p_data_length_change->MaxTxOctets;
+            a_AppBleLink[link_index].LinkInfo.MaxRxOctets = p_data_length_change->MaxRxOctets;
+          }
+          LOG_INFO_APP(">>== HCI_LE_DATA_LENGTH_CHANGE_SUBEVT_CODE - TX: %d bytes, RX: %d bytes\n",
+                       p_data_length_change->MaxTxOctets,
+                       p_data_length_change->MaxRxOctets);
+          break;
+        }
         /* USER CODE END SUBEVENT */
         default:
         {
@@ -566,7 +752,15 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
           p_l2cap_conn_update_resp = (aci_l2cap_connection_update_resp_event_rp0 *) p_blecore_evt->data;
           UNUSED(p_l2cap_conn_update_resp);
           /* USER CODE BEGIN EVT_L2CAP_CONNECTION_UPDATE_RESP */
-
+          if (p_l2cap_conn_update_resp->Result != 0x0000)
+          {
+            LOG_INFO_APP(">>== Connection parameters update rejected by the central\n");
+            link_index = APP_BLE_Get_Link_Index(p_l2cap_conn_update_resp->Connection_Handle);
+            if (link_index < CFG_BLE_NUM_LINK)
+            {
+              ConnParam_Rejected(&a_AppBleLink[link_index].ConnParam);
+            }
+          }
           /* USER CODE END EVT_L2CAP_CONNECTION_UPDATE_RESP */
           break;
         }
@@ -616,6 +810,11 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
         case ACI_HAL_END_OF_RADIO_ACTIVITY_VSEVT_CODE:
         {
           /* USER CODE BEGIN RADIO_ACTIVITY_EVENT*/
+#if (CFG_ENERGY_ACCT_SUPPORTED == 1)
+          aci_hal_end_of_radio_activity_event_rp0 *p_radio_activity;
+          p_radio_activity = (aci_hal_end_of_radio_activity_event_rp0*) p_blecore_evt->data;
+          ENERGY_ACCT_RadioActivityEnd(p_radio_activity->Last_State);
+#endif /* CFG_ENERGY_ACCT_SUPPORTED */
 
           /* USER CODE END RADIO_ACTIVITY_EVENT*/
           break; /* ACI_HAL_END_OF_RADIO_ACTIVITY_VSEVT_CODE */
@@ -710,7 +909,12 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
           {
             LOG_INFO_APP("===>> aci_gap_get_security_level - Success : security_mode = %d| security_level = %d\n", security_mode, security_level);
           }     
-          UTIL_SEQ_SetTask(1U << CFG_TASK_DISCOVER_SERVICES_ID, CFG_SEQ_PRIO_0);
+          if (p_pairing_complete->Status == 0)
+          {
+            /* Store the new bond without waiting for the end of the quiet period */
+            (void)SNVMA_Flush();
+          }
+          GATT_CLIENT_APP_Request_Discovery(APP_BLE_Get_Link_Index(p_pairing_complete->Connection_Handle));
           Menu_SetConnectedPage();
           /* USER CODE END ACI_GAP_PAIRING_COMPLETE_VSEVT_CODE*/
           break;
@@ -733,7 +937,57 @@ SVCCTL_UserEvtFlowStatus_t SVCCTL_App_Notification(void *p_Pckt)
           break;
         }
         /* USER CODE BEGIN ECODE_1 */
-
+        case ACI_ATT_EXCHANGE_MTU_RESP_VSEVT_CODE:
+        {
+          aci_att_exchange_mtu_resp_event_rp0 *p_exchange_mtu;
+          p_exchange_mtu = (aci_att_exchange_mtu_resp_event_rp0 *) p_blecore_evt->data;
+          /* Exchanged on either side, the ATT MTU is the lowest of both */
+          link_index = APP_BLE_Get_Link_Index(p_exchange_mtu->Connection_Handle);
+          if (link_index < CFG_BLE_NUM_LINK)
+          {
+            a_AppBleLink[link_index].LinkInfo.AttMtu = MIN(p_exchange_mtu->Server_RX_MTU, CFG_BLE_ATT_MTU_MAX);
+          }
+          break;
+        }
+        /* Heart rate history export channel */
+        case ACI_L2CAP_COC_CONNECT_VSEVT_CODE:
+        {
+          aci_l2cap_coc_connect_event_rp0 *p_coc_connect;
+          p_coc_connect = (aci_l2cap_coc_connect_event_rp0 *) p_blecore_evt->data;
+          HRS_LOG_CocConnect(p_coc_connect->Connection_Handle,
+                             p_coc_connect->SPSM,
+                             p_coc_connect->MTU,
+                             p_coc_connect->MPS,
+                             p_coc_connect->Initial_Credits,
+                             p_coc_connect->Channel_Number);
+          break;
+        }
+        case ACI_L2CAP_COC_DISCONNECT_VSEVT_CODE:
+        {
+          aci_l2cap_coc_disconnect_event_rp0 *p_coc_disconnect;
+          p_coc_disconnect = (aci_l2cap_coc_disconnect_event_rp0 *) p_blecore_evt->data;
+          HRS_LOG_CocDisconnect(p_coc_disconnect->Channel_Index);
+          break;
+        }
+        case ACI_L2CAP_COC_FLOW_CONTROL_VSEVT_CODE:
+        {
+          aci_l2cap_coc_flow_control_event_rp0 *p_coc_flow_control;
+          p_coc_flow_control = (aci_l2cap_coc_flow_control_event_rp0 *) p_blecore_evt->data;
+          HRS_LOG_CocFlowControl(p_coc_flow_control->Channel_Index, p_coc_flow_control->Credits);
+          break;
+        }
+        case ACI_L2CAP_COC_RX_DATA_VSEVT_CODE:
+        {
+          aci_l2cap_coc_rx_data_event_rp0 *p_coc_rx_data;
+          p_coc_rx_data = (aci_l2cap_coc_rx_data_event_rp0 *) p_blecore_evt->data;
+          HRS_LOG_CocRxData(p_coc_rx_data->Channel_Index, p_coc_rx_data->Length, p_coc_rx_data->Data);
+          break;
+        }
+        case ACI_L2CAP_COC_TX_POOL_AVAILABLE_VSEVT_CODE:
+        {
+          HRS_LOG_CocTxPoolAvailable();
+          break;
+        }
         /* USER CODE END ECODE_1 */
         default:
         {
@@ -869,7 +1123,6 @@ void APP_BLE_Procedure_Gap_General(ProcGapGeneralId_t ProcGapGeneralId)
       break;
     }
     /* USER CODE BEGIN GAP_GENERAL */
-
     /* USER CODE END GAP_GENERAL */
     default:
       break;
@@ -1183,7 +1436,286 @@ void APP_BLE_Procedure_Gap_Central(ProcGapCentralId_t ProcGapCentralId)
 }
 
 /* USER CODE BEGIN FD*/
+/**
+ * @brief  Get the index of a link, shared with the GATT client contexts
+ * @param  ConnHdl: Connection handle
+ * @retval Index of the link, CFG_BLE_NUM_LINK when the handle is unknown
+ */
+uint8_t APP_BLE_Get_Link_Index(uint16_t ConnHdl)
+{
+  uint8_t index;
+
+  for (index = 0; index < CFG_BLE_NUM_LINK; index++)
+  {
+    if ((ConnHdl != APP_BLE_INVALID_CONN_HDL) && (a_AppBleLink[index].ConnHdl == ConnHdl))
+    {
+      break;
+    }
+  }
+
+  return index;
+}
+
+/**
+ * @brief  Report traffic to the connection parameter manager
+ * @param  ConnHdl: Connection handle of the traffic, APP_BLE_ALL_LINKS for all the links
+ * @param  Traffic: Kind of traffic
+ * @retval None
+ */
+void APP_BLE_ConnParam_Traffic(uint16_t ConnHdl, APP_BLE_Traffic_t Traffic)
+{
+  ConnParamMgr_t *p_mgr;
+  uint8_t index;
+  uint8_t evaluate = 0;
+
+  for (index = 0; index < CFG_BLE_NUM_LINK; index++)
+  {
+    if ((ConnHdl != APP_BLE_ALL_LINKS) && (a_AppBleLink[index].ConnHdl != ConnHdl))
+    {
+      continue;
+    }
+
+    p_mgr = &a_AppBleLink[index].ConnParam;
+    if (Traffic == APP_BLE_TRAFFIC_STREAMING)
+    {
+      p_mgr->StreamingSeen = 1;
+      p_mgr->LastStreamingTime = UTIL_TIMER_GetCurrentTime();
+    }
+    else
+    {
+      p_mgr->BurstSeen = 1;
+      p_mgr->LastBurstTime = UTIL_TIMER_GetCurrentTime();
+    }
+
+    if ((p_mgr->Connected != 0) &&
+        (p_mgr->Pending == APP_BLE_CONN_PARAM_NBR) &&
+        (ConnParam_Target(p_mgr) != p_mgr->Applied))
+    {
+      evaluate = 1;
+    }
+  }
+
+  if (evaluate != 0)
+  {
+    UTIL_SEQ_SetTask(1U << CFG_TASK_CONN_PARAM_ID, CFG_SEQ_PRIO_0);
+  }
+
+  return;
+}
+
+/**
+ * @brief  Get the characteristics of a link
+ * @param  Index: Index of the link
+ * @param  p_LinkInfo: Link information to fill
+ * @retval None
+ */
+void APP_BLE_GetLinkInfo(uint8_t Index, APP_BLE_LinkInfo_t *p_LinkInfo)
+{
+  *p_LinkInfo = a_AppBleLink[Index].LinkInfo;
+
+  return;
+}
+
+/**
+ * @brief  Smallest ATT MTU among the connected links
+ * @param  None
+ * @retval ATT MTU, BLE_DEFAULT_ATT_MTU when no link is connected
+ */
+uint16_t APP_BLE_Get_Min_Att_Mtu(void)
+{
+  uint8_t index;
+  uint16_t att_mtu = 0;
+
+  for (index = 0; index < CFG_BLE_NUM_LINK; index++)
+  {
+    if ((a_AppBleLink[index].ConnHdl != APP_BLE_INVALID_CONN_HDL) &&
+        ((att_mtu == 0) || (a_AppBleLink[index].LinkInfo.AttMtu < att_mtu)))
+    {
+      att_mtu = a_AppBleLink[index].LinkInfo.AttMtu;
+    }
+  }
+
+  if (att_mtu < BLE_DEFAULT_ATT_MTU)
+  {
+    att_mtu = BLE_DEFAULT_ATT_MTU;
+  }
+
+  return att_mtu;
+}
+
+/**
+ * @brief  Request the longest LL PDUs and the 2M PHY on a link
+ * @param  Index: Index of the link
+ * @retval None
+ */
+void APP_BLE_Procedure_Link_Setup(uint8_t Index)
+{
+  tBleStatus status;
+  AppBleLink_t *p_link = &a_AppBleLink[Index];
+
+  /* Longest LL PDUs, so that a full ATT MTU fits in a single packet */
+  if (p_link->LinkInfo.MaxTxOctets < CFG_BLE_LINK_MAX_TX_OCTETS)
+  {
+    status = hci_le_set_data_length(p_link->ConnHdl,
+                                    CFG_BLE_LINK_MAX_TX_OCTETS,
+                                    CFG_BLE_LINK_MAX_TX_TIME);
+    if (status != BLE_STATUS_SUCCESS)
+    {
+      LOG_INFO_APP("hci_le_set_data_length failure: reason=0x%02X\n", status);
+    }
+    else
+    {
+      LOG_INFO_APP("==>> hci_le_set_data_length : Success\n");
+    }
+  }
+
+  /* The controller keeps the 1M PHY when the peer does not support the 2M PHY */
+  if ((p_link->LinkInfo.TxPhy != HCI_TX_PHY_LE_2M) || (p_link->LinkInfo.RxPhy != HCI_RX_PHY_LE_2M))
+  {
+    status = hci_le_set_phy(p_link->ConnHdl, CFG_PHY_PREF, CFG_PHY_PREF_TX, CFG_PHY_PREF_RX, 0);
+    if (status != BLE_STATUS_SUCCESS)
+    {
+      LOG_INFO_APP("hci_le_set_phy failure: reason=0x%02X\n", status);
+    }
+    else
+    {
+      LOG_INFO_APP("==>> hci_le_set_phy : Success\n");
+      gap_cmd_resp_wait();/* waiting for HCI_LE_PHY_UPDATE_COMPLETE_SUBEVT_CODE */
+    }
+  }
+
+  p_link->LinkInfo.SetupDone = 1;
+
+  return;
+}
+
+/**
+ * @brief  Start the throughput probe
+ * @param  Index: Index of the link the probe is started for
+ * @retval None
+ */
+void APP_BLE_LinkProbe_Start(uint8_t Index)
+{
+#if (CFG_BLE_LINK_PROBE != 0)
+  /* A single probe at a time, links discovered concurrently are accounted together */
+  if (LinkProbe.Running == 0)
+  {
+    LinkProbe.Bytes = 0;
+    LinkProbe.Packets = 0;
+    LinkProbe.StartTime = UTIL_TIMER_GetCurrentTime();
+    LinkProbe.Index = Index;
+    LinkProbe.Running = 1;
+  }
+#else
+  UNUSED(Index);
+#endif /* CFG_BLE_LINK_PROBE != 0 */
+
+  return;
+}
+
+/**
+ * @brief  Account bytes received while the throughput probe runs
+ * @param  Length: Number of bytes received
+ * @retval None
+ */
+void APP_BLE_LinkProbe_Rx(uint16_t Length)
+{
+#if (CFG_BLE_LINK_PROBE != 0)
+  if (LinkProbe.Running != 0)
+  {
+    LinkProbe.Bytes += Length;
+    LinkProbe.Packets++;
+  }
+#else
+  UNUSED(Length);
+#endif /* CFG_BLE_LINK_PROBE != 0 */
 
+  return;
+}
+
+/**
+ * @brief  Stop the throughput probe and log the effective bytes per connection event
+ * @param  Index: Index of the link the probe has been started for
+ * @param  p_Probe: Result of the probe to fill - Can be NULL
+ * @retval None
+ */
+void APP_BLE_LinkProbe_Stop(uint8_t Index, APP_BLE_LinkProbe_t *p_Probe)
+{
+#if (CFG_BLE_LINK_PROBE != 0)
+  APP_BLE_LinkProbe_t probe;
+
+  if ((LinkProbe.Running != 0) && (LinkProbe.Index == Index))
+  {
+    LinkProbe.Running = 0;
+
+    probe.Bytes = LinkProbe.Bytes;
+    probe.Packets = LinkProbe.Packets;
+    probe.DurationMs = UTIL_TIMER_GetElapsedTime(LinkProbe.StartTime);
+    /* Connection interval is in 1.25 ms unit */
+    probe.ConnEvents = ((probe.DurationMs * 4U) / (a_AppBleLink[Index].LinkInfo.ConnInterval * 5U)) + 1U;
+
+    LOG_INFO_APP("Link probe: %d bytes in %d packets, %d ms, %d connection events, %d.%01d bytes per connection event\n",
+                 probe.Bytes,
+                 probe.Packets,
+                 probe.DurationMs,
+                 probe.ConnEvents,
+                 probe.Bytes / probe.ConnEvents,
+                 ((probe.Bytes * 10U) / probe.ConnEvents) % 10U);
+
+    if (p_Probe != NULL)
+    {
+      *p_Probe = probe;
+    }
+  }
+#else
+  UNUSED(Index);
+  UNUSED(p_Probe);
+#endif /* CFG_BLE_LINK_PROBE != 0 */
+
+  return;
+}
+
+/**
+ * @brief  Get the residency and request statistics of the connection parameter manager
+ * @param  Index: Index of the link
+ * @param  p_Stats: Statistics to fill
+ * @retval None
+ */
+void APP_BLE_ConnParam_GetStats(uint8_t Index, APP_BLE_ConnParamStats_t *p_Stats)
+{
+  ConnParamMgr_t *p_mgr = &a_AppBleLink[Index].ConnParam;
+
+  if (p_mgr->Connected != 0)
+  {
+    ConnParam_Account(p_mgr);
+  }
+
+  *p_Stats = p_mgr->Stats;
+
+  return;
+}
+
+/**
+ * @brief  Log the counters of the event routes registered to the service controller
+ * @param  None
+ * @retval None
+ */
+void APP_BLE_LogRouteStats(void)
+{
+  SVCCTL_RouteStats_t route_stats;
+
+  for (uint8_t route = 0; SVCCTL_GetRouteStats(route, &route_stats) == 0; route++)
+  {
+    if (route_stats.Calls != 0)
+    {
+      LOG_INFO_APP("     - Event 0x%04X handles 0x%04X-0x%04X: %d calls, %d hits\n",
+                   route_stats.Ecode, route_stats.StartHandle, route_stats.EndHandle,
+                   route_stats.Calls, route_stats.Hits);
+    }
+  }
+
+  return;
+}
 /* USER CODE END FD*/
 
 /*************************************************************
@@ -1671,6 +2203,290 @@ static void APP_BLE_AdvLowPower(void)
   APP_BLE_Procedure_Gap_Peripheral(PROC_GAP_PERIPH_ADVERTISE_STOP);
   APP_BLE_Procedure_Gap_Peripheral(PROC_GAP_PERIPH_ADVERTISE_START_LP);
 }
+
+static uint8_t Link_Alloc(uint16_t ConnHdl)
+{
+  uint8_t index;
+
+  for (index = 0; index < CFG_BLE_NUM_LINK; index++)
+  {
+    if (a_AppBleLink[index].ConnHdl == APP_BLE_INVALID_CONN_HDL)
+    {
+      a_AppBleLink[index].ConnHdl = ConnHdl;
+      break;
+    }
+  }
+
+  return index;
+}
+
+static uint8_t Link_Count(void)
+{
+  uint8_t index;
+  uint8_t count = 0;
+
+  for (index = 0; index < CFG_BLE_NUM_LINK; index++)
+  {
+    if (a_AppBleLink[index].ConnHdl != APP_BLE_INVALID_CONN_HDL)
+    {
+      count++;
+    }
+  }
+
+  return count;
+}
+
+static void Link_Start(uint8_t Index, uint16_t ConnInterval)
+{
+  APP_BLE_LinkInfo_t *p_link_info = &a_AppBleLink[Index].LinkInfo;
+
+  p_link_info->SetupDone = 0;
+  p_link_info->AttMtu = BLE_DEFAULT_ATT_MTU;
+  p_link_info->MaxTxOctets = 27;
+  p_link_info->MaxRxOctets = 27;
+  p_link_info->TxPhy = HCI_TX_PHY_LE_1M;
+  p_link_info->RxPhy = HCI_RX_PHY_LE_1M;
+  p_link_info->ConnInterval = ConnInterval;
+}
+
+static void ConnParam_Start(uint8_t Index)
+{
+  ConnParamMgr_t *p_mgr = &a_AppBleLink[Index].ConnParam;
+
+  memset(&p_mgr->Stats, 0, sizeof(p_mgr->Stats));
+  memset(p_mgr->a_Backoff, 0, sizeof(p_mgr->a_Backoff));
+
+  p_mgr->Connected = 1;
+  p_mgr->Applied = APP_BLE_CONN_PARAM_CENTRAL;
+  p_mgr->Pending = APP_BLE_CONN_PARAM_NBR;
+  p_mgr->AppliedTime = UTIL_TIMER_GetCurrentTime();
+  p_mgr->StreamingSeen = 0;
+
+  /* Security and discovery follow the connection */
+  APP_BLE_ConnParam_Traffic(a_AppBleLink[Index].ConnHdl, APP_BLE_TRAFFIC_DISCOVERY);
+}
+
+static void ConnParam_Stop(uint8_t Index)
+{
+  ConnParamMgr_t *p_mgr = &a_AppBleLink[Index].ConnParam;
+
+  if (p_mgr->Connected != 0)
+  {
+    p_mgr->Connected = 0;
+    UTIL_TIMER_Stop(&(p_mgr->Timer_Id));
+    ConnParam_Account(p_mgr);
+
+    LOG_INFO_APP("Link %d connection parameters residency: fast %d ms, streaming %d ms, idle %d ms, central %d ms\n",
+                 Index,
+                 p_mgr->Stats.ResidencyMs[APP_BLE_CONN_PARAM_FAST],
+                 p_mgr->Stats.ResidencyMs[APP_BLE_CONN_PARAM_STREAMING],
+                 p_mgr->Stats.ResidencyMs[APP_BLE_CONN_PARAM_IDLE],
+                 p_mgr->Stats.ResidencyMs[APP_BLE_CONN_PARAM_CENTRAL]);
+    LOG_INFO_APP("Link %d connection parameters requests: %d, accepted %d, rejected %d\n",
+                 Index,
+                 p_mgr->Stats.Requests,
+                 p_mgr->Stats.Accepted,
+                 p_mgr->Stats.Rejected);
+  }
+}
+
+static void ConnParam_Updated(uint8_t Index, uint8_t Status, uint16_t Interval, uint16_t Latency)
+{
+  ConnParamMgr_t *p_mgr = &a_AppBleLink[Index].ConnParam;
+  APP_BLE_ConnParamSet_t set;
+
+  if (Status == 0x00)
+  {
+    ConnParam_Account(p_mgr);
+
+    /* Find the set the new parameters belong to */
+    for (set = APP_BLE_CONN_PARAM_FAST; set < APP_BLE_CONN_PARAM_CENTRAL; set++)
+    {
+      if ((Interval >= a_ConnParamSets[set].IntervalMin) &&
+          (Interval <= a_ConnParamSets[set].IntervalMax) &&
+          (Latency == a_ConnParamSets[set].Latency))
+      {
+        break;
+      }
+    }
+    p_mgr->Applied = set;
+  }
+
+  if (p_mgr->Pending != APP_BLE_CONN_PARAM_NBR)
+  {
+    if (p_mgr->Applied == p_mgr->Pending)
+    {
+      p_mgr->Stats.Accepted++;
+      p_mgr->a_Backoff[p_mgr->Pending] = 0;
+      p_mgr->Pending = APP_BLE_CONN_PARAM_NBR;
+    }
+    else
+    {
+      /* The central applied other parameters than the requested ones */
+      ConnParam_Rejected(p_mgr);
+    }
+  }
+
+  LOG_INFO_APP("Link %d connection parameters set: %s\n", Index, a_ConnParamSetName[p_mgr->Applied]);
+
+  UTIL_SEQ_SetTask(1U << CFG_TASK_CONN_PARAM_ID, CFG_SEQ_PRIO_0);
+}
+
+static void ConnParam_Rejected(ConnParamMgr_t *p_Mgr)
+{
+  APP_BLE_ConnParamSet_t set = p_Mgr->Pending;
+
+  if (set != APP_BLE_CONN_PARAM_NBR)
+  {
+    p_Mgr->Stats.Rejected++;
+
+    /* Exponential back off before requesting the same set again */
+    if (p_Mgr->a_Backoff[set] == 0)
+    {
+      p_Mgr->a_Backoff[set] = CONN_PARAM_BACKOFF_MIN_MS;
+    }
+    else if (p_Mgr->a_Backoff[set] < CONN_PARAM_BACKOFF_MAX_MS)
+    {
+      p_Mgr->a_Backoff[set] *= 2;
+    }
+    p_Mgr->a_BackoffStart[set] = UTIL_TIMER_GetCurrentTime();
+    p_Mgr->Pending = APP_BLE_CONN_PARAM_NBR;
+
+    LOG_INFO_APP("Connection parameters set %s backs off for %d ms\n",
+                 a_ConnParamSetName[set],
+                 p_Mgr->a_Backoff[set]);
+  }
+}
+
+static void ConnParam_Account(ConnParamMgr_t *p_Mgr)
+{
+  uint32_t now = UTIL_TIMER_GetCurrentTime();
+
+  p_Mgr->Stats.ResidencyMs[p_Mgr->Applied] += (now - p_Mgr->AppliedTime);
+  p_Mgr->AppliedTime = now;
+}
+
+static APP_BLE_ConnParamSet_t ConnParam_Target(ConnParamMgr_t *p_Mgr)
+{
+  APP_BLE_ConnParamSet_t target = APP_BLE_CONN_PARAM_IDLE;
+
+  if ((p_Mgr->BurstSeen != 0) &&
+      (UTIL_TIMER_GetElapsedTime(p_Mgr->LastBurstTime) < CONN_PARAM_FAST_HOLD_MS))
+  {
+    target = APP_BLE_CONN_PARAM_FAST;
+  }
+  else if ((p_Mgr->StreamingSeen != 0) &&
+           (UTIL_TIMER_GetElapsedTime(p_Mgr->LastStreamingTime) < CONN_PARAM_STREAMING_HOLD_MS))
+  {
+    target = APP_BLE_CONN_PARAM_STREAMING;
+  }
+
+  return target;
+}
+
+static uint8_t ConnParam_IsBackingOff(ConnParamMgr_t *p_Mgr, APP_BLE_ConnParamSet_t Set)
+{
+  return ((p_Mgr->a_Backoff[Set] != 0) &&
+          (UTIL_TIMER_GetElapsedTime(p_Mgr->a_BackoffStart[Set]) < p_Mgr->a_Backoff[Set]));
+}
+
+static void ConnParam_timCB(void *arg)
+{
+  /* ACI commands are sent from the background */
+  UTIL_SEQ_SetTask(1U << CFG_TASK_CONN_PARAM_ID, CFG_SEQ_PRIO_0);
+}
+
+static void ConnParam_Process(void)
+{
+  uint8_t index;
+
+  for (index = 0; index < CFG_BLE_NUM_LINK; index++)
+  {
+    if (a_AppBleLink[index].ConnParam.Connected != 0)
+    {
+      ConnParam_Evaluate(index);
+    }
+  }
+}
+
+static void ConnParam_Evaluate(uint8_t Index)
+{
+  ConnParamMgr_t *p_mgr = &a_AppBleLink[Index].ConnParam;
+  tBleStatus status;
+  APP_BLE_ConnParamSet_t target;
+  uint32_t next_ms = 0;
+  uint32_t elapsed;
+
+  /* Give up a request left without answer */
+  if ((p_mgr->Pending != APP_BLE_CONN_PARAM_NBR) &&
+      (UTIL_TIMER_GetElapsedTime(p_mgr->PendingTime) >= CONN_PARAM_RESP_TIMEOUT_MS))
+  {
+    ConnParam_Rejected(p_mgr);
+  }
+
+  target = ConnParam_Target(p_mgr);
+
+  if ((p_mgr->Pending == APP_BLE_CONN_PARAM_NBR) &&
+      (target != p_mgr->Applied))
+  {
+    if (ConnParam_IsBackingOff(p_mgr, target) != 0)
+    {
+      next_ms = p_mgr->a_Backoff[target] - UTIL_TIMER_GetElapsedTime(p_mgr->a_BackoffStart[target]);
+    }
+    else
+    {
+      status = aci_l2cap_connection_parameter_update_req(a_AppBleLink[Index].ConnHdl,
+                                                         a_ConnParamSets[target].IntervalMin,
+                                                         a_ConnParamSets[target].IntervalMax,
+                                                         a_ConnParamSets[target].Latency,
+                                                         a_ConnParamSets[target].Timeout);
+      p_mgr->Stats.Requests++;
+      p_mgr->Pending = target;
+      p_mgr->PendingTime = UTIL_TIMER_GetCurrentTime();
+
+      if (status != BLE_STATUS_SUCCESS)
+      {
+        LOG_INFO_APP("aci_l2cap_connection_parameter_update_req - fail, result: 0x%02X\n", status);
+        ConnParam_Rejected(p_mgr);
+      }
+      else
+      {
+        LOG_INFO_APP("==>> Link %d connection parameters set %s requested\n", Index, a_ConnParamSetName[target]);
+      }
+    }
+  }
+
+  /* Next evaluation when the target changes or the request times out */
+  if (p_mgr->Pending != APP_BLE_CONN_PARAM_NBR)
+  {
+    next_ms = CONN_PARAM_RESP_TIMEOUT_MS;
+  }
+  else if (target == APP_BLE_CONN_PARAM_FAST)
+  {
+    elapsed = UTIL_TIMER_GetElapsedTime(p_mgr->LastBurstTime);
+    if ((next_ms == 0) || ((CONN_PARAM_FAST_HOLD_MS - elapsed) < next_ms))
+    {
+      next_ms = CONN_PARAM_FAST_HOLD_MS - elapsed;
+    }
+  }
+  else if (target == APP_BLE_CONN_PARAM_STREAMING)
+  {
+    elapsed = UTIL_TIMER_GetElapsedTime(p_mgr->LastStreamingTime);
+    if ((next_ms == 0) || ((CONN_PARAM_STREAMING_HOLD_MS - elapsed) < next_ms))
+    {
+      next_ms = CONN_PARAM_STREAMING_HOLD_MS - elapsed;
+    }
+  }
+
+  if (next_ms != 0)
+  {
+    UTIL_TIMER_StartWithPeriod(&(p_mgr->Timer_Id), next_ms);
+  }
+  else
+  {
+    UTIL_TIMER_Stop(&(p_mgr->Timer_Id));
+  }
+}
 /* USER CODE END FD_LOCAL_FUNCTION */
 
 /*************************************************************
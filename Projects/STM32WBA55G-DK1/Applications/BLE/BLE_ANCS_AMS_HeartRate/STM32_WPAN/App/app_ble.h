@@ -116,7 +116,53 @@ typedef enum
 }ProcGapCentralId_t;
 
 /* USER CODE BEGIN ET */
+/* Traffic reported to the connection parameter manager */
+typedef enum
+{
+  APP_BLE_TRAFFIC_DISCOVERY,
+  APP_BLE_TRAFFIC_NOTIFICATION,
+  APP_BLE_TRAFFIC_STREAMING,
+  APP_BLE_TRAFFIC_UI,
+}APP_BLE_Traffic_t;
 
+/* Connection parameter sets */
+typedef enum
+{
+  APP_BLE_CONN_PARAM_FAST,
+  APP_BLE_CONN_PARAM_STREAMING,
+  APP_BLE_CONN_PARAM_IDLE,
+  APP_BLE_CONN_PARAM_CENTRAL,   /* Parameters chosen by the central */
+  APP_BLE_CONN_PARAM_NBR
+}APP_BLE_ConnParamSet_t;
+
+typedef struct
+{
+  uint32_t ResidencyMs[APP_BLE_CONN_PARAM_NBR];
+  uint32_t Requests;
+  uint32_t Accepted;
+  uint32_t Rejected;
+}APP_BLE_ConnParamStats_t;
+
+/* Characteristics of the link, negotiated at connection bring-up */
+typedef struct
+{
+  uint8_t  SetupDone;
+  uint16_t AttMtu;
+  uint16_t MaxTxOctets;
+  uint16_t MaxRxOctets;
+  uint8_t  TxPhy;
+  uint8_t  RxPhy;
+  uint16_t ConnInterval;  /* Unit: 1.25 ms */
+}APP_BLE_LinkInfo_t;
+
+/* Result of the throughput probe */
+typedef struct
+{
+  uint32_t Bytes;
+  uint32_t Packets;
+  uint32_t DurationMs;
+  uint32_t ConnEvents;
+}APP_BLE_LinkProbe_t;
 /* USER CODE END ET */
 
 /* Exported constants --------------------------------------------------------*/
@@ -155,6 +201,16 @@ enum
   FW_ID_HEART_RATE =  0x89,
   FW_ID_HEALTH_THERMO = 0x8A
 };
+
+/**
+  * Connection handle of a free link
+**/
+#define APP_BLE_INVALID_CONN_HDL    (0xFFFFU)
+
+/**
+  * Connection handle addressing all the connected links
+**/
+#define APP_BLE_ALL_LINKS           APP_BLE_INVALID_CONN_HDL
 /* USER CODE END EC */
 
 /* External variables --------------------------------------------------------*/
@@ -181,7 +237,16 @@ void APP_BLE_Procedure_Gap_General(ProcGapGeneralId_t ProcGapGeneralId);
 void APP_BLE_Procedure_Gap_Peripheral(ProcGapPeripheralId_t ProcGapPeripheralId);
 void APP_BLE_Procedure_Gap_Central(ProcGapCentralId_t ProcGapCentralId);
 /* USER CODE BEGIN EFP */
-
+uint8_t APP_BLE_Get_Link_Index(uint16_t ConnHdl);
+void APP_BLE_Procedure_Link_Setup(uint8_t Index);
+void APP_BLE_ConnParam_Traffic(uint16_t ConnHdl, APP_BLE_Traffic_t Traffic);
+void APP_BLE_ConnParam_GetStats(uint8_t Index, APP_BLE_ConnParamStats_t *p_Stats);
+void APP_BLE_GetLinkInfo(uint8_t Index, APP_BLE_LinkInfo_t *p_LinkInfo);
+uint16_t APP_BLE_Get_Min_Att_Mtu(void);
+void APP_BLE_LinkProbe_Start(uint8_t Index);
+void APP_BLE_LinkProbe_Rx(uint16_t Length);
+void APP_BLE_LinkProbe_Stop(uint8_t Index, APP_BLE_LinkProbe_t *p_Probe);
+void APP_BLE_LogRouteStats(void);
 /* USER CODE END EFP */
 
 #ifdef __cplusplus
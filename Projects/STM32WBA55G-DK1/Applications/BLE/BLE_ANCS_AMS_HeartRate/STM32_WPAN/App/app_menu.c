@@ -634,6 +634,12 @@ void cpy_ext_utf8_data(char *p_data, char *ascii_converted_data, uint8_t l_data)
 
     else if ( (p_data[index] & 0xF0) == 0xF0)   //Extended ascii char detected on 4 bytes => 0b11110xxx 10xxxxxx 10xxxxxx 10xxxxxx
     {
+      if ((index + 3) >= l_data)
+      {
+        /* Code point cut by the end of the data, stop at the last complete one */
+        break;
+      }
+
       ascii_converted_data[ascii_index] = '?';   //this shouldn't happens
 
       ascii_index++;      
@@ -642,6 +648,12 @@ void cpy_ext_utf8_data(char *p_data, char *ascii_converted_data, uint8_t l_data)
 
     else if ( (p_data[index] & 0xE0) == 0xE0)   //Extended ascii char detected on 3 bytes => 0b1110xxxx 10xxxxxx 10xxxxxx
     {
+      if ((index + 2) >= l_data)
+      {
+        /* Code point cut by the end of the data, stop at the last complete one */
+        break;
+      }
+
       ascii_converted_data[ascii_index] = '?';   //this shouldn't happens
 
       ascii_index++;      
@@ -650,6 +662,12 @@ void cpy_ext_utf8_data(char *p_data, char *ascii_converted_data, uint8_t l_data)
 
     else if ( (p_data[index] & 0xC0) == 0xC0)   //Extended ascii char detected on 2 bytes => 0b110xxxXX 10XXXXXX   (with x unused data and X usefull data)
     {
+      if ((index + 1) >= l_data)
+      {
+        /* Code point cut by the end of the data, stop at the last complete one */
+        break;
+      }
+
       converted_extended_ascii_to_utf8 = (p_data[index] & 0x3) << 6;
       converted_extended_ascii_to_utf8 |= p_data[index+1] & 0x3F;
       
@@ -65,7 +65,7 @@ Menu_Content_Text_t connecting_text = {1, {"Connecting"}};
 Menu_Content_Text_t connected_text = {1, {"Connected"}};
 Menu_Content_Text_t volume_text = {1, {"  0%"}};
 Menu_Content_Text_t call_text = {2, {"Call", "Control"}};
-Menu_Content_Text_t media_text = {2, {"    Media    ", "   Control   "}};
+Menu_Content_Text_t media_text = {4, {"    Media    ", "   Control   ", "", ""}};
 Menu_Content_Text_t notif_display_text = {3, {"00/00", "No", "Notif"}};
 Menu_Content_Text_t notif_control_text = {2, {"No Action", "To Do"}};
 Menu_Content_Text_t hrs_text = {1, {"  xxbpm - xxxkcal"}};
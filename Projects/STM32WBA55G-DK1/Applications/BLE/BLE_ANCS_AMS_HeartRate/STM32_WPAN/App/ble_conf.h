@@ -40,7 +40,11 @@
 #define BLE_CFG_MAX_NBR_CB                        (1)
 
 /* USER CODE BEGIN ble_conf_1 */
-
+/**
+ * Number of routes, an event code and a range of attribute handles, that can be
+ * registered with SVCCTL_RegisterRoute
+ */
+#define BLE_CFG_ROUTE_MAX_NBR                     (24)
 /* USER CODE END ble_conf_1 */
 
 #endif /*BLE_CONF_H */
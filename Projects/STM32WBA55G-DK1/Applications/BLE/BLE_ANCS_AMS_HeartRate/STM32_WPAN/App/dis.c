@@ -429,7 +429,16 @@ void DIS_Init(void)
   /* USER CODE END SVCCTL_InitService2Char5 */
 
   /* USER CODE BEGIN SVCCTL_InitService2Svc_2 */
-
+  /* Route the events of the attributes of the service to the handler, it then gets no other event */
+  SVCCTL_RegisterRoute(ACI_GATT_ATTRIBUTE_MODIFIED_VSEVT_CODE,
+                       DIS_Context.DisSvcHdle, DIS_Context.FrsCharHdle + CHARACTERISTIC_VALUE_ATTRIBUTE_OFFSET,
+                       DIS_EventHandler);
+  SVCCTL_RegisterRoute(ACI_GATT_READ_PERMIT_REQ_VSEVT_CODE,
+                       DIS_Context.DisSvcHdle, DIS_Context.FrsCharHdle + CHARACTERISTIC_VALUE_ATTRIBUTE_OFFSET,
+                       DIS_EventHandler);
+  SVCCTL_RegisterRoute(ACI_GATT_WRITE_PERMIT_REQ_VSEVT_CODE,
+                       DIS_Context.DisSvcHdle, DIS_Context.FrsCharHdle + CHARACTERISTIC_VALUE_ATTRIBUTE_OFFSET,
+                       DIS_EventHandler);
   /* USER CODE END SVCCTL_InitService2Svc_2 */
 
   return;
@@ -30,12 +30,17 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include <stddef.h>
 #include "stm32_timer.h"
+#include "simple_nvm_arbiter.h"
 #include "ams_app.h"
 #include "ancs_app.h"
 #include "hrs_app.h"
+#include "app_menu.h"
 #include "stm32_lcd.h"
 #include "stm32wba55g_discovery.h"
+#include "wall_clock.h"
+#include "app_entry.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -134,6 +139,7 @@ typedef struct
   
   uint16_t CurrentTimeCharStartHdle;
   uint16_t CurrentTimeCharValueHdle;
+  uint16_t CurrentTimeCharDescHdle;
 
   /* end of handles of the Battery service and char */  
 /* USER CODE END BleClientAppContext_t */
@@ -143,6 +149,150 @@ typedef struct
 /* Private defines ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
 #define REFRESH_SCREEN_TIMER 500
+
+/* Links of app_ble and client contexts share the same index */
+#if (BLE_CFG_CLT_MAX_NBR_CB < CFG_BLE_NUM_LINK)
+#error BLE_CFG_CLT_MAX_NBR_CB shall not be lower than CFG_BLE_NUM_LINK
+#endif
+
+/* GATT discovery cache */
+#define GATT_CACHE_NBR_ENTRIES          (4)
+#define GATT_CACHE_VERSION              (0x02)
+#define GATT_CACHE_DB_HASH_SIZE         (16)
+/* Discovered handles are cached from ALLServiceStartHdl up to the end of the client context */
+#define GATT_CACHE_HANDLES_OFFSET       offsetof(BleClientAppContext_t, ALLServiceStartHdl)
+#define GATT_CACHE_HANDLES_SIZE         (sizeof(BleClientAppContext_t) - GATT_CACHE_HANDLES_OFFSET)
+
+typedef struct
+{
+  /* Use sequence number of the entry, 0 when the entry is free */
+  uint32_t Sequence;
+  uint8_t IdAddrType;
+  uint8_t IdAddr[6];
+  /* Set when the peer exposes the Database Hash characteristic */
+  uint8_t DbHashKnown;
+  uint8_t DbHash[GATT_CACHE_DB_HASH_SIZE];
+  uint8_t a_Handles[GATT_CACHE_HANDLES_SIZE];
+}GattCacheEntry_t;
+
+typedef struct
+{
+  uint32_t Version;
+  uint32_t Sequence;
+  GattCacheEntry_t a_Entry[GATT_CACHE_NBR_ENTRIES];
+}GattCache_t;
+
+typedef struct
+{
+  uint8_t PeerAddrType;
+  uint8_t PeerAddr[6];
+  uint8_t IdAddrType;
+  uint8_t IdAddr[6];
+  uint8_t DbHashRead;
+  uint8_t DbHash[GATT_CACHE_DB_HASH_SIZE];
+  /* Service of the discovery plan being discovered by UUID */
+  uint8_t DiscService;
+}GattClientPeer_t;
+
+/* GATT discovery plan */
+#define GATT_DISC_NO_FIELD              (0xFFFF)
+#define GATT_DISC_NBR_SERVICES          (sizeof(a_GattDiscServices) / sizeof(a_GattDiscServices[0]))
+#define GATT_DISC_NBR_CHARS             (sizeof(a_GattDiscChars) / sizeof(a_GattDiscChars[0]))
+/* Handle field of the client context at a given offset */
+#define GATT_DISC_HDL(index, offset)    (*(uint16_t *)((uint8_t *)&a_ClientContext[index] + (offset)))
+
+typedef enum
+{
+  GATT_DISC_SRV_GATT,
+  GATT_DISC_SRV_CTS,
+  GATT_DISC_SRV_BAS,
+  GATT_DISC_SRV_ANCS,
+  GATT_DISC_SRV_AMS,
+}GattDiscServiceId_t;
+
+typedef struct
+{
+  const char *p_Name;
+  uint8_t UuidType;
+  UUID_t Uuid;
+  /* 16 bits UUID, or bytes 12 and 13 of the 128 bits UUID */
+  uint16_t ShortUuid;
+  uint16_t StartHdlOffset;
+  uint16_t EndHdlOffset;
+}GattDiscService_t;
+
+typedef struct
+{
+  const char *p_Name;
+  GattDiscServiceId_t Service;
+  /* 16 bits UUID, or bytes 12 and 13 of the 128 bits UUID */
+  uint16_t ShortUuid;
+  uint16_t StartHdlOffset;
+  uint16_t ValueHdlOffset;
+  /* Client Characteristic Configuration descriptor, GATT_DISC_NO_FIELD when not used */
+  uint16_t DescHdlOffset;
+}GattDiscChar_t;
+
+typedef enum
+{
+  GATT_DISC_PHASE_SERVICES,
+  GATT_DISC_PHASE_CHARS,
+  GATT_DISC_PHASE_DESCS,
+  GATT_DISC_PHASE_ENABLE,
+  GATT_DISC_PHASE_NBR
+}GattDiscPhase_t;
+
+/* Queued GATT operations */
+typedef enum
+{
+  GATT_OP_READ,
+  GATT_OP_READ_LONG,
+  GATT_OP_WRITE,
+  GATT_OP_WRITE_NO_RESP,
+  GATT_OP_ENABLE_CCCD,
+}GattOpType_t;
+
+typedef enum
+{
+  GATT_OP_STATE_IDLE,       /* No procedure running for the queue */
+  GATT_OP_STATE_PENDING,    /* Waiting for ACI_GATT_PROC_COMPLETE */
+  GATT_OP_STATE_COMPLETE,   /* Procedure over, to be reported by the GATT operation task */
+  GATT_OP_STATE_TX_FULL,    /* Write without response waiting for ACI_GATT_TX_POOL_AVAILABLE */
+}GattOpState_t;
+
+typedef struct
+{
+  GattOpType_t Type;
+  uint8_t Id;
+  /* Set once the callback has been called, on a timeout or a cancel before the end of the procedure */
+  uint8_t Reported;
+  uint16_t AttHdl;
+  uint16_t Length;
+  uint8_t a_Data[GATT_CLIENT_APP_OP_DATA_SIZE];
+  GATT_CLIENT_APP_OpCb_t Callback;
+  void *p_Context;
+}GattOp_t;
+
+typedef struct
+{
+  GattOp_t a_Op[GATT_CLIENT_APP_OP_QUEUE_SIZE];
+  uint8_t Head;
+  uint8_t Count;
+  uint8_t NextId;
+  GattOpState_t State;
+  uint8_t ProcStatus;
+  uint8_t TimedOut;
+  /* Set while a discovery worker waits for the end of the running operation */
+  uint8_t DiscWaiting;
+  UTIL_TIMER_Object_t Timer;
+  /* Statistics of the connection */
+  uint32_t Done;
+  uint32_t Errors;
+  uint32_t Timeouts;
+  uint32_t Cancelled;
+  uint32_t Rejected;
+  uint8_t MaxDepth;
+}GattOpQueue_t;
 /* USER CODE END PD */
 
 /* Private macros -------------------------------------------------------------*/
@@ -161,9 +311,146 @@ static uint16_t gattCharValueHdl = 0;
 
 /* USER CODE BEGIN PV */
 static UTIL_TIMER_Object_t ClientTimer_Id;
-static UTIL_TIMER_Object_t Start_Notification_Id;
-static Init_Client_State_t init_state;
+static UTIL_TIMER_Object_t a_StartNotification_Id[BLE_CFG_CLT_MAX_NBR_CB];
+#if (CFG_WALL_CLOCK_SUPPORTED == 1)
+/* Set while a read of the Current Time is queued */
+static uint8_t time_read_pending = 0;
+#else
 static uint8_t counter_to_1_min = 0;
+#endif /* CFG_WALL_CLOCK_SUPPORTED */
+
+/* Links waiting for a discovery, and links being discovered by a worker task */
+static uint8_t DiscRequest;
+static uint8_t DiscRunning;
+
+static GattClientPeer_t a_ClientPeer[BLE_CFG_CLT_MAX_NBR_CB];
+static GattCache_t GattCache;
+
+/* Services and characteristics discovered, in the order of the discovery */
+static const GattDiscService_t a_GattDiscServices[] =
+{
+  [GATT_DISC_SRV_GATT] =
+  {
+    "GENERIC_ATTRIBUTE_SERVICE_UUID", UUID_TYPE_16, { .UUID_16 = GENERIC_ATTRIBUTE_SERVICE_UUID },
+    GENERIC_ATTRIBUTE_SERVICE_UUID,
+    offsetof(BleClientAppContext_t, GATTServiceStartHdl),
+    offsetof(BleClientAppContext_t, GATTServiceEndHdl)
+  },
+  [GATT_DISC_SRV_CTS] =
+  {
+    "CURRENT_TIME_SERVICE_UUID", UUID_TYPE_16, { .UUID_16 = CURRENT_TIME_SERVICE_UUID },
+    CURRENT_TIME_SERVICE_UUID,
+    offsetof(BleClientAppContext_t, CurrentTimeServiceStartHandle),
+    offsetof(BleClientAppContext_t, CurrentTimeServiceEndHandle)
+  },
+  [GATT_DISC_SRV_BAS] =
+  {
+    "BATTERY_SERVICE_UUID", UUID_TYPE_16, { .UUID_16 = BATTERY_SERVICE_UUID },
+    BATTERY_SERVICE_UUID,
+    offsetof(BleClientAppContext_t, BatteryServiceStartHandle),
+    offsetof(BleClientAppContext_t, BatteryServiceEndHandle)
+  },
+  [GATT_DISC_SRV_ANCS] =
+  {
+    /* 7905F431-B5CE-4E99-A40F-4B1E122D00D0 */
+    "ANCS_SERVICE_UUID", UUID_TYPE_128,
+    { .UUID_128 = {0xD0, 0x00, 0x2D, 0x12, 0x1E, 0x4B, 0x0F, 0xA4, 0x99, 0x4E, 0xCE, 0xB5, 0x31, 0xF4, 0x05, 0x79} },
+    ANCS_SERVICE_UUID,
+    offsetof(BleClientAppContext_t, ANCSServiceStartHandle),
+    offsetof(BleClientAppContext_t, ANCSServiceEndHandle)
+  },
+  [GATT_DISC_SRV_AMS] =
+  {
+    /* 89D3502B-0F36-433A-8EF4-C502AD55F8DC */
+    "AMS_SERVICE_UUID", UUID_TYPE_128,
+    { .UUID_128 = {0xDC, 0xF8, 0x55, 0xAD, 0x02, 0xC5, 0xF4, 0x8E, 0x3A, 0x43, 0x36, 0x0F, 0x2B, 0x50, 0xD3, 0x89} },
+    AMS_SERVICE_UUID,
+    offsetof(BleClientAppContext_t, AMSServiceStartHandle),
+    offsetof(BleClientAppContext_t, AMSServiceEndHandle)
+  },
+};
+
+static const GattDiscChar_t a_GattDiscChars[] =
+{
+  {
+    "SERVICE_CHANGED_CHARACTERISTIC_UUID", GATT_DISC_SRV_GATT, SERVICE_CHANGED_CHARACTERISTIC_UUID,
+    offsetof(BleClientAppContext_t, ServiceChangedCharStartHdl),
+    offsetof(BleClientAppContext_t, ServiceChangedCharValueHdl),
+    offsetof(BleClientAppContext_t, ServiceChangedCharDescHdl)
+  },
+  {
+    "CURRENT_TIME_CHAR_UUID", GATT_DISC_SRV_CTS, CURRENT_TIME_CHAR_UUID,
+    offsetof(BleClientAppContext_t, CurrentTimeCharStartHdle),
+    offsetof(BleClientAppContext_t, CurrentTimeCharValueHdle),
+    offsetof(BleClientAppContext_t, CurrentTimeCharDescHdle)
+  },
+  {
+    "BATTERY_LEVEL_CHAR_UUID", GATT_DISC_SRV_BAS, BATTERY_LEVEL_CHAR_UUID,
+    offsetof(BleClientAppContext_t, BatteryLevelCharStartHdle),
+    offsetof(BleClientAppContext_t, BatteryLevelCharValueHdle),
+    offsetof(BleClientAppContext_t, BatteryLevelCharDescHdle)
+  },
+  {
+    "ANCS_NOTIFICATION_SOURCE_CHAR_UUID", GATT_DISC_SRV_ANCS, ANCS_NOTIFICATION_SOURCE_CHAR_UUID,
+    offsetof(BleClientAppContext_t, ANCSNotifSourceCharStartHdle),
+    offsetof(BleClientAppContext_t, ANCSNotifSourceCharValueHdle),
+    offsetof(BleClientAppContext_t, ANCSNotifSourceCharDescHdle)
+  },
+  {
+    "ANCS_CONTROL_POINT_CHAR_UUID", GATT_DISC_SRV_ANCS, ANCS_CONTROL_POINT_CHAR_UUID,
+    offsetof(BleClientAppContext_t, ANCSCtrlPointCharStartHdle),
+    offsetof(BleClientAppContext_t, ANCSCtrlPointCharValueHdle),
+    GATT_DISC_NO_FIELD
+  },
+  {
+    "ANCS_DATA_SOURCE_CHAR_UUID", GATT_DISC_SRV_ANCS, ANCS_DATA_SOURCE_CHAR_UUID,
+    offsetof(BleClientAppContext_t, ANCSDataSourceCharStartHdle),
+    offsetof(BleClientAppContext_t, ANCSDataSourceCharValueHdle),
+    offsetof(BleClientAppContext_t, ANCSDataSourceCharDescHdle)
+  },
+  {
+    "AMS_REMOTE_COMMAND_CHAR_UUID", GATT_DISC_SRV_AMS, AMS_REMOTE_COMMAND_CHAR_UUID,
+    offsetof(BleClientAppContext_t, AMSRemoteCommandCharStartHdle),
+    offsetof(BleClientAppContext_t, AMSRemoteCommandCharValueHdle),
+    offsetof(BleClientAppContext_t, AMSRemoteCommandCharDescHdle)
+  },
+  {
+    "AMS_ENTITY_UPDATE_CHAR_UUID", GATT_DISC_SRV_AMS, AMS_ENTITY_UPDATE_CHAR_UUID,
+    offsetof(BleClientAppContext_t, AMSEntityUpdateCharStartHdle),
+    offsetof(BleClientAppContext_t, AMSEntityUpdateCharValueHdle),
+    offsetof(BleClientAppContext_t, AMSEntityUpdateCharDescHdle)
+  },
+  {
+    "AMS_ENTITY_ATTRIBUTE_CHAR_UUID", GATT_DISC_SRV_AMS, AMS_ENTITY_ATTRIBUTE_CHAR_UUID,
+    offsetof(BleClientAppContext_t, AMSEntityAttributeCharStartHdle),
+    offsetof(BleClientAppContext_t, AMSEntityAttributeCharValueHdle),
+    GATT_DISC_NO_FIELD
+  },
+};
+
+/* Duration in ms of each phase of the last discovery of each link */
+static uint32_t a_GattDiscPhaseTime[BLE_CFG_CLT_MAX_NBR_CB][GATT_DISC_PHASE_NBR];
+/* Notifications being enabled by the GATT operation task */
+static uint8_t a_CccdPending[BLE_CFG_CLT_MAX_NBR_CB];
+static uint32_t a_CccdStart[BLE_CFG_CLT_MAX_NBR_CB];
+
+static GattOpQueue_t a_GattOpQueue[CFG_BLE_NUM_LINK];
+
+/* Events handled by Event_Handler, routed to it by the BLE controller */
+static const uint16_t a_GattClientEcode[] =
+{
+  ACI_ATT_READ_BY_GROUP_TYPE_RESP_VSEVT_CODE,
+  ACI_ATT_FIND_BY_TYPE_VALUE_RESP_VSEVT_CODE,
+  ACI_ATT_READ_BY_TYPE_RESP_VSEVT_CODE,
+  ACI_ATT_FIND_INFO_RESP_VSEVT_CODE,
+  ACI_ATT_READ_RESP_VSEVT_CODE,
+  ACI_ATT_READ_BLOB_RESP_VSEVT_CODE,
+  ACI_ATT_EXCHANGE_MTU_RESP_VSEVT_CODE,
+  ACI_GATT_NOTIFICATION_VSEVT_CODE,
+  ACI_GATT_INDICATION_VSEVT_CODE,
+  ACI_GATT_PROC_COMPLETE_VSEVT_CODE,
+  ACI_GATT_TX_POOL_AVAILABLE_VSEVT_CODE,
+};
 /* USER CODE END PV */
 
 /* Global variables ----------------------------------------------------------*/
@@ -171,8 +458,9 @@ static uint8_t counter_to_1_min = 0;
 extern gatt_client_interface_ams_t gatt_client_interface_ams;
 extern gatt_client_interface_ancs_t gatt_client_interface_ancs;
 
-extern AMS_init_data_t AMS_init_data;
-extern ANCS_init_data_t ANCS_init_data;
+extern AMS_init_data_t AMS_init_data[CFG_BLE_NUM_LINK];
+extern ANCS_init_data_t ANCS_init_data[CFG_BLE_NUM_LINK];
+extern Menu_Page_t *p_media_control_menu;
 
 uint8_t current_battery_level = 0;
 uint8_t current_time_hour = 0;
@@ -188,17 +476,55 @@ static void gatt_parse_descs(aci_att_find_info_resp_event_rp0 *p_evt);
 static void gatt_parse_notification(aci_gatt_notification_event_rp0 *p_evt);
 static void gatt_Notification(GATT_CLIENT_APP_Notification_evt_t *p_Notif);
 static void client_discover_all(void);
-static void gatt_cmd_resp_release(void);
-static void gatt_cmd_resp_wait(void);
+static void client_discover_link(void);
+static void client_discover(uint8_t index);
+static void client_link_setup(uint8_t index);
+static void gatt_cmd_resp_release(uint8_t index);
+static void gatt_cmd_resp_wait(uint8_t index);
 /* USER CODE BEGIN PFP */
 
-static void send_cmd_to_ams(GattCmdToAMS_t GattCmdToAMS, uint16_t char_UUID, uint8_t l_payload, uint8_t *p_Payload);
-static void send_cmd_to_ancs(GattCmdToANCS_t GattCmdToANCS, uint16_t char_UUID, uint8_t l_payload, uint8_t *p_Payload);
+static uint8_t client_get_index(uint16_t connHdl);
+static void send_cmd_to_ams(uint8_t index, GattCmdToAMS_t GattCmdToAMS, uint16_t char_UUID, uint8_t l_payload, uint8_t *p_Payload);
+static void send_cmd_to_ancs(uint8_t index, GattCmdToANCS_t GattCmdToANCS, uint16_t char_UUID, uint8_t l_payload, uint8_t *p_Payload);
 
 static void ClientTimer_cb(void *arg);
 static void ClientTimer_Task(void);
 
 static void start_notification(void *arg);
+
+static void gatt_parse_indication(aci_gatt_indication_event_rp0 *p_evt);
+static uint8_t gatt_parse_db_hash(aci_att_read_by_type_resp_event_rp0 *p_evt);
+
+static void gatt_cache_init(void);
+static uint8_t gatt_cache_identify(uint8_t index);
+static uint8_t gatt_cache_find(uint8_t index);
+static uint8_t gatt_cache_read_db_hash(uint8_t index);
+static uint8_t gatt_cache_load(uint8_t index);
+static void gatt_cache_store(uint8_t index);
+static void gatt_cache_invalidate(uint8_t index);
+static void gatt_cache_nvm_cb(SNVMA_Callback_Status_t CbkStatus);
+
+static uint8_t gatt_disc_service_has_desc(uint8_t index, GattDiscServiceId_t Service);
+static uint8_t gatt_disc_set_service(uint8_t index, uint16_t ShortUuid, uint16_t StartHdl, uint16_t EndHdl);
+static uint8_t gatt_disc_set_char(uint8_t index, uint16_t ShortUuid, uint8_t Properties, uint16_t StartHdl, uint16_t ValueHdl);
+static uint8_t gatt_disc_set_desc(uint8_t index, uint16_t CharValueHdl, uint16_t DescHdl);
+
+static uint8_t gatt_op_submit(uint8_t index, GattOpType_t Type, uint16_t AttHdl, uint16_t Length,
+                              const uint8_t *p_Data, GATT_CLIENT_APP_OpCb_t Callback, void *p_Context);
+static void gatt_op_process(void);
+static void gatt_op_start(uint8_t index);
+static void gatt_op_end(uint8_t index, GATT_CLIENT_APP_OpStatus_t Status);
+static void gatt_op_report(uint8_t index, GattOp_t *p_Op, GATT_CLIENT_APP_OpStatus_t Status);
+static void gatt_op_flush(uint8_t index);
+static void gatt_op_wait_idle(uint8_t index);
+static void gatt_op_timeout_cb(void *arg);
+static void client_cccd_cb(uint8_t index, uint8_t OpId, GATT_CLIENT_APP_OpStatus_t Status,
+                           const uint8_t *p_Data, uint16_t Length, void *p_Context);
+static void client_read_time_cb(uint8_t index, uint8_t OpId, GATT_CLIENT_APP_OpStatus_t Status,
+                                const uint8_t *p_Data, uint16_t Length, void *p_Context);
+static void client_time_update(const uint8_t *p_Data, uint16_t Length);
+static void client_read_battery_cb(uint8_t index, uint8_t OpId, GATT_CLIENT_APP_OpStatus_t Status,
+                                   const uint8_t *p_Data, uint16_t Length, void *p_Context);
 /* USER CODE END PFP */
 
 /* Functions Definition ------------------------------------------------------*/
@@ -212,41 +538,74 @@ void GATT_CLIENT_APP_Init(void)
   uint8_t index =0;
   /* USER CODE BEGIN GATT_CLIENT_APP_Init_1 */
   AMS_APP_Init();
-  AMS_init_data.connHdl = (uint16_t *) &(a_ClientContext[index].connHdl);
-  AMS_init_data.EntityAttributeCharValueHdle = (uint16_t *) &(a_ClientContext[index].AMSEntityAttributeCharValueHdle);
-  AMS_init_data.RemoteCommandCharValueHdle   = (uint16_t *) &(a_ClientContext[index].AMSRemoteCommandCharValueHdle);
-  AMS_init_data.EntityUpdateCharValueHdle    = (uint16_t *) &(a_ClientContext[index].AMSEntityUpdateCharValueHdle);
-  
   ANCS_APP_Init();
-  ANCS_init_data.app_init = false;
-  ANCS_init_data.connHdl = (uint16_t *) &(a_ClientContext[index].connHdl);
-  ANCS_init_data.CtrlPointCharValueHdle =  (uint16_t *) &(a_ClientContext[index].ANCSCtrlPointCharValueHdle);
-  ANCS_init_data.DataSourceCharValueHdle = (uint16_t *) &(a_ClientContext[index].ANCSDataSourceCharValueHdle);
-  ANCS_init_data.NotifSourceCharValueHdle = (uint16_t *) &(a_ClientContext[index].ANCSNotifSourceCharValueHdle);
+  for (index = 0; index < CFG_BLE_NUM_LINK; index++)
+  {
+    AMS_init_data[index].connHdl = (uint16_t *) &(a_ClientContext[index].connHdl);
+    AMS_init_data[index].EntityAttributeCharValueHdle = (uint16_t *) &(a_ClientContext[index].AMSEntityAttributeCharValueHdle);
+    AMS_init_data[index].RemoteCommandCharValueHdle   = (uint16_t *) &(a_ClientContext[index].AMSRemoteCommandCharValueHdle);
+    AMS_init_data[index].EntityUpdateCharValueHdle    = (uint16_t *) &(a_ClientContext[index].AMSEntityUpdateCharValueHdle);
+
+    ANCS_init_data[index].app_init = false;
+    ANCS_init_data[index].connHdl = (uint16_t *) &(a_ClientContext[index].connHdl);
+    ANCS_init_data[index].CtrlPointCharValueHdle =  (uint16_t *) &(a_ClientContext[index].ANCSCtrlPointCharValueHdle);
+    ANCS_init_data[index].DataSourceCharValueHdle = (uint16_t *) &(a_ClientContext[index].ANCSDataSourceCharValueHdle);
+    ANCS_init_data[index].NotifSourceCharValueHdle = (uint16_t *) &(a_ClientContext[index].ANCSNotifSourceCharValueHdle);
+  }
   /* USER CODE END GATT_CLIENT_APP_Init_1 */
   for(index = 0; index < BLE_CFG_CLT_MAX_NBR_CB; index++)
   {
     a_ClientContext[index].connStatus = APP_BLE_IDLE;
+    /* USER CODE BEGIN GATT_CLIENT_APP_Init_3 */
+    a_ClientContext[index].connHdl = APP_BLE_INVALID_CONN_HDL;
+    /* USER CODE END GATT_CLIENT_APP_Init_3 */
   }
 
   /* Register the event handler to the BLE controller */
   SVCCTL_RegisterCltHandler(Event_Handler);
 
   /* Register a task allowing to discover all services and characteristics and enable all notifications */
-  UTIL_SEQ_RegTask(1U << CFG_TASK_DISCOVER_SERVICES_ID, UTIL_SEQ_RFU, client_discover_all);
+  APPE_SEQ_RegTask(1U << CFG_TASK_DISCOVER_SERVICES_ID, UTIL_SEQ_RFU, client_discover_all);
 
   /* USER CODE BEGIN GATT_CLIENT_APP_Init_2 */
+  /* Route the events of the client to the handler, it then gets no other event */
+  for (index = 0; index < (sizeof(a_GattClientEcode) / sizeof(a_GattClientEcode[0])); index++)
+  {
+    SVCCTL_RegisterRoute(a_GattClientEcode[index], SVCCTL_ROUTE_HANDLE_FIRST, SVCCTL_ROUTE_HANDLE_LAST, Event_Handler);
+  }
+
+  /* Workers discovering the links concurrently */
+  for (index = 0; index < CFG_BLE_NUM_LINK; index++)
+  {
+    APPE_SEQ_RegTask(1U << (CFG_TASK_DISCOVER_LINK_ID + index), UTIL_SEQ_RFU, client_discover_link);
+  }
+
   UTIL_TIMER_Create(&ClientTimer_Id,
                     REFRESH_SCREEN_TIMER,
                     UTIL_TIMER_PERIODIC,
                     &ClientTimer_cb, 0);
   
-  UTIL_TIMER_Create(&Start_Notification_Id,
-                    200,
-                    UTIL_TIMER_ONESHOT,
-                    &start_notification, 0);  
+  for (index = 0; index < BLE_CFG_CLT_MAX_NBR_CB; index++)
+  {
+    UTIL_TIMER_Create(&a_StartNotification_Id[index],
+                      200,
+                      UTIL_TIMER_ONESHOT,
+                      &start_notification, (void *)(uint32_t)index);
+  }
   
-  UTIL_SEQ_RegTask(1U << CFG_TASK_CLIENT_TIMER_ID, UTIL_SEQ_RFU, ClientTimer_Task);
+  APPE_SEQ_RegTask(1U << CFG_TASK_CLIENT_TIMER_ID, UTIL_SEQ_RFU, ClientTimer_Task);
+
+  /* GATT operations are queued per link and run by one task */
+  APPE_SEQ_RegTask(1U << CFG_TASK_GATT_OP_ID, UTIL_SEQ_RFU, gatt_op_process);
+  for (index = 0; index < CFG_BLE_NUM_LINK; index++)
+  {
+    UTIL_TIMER_Create(&a_GattOpQueue[index].Timer,
+                      GATT_CLIENT_APP_OP_TIMEOUT_MS,
+                      UTIL_TIMER_ONESHOT,
+                      &gatt_op_timeout_cb, (void *)(uint32_t)index);
+  }
+
+  gatt_cache_init();
   /* USER CODE END GATT_CLIENT_APP_Init_2 */
   return;
 }
@@ -254,6 +613,7 @@ void GATT_CLIENT_APP_Init(void)
 void GATT_CLIENT_APP_Notification(GATT_CLIENT_APP_ConnHandle_Notif_evt_t *p_Notif)
 {
   /* USER CODE BEGIN GATT_CLIENT_APP_Notification_1 */
+  uint8_t index;
 
   /* USER CODE END GATT_CLIENT_APP_Notification_1 */
   switch(p_Notif->ConnOpcode)
@@ -264,7 +624,8 @@ void GATT_CLIENT_APP_Notification(GATT_CLIENT_APP_ConnHandle_Notif_evt_t *p_Noti
 
     case PEER_CONN_HANDLE_EVT :
       /* USER CODE BEGIN PEER_CONN_HANDLE_EVT */
-      for(uint8_t index = 0; index < BLE_CFG_CLT_MAX_NBR_CB; index++)
+      index = client_get_index(p_Notif->ConnHdl);
+      if (index < BLE_CFG_CLT_MAX_NBR_CB)
       {
         a_ClientContext[index].state = GATT_CLIENT_APP_CONNECTED;
         a_ClientContext[index].connStatus = APP_BLE_CONNECTED_CLIENT;
@@ -274,15 +635,44 @@ void GATT_CLIENT_APP_Notification(GATT_CLIENT_APP_ConnHandle_Notif_evt_t *p_Noti
 
     case PEER_DISCON_HANDLE_EVT :
       /* USER CODE BEGIN PEER_DISCON_HANDLE_EVT */
-      for(uint8_t index = 0; index < BLE_CFG_CLT_MAX_NBR_CB; index++)
+      index = client_get_index(p_Notif->ConnHdl);
+      if (index < BLE_CFG_CLT_MAX_NBR_CB)
       {
         a_ClientContext[index].state = GATT_CLIENT_APP_IDLE;
         a_ClientContext[index].connStatus = APP_BLE_IDLE;
+        /* The handle may be given to the next connection on another index */
+        a_ClientContext[index].connHdl = APP_BLE_INVALID_CONN_HDL;
+        DiscRequest &= ~(1U << index);
+        UTIL_TIMER_Stop(&a_StartNotification_Id[index]);
+        a_CccdPending[index] = 0;
+        if (index < CFG_BLE_NUM_LINK)
+        {
+          /* Queued operations end with GATT_CLIENT_APP_OP_DISCONNECTED */
+          gatt_op_flush(index);
+        }
+        if ((DiscRunning & (1U << index)) != 0)
+        {
+          /* Release the worker waiting for a procedure of the link */
+          gatt_cmd_resp_release(index);
+        }
+
+        send_cmd_to_ancs(index, ANCS_DECONNECTION, 0, 0, NULL);
+        send_cmd_to_ams(index, AMS_DECONNECTION, 0, 0, NULL);
+      }
+
+      for (index = 0; index < BLE_CFG_CLT_MAX_NBR_CB; index++)
+      {
+        if (a_ClientContext[index].connHdl != APP_BLE_INVALID_CONN_HDL)
+        {
+          break;
+        }
+      }
+      if (index == BLE_CFG_CLT_MAX_NBR_CB)
+      {
+        /* No phone connected anymore */
+        UTIL_TIMER_Stop(&ClientTimer_Id);
+        current_battery_level = 0;
       }
-      UTIL_TIMER_Stop(&ClientTimer_Id);
-      current_battery_level = 0;
-      send_cmd_to_ancs(ANCS_DECONNECTION, NULL, NULL, NULL);
-      send_cmd_to_ams(AMS_DECONNECTION, NULL, NULL, NULL);
       /* USER CODE END PEER_DISCON_HANDLE_EVT */
       break;
 
@@ -322,10 +712,34 @@ uint8_t GATT_CLIENT_APP_Get_State(uint8_t index)
 
 void GATT_CLIENT_APP_Discover_services(uint8_t index)
 {
-  GATT_CLIENT_APP_Procedure_Gatt(index, PROC_GATT_DISC_ALL_PRIMARY_SERVICES);
-  GATT_CLIENT_APP_Procedure_Gatt(index, PROC_GATT_DISC_ALL_CHARS);
-  GATT_CLIENT_APP_Procedure_Gatt(index, PROC_GATT_DISC_ALL_DESCS);
-  GATT_CLIENT_APP_Procedure_Gatt(index, PROC_GATT_PROPERTIES_ENABLE_ALL);
+  /* USER CODE BEGIN GATT_CLIENT_APP_Discover_services */
+  static const ProcGattId_t a_Phases[GATT_DISC_PHASE_NBR] =
+  {
+    [GATT_DISC_PHASE_SERVICES] = PROC_GATT_DISC_PLAN_SERVICES,
+    [GATT_DISC_PHASE_CHARS]    = PROC_GATT_DISC_PLAN_CHARS,
+    [GATT_DISC_PHASE_DESCS]    = PROC_GATT_DISC_PLAN_DESCS,
+    [GATT_DISC_PHASE_ENABLE]   = PROC_GATT_PROPERTIES_ENABLE_ALL,
+  };
+  uint32_t phase_start;
+  uint32_t total = 0;
+
+  /* Only the services and characteristics of the discovery plan are discovered */
+  for (uint8_t phase = 0; phase < GATT_DISC_PHASE_NBR; phase++)
+  {
+    phase_start = UTIL_TIMER_GetCurrentTime();
+    GATT_CLIENT_APP_Procedure_Gatt(index, a_Phases[phase]);
+    a_GattDiscPhaseTime[index][phase] = UTIL_TIMER_GetElapsedTime(phase_start);
+    total += a_GattDiscPhaseTime[index][phase];
+  }
+
+  LOG_INFO_APP("Link %d discovery timing: services %d ms, chars %d ms, descs %d ms, enable queued %d ms, total %d ms\n",
+               index,
+               a_GattDiscPhaseTime[index][GATT_DISC_PHASE_SERVICES],
+               a_GattDiscPhaseTime[index][GATT_DISC_PHASE_CHARS],
+               a_GattDiscPhaseTime[index][GATT_DISC_PHASE_DESCS],
+               a_GattDiscPhaseTime[index][GATT_DISC_PHASE_ENABLE],
+               total);
+  /* USER CODE END GATT_CLIENT_APP_Discover_services */
 
   return;
 }
@@ -353,7 +767,7 @@ uint8_t GATT_CLIENT_APP_Procedure_Gatt(uint8_t index, ProcGattId_t GattProcId)
 
         if (result == BLE_STATUS_SUCCESS)
         {
-          gatt_cmd_resp_wait();
+          gatt_cmd_resp_wait(index);
           LOG_INFO_APP("PROC_GATT_DISC_ALL_PRIMARY_SERVICES services discovered Successfully\n\n");
         }
         else
@@ -379,7 +793,7 @@ uint8_t GATT_CLIENT_APP_Procedure_Gatt(uint8_t index, ProcGattId_t GattProcId)
 
         if (result == BLE_STATUS_SUCCESS)
         {
-          gatt_cmd_resp_wait();
+          gatt_cmd_resp_wait(index);
           LOG_INFO_APP("All characteristics discovered Successfully\n\n");
         }
         else
@@ -403,7 +817,7 @@ uint8_t GATT_CLIENT_APP_Procedure_Gatt(uint8_t index, ProcGattId_t GattProcId)
 
         if (result == BLE_STATUS_SUCCESS)
         {
-          gatt_cmd_resp_wait();
+          gatt_cmd_resp_wait(index);
           LOG_INFO_APP("All characteristic descriptors discovered Successfully\n\n");
         }
         else
@@ -412,114 +826,143 @@ uint8_t GATT_CLIENT_APP_Procedure_Gatt(uint8_t index, ProcGattId_t GattProcId)
         }
       }
       break; /* PROC_GATT_DISC_ALL_DESCS */
-      case PROC_GATT_PROPERTIES_ENABLE_ALL:
+      /* USER CODE BEGIN PROC_GATT */
+      case PROC_GATT_DISC_PLAN_SERVICES:
       {
-        uint16_t charPropVal = 0x0000;
+        UUID_t uuid;
 
-        if (a_ClientContext[index].ServiceChangedCharDescHdl != 0x0000)
-        {
-          if(((a_ClientContext[index].ServiceChangedCharProperties) & CHAR_PROP_NOTIFY) == CHAR_PROP_NOTIFY)
-          {
-            charPropVal = 0x0001;
-          }
-          if(((a_ClientContext[index].ServiceChangedCharProperties) & CHAR_PROP_INDICATE) == CHAR_PROP_INDICATE)
-          {
-            charPropVal = 0x0002;
-          }
-          result = aci_gatt_write_char_desc(a_ClientContext[index].connHdl,
-                                            a_ClientContext[index].ServiceChangedCharDescHdl,
-                                            2,
-                                            (uint8_t *) &charPropVal);
-          gatt_cmd_resp_wait();
-          LOG_INFO_APP(" ServiceChangedCharDescHdl =0x%04X\n",a_ClientContext[index].ServiceChangedCharDescHdl);
-        }
-        /* USER CODE BEGIN PROC_GATT_PROPERTIES_ENABLE_ALL */
-        uint8_t enable = 0x01;
+        a_ClientContext[index].state = GATT_CLIENT_APP_DISCOVER_SERVICES;
 
-        if(a_ClientContext[index].AMSEntityUpdateCharDescHdle != 0x0000)
+        /* Services are discovered by UUID, one after the other */
+        for (uint8_t srv = 0; srv < GATT_DISC_NBR_SERVICES; srv++)
         {
-          result = aci_gatt_write_char_desc(a_ClientContext[index].connHdl,
-                                            a_ClientContext[index].AMSEntityUpdateCharDescHdle,
-                                            2,
-                                            (uint8_t *) &enable);
+          a_ClientPeer[index].DiscService = srv;
+          uuid = a_GattDiscServices[srv].Uuid;
+
+          result = aci_gatt_disc_primary_service_by_uuid(a_ClientContext[index].connHdl,
+                                                         a_GattDiscServices[srv].UuidType,
+                                                         &uuid);
           if (result == BLE_STATUS_SUCCESS)
           {
-            LOG_INFO_APP("  AMS Entity Update notification enabled Successfully\n");
-            gatt_cmd_resp_wait();  
+            gatt_cmd_resp_wait(index);
           }
           else
           {
-            LOG_INFO_APP("  AMS Entity Update notification enabled Failed result=0x%02X\n",result);
-          }  
+            LOG_INFO_APP("%s discovery Failed, status =0x%02X\n", a_GattDiscServices[srv].p_Name, result);
+          }
         }
-        
-        if(a_ClientContext[index].AMSRemoteCommandCharDescHdle != 0x0000)
+        a_ClientPeer[index].DiscService = GATT_DISC_NBR_SERVICES;
+
+        LOG_INFO_APP("Services of the discovery plan discovered\n\n");
+      }
+      break; /* PROC_GATT_DISC_PLAN_SERVICES */
+
+      case PROC_GATT_DISC_PLAN_CHARS:
+      {
+        uint16_t start_hdl, end_hdl;
+
+        a_ClientContext[index].state = GATT_CLIENT_APP_DISCOVER_CHARACS;
+
+        for (uint8_t srv = 0; srv < GATT_DISC_NBR_SERVICES; srv++)
         {
-          result = aci_gatt_write_char_desc(a_ClientContext[index].connHdl,
-                                            a_ClientContext[index].AMSRemoteCommandCharDescHdle,
-                                            2,
-                                            (uint8_t *) &enable);
-          if (result == BLE_STATUS_SUCCESS)
+          start_hdl = GATT_DISC_HDL(index, a_GattDiscServices[srv].StartHdlOffset);
+          end_hdl = GATT_DISC_HDL(index, a_GattDiscServices[srv].EndHdlOffset);
+
+          if (start_hdl != 0x0000)
           {
-            LOG_INFO_APP("  AMS Remote Command notification enabled Successfully\n");
-            gatt_cmd_resp_wait();          
+            result = aci_gatt_disc_all_char_of_service(a_ClientContext[index].connHdl, start_hdl, end_hdl);
+            if (result == BLE_STATUS_SUCCESS)
+            {
+              gatt_cmd_resp_wait(index);
+            }
+            else
+            {
+              LOG_INFO_APP("%s characteristics discovery Failed, status =0x%02X\n", a_GattDiscServices[srv].p_Name, result);
+            }
           }
-          else
-          {
-            LOG_INFO_APP("  AMS Remote Command notification enabled Failed result=0x%02X\n",result);
-          }          
         }
-        
-        if(a_ClientContext[index].BatteryLevelCharDescHdle != 0x0000)
+
+        LOG_INFO_APP("Characteristics of the discovery plan discovered\n\n");
+      }
+      break; /* PROC_GATT_DISC_PLAN_CHARS */
+
+      case PROC_GATT_DISC_PLAN_DESCS:
+      {
+        uint16_t start_hdl, end_hdl;
+
+        a_ClientContext[index].state = GATT_CLIENT_APP_DISCOVER_WRITE_DESC;
+
+        /* Descriptors are only looked for in the services holding a characteristic to enable */
+        for (uint8_t srv = 0; srv < GATT_DISC_NBR_SERVICES; srv++)
         {
-          result = aci_gatt_write_char_desc(a_ClientContext[index].connHdl,
-                                            a_ClientContext[index].BatteryLevelCharDescHdle,
-                                            2,
-                                            (uint8_t *) &enable);
-          if (result == BLE_STATUS_SUCCESS)
+          start_hdl = GATT_DISC_HDL(index, a_GattDiscServices[srv].StartHdlOffset);
+          end_hdl = GATT_DISC_HDL(index, a_GattDiscServices[srv].EndHdlOffset);
+
+          if ((start_hdl != 0x0000) && (gatt_disc_service_has_desc(index, (GattDiscServiceId_t)srv) != 0))
           {
-            LOG_INFO_APP("  Battery Level notification enabled Successfully \n\r");
-            gatt_cmd_resp_wait();          
+            result = aci_gatt_disc_all_char_desc(a_ClientContext[index].connHdl, start_hdl, end_hdl);
+            if (result == BLE_STATUS_SUCCESS)
+            {
+              gatt_cmd_resp_wait(index);
+            }
+            else
+            {
+              LOG_INFO_APP("%s descriptors discovery Failed, status =0x%02X\n", a_GattDiscServices[srv].p_Name, result);
+            }
           }
-          else
-          {
-            LOG_INFO_APP("  Battery Level notification enabled Failed result=0x%02X\n",result);
-          }          
         }
 
-        if(a_ClientContext[index].ANCSDataSourceCharDescHdle!= 0x0000)
+        LOG_INFO_APP("Descriptors of the discovery plan discovered\n\n");
+      }
+      break; /* PROC_GATT_DISC_PLAN_DESCS */
+      /* USER CODE END PROC_GATT */
+      case PROC_GATT_PROPERTIES_ENABLE_ALL:
+      {
+        uint16_t charPropVal = 0x0000;
+
+        if (a_ClientContext[index].ServiceChangedCharDescHdl != 0x0000)
         {
-          result = aci_gatt_write_char_desc(a_ClientContext[index].connHdl,
-                                            a_ClientContext[index].ANCSDataSourceCharDescHdle,
-                                            2,
-                                            (uint8_t *) &enable);
-          if (result == BLE_STATUS_SUCCESS)
+          if(((a_ClientContext[index].ServiceChangedCharProperties) & CHAR_PROP_NOTIFY) == CHAR_PROP_NOTIFY)
           {
-            LOG_INFO_APP("  ANCS Data Source notification enabled Successfully\n");
-            gatt_cmd_resp_wait();          
+            charPropVal = 0x0001;
           }
-          else
+          if(((a_ClientContext[index].ServiceChangedCharProperties) & CHAR_PROP_INDICATE) == CHAR_PROP_INDICATE)
           {
-            LOG_INFO_APP("  ANCS Data Source notification enabled Failed result=0x%02X\n",result);
-          }          
-        }
-        
-        if(a_ClientContext[index].ANCSNotifSourceCharDescHdle!= 0x0000)
-        {
+            charPropVal = 0x0002;
+          }
           result = aci_gatt_write_char_desc(a_ClientContext[index].connHdl,
-                                            a_ClientContext[index].ANCSNotifSourceCharDescHdle,
+                                            a_ClientContext[index].ServiceChangedCharDescHdl,
                                             2,
-                                            (uint8_t *) &enable);
-          if (result == BLE_STATUS_SUCCESS)
+                                            (uint8_t *) &charPropVal);
+          gatt_cmd_resp_wait(index);
+          LOG_INFO_APP(" ServiceChangedCharDescHdl =0x%04X\n",a_ClientContext[index].ServiceChangedCharDescHdl);
+        }
+        /* USER CODE BEGIN PROC_GATT_PROPERTIES_ENABLE_ALL */
+        uint16_t desc_hdl;
+
+        /* Queued, the GATT operation task writes them once the discovery of the link is over */
+        a_CccdStart[index] = UTIL_TIMER_GetCurrentTime();
+        for (uint8_t chr = 0; chr < GATT_DISC_NBR_CHARS; chr++)
+        {
+          /* Service Changed is enabled above, according to its properties */
+          if ((a_GattDiscChars[chr].DescHdlOffset != GATT_DISC_NO_FIELD) &&
+              (a_GattDiscChars[chr].DescHdlOffset != offsetof(BleClientAppContext_t, ServiceChangedCharDescHdl)))
           {
-            LOG_INFO_APP("  ANCS Notif Source notification enabled Successfully\n");
-            gatt_cmd_resp_wait();  
+            desc_hdl = GATT_DISC_HDL(index, a_GattDiscChars[chr].DescHdlOffset);
+            if (desc_hdl != 0x0000)
+            {
+              if (GATT_CLIENT_APP_Op_Enable_Cccd(index, desc_hdl, 0x0001, client_cccd_cb, (void *)(uint32_t)chr) != GATT_CLIENT_APP_OP_INVALID_ID)
+              {
+                a_CccdPending[index]++;
+              }
+              else
+              {
+                LOG_INFO_APP("  %s notification enable not queued\n", a_GattDiscChars[chr].p_Name);
+                result = BLE_STATUS_FAILED;
+              }
+            }
           }
-          else
-          {
-            LOG_INFO_APP("  ANCS Notif Source notification enabled Failed result=0x%02X\n",result);
-          }          
-        }        
+        }
         /* USER CODE END PROC_GATT_PROPERTIES_ENABLE_ALL */
 
         if (result == BLE_STATUS_SUCCESS)
@@ -541,7 +984,159 @@ uint8_t GATT_CLIENT_APP_Procedure_Gatt(uint8_t index, ProcGattId_t GattProcId)
 }
 
 /* USER CODE BEGIN FD */
+/**
+ * @brief  Record the address of the peer, used to retrieve its GATT discovery cache
+ * @param  index: Index of the client context
+ * @param  PeerAddrType: Address type given by the connection complete event
+ * @param  p_PeerAddr: Address given by the connection complete event
+ * @retval None
+ */
+void GATT_CLIENT_APP_Set_Peer_Address(uint8_t index, uint8_t PeerAddrType, const uint8_t *p_PeerAddr)
+{
+  if (index < BLE_CFG_CLT_MAX_NBR_CB)
+  {
+    a_ClientPeer[index].PeerAddrType = PeerAddrType;
+    memcpy(a_ClientPeer[index].PeerAddr, p_PeerAddr, sizeof(a_ClientPeer[index].PeerAddr));
+  }
+
+  return;
+}
+
+/**
+ * @brief  Request the discovery of a link, run by a worker task concurrently with the other links
+ * @param  index: Index of the client context
+ * @retval None
+ */
+void GATT_CLIENT_APP_Request_Discovery(uint8_t index)
+{
+  if (index < CFG_BLE_NUM_LINK)
+  {
+    DiscRequest |= (1U << index);
+    UTIL_SEQ_SetTask(1U << CFG_TASK_DISCOVER_SERVICES_ID, CFG_SEQ_PRIO_0);
+  }
+
+  return;
+}
+
+/**
+ * @brief  Queue the read of a characteristic value
+ * @param  index: Index of the link
+ * @param  AttHdl: Handle of the characteristic value
+ * @param  Callback: Called with the value read, may be NULL
+ * @param  p_Context: Given back to the callback
+ * @retval Identifier of the operation, GATT_CLIENT_APP_OP_INVALID_ID when not queued
+ */
+uint8_t GATT_CLIENT_APP_Op_Read(uint8_t index, uint16_t AttHdl, GATT_CLIENT_APP_OpCb_t Callback, void *p_Context)
+{
+  return gatt_op_submit(index, GATT_OP_READ, AttHdl, 0, NULL, Callback, p_Context);
+}
+
+/**
+ * @brief  Queue the read of a characteristic value longer than ATT_MTU - 1,
+ *         read in several parts. The callback gets the first
+ *         GATT_CLIENT_APP_OP_DATA_SIZE bytes at most
+ * @param  index: Index of the link
+ * @param  AttHdl: Handle of the characteristic value
+ * @param  Callback: Called with the value read, may be NULL
+ * @param  p_Context: Given back to the callback
+ * @retval Identifier of the operation, GATT_CLIENT_APP_OP_INVALID_ID when not queued
+ */
+uint8_t GATT_CLIENT_APP_Op_Read_Long(uint8_t index, uint16_t AttHdl, GATT_CLIENT_APP_OpCb_t Callback, void *p_Context)
+{
+  return gatt_op_submit(index, GATT_OP_READ_LONG, AttHdl, 0, NULL, Callback, p_Context);
+}
+
+/**
+ * @brief  Queue the write of a characteristic value, acknowledged by the peer
+ * @param  index: Index of the link
+ * @param  AttHdl: Handle of the characteristic value
+ * @param  Length: Length of the value, up to GATT_CLIENT_APP_OP_DATA_SIZE
+ * @param  p_Data: Value, copied in the queue
+ * @param  Callback: Called at the end of the write, may be NULL
+ * @param  p_Context: Given back to the callback
+ * @retval Identifier of the operation, GATT_CLIENT_APP_OP_INVALID_ID when not queued
+ */
+uint8_t GATT_CLIENT_APP_Op_Write(uint8_t index, uint16_t AttHdl, uint16_t Length, const uint8_t *p_Data,
+                                 GATT_CLIENT_APP_OpCb_t Callback, void *p_Context)
+{
+  return gatt_op_submit(index, GATT_OP_WRITE, AttHdl, Length, p_Data, Callback, p_Context);
+}
+
+/**
+ * @brief  Queue the write of a characteristic value without response
+ * @param  index: Index of the link
+ * @param  AttHdl: Handle of the characteristic value
+ * @param  Length: Length of the value, up to GATT_CLIENT_APP_OP_DATA_SIZE
+ * @param  p_Data: Value, copied in the queue
+ * @param  Callback: Called once the value is given to the stack, may be NULL
+ * @param  p_Context: Given back to the callback
+ * @retval Identifier of the operation, GATT_CLIENT_APP_OP_INVALID_ID when not queued
+ */
+uint8_t GATT_CLIENT_APP_Op_Write_No_Resp(uint8_t index, uint16_t AttHdl, uint16_t Length, const uint8_t *p_Data,
+                                         GATT_CLIENT_APP_OpCb_t Callback, void *p_Context)
+{
+  return gatt_op_submit(index, GATT_OP_WRITE_NO_RESP, AttHdl, Length, p_Data, Callback, p_Context);
+}
+
+/**
+ * @brief  Queue the write of a Client Characteristic Configuration descriptor
+ * @param  index: Index of the link
+ * @param  DescHdl: Handle of the descriptor
+ * @param  CccdValue: 0x0001 for notifications, 0x0002 for indications
+ * @param  Callback: Called at the end of the write, may be NULL
+ * @param  p_Context: Given back to the callback
+ * @retval Identifier of the operation, GATT_CLIENT_APP_OP_INVALID_ID when not queued
+ */
+uint8_t GATT_CLIENT_APP_Op_Enable_Cccd(uint8_t index, uint16_t DescHdl, uint16_t CccdValue,
+                                       GATT_CLIENT_APP_OpCb_t Callback, void *p_Context)
+{
+  uint8_t a_value[2];
+
+  a_value[0] = (uint8_t)(CccdValue & 0xFF);
+  a_value[1] = (uint8_t)(CccdValue >> 8);
+
+  return gatt_op_submit(index, GATT_OP_ENABLE_CCCD, DescHdl, sizeof(a_value), a_value, Callback, p_Context);
+}
+
+/**
+ * @brief  Cancel a queued GATT operation
+ *         The callback is called with GATT_CLIENT_APP_OP_CANCELLED before returning. A running
+ *         procedure cannot be stopped in the stack, the next operation waits for its end.
+ * @param  index: Index of the link
+ * @param  OpId: Identifier returned when the operation was queued
+ * @retval 0 when cancelled, 1 when the operation is unknown or already reported
+ */
+uint8_t GATT_CLIENT_APP_Op_Cancel(uint8_t index, uint8_t OpId)
+{
+  GattOpQueue_t *p_queue;
+  GattOp_t *p_op;
+
+  if ((index >= CFG_BLE_NUM_LINK) || (OpId == GATT_CLIENT_APP_OP_INVALID_ID))
+  {
+    return 1;
+  }
 
+  p_queue = &a_GattOpQueue[index];
+  for (uint8_t pos = 0; pos < p_queue->Count; pos++)
+  {
+    p_op = &p_queue->a_Op[(p_queue->Head + pos) % GATT_CLIENT_APP_OP_QUEUE_SIZE];
+    if ((p_op->Id == OpId) && (p_op->Reported == 0))
+    {
+      p_queue->Cancelled++;
+      if ((pos == 0) && (p_queue->State == GATT_OP_STATE_TX_FULL))
+      {
+        /* Nothing given to the stack yet */
+        p_queue->State = GATT_OP_STATE_IDLE;
+      }
+      gatt_op_report(index, p_op, GATT_CLIENT_APP_OP_CANCELLED);
+      /* Dropped by the GATT operation task, when started or at the end of its procedure */
+      UTIL_SEQ_SetTask(1U << CFG_TASK_GATT_OP_ID, CFG_SEQ_PRIO_0);
+      return 0;
+    }
+  }
+
+  return 1;
+}
 /* USER CODE END FD */
 
 /*************************************************************
@@ -572,6 +1167,7 @@ static SVCCTL_EvtAckStatus_t Event_Handler(void *Event)
     case HCI_VENDOR_SPECIFIC_DEBUG_EVT_CODE:
     {
       p_blecore_evt = (evt_blecore_aci*)event_pckt->data;
+      APP_BLE_LinkProbe_Rx(event_pckt->plen);
       switch (p_blecore_evt->ecode)
       {
         case ACI_ATT_READ_BY_GROUP_TYPE_RESP_VSEVT_CODE:
@@ -589,7 +1185,11 @@ static SVCCTL_EvtAckStatus_t Event_Handler(void *Event)
         case ACI_ATT_READ_BY_TYPE_RESP_VSEVT_CODE:
         {
           aci_att_read_by_type_resp_event_rp0 *p_evt_rsp = (void*)p_blecore_evt->data;
-          gatt_parse_chars((aci_att_read_by_type_resp_event_rp0 *)p_evt_rsp);
+          /* Database Hash read by UUID shares this response with the characteristics discovery */
+          if (gatt_parse_db_hash((aci_att_read_by_type_resp_event_rp0 *)p_evt_rsp) == 0)
+          {
+            gatt_parse_chars((aci_att_read_by_type_resp_event_rp0 *)p_evt_rsp);
+          }
         }
         break; /* ACI_ATT_READ_BY_TYPE_RESP_VSEVT_CODE */
         case ACI_ATT_FIND_INFO_RESP_VSEVT_CODE:
@@ -604,19 +1204,33 @@ static SVCCTL_EvtAckStatus_t Event_Handler(void *Event)
           gatt_parse_notification((aci_gatt_notification_event_rp0 *)p_evt_rsp);
         }
         break;/* ACI_GATT_NOTIFICATION_VSEVT_CODE */
+        case ACI_GATT_INDICATION_VSEVT_CODE:
+        {
+          aci_gatt_indication_event_rp0 *p_evt_rsp = (void*)p_blecore_evt->data;
+          gatt_parse_indication((aci_gatt_indication_event_rp0 *)p_evt_rsp);
+        }
+        break;/* ACI_GATT_INDICATION_VSEVT_CODE */
         case ACI_GATT_PROC_COMPLETE_VSEVT_CODE:
         {
           aci_gatt_proc_complete_event_rp0 *p_evt_rsp = (void*)p_blecore_evt->data;
 
-          uint8_t index;
-          for (index = 0 ; index < BLE_CFG_CLT_MAX_NBR_CB ; index++)
+          uint8_t index = client_get_index(p_evt_rsp->Connection_Handle);
+          if ((index < CFG_BLE_NUM_LINK) && (a_GattOpQueue[index].State == GATT_OP_STATE_PENDING))
           {
-            if (a_ClientContext[index].connHdl == p_evt_rsp->Connection_Handle)
+            /* End of a queued operation, reported by the GATT operation task */
+            a_GattOpQueue[index].State = GATT_OP_STATE_COMPLETE;
+            a_GattOpQueue[index].ProcStatus = p_evt_rsp->Error_Code;
+            UTIL_SEQ_SetTask(1U << CFG_TASK_GATT_OP_ID, CFG_SEQ_PRIO_0);
+            if (a_GattOpQueue[index].DiscWaiting != 0)
             {
-              gatt_cmd_resp_release();
-              break;
+              gatt_cmd_resp_release(index);
             }
           }
+          else if ((index < CFG_BLE_NUM_LINK) && ((DiscRunning & (1U << index)) != 0))
+          {
+            /* End of a discovery procedure */
+            gatt_cmd_resp_release(index);
+          }
         }
         break;/* ACI_GATT_PROC_COMPLETE_VSEVT_CODE */
         case ACI_GATT_TX_POOL_AVAILABLE_VSEVT_CODE:
@@ -625,8 +1239,16 @@ static SVCCTL_EvtAckStatus_t Event_Handler(void *Event)
           tx_pool_available = (aci_att_exchange_mtu_resp_event_rp0 *)p_blecore_evt->data;
           UNUSED(tx_pool_available);
           /* USER CODE BEGIN ACI_GATT_TX_POOL_AVAILABLE_VSEVT_CODE */
-
-          /* USER CODE END ACI_GATT_TX_POOL_AVAILABLE_VSEVT_CODE */
+          for (uint8_t index = 0; index < CFG_BLE_NUM_LINK; index++)
+          {
+            if (a_GattOpQueue[index].State == GATT_OP_STATE_TX_FULL)
+            {
+              /* Write without response tried again by the GATT operation task */
+              a_GattOpQueue[index].State = GATT_OP_STATE_IDLE;
+              UTIL_SEQ_SetTask(1U << CFG_TASK_GATT_OP_ID, CFG_SEQ_PRIO_0);
+            }
+          }
+          /* USER CODE END ACI_GATT_TX_POOL_AVAILABLE_VSEVT_CODE */
         }
         break;/* ACI_GATT_TX_POOL_AVAILABLE_VSEVT_CODE*/
         case ACI_ATT_EXCHANGE_MTU_RESP_VSEVT_CODE:
@@ -640,23 +1262,26 @@ static SVCCTL_EvtAckStatus_t Event_Handler(void *Event)
         break;
         
         case ACI_ATT_READ_RESP_VSEVT_CODE :
+        case ACI_ATT_READ_BLOB_RESP_VSEVT_CODE :
         {
+          /* Both responses share the same layout, the parts of a long read are appended */
           aci_att_read_resp_event_rp0 *p_evt_read = (void*)p_blecore_evt->data;
-          if (init_state ==  CLIENT_READ_TIME)
-          {
-//            LOG_INFO_APP("  Incoming Read received Current Time = %02d:%02d:%02d\n",
-//                         p_evt_read->Attribute_Value[4],
-//                         p_evt_read->Attribute_Value[5],
-//                         p_evt_read->Attribute_Value[6]);
-            current_time_hour = p_evt_read->Attribute_Value[4];
-            current_time_min = p_evt_read->Attribute_Value[5];
-            counter_to_1_min = p_evt_read->Attribute_Value[6] * 1000 / REFRESH_SCREEN_TIMER;
-            UTIL_TIMER_Start(&ClientTimer_Id);
-          }
-          else if (init_state ==  CLIENT_READ_BATTERY_LEVEL)
+          uint8_t index = client_get_index(p_evt_read->Connection_Handle);
+          if ((index < CFG_BLE_NUM_LINK) && (a_GattOpQueue[index].State == GATT_OP_STATE_PENDING))
           {
-            current_battery_level = p_evt_read->Attribute_Value[0];             
-//            LOG_INFO_APP("  Incoming Read received Battery Level = %2d%%\n", current_battery_level);
+            GattOp_t *p_op = &a_GattOpQueue[index].a_Op[a_GattOpQueue[index].Head];
+            uint16_t length = p_evt_read->Event_Data_Length;
+
+            /* Value given to the callback of the read at the end of the procedure */
+            if ((p_op->Type == GATT_OP_READ) || (p_op->Type == GATT_OP_READ_LONG))
+            {
+              if (length > (GATT_CLIENT_APP_OP_DATA_SIZE - p_op->Length))
+              {
+                length = GATT_CLIENT_APP_OP_DATA_SIZE - p_op->Length;
+              }
+              memcpy(&p_op->a_Data[p_op->Length], p_evt_read->Attribute_Value, length);
+              p_op->Length += length;
+            }
           }
           /* USER CODE END ACI_ATT_EXCHANGE_MTU_RESP_VSEVT_CODE */
         }
@@ -775,44 +1400,10 @@ static void gatt_parse_services(aci_att_read_by_group_type_resp_event_rp0 *p_evt
 
         LOG_INFO_APP(", GAP_SERVICE_UUID found\n");
       }
-      else if (uuid == GENERIC_ATTRIBUTE_SERVICE_UUID)
-      {
-        a_ClientContext[index].GATTServiceStartHdl = ServiceStartHdl;
-        a_ClientContext[index].GATTServiceEndHdl = ServiceEndHdl;
-
-        LOG_INFO_APP(", GENERIC_ATTRIBUTE_SERVICE_UUID found\n");
-      }
 /* USER CODE BEGIN gatt_parse_services_1 */
-      else if (uuid == DEVICE_INFORMATION_SERVICE_UUID)
-      {
-        LOG_INFO_APP(", DEVICE_INFORMATION_SERVICE_UUID found\n");
-      }
-      else if (uuid == CURRENT_TIME_SERVICE_UUID)
-      {
-        a_ClientContext[index].CurrentTimeServiceStartHandle = ServiceStartHdl;
-        a_ClientContext[index].CurrentTimeServiceEndHandle = ServiceEndHdl;        
-        LOG_INFO_APP(", CURRENT_TIME_SERVICE_UUID found\n");
-      }
-      else if (uuid == AMS_SERVICE_UUID)
-      {
-        a_ClientContext[index].AMSServiceStartHandle = ServiceStartHdl;
-        a_ClientContext[index].AMSServiceEndHandle = ServiceEndHdl;
-
-        LOG_INFO_APP(", AMS_SERVICE_UUID found\n");
-      }
-      else if (uuid == ANCS_SERVICE_UUID)
+      else if (gatt_disc_set_service(index, uuid, ServiceStartHdl, ServiceEndHdl) != 0)
       {
-        a_ClientContext[index].ANCSServiceStartHandle = ServiceStartHdl;
-        a_ClientContext[index].ANCSServiceEndHandle = ServiceEndHdl;
-
-        LOG_INFO_APP(", ANCS_SERVICE_UUID found\n");
-      }
-      else if (uuid == BATTERY_SERVICE_UUID)
-      {
-        a_ClientContext[index].BatteryServiceStartHandle = ServiceStartHdl;
-        a_ClientContext[index].BatteryServiceEndHandle = ServiceEndHdl;
-
-        LOG_INFO_APP(", BATTERY_SERVICE_UUID found\n");
+        /* Service of the discovery plan, logged by gatt_disc_set_service */
       }
 /* USER CODE END gatt_parse_services_1 */
       else
@@ -851,7 +1442,30 @@ static void gatt_parse_services_by_UUID(aci_att_find_by_type_value_resp_event_rp
   }
 
 /* USER CODE BEGIN gatt_parse_services_by_UUID_1 */
+  uint8_t index;
+
+  for (index = 0 ; index < BLE_CFG_CLT_MAX_NBR_CB ; index++)
+  {
+    if (a_ClientContext[index].connHdl == p_evt->Connection_Handle)
+    {
+      break;
+    }
+  }
 
+  /* Only the first instance of a service of the discovery plan is used */
+  if ((index < BLE_CFG_CLT_MAX_NBR_CB) &&
+      (a_ClientPeer[index].DiscService < GATT_DISC_NBR_SERVICES) &&
+      (p_evt->Num_of_Handle_Pair > 0))
+  {
+    LOG_INFO_APP("  short UUID=0x%04X, handle [0x%04X - 0x%04X]",
+                 a_GattDiscServices[a_ClientPeer[index].DiscService].ShortUuid,
+                 p_evt->Attribute_Group_Handle_Pair[0].Found_Attribute_Handle,
+                 p_evt->Attribute_Group_Handle_Pair[0].Group_End_Handle);
+    gatt_disc_set_service(index,
+                          a_GattDiscServices[a_ClientPeer[index].DiscService].ShortUuid,
+                          p_evt->Attribute_Group_Handle_Pair[0].Found_Attribute_Handle,
+                          p_evt->Attribute_Group_Handle_Pair[0].Group_End_Handle);
+  }
 /* USER CODE END gatt_parse_services_by_UUID_1 */
 
   return;
@@ -931,76 +1545,10 @@ static void gatt_parse_chars(aci_att_read_by_type_resp_event_rp0 *p_evt)
         {
           LOG_INFO_APP(", GAP APPEARANCE charac found\n");
         }
-        else if (uuid == SERVICE_CHANGED_CHARACTERISTIC_UUID)
-        {
-          a_ClientContext[index].ServiceChangedCharStartHdl = CharStartHdl;
-          a_ClientContext[index].ServiceChangedCharValueHdl = CharValueHdl;
-          LOG_INFO_APP(", GATT SERVICE_CHANGED_CHARACTERISTIC_UUID charac found\n");
-        }
 /* USER CODE BEGIN gatt_parse_chars_1 */
-        else if (uuid == MANUFACTURER_NAME_UUID)
-        {
-          //Not Used
-          LOG_INFO_APP(", MANUFACTURER_NAME_UUID charac found\n");
-        }
-        else if (uuid == MODEL_NUMBER_UUID)
-        {
-          //Not Used
-          LOG_INFO_APP(", MODEL_NUMBER_UUID charac found\n");
-        }
-        else if (uuid == BATTERY_LEVEL_CHAR_UUID)
-        {
-          a_ClientContext[index].BatteryLevelCharStartHdle = CharStartHdl;
-          a_ClientContext[index].BatteryLevelCharValueHdle = CharValueHdl;
-          LOG_INFO_APP(", BATTERY_LEVEL_CHAR_UUID charac found\n");
-        }
-        else if (uuid == CURRENT_TIME_CHAR_UUID)
-        {
-          a_ClientContext[index].CurrentTimeCharStartHdle = CharStartHdl;
-          a_ClientContext[index].CurrentTimeCharValueHdle = CharValueHdl;
-          LOG_INFO_APP(", CURRENT_TIME_CHAR_UUID charac found\n");
-        }
-        else if (uuid == LOCAL_TIME_INFORMATION_CHAR_UUID)
-        {
-          //Not Used
-          LOG_INFO_APP(", LOCAL_TIME_INFORMATION_CHAR_UUID charac found\n");
-        }
-        else if (uuid == AMS_REMOTE_COMMAND_CHAR_UUID)
+        else if (gatt_disc_set_char(index, uuid, CharProperties, CharStartHdl, CharValueHdl) != 0)
         {
-          a_ClientContext[index].AMSRemoteCommandCharStartHdle = CharStartHdl;
-          a_ClientContext[index].AMSRemoteCommandCharValueHdle = CharValueHdl;
-          LOG_INFO_APP(", AMS_REMOTE_COMMAND_CHAR_UUID charac found\n");
-        }
-        else if (uuid == AMS_ENTITY_UPDATE_CHAR_UUID)
-        {
-          a_ClientContext[index].AMSEntityUpdateCharStartHdle = CharStartHdl;
-          a_ClientContext[index].AMSEntityUpdateCharValueHdle = CharValueHdl;
-          LOG_INFO_APP(", AMS_ENTITY_UPDATE_CHAR_UUID charac found\n");
-        }
-        else if (uuid == AMS_ENTITY_ATTRIBUTE_CHAR_UUID)
-        {
-          a_ClientContext[index].AMSEntityAttributeCharStartHdle = CharStartHdl;
-          a_ClientContext[index].AMSEntityAttributeCharValueHdle = CharValueHdl;
-          LOG_INFO_APP(", AMS_ENTITY_ATTRIBUTE_CHAR_UUID charac found\n");
-        }
-        
-        else if (uuid == ANCS_NOTIFICATION_SOURCE_CHAR_UUID)
-        {
-          a_ClientContext[index].ANCSNotifSourceCharStartHdle = CharStartHdl;
-          a_ClientContext[index].ANCSNotifSourceCharValueHdle = CharValueHdl;
-          LOG_INFO_APP(", ANCS_NOTIFICATION_SOURCE_CHAR_UUID charac found\n");
-        }
-        else if (uuid == ANCS_DATA_SOURCE_CHAR_UUID)
-        {
-          a_ClientContext[index].ANCSDataSourceCharStartHdle = CharStartHdl;
-          a_ClientContext[index].ANCSDataSourceCharValueHdle = CharValueHdl;
-          LOG_INFO_APP(", ANCS_DATA_SOURCE_CHAR_UUID charac found\n");
-        }
-        else if (uuid == ANCS_CONTROL_POINT_CHAR_UUID)
-        {
-          a_ClientContext[index].ANCSCtrlPointCharStartHdle = CharStartHdl;
-          a_ClientContext[index].ANCSCtrlPointCharValueHdle = CharValueHdl;
-          LOG_INFO_APP(", ANCS_CONTROL_POINT_CHAR_UUID charac found\n");
+          /* Characteristic of the discovery plan, logged by gatt_disc_set_char */
         }
 /* USER CODE END gatt_parse_chars_1 */
         else
@@ -1095,39 +1643,14 @@ static void gatt_parse_descs(aci_att_find_info_resp_event_rp0 *p_evt)
 //                      gattCharStartHdl,
 //                      gattCharValueHdl,
 //                      handle);
-        if (a_ClientContext[index].ServiceChangedCharValueHdl == gattCharValueHdl)
+        if (uuid != CLIENT_CHAR_CONFIG_DESCRIPTOR_UUID)
         {
-          a_ClientContext[index].ServiceChangedCharDescHdl = handle;
-//          LOG_INFO_APP(", Service Changed found\n");
+          /* Only the Client Characteristic Configuration descriptors are used */
         }
 /* USER CODE BEGIN gatt_parse_descs_1 */
-        else if (uuid == CLIENT_CHAR_CONFIG_DESCRIPTOR_UUID)
+        else if (gatt_disc_set_desc(index, gattCharValueHdl, handle) != 0)
         {
-          if (a_ClientContext[index].AMSRemoteCommandCharValueHdle == gattCharValueHdl)
-          {
-            a_ClientContext[index].AMSRemoteCommandCharDescHdle = handle;
-            LOG_INFO_APP("  Descriptor found, AMS Remote Cmd char Descriptor found,    handle=0x%04X\n", handle);
-          }
-          else if (a_ClientContext[index].AMSEntityUpdateCharValueHdle == gattCharValueHdl)
-          {
-            a_ClientContext[index].AMSEntityUpdateCharDescHdle = handle;
-            LOG_INFO_APP("  Descriptor found, AMS Entity Update char Descriptor found, handle=0x%04X\n", handle);
-          }        
-          else if (a_ClientContext[index].ANCSNotifSourceCharValueHdle == gattCharValueHdl)
-          {
-            a_ClientContext[index].ANCSNotifSourceCharDescHdle = handle;
-            LOG_INFO_APP("  Descriptor found, ANCS Notif Source char Descriptor found, handle=0x%04X\n", handle);
-          }
-          else if (a_ClientContext[index].ANCSDataSourceCharValueHdle == gattCharValueHdl)
-          {
-            a_ClientContext[index].ANCSDataSourceCharDescHdle = handle;
-            LOG_INFO_APP("  Descriptor found, ANCS Data source char Descriptor found,  handle=0x%04X\n", handle);
-          }
-          else if (a_ClientContext[index].BatteryLevelCharValueHdle == gattCharValueHdl)
-          {
-            a_ClientContext[index].BatteryLevelCharDescHdle = handle;
-            LOG_INFO_APP("  Descriptor found, Battery level char Descriptor found,  handle=0x%04X\n", handle);
-          }
+          /* Descriptor of the discovery plan, logged by gatt_disc_set_desc */
           UNUSED(gattCharStartHdl);
         }
 /* USER CODE END gatt_parse_descs_1 */
@@ -1188,33 +1711,45 @@ static void gatt_parse_notification(aci_gatt_notification_event_rp0 *p_evt)
     }
   }
 
-  if (a_ClientContext[index].connHdl == p_evt->Connection_Handle)
+  if (index < BLE_CFG_CLT_MAX_NBR_CB)
   {
+    if ((p_evt->Attribute_Handle != a_ClientContext[index].BatteryLevelCharValueHdle) &&
+        (p_evt->Attribute_Handle != a_ClientContext[index].CurrentTimeCharValueHdle))
+    {
+      /* ANCS and AMS notifications come in bursts */
+      APP_BLE_ConnParam_Traffic(p_evt->Connection_Handle, APP_BLE_TRAFFIC_NOTIFICATION);
+    }
+
     if (p_evt->Attribute_Handle == a_ClientContext[index].ANCSNotifSourceCharValueHdle)
     {
       //LOG_INFO_APP("  Incoming Nofification received ANCS Notif Source\n");
-      send_cmd_to_ancs(ANCS_RECEIVE_NOTIF, ANCS_NOTIFICATION_SOURCE_CHAR_UUID, p_evt->Attribute_Value_Length, &p_evt->Attribute_Value[0]);
+      send_cmd_to_ancs(index, ANCS_RECEIVE_NOTIF, ANCS_NOTIFICATION_SOURCE_CHAR_UUID, p_evt->Attribute_Value_Length, &p_evt->Attribute_Value[0]);
     }
     else if (p_evt->Attribute_Handle == a_ClientContext[index].ANCSDataSourceCharValueHdle)
     {
       //LOG_INFO_APP("  Incoming Nofification received ANCS Data Source\n");
-      send_cmd_to_ancs(ANCS_RECEIVE_NOTIF, ANCS_DATA_SOURCE_CHAR_UUID, p_evt->Attribute_Value_Length, &p_evt->Attribute_Value[0]);      
+      send_cmd_to_ancs(index, ANCS_RECEIVE_NOTIF, ANCS_DATA_SOURCE_CHAR_UUID, p_evt->Attribute_Value_Length, &p_evt->Attribute_Value[0]);      
     }    
     else if (p_evt->Attribute_Handle == a_ClientContext[index].AMSRemoteCommandCharValueHdle)
     {
       //LOG_INFO_APP("  Incoming Nofification received AMS Remote Cmd\n");
-      send_cmd_to_ams(AMS_RECEIVE_NOTIF, AMS_REMOTE_COMMAND_CHAR_UUID, p_evt->Attribute_Value_Length, &p_evt->Attribute_Value[0]);
+      send_cmd_to_ams(index, AMS_RECEIVE_NOTIF, AMS_REMOTE_COMMAND_CHAR_UUID, p_evt->Attribute_Value_Length, &p_evt->Attribute_Value[0]);
     }
     else if (p_evt->Attribute_Handle == a_ClientContext[index].AMSEntityUpdateCharValueHdle)
     {
       //LOG_INFO_APP("  Incoming Nofification received AMS Entity Updatet Cmd\n");
-      send_cmd_to_ams(AMS_RECEIVE_NOTIF, AMS_ENTITY_UPDATE_CHAR_UUID, p_evt->Attribute_Value_Length, &p_evt->Attribute_Value[0]);
+      send_cmd_to_ams(index, AMS_RECEIVE_NOTIF, AMS_ENTITY_UPDATE_CHAR_UUID, p_evt->Attribute_Value_Length, &p_evt->Attribute_Value[0]);
     }
     else if (p_evt->Attribute_Handle == a_ClientContext[index].BatteryLevelCharValueHdle)
     {
       //LOG_INFO_APP("  Incoming Nofification received Battery Level :  %d%%\n", p_evt->Attribute_Value[0]);
 			current_battery_level = p_evt->Attribute_Value[0];
     }		
+    else if (p_evt->Attribute_Handle == a_ClientContext[index].CurrentTimeCharValueHdle)
+    {
+      /* Sent by the phone when its time is adjusted */
+      client_time_update(&p_evt->Attribute_Value[0], p_evt->Attribute_Value_Length);
+    }
     else
     {
       LOG_INFO_APP("Unknown Attribute handle\n");
@@ -1231,65 +1766,200 @@ static void gatt_parse_notification(aci_gatt_notification_event_rp0 *p_evt)
 
 static void client_discover_all(void)
 {
-  uint8_t index = 0;
+  /* USER CODE BEGIN client_discover_all */
+  uint8_t pending = DiscRequest & ~DiscRunning;
+
+  /* Each link gets its own worker task, so that a link waiting for its peer does not hold the others */
+  for (uint8_t index = 0; index < CFG_BLE_NUM_LINK; index++)
+  {
+    if ((pending & (1U << index)) != 0)
+    {
+      UTIL_SEQ_SetTask(1U << (CFG_TASK_DISCOVER_LINK_ID + index), CFG_SEQ_PRIO_0);
+    }
+  }
+  /* USER CODE END client_discover_all */
+  return;
+}
+
+static void client_discover_link(void)
+{
+  uint8_t index;
+
+  /* Workers share the same function, each one takes the first link waiting for a discovery */
+  for (index = 0; index < CFG_BLE_NUM_LINK; index++)
+  {
+    if (((DiscRequest & ~DiscRunning) & (1U << index)) != 0)
+    {
+      break;
+    }
+  }
+
+  if (index < CFG_BLE_NUM_LINK)
+  {
+    DiscRequest &= ~(1U << index);
+    DiscRunning |= (1U << index);
+
+    /* Queued operations do not start while the link is discovered, wait for the one running */
+    gatt_op_wait_idle(index);
+
+    client_discover(index);
+
+    DiscRunning &= ~(1U << index);
+    UTIL_SEQ_SetTask(1U << CFG_TASK_GATT_OP_ID, CFG_SEQ_PRIO_0);
+    if (DiscRequest != 0)
+    {
+      /* Requested again by a Service Changed indication */
+      UTIL_SEQ_SetTask(1U << CFG_TASK_DISCOVER_SERVICES_ID, CFG_SEQ_PRIO_0);
+    }
+  }
+
+  return;
+}
+
+static void client_discover(uint8_t index)
+{
   /* USER CODE BEGIN client_discover_1 */
+  uint32_t start_time;
+
+  APP_BLE_ConnParam_Traffic(a_ClientContext[index].connHdl, APP_BLE_TRAFFIC_DISCOVERY);
 
+  /* Larger ATT MTU, LL PDUs and 2M PHY before the discovery and the ANCS/AMS transfers */
+  client_link_setup(index);
+
+  start_time = UTIL_TIMER_GetCurrentTime();
+  APP_BLE_LinkProbe_Start(index);
+
+  if (gatt_cache_load(index) != 0)
+  {
+    /* Handles restored from the cache, only the notifications need to be enabled */
+    GATT_CLIENT_APP_Procedure_Gatt(index, PROC_GATT_PROPERTIES_ENABLE_ALL);
+    LOG_INFO_APP("Link %d GATT client ready from cache in %d ms\n", index, UTIL_TIMER_GetElapsedTime(start_time));
+    APP_BLE_LinkProbe_Stop(index, NULL);
+  }
+  else
+  {
   /* USER CODE END client_discover_1 */
 
   GATT_CLIENT_APP_Discover_services(index);
 
   /* USER CODE BEGIN client_discover_2 */
-  /* Read value of Time and battery level */
-  init_state = CLIENT_READ_TIME;
-  tBleStatus result = aci_gatt_read_char_value( a_ClientContext[index].connHdl,
-                      a_ClientContext[index].CurrentTimeCharValueHdle);
-  
-  if (result == BLE_STATUS_SUCCESS)
-  {
-    gatt_cmd_resp_wait();
+    LOG_INFO_APP("Link %d GATT client ready from discovery in %d ms\n", index, UTIL_TIMER_GetElapsedTime(start_time));
+    APP_BLE_LinkProbe_Stop(index, NULL);
+    gatt_cache_store(index);
   }
-  else
+
+  /* Read value of Time and battery level, after the notifications enable */
+#if (CFG_WALL_CLOCK_SUPPORTED == 1)
+  /* The time is only read when the local clock has drifted too far, the
+   * phone notifies its adjustments */
+  if (WALL_CLOCK_SyncNeeded() == 0)
   {
-    LOG_INFO_APP("Read Curent Time cmd NOK status =0x%02X \n\n", result);
+    UTIL_TIMER_Start(&ClientTimer_Id);
   }
-      
-  init_state = CLIENT_READ_BATTERY_LEVEL;
-  result = aci_gatt_read_char_value( a_ClientContext[index].connHdl,
-                      a_ClientContext[index].BatteryLevelCharValueHdle);
-  
-  if (result == BLE_STATUS_SUCCESS)
+  else if (time_read_pending == 0)
+#endif /* CFG_WALL_CLOCK_SUPPORTED */
   {
-    gatt_cmd_resp_wait();
+    if (GATT_CLIENT_APP_Op_Read(index, a_ClientContext[index].CurrentTimeCharValueHdle,
+                                client_read_time_cb, NULL) == GATT_CLIENT_APP_OP_INVALID_ID)
+    {
+      LOG_INFO_APP("Read Curent Time cmd not queued\n\n");
+    }
+#if (CFG_WALL_CLOCK_SUPPORTED == 1)
+    else
+    {
+      time_read_pending = 1;
+    }
+#endif /* CFG_WALL_CLOCK_SUPPORTED */
   }
-  else
+
+  if (GATT_CLIENT_APP_Op_Read(index, a_ClientContext[index].BatteryLevelCharValueHdle,
+                              client_read_battery_cb, NULL) == GATT_CLIENT_APP_OP_INVALID_ID)
   {
-    LOG_INFO_APP("Read Battery Level cmd NOK status =0x%02X \n\n", result);
+    LOG_INFO_APP("Read Battery Level cmd not queued\n\n");
   }
   
-  send_cmd_to_ams(AMS_START_NOTIF, NULL, NULL, NULL);
+  AMS_APP_Start(index);
   /* Set a timer to start the notification of both ANCS and AMS in 500 ms */
-  UTIL_TIMER_Start(&Start_Notification_Id);
+  UTIL_TIMER_Start(&a_StartNotification_Id[index]);
 
   /* USER CODE END client_discover_2 */
   return;
 }
 
-static void gatt_cmd_resp_release(void)
+static void client_link_setup(uint8_t index)
+{
+  APP_BLE_LinkInfo_t link_info;
+  tBleStatus result;
+  uint32_t start_time = UTIL_TIMER_GetCurrentTime();
+
+  APP_BLE_GetLinkInfo(index, &link_info);
+  if (link_info.SetupDone != 0)
+  {
+    /* Done once per connection, not on a discovery restarted by Service Changed */
+    return;
+  }
+
+  APP_BLE_Procedure_Link_Setup(index);
+
+  if (link_info.AttMtu < CFG_BLE_ATT_MTU_MAX)
+  {
+    result = aci_gatt_exchange_config(a_ClientContext[index].connHdl);
+    if (result == BLE_STATUS_SUCCESS)
+    {
+      gatt_cmd_resp_wait(index);
+    }
+    else
+    {
+      LOG_INFO_APP("aci_gatt_exchange_config cmd NOK status =0x%02X\n", result);
+    }
+  }
+
+  APP_BLE_GetLinkInfo(index, &link_info);
+  LOG_INFO_APP("Link %d ready in %d ms: ATT MTU %d, LL PDU TX %d / RX %d bytes, PHY TX %d / RX %d\n",
+               index,
+               UTIL_TIMER_GetElapsedTime(start_time),
+               link_info.AttMtu,
+               link_info.MaxTxOctets,
+               link_info.MaxRxOctets,
+               link_info.TxPhy,
+               link_info.RxPhy);
+
+  return;
+}
+
+static void gatt_cmd_resp_release(uint8_t index)
 {
-  UTIL_SEQ_SetEvt(1U << CFG_IDLEEVT_PROC_GATT_COMPLETE);
+  /* One event per link, a procedure ending on a link only wakes up the task waiting for that link */
+  UTIL_SEQ_SetEvt(1U << (CFG_IDLEEVT_PROC_GATT_LINK_COMPLETE + index));
   return;
 }
 
-static void gatt_cmd_resp_wait(void)
+static void gatt_cmd_resp_wait(uint8_t index)
 {
-  UTIL_SEQ_WaitEvt(1U << CFG_IDLEEVT_PROC_GATT_COMPLETE);
+  UTIL_SEQ_WaitEvt(1U << (CFG_IDLEEVT_PROC_GATT_LINK_COMPLETE + index));
   return;
 }
 
 /* USER CODE BEGIN LF */
 
-static void send_cmd_to_ams(GattCmdToAMS_t GattCmdToAMS, uint16_t char_UUID, uint8_t l_payload, uint8_t *p_Payload)
+static uint8_t client_get_index(uint16_t connHdl)
+{
+  uint8_t index;
+
+  for (index = 0 ; index < BLE_CFG_CLT_MAX_NBR_CB ; index++)
+  {
+    if (a_ClientContext[index].connHdl == connHdl)
+    {
+      break;
+    }
+  }
+
+  return index;
+}
+
+static void send_cmd_to_ams(uint8_t index, GattCmdToAMS_t GattCmdToAMS, uint16_t char_UUID, uint8_t l_payload, uint8_t *p_Payload)
 {
+  gatt_client_interface_ams.Link = index;
   gatt_client_interface_ams.GattCmdToAMS = GattCmdToAMS;
   gatt_client_interface_ams.char_UUID = char_UUID;  
   gatt_client_interface_ams.l_payload = l_payload;
@@ -1299,8 +1969,9 @@ static void send_cmd_to_ams(GattCmdToAMS_t GattCmdToAMS, uint16_t char_UUID, uin
   return;
 };
 
-static void send_cmd_to_ancs(GattCmdToANCS_t GattCmdToANCS, uint16_t char_UUID, uint8_t l_payload, uint8_t *p_Payload)
+static void send_cmd_to_ancs(uint8_t index, GattCmdToANCS_t GattCmdToANCS, uint16_t char_UUID, uint8_t l_payload, uint8_t *p_Payload)
 {
+  gatt_client_interface_ancs.Link = index;
   gatt_client_interface_ancs.GattCmdToANCS = GattCmdToANCS;
   gatt_client_interface_ancs.char_UUID = char_UUID;  
   gatt_client_interface_ancs.l_payload = l_payload;
@@ -1318,32 +1989,865 @@ static void ClientTimer_cb(void *arg)
 
 static void ClientTimer_Task(void)
 {
-  uint8_t index = 0;
-  if (counter_to_1_min++ >= 60 * 1000/REFRESH_SCREEN_TIMER)
+  uint8_t index;
+  uint8_t media_changed;
+
+  /* The time is read from the first phone exposing the Current Time service */
+  for (index = 0; index < BLE_CFG_CLT_MAX_NBR_CB; index++)
   {
-    init_state = CLIENT_READ_TIME;
-    tBleStatus result = aci_gatt_read_char_value( a_ClientContext[index].connHdl,
-                        a_ClientContext[index].CurrentTimeCharValueHdle);
-    
-    if (result == BLE_STATUS_SUCCESS)
+    if ((a_ClientContext[index].connHdl != APP_BLE_INVALID_CONN_HDL) &&
+        (a_ClientContext[index].CurrentTimeCharValueHdle != 0x0000))
+    {
+      break;
+    }
+  }
+
+#if (CFG_WALL_CLOCK_SUPPORTED == 1)
+  if (WALL_CLOCK_IsSynced() != 0)
+  {
+    struct tm local_time;
+
+    WALL_CLOCK_GetLocalTime(&local_time);
+    current_time_hour = (uint8_t)local_time.tm_hour;
+    current_time_min = (uint8_t)local_time.tm_min;
+  }
+
+  /* Read again only once the error bound of the clock is too large */
+  if ((WALL_CLOCK_SyncNeeded() != 0) && (time_read_pending == 0) && (index < BLE_CFG_CLT_MAX_NBR_CB))
+  {
+    if (GATT_CLIENT_APP_Op_Read(index, a_ClientContext[index].CurrentTimeCharValueHdle,
+                                client_read_time_cb, NULL) == GATT_CLIENT_APP_OP_INVALID_ID)
     {
-      gatt_cmd_resp_wait();
+      LOG_INFO_APP("Read Curent Time cmd not queued\n\n");
     }
     else
     {
-      LOG_INFO_APP("Read Curent Time cmd NOK status =0x%02X \n\n", result);
+      time_read_pending = 1;
     }
   }
+#else
+  if ((counter_to_1_min++ >= 60 * 1000/REFRESH_SCREEN_TIMER) && (index < BLE_CFG_CLT_MAX_NBR_CB))
+  {
+    /* Set again by the read callback, the screen keeps being refreshed meanwhile */
+    counter_to_1_min = 0;
+    if (GATT_CLIENT_APP_Op_Read(index, a_ClientContext[index].CurrentTimeCharValueHdle,
+                                client_read_time_cb, NULL) == GATT_CLIENT_APP_OP_INVALID_ID)
+    {
+      LOG_INFO_APP("Read Curent Time cmd not queued\n\n");
+    }
+  }
+#endif /* CFG_WALL_CLOCK_SUPPORTED */
   
-  ams_update_singer_song_name();
+  media_changed = ams_update_singer_song_name();
   ancs_update_notif(ShowWithoutModif);
   hrs_update();
-  UTIL_SEQ_SetTask( 1U << CFG_TASK_MENU_PRINT_ID, CFG_SEQ_PRIO_0);  //Update Menu
+  /* The media control page is only redrawn when its text changes, as its
+   * position changes each second, the other pages are animated on each tick */
+  if ((media_changed != 0) || (Menu_GetActivePage() != p_media_control_menu))
+  {
+    UTIL_SEQ_SetTask( 1U << CFG_TASK_MENU_PRINT_ID, CFG_SEQ_PRIO_0);  //Update Menu
+  }
 }
 
 static void start_notification(void *arg)
 {
-  ANCS_init_data.app_init = true;
+  ANCS_init_data[(uint32_t)arg].app_init = true;
+}
+
+/**
+* function of GATT indication parse
+*/
+static void gatt_parse_indication(aci_gatt_indication_event_rp0 *p_evt)
+{
+  uint8_t index;
+
+  for (index = 0 ; index < BLE_CFG_CLT_MAX_NBR_CB ; index++)
+  {
+    if (a_ClientContext[index].connHdl == p_evt->Connection_Handle)
+    {
+      break;
+    }
+  }
+
+  aci_gatt_confirm_indication(p_evt->Connection_Handle);
+
+  if ((index < BLE_CFG_CLT_MAX_NBR_CB) &&
+      (a_ClientContext[index].ServiceChangedCharValueHdl != 0x0000) &&
+      (p_evt->Attribute_Handle == a_ClientContext[index].ServiceChangedCharValueHdl))
+  {
+    LOG_INFO_APP("Service Changed indication received, discovery cache dropped\n");
+
+    /* The cached handles may be wrong, run a full discovery again */
+    gatt_cache_invalidate(index);
+    GATT_CLIENT_APP_Request_Discovery(index);
+  }
+
+  return;
+}
+
+/**
+* function of GATT Database Hash parse
+*/
+static uint8_t gatt_parse_db_hash(aci_att_read_by_type_resp_event_rp0 *p_evt)
+{
+  uint8_t index;
+  uint8_t consumed = 0;
+
+  for (index = 0 ; index < BLE_CFG_CLT_MAX_NBR_CB ; index++)
+  {
+    if (a_ClientContext[index].connHdl == p_evt->Connection_Handle)
+    {
+      break;
+    }
+  }
+
+  if ((index < BLE_CFG_CLT_MAX_NBR_CB) && (a_ClientContext[index].state == GATT_CLIENT_APP_READ_DB_HASH))
+  {
+    /* event data in Handle_Value_Pair_Data contains:
+    * 2 bytes handle
+    * 16 bytes Database Hash value
+    */
+    if ((p_evt->Handle_Value_Pair_Length == (2 + GATT_CACHE_DB_HASH_SIZE)) &&
+        (p_evt->Data_Length >= p_evt->Handle_Value_Pair_Length))
+    {
+      memcpy(a_ClientPeer[index].DbHash, &p_evt->Handle_Value_Pair_Data[2], GATT_CACHE_DB_HASH_SIZE);
+      a_ClientPeer[index].DbHashRead = 1;
+    }
+    consumed = 1;
+  }
+
+  return consumed;
+}
+
+/**
+* Register and restore the GATT discovery cache from the NVM
+*/
+static void gatt_cache_init(void)
+{
+  SNVMA_Cmd_Status_t status;
+
+  status = SNVMA_Register(APP_GATT_CacheBuffer,
+                          (uint32_t *)&GattCache,
+                          (sizeof(GattCache) / sizeof(uint32_t)));
+  if (status == SNVMA_ERROR_OK)
+  {
+    status = SNVMA_Restore(APP_GATT_CacheBuffer);
+  }
+
+  if ((status != SNVMA_ERROR_OK) || (GattCache.Version != GATT_CACHE_VERSION))
+  {
+    LOG_INFO_APP("GATT discovery cache empty, status = %d\n", status);
+    memset(&GattCache, 0, sizeof(GattCache));
+    GattCache.Version = GATT_CACHE_VERSION;
+  }
+
+  return;
+}
+
+/**
+* Get the identity address of the peer, return 1 when the peer is bonded
+*/
+static uint8_t gatt_cache_identify(uint8_t index)
+{
+  GattClientPeer_t *p_peer = &a_ClientPeer[index];
+  uint8_t bonded = 0;
+
+  /* Connection complete address types 0x02 and 0x03 are identity addresses resolved by the controller */
+  p_peer->IdAddrType = p_peer->PeerAddrType & 0x01;
+  memcpy(p_peer->IdAddr, p_peer->PeerAddr, sizeof(p_peer->IdAddr));
+
+  /* Resolvable private address: two most significant bits equal to 0b01 */
+  if ((p_peer->PeerAddrType == GAP_STATIC_RANDOM_ADDR) && ((p_peer->PeerAddr[5] & 0xC0) == 0x40))
+  {
+    if (aci_gap_resolve_private_addr(p_peer->PeerAddr, p_peer->IdAddr) == BLE_STATUS_SUCCESS)
+    {
+      /* The identity address type is the one registered in the bonding table */
+      if (aci_gap_is_device_bonded(GAP_PUBLIC_ADDR, p_peer->IdAddr) == BLE_STATUS_SUCCESS)
+      {
+        p_peer->IdAddrType = GAP_PUBLIC_ADDR;
+        bonded = 1;
+      }
+      else if (aci_gap_is_device_bonded(GAP_STATIC_RANDOM_ADDR, p_peer->IdAddr) == BLE_STATUS_SUCCESS)
+      {
+        p_peer->IdAddrType = GAP_STATIC_RANDOM_ADDR;
+        bonded = 1;
+      }
+    }
+  }
+  else if (aci_gap_is_device_bonded(p_peer->IdAddrType, p_peer->IdAddr) == BLE_STATUS_SUCCESS)
+  {
+    bonded = 1;
+  }
+
+  return bonded;
 }
 
+/**
+* Find the cache entry of the peer, return GATT_CACHE_NBR_ENTRIES when not found
+*/
+static uint8_t gatt_cache_find(uint8_t index)
+{
+  uint8_t entry;
+
+  for (entry = 0; entry < GATT_CACHE_NBR_ENTRIES; entry++)
+  {
+    if ((GattCache.a_Entry[entry].Sequence != 0) &&
+        (GattCache.a_Entry[entry].IdAddrType == a_ClientPeer[index].IdAddrType) &&
+        (memcmp(GattCache.a_Entry[entry].IdAddr, a_ClientPeer[index].IdAddr, sizeof(a_ClientPeer[index].IdAddr)) == 0))
+    {
+      break;
+    }
+  }
+
+  return entry;
+}
+
+/**
+* Read the Database Hash characteristic of the peer, return 1 when read
+*/
+static uint8_t gatt_cache_read_db_hash(uint8_t index)
+{
+  tBleStatus result;
+  UUID_t uuid;
+  uint16_t start_hdl = 0x0001;
+  uint16_t end_hdl = 0xFFFF;
+
+  if (a_ClientContext[index].GATTServiceStartHdl != 0x0000)
+  {
+    start_hdl = a_ClientContext[index].GATTServiceStartHdl;
+    end_hdl = a_ClientContext[index].GATTServiceEndHdl;
+  }
+
+  a_ClientPeer[index].DbHashRead = 0;
+  a_ClientContext[index].state = GATT_CLIENT_APP_READ_DB_HASH;
+
+  uuid.UUID_16 = DATABASE_HASH_UUID;
+  result = aci_gatt_read_using_char_uuid(a_ClientContext[index].connHdl,
+                                         start_hdl,
+                                         end_hdl,
+                                         UUID_TYPE_16,
+                                         &uuid);
+  if (result == BLE_STATUS_SUCCESS)
+  {
+    gatt_cmd_resp_wait(index);
+  }
+  else
+  {
+    LOG_INFO_APP("Read Database Hash cmd NOK status =0x%02X\n", result);
+  }
+
+  a_ClientContext[index].state = GATT_CLIENT_APP_CONNECTED;
+
+  return a_ClientPeer[index].DbHashRead;
+}
+
+/**
+* Restore the discovered handles of a bonded peer, return 1 when the cache can be used
+*/
+static uint8_t gatt_cache_load(uint8_t index)
+{
+  GattCacheEntry_t *p_entry;
+  uint8_t entry = GATT_CACHE_NBR_ENTRIES;
+  uint8_t hit = 0;
+
+  if (gatt_cache_identify(index) != 0)
+  {
+    entry = gatt_cache_find(index);
+  }
+
+  if (entry < GATT_CACHE_NBR_ENTRIES)
+  {
+    p_entry = &GattCache.a_Entry[entry];
+    memcpy((uint8_t *)&a_ClientContext[index] + GATT_CACHE_HANDLES_OFFSET, p_entry->a_Handles, GATT_CACHE_HANDLES_SIZE);
+    hit = 1;
+
+    /* Without Database Hash, changes are reported to a bonded client through the Service Changed indication */
+    if (p_entry->DbHashKnown != 0)
+    {
+      if ((gatt_cache_read_db_hash(index) == 0) ||
+          (memcmp(a_ClientPeer[index].DbHash, p_entry->DbHash, GATT_CACHE_DB_HASH_SIZE) != 0))
+      {
+        LOG_INFO_APP("GATT discovery cache outdated, Database Hash differs\n");
+        gatt_cache_invalidate(index);
+        hit = 0;
+      }
+    }
+  }
+
+  if (hit == 0)
+  {
+    /* Start the discovery from a clean context */
+    memset((uint8_t *)&a_ClientContext[index] + GATT_CACHE_HANDLES_OFFSET, 0, GATT_CACHE_HANDLES_SIZE);
+  }
+
+  LOG_INFO_APP("GATT discovery cache %s\n", (hit != 0) ? "hit" : "miss");
+
+  return hit;
+}
+
+/**
+* Save the discovered handles of a bonded peer
+*/
+static void gatt_cache_store(uint8_t index)
+{
+  GattCacheEntry_t *p_entry;
+  uint8_t entry;
+
+  if (gatt_cache_identify(index) != 0)
+  {
+    entry = gatt_cache_find(index);
+
+    if (entry == GATT_CACHE_NBR_ENTRIES)
+    {
+      /* Replace the least recently used entry */
+      entry = 0;
+      for (uint8_t i = 1; i < GATT_CACHE_NBR_ENTRIES; i++)
+      {
+        if (GattCache.a_Entry[i].Sequence < GattCache.a_Entry[entry].Sequence)
+        {
+          entry = i;
+        }
+      }
+    }
+
+    p_entry = &GattCache.a_Entry[entry];
+    p_entry->IdAddrType = a_ClientPeer[index].IdAddrType;
+    memcpy(p_entry->IdAddr, a_ClientPeer[index].IdAddr, sizeof(p_entry->IdAddr));
+    p_entry->DbHashKnown = gatt_cache_read_db_hash(index);
+    memcpy(p_entry->DbHash, a_ClientPeer[index].DbHash, GATT_CACHE_DB_HASH_SIZE);
+    memcpy(p_entry->a_Handles, (uint8_t *)&a_ClientContext[index] + GATT_CACHE_HANDLES_OFFSET, GATT_CACHE_HANDLES_SIZE);
+    p_entry->Sequence = ++GattCache.Sequence;
+
+    SNVMA_Write(APP_GATT_CacheBuffer, gatt_cache_nvm_cb);
+  }
+
+  return;
+}
+
+/**
+* Remove the cache entry of the peer
+*/
+static void gatt_cache_invalidate(uint8_t index)
+{
+  uint8_t entry = gatt_cache_find(index);
+
+  if (entry < GATT_CACHE_NBR_ENTRIES)
+  {
+    memset(&GattCache.a_Entry[entry], 0, sizeof(GattCache.a_Entry[entry]));
+    SNVMA_Write(APP_GATT_CacheBuffer, gatt_cache_nvm_cb);
+  }
+
+  return;
+}
+
+static void gatt_cache_nvm_cb(SNVMA_Callback_Status_t CbkStatus)
+{
+  if (CbkStatus != SNVMA_OPERATION_COMPLETE)
+  {
+    /* Retry the write operation */
+    SNVMA_Write(APP_GATT_CacheBuffer, gatt_cache_nvm_cb);
+  }
+}
+
+/**
+* Check if a service holds a characteristic of the discovery plan to enable, return 1 if so
+*/
+static uint8_t gatt_disc_service_has_desc(uint8_t index, GattDiscServiceId_t Service)
+{
+  uint8_t has_desc = 0;
+
+  for (uint8_t chr = 0; chr < GATT_DISC_NBR_CHARS; chr++)
+  {
+    if ((a_GattDiscChars[chr].Service == Service) &&
+        (a_GattDiscChars[chr].DescHdlOffset != GATT_DISC_NO_FIELD) &&
+        (GATT_DISC_HDL(index, a_GattDiscChars[chr].ValueHdlOffset) != 0x0000))
+    {
+      has_desc = 1;
+      break;
+    }
+  }
+
+  return has_desc;
+}
+
+/**
+* Record the handles of a service of the discovery plan, return 1 if the service is part of the plan
+*/
+static uint8_t gatt_disc_set_service(uint8_t index, uint16_t ShortUuid, uint16_t StartHdl, uint16_t EndHdl)
+{
+  uint8_t srv;
+
+  for (srv = 0; srv < GATT_DISC_NBR_SERVICES; srv++)
+  {
+    if (a_GattDiscServices[srv].ShortUuid == ShortUuid)
+    {
+      GATT_DISC_HDL(index, a_GattDiscServices[srv].StartHdlOffset) = StartHdl;
+      GATT_DISC_HDL(index, a_GattDiscServices[srv].EndHdlOffset) = EndHdl;
+
+      /* Keep the range covering all the services up to date */
+      if ((a_ClientContext[index].ALLServiceStartHdl == 0x0000) || (StartHdl < a_ClientContext[index].ALLServiceStartHdl))
+      {
+        a_ClientContext[index].ALLServiceStartHdl = StartHdl;
+      }
+      if ((a_ClientContext[index].ALLServiceEndHdl == 0x0000) || (EndHdl > a_ClientContext[index].ALLServiceEndHdl))
+      {
+        a_ClientContext[index].ALLServiceEndHdl = EndHdl;
+      }
+
+      LOG_INFO_APP(", %s found\n", a_GattDiscServices[srv].p_Name);
+      break;
+    }
+  }
+
+  return (srv < GATT_DISC_NBR_SERVICES);
+}
+
+/**
+* Record the handles of a characteristic of the discovery plan, return 1 if the characteristic is part of the plan
+*/
+static uint8_t gatt_disc_set_char(uint8_t index, uint16_t ShortUuid, uint8_t Properties, uint16_t StartHdl, uint16_t ValueHdl)
+{
+  const GattDiscService_t *p_srv;
+  uint8_t chr;
+
+  for (chr = 0; chr < GATT_DISC_NBR_CHARS; chr++)
+  {
+    p_srv = &a_GattDiscServices[a_GattDiscChars[chr].Service];
+
+    /* The short UUID is only meaningful within the range of its service */
+    if ((a_GattDiscChars[chr].ShortUuid == ShortUuid) &&
+        (StartHdl > GATT_DISC_HDL(index, p_srv->StartHdlOffset)) &&
+        (StartHdl <= GATT_DISC_HDL(index, p_srv->EndHdlOffset)))
+    {
+      GATT_DISC_HDL(index, a_GattDiscChars[chr].StartHdlOffset) = StartHdl;
+      GATT_DISC_HDL(index, a_GattDiscChars[chr].ValueHdlOffset) = ValueHdl;
+
+      if (a_GattDiscChars[chr].ValueHdlOffset == offsetof(BleClientAppContext_t, ServiceChangedCharValueHdl))
+      {
+        a_ClientContext[index].ServiceChangedCharProperties = Properties;
+      }
+
+      LOG_INFO_APP(", %s charac found\n", a_GattDiscChars[chr].p_Name);
+      break;
+    }
+  }
+
+  return (chr < GATT_DISC_NBR_CHARS);
+}
+
+/**
+* Record the Client Characteristic Configuration descriptor of a characteristic of the discovery plan,
+* return 1 if the characteristic is part of the plan
+*/
+static uint8_t gatt_disc_set_desc(uint8_t index, uint16_t CharValueHdl, uint16_t DescHdl)
+{
+  uint8_t chr;
+
+  for (chr = 0; chr < GATT_DISC_NBR_CHARS; chr++)
+  {
+    if ((a_GattDiscChars[chr].DescHdlOffset != GATT_DISC_NO_FIELD) &&
+        (CharValueHdl != 0x0000) &&
+        (GATT_DISC_HDL(index, a_GattDiscChars[chr].ValueHdlOffset) == CharValueHdl))
+    {
+      GATT_DISC_HDL(index, a_GattDiscChars[chr].DescHdlOffset) = DescHdl;
+      LOG_INFO_APP("  Descriptor found, %s Descriptor found, handle=0x%04X\n", a_GattDiscChars[chr].p_Name, DescHdl);
+      break;
+    }
+  }
+
+  return (chr < GATT_DISC_NBR_CHARS);
+}
+
+/**
+* Queue a GATT operation, started by the GATT operation task
+*/
+static uint8_t gatt_op_submit(uint8_t index, GattOpType_t Type, uint16_t AttHdl, uint16_t Length,
+                              const uint8_t *p_Data, GATT_CLIENT_APP_OpCb_t Callback, void *p_Context)
+{
+  GattOpQueue_t *p_queue;
+  GattOp_t *p_op;
+
+  if ((index >= CFG_BLE_NUM_LINK) ||
+      (a_ClientContext[index].connHdl == APP_BLE_INVALID_CONN_HDL) ||
+      (AttHdl == 0x0000) ||
+      (Length > GATT_CLIENT_APP_OP_DATA_SIZE))
+  {
+    return GATT_CLIENT_APP_OP_INVALID_ID;
+  }
+
+  p_queue = &a_GattOpQueue[index];
+  if (p_queue->Count == GATT_CLIENT_APP_OP_QUEUE_SIZE)
+  {
+    p_queue->Rejected++;
+    return GATT_CLIENT_APP_OP_INVALID_ID;
+  }
+
+  p_op = &p_queue->a_Op[(p_queue->Head + p_queue->Count) % GATT_CLIENT_APP_OP_QUEUE_SIZE];
+  p_op->Type = Type;
+  p_op->Reported = 0;
+  p_op->AttHdl = AttHdl;
+  p_op->Length = Length;
+  if (Length != 0)
+  {
+    memcpy(p_op->a_Data, p_Data, Length);
+  }
+  p_op->Callback = Callback;
+  p_op->p_Context = p_Context;
+
+  p_queue->NextId++;
+  if (p_queue->NextId == GATT_CLIENT_APP_OP_INVALID_ID)
+  {
+    p_queue->NextId++;
+  }
+  p_op->Id = p_queue->NextId;
+
+  p_queue->Count++;
+  if (p_queue->Count > p_queue->MaxDepth)
+  {
+    p_queue->MaxDepth = p_queue->Count;
+  }
+
+  UTIL_SEQ_SetTask(1U << CFG_TASK_GATT_OP_ID, CFG_SEQ_PRIO_0);
+
+  return p_op->Id;
+}
+
+/**
+* GATT operation task: report the operations over and start the next ones, one procedure per link
+*/
+static void gatt_op_process(void)
+{
+  GattOpQueue_t *p_queue;
+
+  for (uint8_t index = 0; index < CFG_BLE_NUM_LINK; index++)
+  {
+    p_queue = &a_GattOpQueue[index];
+
+    if (p_queue->State == GATT_OP_STATE_COMPLETE)
+    {
+      p_queue->State = GATT_OP_STATE_IDLE;
+      gatt_op_end(index, (p_queue->ProcStatus == BLE_STATUS_SUCCESS) ? GATT_CLIENT_APP_OP_SUCCESS : GATT_CLIENT_APP_OP_ERROR);
+    }
+    else if ((p_queue->State == GATT_OP_STATE_PENDING) && (p_queue->TimedOut != 0))
+    {
+      /* The caller is told now, the link stays busy until the stack ends the procedure */
+      p_queue->TimedOut = 0;
+      p_queue->Timeouts++;
+      LOG_INFO_APP("Link %d GATT operation %d timeout\n", index, p_queue->a_Op[p_queue->Head].Id);
+      gatt_op_report(index, &p_queue->a_Op[p_queue->Head], GATT_CLIENT_APP_OP_TIMEOUT);
+    }
+
+    /* The discovery of the link owns the ATT bearer while it runs */
+    while ((p_queue->State == GATT_OP_STATE_IDLE) &&
+           (p_queue->Count != 0) &&
+           ((DiscRunning & (1U << index)) == 0))
+    {
+      gatt_op_start(index);
+    }
+  }
+
+  return;
+}
+
+/**
+* Start the operation at the head of the queue of a link
+*/
+static void gatt_op_start(uint8_t index)
+{
+  GattOpQueue_t *p_queue = &a_GattOpQueue[index];
+  GattOp_t *p_op = &p_queue->a_Op[p_queue->Head];
+  uint16_t connHdl = a_ClientContext[index].connHdl;
+  tBleStatus result;
+
+  if (p_op->Reported != 0)
+  {
+    /* Cancelled before being started */
+    gatt_op_end(index, GATT_CLIENT_APP_OP_CANCELLED);
+    return;
+  }
+
+  switch (p_op->Type)
+  {
+    case GATT_OP_READ:
+      /* Length counts the bytes received */
+      p_op->Length = 0;
+      result = aci_gatt_read_char_value(connHdl, p_op->AttHdl);
+      break;
+
+    case GATT_OP_READ_LONG:
+      p_op->Length = 0;
+      result = aci_gatt_read_long_char_value(connHdl, p_op->AttHdl, 0);
+      break;
+
+    case GATT_OP_WRITE:
+      result = aci_gatt_write_char_value(connHdl, p_op->AttHdl, p_op->Length, p_op->a_Data);
+      break;
+
+    case GATT_OP_WRITE_NO_RESP:
+      result = aci_gatt_write_without_resp(connHdl, p_op->AttHdl, p_op->Length, p_op->a_Data);
+      break;
+
+    case GATT_OP_ENABLE_CCCD:
+    default:
+      result = aci_gatt_write_char_desc(connHdl, p_op->AttHdl, p_op->Length, p_op->a_Data);
+      break;
+  }
+
+  if (result != BLE_STATUS_SUCCESS)
+  {
+    if ((p_op->Type == GATT_OP_WRITE_NO_RESP) && (result == BLE_STATUS_INSUFFICIENT_RESOURCES))
+    {
+      p_queue->State = GATT_OP_STATE_TX_FULL;
+    }
+    else
+    {
+      LOG_INFO_APP("Link %d GATT operation %d on handle 0x%04X NOK status =0x%02X\n",
+                   index, p_op->Id, p_op->AttHdl, result);
+      gatt_op_end(index, GATT_CLIENT_APP_OP_ERROR);
+    }
+  }
+  else if (p_op->Type == GATT_OP_WRITE_NO_RESP)
+  {
+    /* No procedure runs in the stack for a write without response */
+    gatt_op_end(index, GATT_CLIENT_APP_OP_SUCCESS);
+  }
+  else
+  {
+    p_queue->State = GATT_OP_STATE_PENDING;
+    p_queue->TimedOut = 0;
+    UTIL_TIMER_Start(&p_queue->Timer);
+  }
+
+  return;
+}
+
+/**
+* Remove the operation at the head of the queue of a link and report it
+*/
+static void gatt_op_end(uint8_t index, GATT_CLIENT_APP_OpStatus_t Status)
+{
+  GattOpQueue_t *p_queue = &a_GattOpQueue[index];
+  /* Copied, the callback may queue a new operation in the freed slot */
+  GattOp_t op = p_queue->a_Op[p_queue->Head];
+
+  UTIL_TIMER_Stop(&p_queue->Timer);
+
+  p_queue->Head = (p_queue->Head + 1) % GATT_CLIENT_APP_OP_QUEUE_SIZE;
+  p_queue->Count--;
+
+  if ((op.Reported == 0) && (Status == GATT_CLIENT_APP_OP_SUCCESS))
+  {
+    p_queue->Done++;
+  }
+  else if ((op.Reported == 0) && (Status == GATT_CLIENT_APP_OP_ERROR))
+  {
+    p_queue->Errors++;
+  }
+
+  gatt_op_report(index, &op, Status);
+
+  return;
+}
+
+/**
+* Call the callback of an operation, once
+*/
+static void gatt_op_report(uint8_t index, GattOp_t *p_Op, GATT_CLIENT_APP_OpStatus_t Status)
+{
+  if (p_Op->Reported == 0)
+  {
+    p_Op->Reported = 1;
+    if (p_Op->Callback != NULL)
+    {
+      if ((p_Op->Type == GATT_OP_READ) || (p_Op->Type == GATT_OP_READ_LONG))
+      {
+        p_Op->Callback(index, p_Op->Id, Status, p_Op->a_Data, p_Op->Length, p_Op->p_Context);
+      }
+      else
+      {
+        p_Op->Callback(index, p_Op->Id, Status, NULL, 0, p_Op->p_Context);
+      }
+    }
+  }
+
+  return;
+}
+
+/**
+* End all the operations of a disconnected link
+*/
+static void gatt_op_flush(uint8_t index)
+{
+  GattOpQueue_t *p_queue = &a_GattOpQueue[index];
+
+  p_queue->State = GATT_OP_STATE_IDLE;
+  p_queue->TimedOut = 0;
+  while (p_queue->Count != 0)
+  {
+    gatt_op_end(index, GATT_CLIENT_APP_OP_DISCONNECTED);
+  }
+
+  LOG_INFO_APP("Link %d GATT operations: %d done, %d errors, %d timeouts, %d cancelled, %d rejected, max queued %d\n",
+               index,
+               p_queue->Done,
+               p_queue->Errors,
+               p_queue->Timeouts,
+               p_queue->Cancelled,
+               p_queue->Rejected,
+               p_queue->MaxDepth);
+
+  p_queue->Done = 0;
+  p_queue->Errors = 0;
+  p_queue->Timeouts = 0;
+  p_queue->Cancelled = 0;
+  p_queue->Rejected = 0;
+  p_queue->MaxDepth = 0;
+
+  return;
+}
+
+/**
+* Wait for the end of the operation running on a link, before a discovery
+*/
+static void gatt_op_wait_idle(uint8_t index)
+{
+  if (index >= CFG_BLE_NUM_LINK)
+  {
+    return;
+  }
+
+  while ((a_GattOpQueue[index].State == GATT_OP_STATE_PENDING) &&
+         (a_ClientContext[index].connHdl != APP_BLE_INVALID_CONN_HDL))
+  {
+    a_GattOpQueue[index].DiscWaiting = 1;
+    gatt_cmd_resp_wait(index);
+    a_GattOpQueue[index].DiscWaiting = 0;
+  }
+
+  return;
+}
+
+static void gatt_op_timeout_cb(void *arg)
+{
+  a_GattOpQueue[(uint32_t)arg].TimedOut = 1;
+  UTIL_SEQ_SetTask(1U << CFG_TASK_GATT_OP_ID, CFG_SEQ_PRIO_0);
+}
+
+static void client_cccd_cb(uint8_t index, uint8_t OpId, GATT_CLIENT_APP_OpStatus_t Status,
+                           const uint8_t *p_Data, uint16_t Length, void *p_Context)
+{
+  uint32_t chr = (uint32_t)p_Context;
+
+  UNUSED(OpId);
+  UNUSED(p_Data);
+  UNUSED(Length);
+
+  if (Status == GATT_CLIENT_APP_OP_SUCCESS)
+  {
+    LOG_INFO_APP("  %s notification enabled Successfully\n", a_GattDiscChars[chr].p_Name);
+  }
+  else
+  {
+    LOG_INFO_APP("  %s notification enabled Failed status=%d\n", a_GattDiscChars[chr].p_Name, Status);
+  }
+
+  if (a_CccdPending[index] != 0)
+  {
+    a_CccdPending[index]--;
+    if (a_CccdPending[index] == 0)
+    {
+      a_GattDiscPhaseTime[index][GATT_DISC_PHASE_ENABLE] = UTIL_TIMER_GetElapsedTime(a_CccdStart[index]);
+      LOG_INFO_APP("Link %d notifications enabled in %d ms\n", index, a_GattDiscPhaseTime[index][GATT_DISC_PHASE_ENABLE]);
+    }
+  }
+
+  return;
+}
+
+static void client_read_time_cb(uint8_t index, uint8_t OpId, GATT_CLIENT_APP_OpStatus_t Status,
+                                const uint8_t *p_Data, uint16_t Length, void *p_Context)
+{
+  UNUSED(index);
+  UNUSED(OpId);
+  UNUSED(p_Context);
+
+#if (CFG_WALL_CLOCK_SUPPORTED == 1)
+  time_read_pending = 0;
+#endif /* CFG_WALL_CLOCK_SUPPORTED */
+
+  if (Status == GATT_CLIENT_APP_OP_SUCCESS)
+  {
+    client_time_update(p_Data, Length);
+  }
+  else
+  {
+    LOG_INFO_APP("Read Curent Time NOK status =%d\n\n", Status);
+  }
+
+  return;
+}
+
+static void client_time_update(const uint8_t *p_Data, uint16_t Length)
+{
+#if (CFG_WALL_CLOCK_SUPPORTED == 1)
+  struct tm local_time = {0};
+  SysTime_t reference;
+  uint8_t step = 0;
+#endif /* CFG_WALL_CLOCK_SUPPORTED */
+
+  /* Current Time: year (2), month, day, hours, minutes, seconds, day of week,
+   * fractions of 1/256 s, adjust reason */
+  if ((Length >= 7) && (p_Data[2] != 0) && (p_Data[3] != 0))
+  {
+    current_time_hour = p_Data[4];
+    current_time_min = p_Data[5];
+#if (CFG_WALL_CLOCK_SUPPORTED == 1)
+    local_time.tm_year = (int)(UNPACK_2_BYTE_PARAMETER(&p_Data[0])) - 1900;
+    local_time.tm_mon = p_Data[2] - 1;
+    local_time.tm_mday = p_Data[3];
+    local_time.tm_hour = p_Data[4];
+    local_time.tm_min = p_Data[5];
+    local_time.tm_sec = p_Data[6];
+
+    reference.Seconds = SysTimeMkTime(&local_time);
+    reference.SubSeconds = (Length >= 9) ? (int16_t)((p_Data[8] * 1000U) / 256U) : 0;
+
+    /* Manual time update, time zone or DST change: not a drift of the local clock */
+    if ((Length >= 10) && ((p_Data[9] & 0x0DU) != 0U))
+    {
+      step = 1;
+    }
+
+    (void)WALL_CLOCK_Sync(reference, step);
+#else
+    counter_to_1_min = p_Data[6] * 1000 / REFRESH_SCREEN_TIMER;
+#endif /* CFG_WALL_CLOCK_SUPPORTED */
+    UTIL_TIMER_Start(&ClientTimer_Id);
+  }
+  else
+  {
+    LOG_INFO_APP("Curent Time unknown\n\n");
+  }
+
+  return;
+}
+
+static void client_read_battery_cb(uint8_t index, uint8_t OpId, GATT_CLIENT_APP_OpStatus_t Status,
+                                   const uint8_t *p_Data, uint16_t Length, void *p_Context)
+{
+  UNUSED(index);
+  UNUSED(OpId);
+  UNUSED(p_Context);
+
+  if ((Status == GATT_CLIENT_APP_OP_SUCCESS) && (Length >= 1))
+  {
+    current_battery_level = p_Data[0];
+  }
+  else
+  {
+    LOG_INFO_APP("Read Battery Level NOK status =%d\n\n", Status);
+  }
+
+  return;
+}
 /* USER CODE END LF */
@@ -47,6 +47,7 @@ typedef enum
   GATT_CLIENT_APP_ENABLE_NOTIFICATION_DESC,
   GATT_CLIENT_APP_DISABLE_NOTIFICATION_DESC,
   /* USER CODE BEGIN GATT_CLIENT_APP_State_t*/
+  GATT_CLIENT_APP_READ_DB_HASH,
 
   /* USER CODE END GATT_CLIENT_APP_State_t */
 }GATT_CLIENT_APP_State_t;
@@ -67,6 +68,9 @@ typedef enum
   PROC_GATT_DISC_ALL_DESCS,
   PROC_GATT_PROPERTIES_ENABLE_ALL,
   /* USER CODE BEGIN ProcGattId_t*/
+  PROC_GATT_DISC_PLAN_SERVICES,
+  PROC_GATT_DISC_PLAN_CHARS,
+  PROC_GATT_DISC_PLAN_DESCS,
 
   /* USER CODE END ProcGattId_t */
 }ProcGattId_t;
@@ -77,16 +81,38 @@ typedef struct
   uint16_t                              ConnHdl;
 }GATT_CLIENT_APP_ConnHandle_Notif_evt_t;
 /* USER CODE BEGIN ET */
+/* Result of a queued GATT operation */
 typedef enum
 {
-  CLIENT_READ_TIME,
-  CLIENT_READ_BATTERY_LEVEL,
-}Init_Client_State_t;
+  GATT_CLIENT_APP_OP_SUCCESS,
+  GATT_CLIENT_APP_OP_ERROR,         /* Command rejected or procedure failed */
+  GATT_CLIENT_APP_OP_TIMEOUT,
+  GATT_CLIENT_APP_OP_CANCELLED,
+  GATT_CLIENT_APP_OP_DISCONNECTED,
+}GATT_CLIENT_APP_OpStatus_t;
+
+/**
+  * Completion callback of a queued GATT operation, called from the GATT operation task
+  * p_Data and Length give the value of a read, they are only valid during the call
+  */
+typedef void (*GATT_CLIENT_APP_OpCb_t)(uint8_t index,
+                                       uint8_t OpId,
+                                       GATT_CLIENT_APP_OpStatus_t Status,
+                                       const uint8_t *p_Data,
+                                       uint16_t Length,
+                                       void *p_Context);
 /* USER CODE END ET */
 
 /* Exported constants --------------------------------------------------------*/
 /* USER CODE BEGIN EC */
-
+/* Operations queued per link */
+#define GATT_CLIENT_APP_OP_QUEUE_SIZE   (8U)
+/* Largest value written or read by a queued operation: ANCS Get App Attributes command */
+#define GATT_CLIENT_APP_OP_DATA_SIZE    (104U)
+/* Time given to an operation to complete */
+#define GATT_CLIENT_APP_OP_TIMEOUT_MS   (5000U)
+/* Identifier returned when the operation could not be queued */
+#define GATT_CLIENT_APP_OP_INVALID_ID   (0U)
 /* USER CODE END EC */
 
 /* External variables --------------------------------------------------------*/
@@ -107,6 +133,17 @@ tBleStatus GATT_CLIENT_APP_Set_Conn_Handle(uint8_t index, uint16_t connHdle);
 uint8_t GATT_CLIENT_APP_Get_State(uint8_t index);
 void GATT_CLIENT_APP_Discover_services(uint8_t index);
 /* USER CODE BEGIN EFP */
+void GATT_CLIENT_APP_Set_Peer_Address(uint8_t index, uint8_t PeerAddrType, const uint8_t *p_PeerAddr);
+void GATT_CLIENT_APP_Request_Discovery(uint8_t index);
+uint8_t GATT_CLIENT_APP_Op_Read(uint8_t index, uint16_t AttHdl, GATT_CLIENT_APP_OpCb_t Callback, void *p_Context);
+uint8_t GATT_CLIENT_APP_Op_Read_Long(uint8_t index, uint16_t AttHdl, GATT_CLIENT_APP_OpCb_t Callback, void *p_Context);
+uint8_t GATT_CLIENT_APP_Op_Write(uint8_t index, uint16_t AttHdl, uint16_t Length, const uint8_t *p_Data,
+                                 GATT_CLIENT_APP_OpCb_t Callback, void *p_Context);
+uint8_t GATT_CLIENT_APP_Op_Write_No_Resp(uint8_t index, uint16_t AttHdl, uint16_t Length, const uint8_t *p_Data,
+                                         GATT_CLIENT_APP_OpCb_t Callback, void *p_Context);
+uint8_t GATT_CLIENT_APP_Op_Enable_Cccd(uint8_t index, uint16_t DescHdl, uint16_t CccdValue,
+                                       GATT_CLIENT_APP_OpCb_t Callback, void *p_Context);
+uint8_t GATT_CLIENT_APP_Op_Cancel(uint8_t index, uint8_t OpId);
 
 /* USER CODE END EFP */
 
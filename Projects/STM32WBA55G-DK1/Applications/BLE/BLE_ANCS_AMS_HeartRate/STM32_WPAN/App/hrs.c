@@ -23,6 +23,7 @@
 #include "hrs.h"
 
 /* USER CODE BEGIN Includes */
+#include "hrs_app.h"
 
 /* USER CODE END Includes */
 
@@ -73,7 +74,7 @@ typedef struct{
 /* USER CODE END PM */
 
 /* Private variables ---------------------------------------------------------*/
-static const uint16_t SizeHrme = 23;
+static const uint16_t SizeHrme = HRS_HRME_MAX_LENGTH;
 static const uint16_t SizeBsl = 1;
 static const uint16_t SizeHrcp = 1;
 
@@ -258,6 +259,7 @@ static SVCCTL_EvtAckStatus_t HRS_EventHandler(void *p_Event)
           UNUSED(p_tx_pool_available_event);
 
           /* USER CODE BEGIN ACI_GATT_TX_POOL_AVAILABLE_VSEVT_CODE */
+          HRS_APP_TxPoolAvailable();
 
           /* USER CODE END ACI_GATT_TX_POOL_AVAILABLE_VSEVT_CODE */
           break;/* ACI_GATT_TX_POOL_AVAILABLE_VSEVT_CODE*/
@@ -458,7 +460,19 @@ void HRS_Init(void)
   /* USER CODE END SVCCTL_InitService1Char3 */
 
   /* USER CODE BEGIN SVCCTL_InitService1Svc_2 */
-
+  /* Route the events of the attributes of the service to the handler, it then gets no other event */
+  SVCCTL_RegisterRoute(ACI_GATT_ATTRIBUTE_MODIFIED_VSEVT_CODE,
+                       HRS_Context.HrsSvcHdle, HRS_Context.HrcpCharHdle + CHARACTERISTIC_VALUE_ATTRIBUTE_OFFSET,
+                       HRS_EventHandler);
+  SVCCTL_RegisterRoute(ACI_GATT_READ_PERMIT_REQ_VSEVT_CODE,
+                       HRS_Context.HrsSvcHdle, HRS_Context.HrcpCharHdle + CHARACTERISTIC_VALUE_ATTRIBUTE_OFFSET,
+                       HRS_EventHandler);
+  SVCCTL_RegisterRoute(ACI_GATT_WRITE_PERMIT_REQ_VSEVT_CODE,
+                       HRS_Context.HrsSvcHdle, HRS_Context.HrcpCharHdle + CHARACTERISTIC_VALUE_ATTRIBUTE_OFFSET,
+                       HRS_EventHandler);
+  SVCCTL_RegisterRoute(ACI_GATT_TX_POOL_AVAILABLE_VSEVT_CODE,
+                       SVCCTL_ROUTE_HANDLE_FIRST, SVCCTL_ROUTE_HANDLE_LAST,
+                       HRS_EventHandler);
   /* USER CODE END SVCCTL_InitService1Svc_2 */
 
   return;
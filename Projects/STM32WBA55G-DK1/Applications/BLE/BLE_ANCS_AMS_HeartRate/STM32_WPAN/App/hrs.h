@@ -34,6 +34,8 @@ extern "C" {
 /* Exported defines ----------------------------------------------------------*/
 /* USER CODE BEGIN ED */
 #define HRS_MAX_NBR_RR_INTERVAL_VALUES                     (9)
+/* Longest Heart Rate Measurement value: header and up to 50 RR intervals */
+#define HRS_HRME_MAX_LENGTH                                (105)
 /* USER CODE END ED */
 
 /* Exported types ------------------------------------------------------------*/
@@ -34,11 +34,29 @@
 #include "stm32_timer.h"
 #include "host_stack_if.h"
 #include "app_menu.h"
+#include "hrs_log.h"
+#include "app_entry.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
 /* USER CODE BEGIN PTD */
+#define HRS_APP_RR_RING_SIZE         (64)    /* RR intervals buffered while the link is congested */
 
+/* RR intervals waiting to be notified, oldest first */
+typedef struct
+{
+  uint16_t a_Value[HRS_APP_RR_RING_SIZE];
+  uint8_t  Head;
+  uint8_t  Count;
+}HRS_APP_RrRing_t;
+
+typedef struct
+{
+  uint32_t Notifications;
+  uint32_t RrSent;
+  uint32_t RrDropped;
+  uint32_t TxPoolFull;
+}HRS_APP_Stats_t;
 /* USER CODE END PTD */
 
 typedef enum
@@ -58,13 +76,26 @@ typedef struct
   HRS_MeasVal_t                 MeasurementVal;
   uint8_t                       ResetEnergyExpended;
   HRS_BodySensorLocation_t      BodySensorLocationVal;
+  /* Length of the fields preceding the RR intervals, fixed by the flags */
+  uint8_t                       HeaderLength;
+  /* A measurement has been taken since the last notification */
+  uint8_t                       MeasPending;
+  /* Waiting for ACI_GATT_TX_POOL_AVAILABLE_VSEVT before notifying again */
+  uint8_t                       TxPoolFull;
+  uint32_t                      LastMeasTime;
+  /* Time elapsed since the last simulated beat, in ms */
+  uint32_t                      BeatTime;
+  HRS_APP_RrRing_t              RrRing;
+  HRS_APP_Stats_t               Stats;
   /* USER CODE END Service1_APP_Context_t */
   uint16_t              ConnectionHandle;
 } HRS_APP_Context_t;
 
 /* Private defines -----------------------------------------------------------*/
 /* USER CODE BEGIN PD */
-#define HRS_APP_RR_INTERVAL_NBR      (1)     /* Number of RR interval, shall be lower than HRS_MAX_NBR_RR_INTERVAL_VALUES*/
+#define HRS_APP_ATT_NOTIF_HEADER     (3)     /* Opcode and attribute handle of a notification */
+#define HRS_APP_BEATS_MAX            (8)     /* Beats handled per measurement */
+#define HRS_APP_MEAS_PERIOD_MS       (1000)  /* Measured and logged even when no collector is connected */
 /* USER CODE END PD */
 
 /* External variables --------------------------------------------------------*/
@@ -87,6 +118,7 @@ static HRS_APP_Context_t HRS_APP_Context;
 uint8_t a_HRS_UpdateCharData[247];
 
 /* USER CODE BEGIN PV */
+static UTIL_TIMER_Object_t HRS_APP_MeasTimer;
 
 /* USER CODE END PV */
 
@@ -95,6 +127,12 @@ static void HRS_Hrme_SendNotification(void);
 
 /* USER CODE BEGIN PFP */
 static void HRS_APP_Measurements(void);
+static void HRS_APP_MeasTimer_cb(void *arg);
+static void HRS_APP_Send(void);
+static uint8_t HRS_APP_Serialize(uint8_t MaxRr, uint8_t *p_NbRr);
+static void HRS_APP_RrPush(uint16_t RrInterval);
+static void HRS_APP_RrPop(uint8_t NbRr);
+static void HRS_APP_Stop(void);
 /* USER CODE END PFP */
 
 /* Functions Definition ------------------------------------------------------*/
@@ -115,13 +153,14 @@ void HRS_Notification(HRS_NotificationEvt_t *p_Notification)
     case HRS_HRME_NOTIFY_ENABLED_EVT:
       /* USER CODE BEGIN Service1Char1_NOTIFY_ENABLED_EVT */
         HRS_APP_Context.Hrme_Notification_Status = Hrme_NOTIFICATION_ON;
-    
+        memset(&HRS_APP_Context.Stats, 0, sizeof(HRS_APP_Context.Stats));
       /* USER CODE END Service1Char1_NOTIFY_ENABLED_EVT */
       break;
 
     case HRS_HRME_NOTIFY_DISABLED_EVT:
       /* USER CODE BEGIN Service1Char1_NOTIFY_DISABLED_EVT */
       HRS_APP_Context.Hrme_Notification_Status = Hrme_NOTIFICATION_OFF;
+      HRS_APP_Stop();
       p_hrs_menu->pIcon->pImage = (uint8_t *) &empty_heart_byteicon;
       /* USER CODE END Service1Char1_NOTIFY_DISABLED_EVT */
       break;
@@ -169,8 +208,13 @@ void HRS_APP_EvtRx(HRS_APP_ConnHandleNotEvt_t *p_Notification)
 
     case HRS_DISCON_HANDLE_EVT :
       /* USER CODE BEGIN Service1_APP_DISCON_HANDLE_EVT */
+      if (HRS_APP_Context.Hrme_Notification_Status == Hrme_NOTIFICATION_ON)
+      {
+        HRS_APP_Stop();
+      }
       HRS_APP_Context.Hrme_Notification_Status = Hrme_NOTIFICATION_OFF;
       p_hrs_menu->pIcon->pImage = (uint8_t *) &empty_heart_byteicon;
+      HRS_LOG_LinkDown(p_Notification->ConnectionHandle);
       /* USER CODE END Service1_APP_DISCON_HANDLE_EVT */
       break;
 
@@ -196,7 +240,16 @@ void HRS_APP_Init(void)
   /* USER CODE BEGIN Service1_APP_Init */
   HRS_Data_t msg_conf;
 
-  UTIL_SEQ_RegTask(1<<CFG_TASK_MEAS_REQ_ID, UTIL_SEQ_RFU, HRS_APP_Measurements);
+  APPE_SEQ_RegTask(1<<CFG_TASK_MEAS_REQ_ID, UTIL_SEQ_RFU, HRS_APP_Measurements);
+  APPE_SEQ_RegTask(1<<CFG_TASK_HRS_SEND_ID, UTIL_SEQ_RFU, HRS_APP_Send);
+  HRS_LOG_Init();
+
+  HRS_APP_Context.LastMeasTime = UTIL_TIMER_GetCurrentTime();
+  UTIL_TIMER_Create(&HRS_APP_MeasTimer,
+                    HRS_APP_MEAS_PERIOD_MS,
+                    UTIL_TIMER_PERIODIC,
+                    &HRS_APP_MeasTimer_cb, 0);
+  UTIL_TIMER_Start(&HRS_APP_MeasTimer);
 
   /**
    * Set Flags for measurement value
@@ -213,15 +266,22 @@ void HRS_APP_Init(void)
     HRS_APP_Context.MeasurementVal.EnergyExpended = 10;
   }
 
-  if(HRS_APP_Context.MeasurementVal.Flags & HRS_HRM_RR_INTERVAL_PRESENT)
+  /**
+   * The flags do not change at run time: the layout of the fields preceding
+   * the RR intervals is computed once
+   */
+  HRS_APP_Context.HeaderLength = 1;
+  if(HRS_APP_Context.MeasurementVal.Flags & HRS_HRM_VALUE_FORMAT_UINT16)
   {
-    uint8_t i;
-
-    HRS_APP_Context.MeasurementVal.NbreOfValidRRIntervalValues = HRS_APP_RR_INTERVAL_NBR;
-    for(i = 0; i < HRS_MAX_NBR_RR_INTERVAL_VALUES; i++)
-    {
-      HRS_APP_Context.MeasurementVal.aRRIntervalValues[i] = 1024;
-    }
+    HRS_APP_Context.HeaderLength += 2;
+  }
+  else
+  {
+    HRS_APP_Context.HeaderLength += 1;
+  }
+  if(HRS_APP_Context.MeasurementVal.Flags & HRS_HRM_ENERGY_EXPENDED_PRESENT)
+  {
+    HRS_APP_Context.HeaderLength += 2;
   }
 
   msg_conf.Length = 1;
@@ -234,7 +294,21 @@ void HRS_APP_Init(void)
 }
 
 /* USER CODE BEGIN FD */
+/**
+ * @brief  Resume the notifications stopped on a full TX pool
+ * @param  None
+ * @retval None
+ */
+void HRS_APP_TxPoolAvailable(void)
+{
+  if (HRS_APP_Context.TxPoolFull != 0)
+  {
+    HRS_APP_Context.TxPoolFull = 0;
+    UTIL_SEQ_SetTask(1<<CFG_TASK_HRS_SEND_ID, CFG_SEQ_PRIO_0);
+  }
 
+  return;
+}
 /* USER CODE END FD */
 
 /*************************************************************
@@ -267,12 +341,20 @@ __USED void HRS_Hrme_SendNotification(void) /* Property Notification */
 }
 
 /* USER CODE BEGIN FD_LOCAL_FUNCTIONS*/
+/**
+ * @brief  Take a heart rate measurement, log it with the RR intervals of the
+ *         beats elapsed since the previous one and queue them for the
+ *         collector
+ * @param  None
+ * @retval None
+ */
 static void HRS_APP_Measurements(void)
 {
   uint32_t measurement;
-  tBleStatus ret;
-  HRS_Data_t msg_conf;
-  uint8_t hrm_char_length;
+  uint32_t beat_period;
+  uint16_t a_rr_interval[HRS_APP_BEATS_MAX];
+  uint8_t nb_rr = 0;
+  uint8_t index;
 
   HW_RNG_Get(1, &measurement);
   measurement = (measurement % 15) + 60;
@@ -289,126 +371,97 @@ static void HRS_APP_Measurements(void)
     HRS_APP_Context.ResetEnergyExpended = 0;
   }
   
-  LOG_INFO_APP("Heart Rate value = %d bpm \n", HRS_APP_Context.MeasurementVal.MeasurementValue);
-  LOG_INFO_APP("Energy expended = %d kJ \n", HRS_APP_Context.MeasurementVal.EnergyExpended);
-  /**
-   * Flags update
-   */
-  a_HRS_UpdateCharData[0] = HRS_APP_Context.MeasurementVal.Flags;
-  hrm_char_length = 1;
-
   /**
-   *  Heart Rate Measurement Value
+   * One RR interval per beat, in 1/1024 s
    */
-  if ( (HRS_APP_Context.MeasurementVal.Flags) &  HRS_HRM_VALUE_FORMAT_UINT16 )
+  if ((HRS_APP_Context.MeasurementVal.Flags) & HRS_HRM_RR_INTERVAL_PRESENT)
   {
-    a_HRS_UpdateCharData[hrm_char_length] = (uint8_t)(HRS_APP_Context.MeasurementVal.MeasurementValue & 0xFF);
-    hrm_char_length++;
-    a_HRS_UpdateCharData[hrm_char_length] = (uint8_t)(HRS_APP_Context.MeasurementVal.MeasurementValue >> 8);
-    hrm_char_length++;
+    beat_period = 60000 / measurement;
+    HRS_APP_Context.BeatTime += UTIL_TIMER_GetElapsedTime(HRS_APP_Context.LastMeasTime);
+    while ((HRS_APP_Context.BeatTime >= beat_period) && (nb_rr < HRS_APP_BEATS_MAX))
+    {
+      HRS_APP_Context.BeatTime -= beat_period;
+      a_rr_interval[nb_rr++] = (uint16_t)((60 * 1024) / measurement);
+    }
+    HRS_APP_Context.BeatTime = MIN(HRS_APP_Context.BeatTime, beat_period);
   }
-  else
+  HRS_APP_Context.LastMeasTime = UTIL_TIMER_GetCurrentTime();
+
+  HRS_LOG_Add((uint8_t)measurement, a_rr_interval, nb_rr);
+
+  if (HRS_APP_Context.Hrme_Notification_Status == Hrme_NOTIFICATION_ON)
   {
-    a_HRS_UpdateCharData[hrm_char_length] = (uint8_t)HRS_APP_Context.MeasurementVal.MeasurementValue;
-    hrm_char_length++;
+    LOG_INFO_APP("Heart Rate value = %d bpm \n", HRS_APP_Context.MeasurementVal.MeasurementValue);
+    LOG_INFO_APP("Energy expended = %d kJ \n", HRS_APP_Context.MeasurementVal.EnergyExpended);
+
+    for (index = 0; index < nb_rr; index++)
+    {
+      HRS_APP_RrPush(a_rr_interval[index]);
+    }
+    HRS_APP_Context.MeasPending = 1;
+    UTIL_SEQ_SetTask(1<<CFG_TASK_HRS_SEND_ID, CFG_SEQ_PRIO_0);
   }
 
-  /**
-   *  Energy Expended
-   */
-  if ((HRS_APP_Context.MeasurementVal.Flags) &  HRS_HRM_ENERGY_EXPENDED_PRESENT)
+  return;
+}
+
+/**
+ * @brief  Notify the last measurement and the queued RR intervals, packing
+ *         as many intervals per notification as the ATT MTU allows. Stops
+ *         when the TX pool is full and resumes on TX pool available.
+ * @param  None
+ * @retval None
+ */
+static void HRS_APP_Send(void)
+{
+  tBleStatus ret;
+  HRS_Data_t msg_conf;
+  uint16_t max_length;
+  uint8_t max_rr = 0;
+  uint8_t nb_rr;
+  uint8_t sent = 0;
+
+  max_length = APP_BLE_Get_Min_Att_Mtu() - HRS_APP_ATT_NOTIF_HEADER;
+  if (max_length > HRS_HRME_MAX_LENGTH)
   {
-    a_HRS_UpdateCharData[hrm_char_length] = (uint8_t)(HRS_APP_Context.MeasurementVal.EnergyExpended & 0xFF);
-    hrm_char_length++;
-    a_HRS_UpdateCharData[hrm_char_length] = (uint8_t)(HRS_APP_Context.MeasurementVal.EnergyExpended >> 8);
-    hrm_char_length++;
+    max_length = HRS_HRME_MAX_LENGTH;
   }
-
-  /**
-   *  RR Interval Values
-   */
-  if ((HRS_APP_Context.MeasurementVal.Flags) &  HRS_HRM_RR_INTERVAL_PRESENT)
+  if ((HRS_APP_Context.MeasurementVal.Flags) & HRS_HRM_RR_INTERVAL_PRESENT)
   {
-    uint8_t index;
-    uint8_t rr_interval_number;
+    max_rr = (max_length - HRS_APP_Context.HeaderLength) / 2;
+  }
 
-    if((HRS_APP_Context.MeasurementVal.Flags) &  HRS_HRM_VALUE_FORMAT_UINT16)
+  while ((HRS_APP_Context.Hrme_Notification_Status == Hrme_NOTIFICATION_ON) &&
+         (HRS_APP_Context.TxPoolFull == 0) &&
+         ((HRS_APP_Context.MeasPending != 0) || (HRS_APP_Context.RrRing.Count != 0)))
+  {
+    msg_conf.p_Payload = a_HRS_UpdateCharData;
+    msg_conf.Length = HRS_APP_Serialize(max_rr, &nb_rr);
+    ret = HRS_UpdateValue(HRS_HRME, &msg_conf);
+    if (ret == BLE_STATUS_INSUFFICIENT_RESOURCES)
     {
-      if ((HRS_APP_Context.MeasurementVal.Flags) &  HRS_HRM_ENERGY_EXPENDED_PRESENT)
-      {
-#if (BLE_CFG_HRS_ENERGY_RR_INTERVAL_FLAG > (HRS_MAX_NBR_RR_INTERVAL_VALUES-2))
-        /**
-         * When the HRM is on 16bits and the Energy expended info is present
-         * The maximum RR values is 7
-         */
-        if(HRS_APP_Context.MeasurementVal.NbreOfValidRRIntervalValues > (HRS_MAX_NBR_RR_INTERVAL_VALUES-2))
-        {
-          rr_interval_number = (HRS_MAX_NBR_RR_INTERVAL_VALUES-2);
-        }
-        else
-#endif
-        {
-          rr_interval_number = HRS_APP_Context.MeasurementVal.NbreOfValidRRIntervalValues;
-        }
-      }
-      else
-      {
-#if (BLE_CFG_HRS_ENERGY_RR_INTERVAL_FLAG > (HRS_MAX_NBR_RR_INTERVAL_VALUES-1))
-        /**
-         * When the HRM is on 16bits and the Energy expended info is not present
-         * The maximum RR values is 8
-         */
-        if(HRS_APP_Context.MeasurementVal.NbreOfValidRRIntervalValues > (HRS_MAX_NBR_RR_INTERVAL_VALUES-1))
-        {
-          rr_interval_number = (HRS_MAX_NBR_RR_INTERVAL_VALUES-1);
-        }
-        else
-#endif
-        {
-          rr_interval_number = HRS_APP_Context.MeasurementVal.NbreOfValidRRIntervalValues;
-        }
-      }
+      /* Kept queued, sent again on ACI_GATT_TX_POOL_AVAILABLE_VSEVT */
+      HRS_APP_Context.TxPoolFull = 1;
+      HRS_APP_Context.Stats.TxPoolFull++;
     }
-    else
+    else if (ret != BLE_STATUS_SUCCESS)
     {
-      if ((HRS_APP_Context.MeasurementVal.Flags) &  HRS_HRM_ENERGY_EXPENDED_PRESENT)
-      {
-#if (BLE_CFG_HRS_ENERGY_RR_INTERVAL_FLAG > (HRS_MAX_NBR_RR_INTERVAL_VALUES-1))
-        /**
-         * When the HRM is on 8bits and the Energy expended info is present
-         * The maximum RR values is 8
-         */
-        if(HRS_APP_Context.MeasurementVal.NbreOfValidRRIntervalValues > (HRS_MAX_NBR_RR_INTERVAL_VALUES-1))
-        {
-          rr_interval_number = (HRS_MAX_NBR_RR_INTERVAL_VALUES-1);
-        }
-        else
-#endif
-        {
-          rr_interval_number = HRS_APP_Context.MeasurementVal.NbreOfValidRRIntervalValues;
-        }
-      }
-      else
-      {
-        rr_interval_number = HRS_APP_Context.MeasurementVal.NbreOfValidRRIntervalValues;
-      }
+      LOG_INFO_APP("HRS_UpdateValue fails\n");
+      break;
     }
-
-    for ( index = 0 ; index < rr_interval_number ; index++ )
+    else
     {
-      a_HRS_UpdateCharData[hrm_char_length] = (uint8_t)(HRS_APP_Context.MeasurementVal.aRRIntervalValues[index] & 0xFF);
-      hrm_char_length++;
-      a_HRS_UpdateCharData[hrm_char_length] = (uint8_t)(HRS_APP_Context.MeasurementVal.aRRIntervalValues[index] >> 8);
-      hrm_char_length++;
+      HRS_APP_RrPop(nb_rr);
+      HRS_APP_Context.MeasPending = 0;
+      HRS_APP_Context.Stats.Notifications++;
+      HRS_APP_Context.Stats.RrSent += nb_rr;
+      sent = 1;
     }
   }
 
-  msg_conf.p_Payload = a_HRS_UpdateCharData;
-  msg_conf.Length = hrm_char_length;
-  ret = HRS_UpdateValue(HRS_HRME, &msg_conf);
-  if(ret != BLE_STATUS_SUCCESS)
+  if (sent != 0)
   {
-    LOG_INFO_APP("HRS_UpdateValue fails\n");
+    APP_BLE_ConnParam_Traffic(APP_BLE_ALL_LINKS, APP_BLE_TRAFFIC_STREAMING);
   }
 
   BleStackCB_Process();
@@ -416,18 +469,132 @@ static void HRS_APP_Measurements(void)
   return;
 }
 
+/**
+ * @brief  Build the Heart Rate Measurement value in a_HRS_UpdateCharData
+ * @param  MaxRr: Maximum number of RR intervals to add
+ * @param  p_NbRr: Number of RR intervals added, from the oldest queued one
+ * @retval Length of the value
+ */
+static uint8_t HRS_APP_Serialize(uint8_t MaxRr, uint8_t *p_NbRr)
+{
+  HRS_APP_RrRing_t *p_ring = &HRS_APP_Context.RrRing;
+  uint8_t *p_data = a_HRS_UpdateCharData;
+  uint8_t nb_rr;
+  uint8_t index;
+  uint8_t slot;
+
+  nb_rr = MIN(MaxRr, p_ring->Count);
+
+  p_data[0] = HRS_APP_Context.MeasurementVal.Flags;
+  if (nb_rr == 0)
+  {
+    p_data[0] &= ~HRS_HRM_RR_INTERVAL_PRESENT;
+  }
+  p_data++;
+
+  if ((HRS_APP_Context.MeasurementVal.Flags) & HRS_HRM_VALUE_FORMAT_UINT16)
+  {
+    *p_data++ = (uint8_t)(HRS_APP_Context.MeasurementVal.MeasurementValue & 0xFF);
+    *p_data++ = (uint8_t)(HRS_APP_Context.MeasurementVal.MeasurementValue >> 8);
+  }
+  else
+  {
+    *p_data++ = (uint8_t)HRS_APP_Context.MeasurementVal.MeasurementValue;
+  }
+
+  if ((HRS_APP_Context.MeasurementVal.Flags) & HRS_HRM_ENERGY_EXPENDED_PRESENT)
+  {
+    *p_data++ = (uint8_t)(HRS_APP_Context.MeasurementVal.EnergyExpended & 0xFF);
+    *p_data++ = (uint8_t)(HRS_APP_Context.MeasurementVal.EnergyExpended >> 8);
+  }
+
+  slot = p_ring->Head;
+  for (index = 0; index < nb_rr; index++)
+  {
+    *p_data++ = (uint8_t)(p_ring->a_Value[slot] & 0xFF);
+    *p_data++ = (uint8_t)(p_ring->a_Value[slot] >> 8);
+    slot = (slot + 1) % HRS_APP_RR_RING_SIZE;
+  }
+
+  *p_NbRr = nb_rr;
+
+  return (HRS_APP_Context.HeaderLength + (2 * nb_rr));
+}
+
+/**
+ * @brief  Queue an RR interval, dropping the oldest one when the ring is full
+ * @param  RrInterval: RR interval, in 1/1024 s
+ * @retval None
+ */
+static void HRS_APP_RrPush(uint16_t RrInterval)
+{
+  HRS_APP_RrRing_t *p_ring = &HRS_APP_Context.RrRing;
+
+  if (p_ring->Count == HRS_APP_RR_RING_SIZE)
+  {
+    p_ring->Head = (p_ring->Head + 1) % HRS_APP_RR_RING_SIZE;
+    p_ring->Count--;
+    HRS_APP_Context.Stats.RrDropped++;
+  }
+
+  p_ring->a_Value[(p_ring->Head + p_ring->Count) % HRS_APP_RR_RING_SIZE] = RrInterval;
+  p_ring->Count++;
+
+  return;
+}
+
+/**
+ * @brief  Remove the oldest RR intervals once notified
+ * @param  NbRr: Number of RR intervals to remove
+ * @retval None
+ */
+static void HRS_APP_RrPop(uint8_t NbRr)
+{
+  HRS_APP_RrRing_t *p_ring = &HRS_APP_Context.RrRing;
+
+  p_ring->Head = (p_ring->Head + NbRr) % HRS_APP_RR_RING_SIZE;
+  p_ring->Count -= NbRr;
+
+  return;
+}
+
+/**
+ * @brief  Log the statistics of the notification session and drop the data
+ *         not notified
+ * @param  None
+ * @retval None
+ */
+static void HRS_APP_Stop(void)
+{
+  LOG_INFO_APP("HRS: %d notifications, %d RR intervals sent, %d dropped, TX pool full %d times\n",
+               HRS_APP_Context.Stats.Notifications,
+               HRS_APP_Context.Stats.RrSent,
+               HRS_APP_Context.Stats.RrDropped,
+               HRS_APP_Context.Stats.TxPoolFull);
+
+  /* RR intervals of a previous session are meaningless to the next one */
+  HRS_APP_Context.RrRing.Head = 0;
+  HRS_APP_Context.RrRing.Count = 0;
+  HRS_APP_Context.MeasPending = 0;
+  HRS_APP_Context.TxPoolFull = 0;
+
+  return;
+}
+
+static void HRS_APP_MeasTimer_cb(void *arg)
+{
+  UTIL_SEQ_SetTask(1<<CFG_TASK_MEAS_REQ_ID, CFG_SEQ_PRIO_0);
+
+  return;
+}
+
 void hrs_update(void)
 {
-  static uint8_t reduce_frequency = 0;
   if (HRS_APP_Context.Hrme_Notification_Status == Hrme_NOTIFICATION_OFF)
   {
     return;
   }
   
-  if (reduce_frequency++%2)
-  {
-    HRS_APP_Measurements();
-  }
   snprintf(hrs_text.Lines[0] , 17, "  %2dbpm - %3dkcal",HRS_APP_Context.MeasurementVal.MeasurementValue %100, HRS_APP_Context.MeasurementVal.EnergyExpended%1000);
   if (p_hrs_menu->pIcon->pImage == full_heart_byteicon)
     p_hrs_menu->pIcon->pImage = (uint8_t *) &empty_heart_byteicon;
@@ -77,6 +77,7 @@ void HRS_APP_Init(void);
 void HRS_APP_EvtRx(HRS_APP_ConnHandleNotEvt_t *p_Notification);
 /* USER CODE BEGIN EFP */
 void hrs_update(void);
+void HRS_APP_TxPoolAvailable(void);
 /* USER CODE END EFP */
 
 #ifdef __cplusplus
@@ -0,0 +1,1035 @@
+/**
+  ******************************************************************************
+  * @file    hrs_log.c
+  * @author  MCD Application Team
+  * @brief   Heart rate history log, stored in flash and exported over an
+  *          L2CAP connection-oriented channel
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "app_common.h"
+#include "app_conf.h"
+#include "ble.h"
+#include "stm32_seq.h"
+#include "app_entry.h"
+#include "stm32_timer.h"
+#include "flash_manager.h"
+#include "hrs_log.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Magic;
+  uint32_t Sequence;
+  uint32_t a_Reserved[2];
+} HRS_LOG_PageHeader_t;
+
+/* Flash write source, 32-bit aligned */
+typedef union
+{
+  HRS_LOG_Block_t Block;
+  uint32_t        a_Word[HRS_LOG_BLOCK_SIZE / 4];
+} HRS_LOG_Buffer_t;
+
+typedef enum
+{
+  HRS_LOG_FLASH_IDLE,
+  HRS_LOG_FLASH_ERASE,
+  HRS_LOG_FLASH_HEADER,
+  HRS_LOG_FLASH_BLOCK,
+} HRS_LOG_FlashState_t;
+
+typedef struct
+{
+  uint32_t Samples;
+  uint32_t Blocks;
+  uint32_t Dropped;
+  uint32_t FlashErrors;
+} HRS_LOG_Stats_t;
+
+typedef struct
+{
+  /* Page being written, its sequence number and its next free block */
+  uint8_t  Page;
+  uint8_t  PageReady;
+  uint16_t Block;
+  uint32_t Sequence;
+  HRS_LOG_PageHeader_t PageHeader;
+  HRS_LOG_FlashState_t FlashState;
+  /* Flash operation requested again once the flash manager is available */
+  uint8_t  FlashRetry;
+  uint8_t  FlashDone;
+  /* Block being filled and block waiting to be written */
+  HRS_LOG_Buffer_t a_Buffer[2];
+  uint8_t  Fill;
+  uint8_t  Pending;
+  /* Log time of the last reset and encoder state */
+  uint32_t TimeBase;
+  uint32_t LastTime;
+  uint8_t  LastHeartRate;
+  uint16_t LastRr;
+  HRS_LOG_Stats_t Stats;
+} HRS_LOG_Context_t;
+
+typedef enum
+{
+  HRS_LOG_EXPORT_CLOSED,
+  HRS_LOG_EXPORT_OPEN,
+  HRS_LOG_EXPORT_FLASH,
+  HRS_LOG_EXPORT_LAST_BLOCK,
+  HRS_LOG_EXPORT_END,
+  HRS_LOG_EXPORT_DONE,
+} HRS_LOG_ExportState_t;
+
+typedef struct
+{
+  HRS_LOG_ExportState_t State;
+  uint16_t ConnHdl;
+  uint8_t  ChannelIndex;
+  uint16_t PeerMtu;
+  uint16_t PeerMps;
+  uint16_t Credits;
+  uint8_t  TxPoolFull;
+  /* Next block to read from flash */
+  uint8_t  Page;
+  uint16_t Block;
+  uint32_t Sequence;
+  /* SDU being sent, prefixed by its length as in the first K-frame */
+  uint8_t  a_Sdu[2 + 1 + (HRS_LOG_SDU_BLOCKS_MAX * HRS_LOG_BLOCK_SIZE)];
+  uint16_t SduLength;
+  uint16_t SduOffset;
+  /* Statistics of the export in progress */
+  uint32_t StartTime;
+  uint32_t BlocksSent;
+  uint32_t Bytes;
+  uint32_t KFrames;
+  uint32_t CreditStalls;
+  uint32_t TxPoolStalls;
+} HRS_LOG_Export_t;
+
+/* Private defines -----------------------------------------------------------*/
+#define HRS_LOG_PAGE_MAGIC            (0x314C5248u)  /* "HRL1" */
+#define HRS_LOG_ERASED_WORD           (0xFFFFFFFFu)
+#define HRS_LOG_NO_BUFFER             (0xFF)
+#define HRS_LOG_BLOCKS_PER_PAGE       ((FLASH_PAGE_SIZE - sizeof(HRS_LOG_PageHeader_t)) / HRS_LOG_BLOCK_SIZE)
+
+/* Receive side of the channel: single-byte commands only */
+#define HRS_LOG_COC_MTU               (23)
+#define HRS_LOG_COC_MPS               (23)
+#define HRS_LOG_COC_RX_CREDITS        (2)
+
+/* Results of the credit based connection response */
+#define HRS_LOG_COC_SUCCESS                   (0x0000)
+#define HRS_LOG_COC_SPSM_NOT_SUPPORTED        (0x0002)
+#define HRS_LOG_COC_NO_RESOURCES              (0x0004)
+#define HRS_LOG_COC_UNACCEPTABLE_PARAMETERS   (0x000B)
+
+/* Private macros ------------------------------------------------------------*/
+#define HRS_LOG_PAGE_ADDRESS(page)    (CFG_HRS_LOG_START_ADDRESS + ((page) * FLASH_PAGE_SIZE))
+#define HRS_LOG_PAGE_HEADER(page)     ((const HRS_LOG_PageHeader_t *)HRS_LOG_PAGE_ADDRESS(page))
+#define HRS_LOG_BLOCK(page, block)    ((const HRS_LOG_Block_t *)(HRS_LOG_PAGE_ADDRESS(page) + \
+                                        sizeof(HRS_LOG_PageHeader_t) + ((block) * HRS_LOG_BLOCK_SIZE)))
+
+/* Private variables ---------------------------------------------------------*/
+static HRS_LOG_Context_t HRS_LOG_Context;
+static HRS_LOG_Export_t HRS_LOG_Export;
+
+static void HRS_LOG_FlashCallback(FM_FlashOp_Status_t Status);
+
+static FM_CallbackNode_t HRS_LOG_FlashCallbackNode =
+{
+  .Callback = HRS_LOG_FlashCallback
+};
+
+/* Private functions prototypes-----------------------------------------------*/
+static void HRS_LOG_Process(void);
+static void HRS_LOG_FlashStart(void);
+static void HRS_LOG_BlockStart(HRS_LOG_Block_t *p_Block, uint32_t Time, uint8_t HeartRate);
+static void HRS_LOG_BlockClose(void);
+static uint8_t HRS_LOG_EncodeMeas(uint8_t *p_Data, uint32_t Time, uint8_t HeartRate, const HRS_LOG_Block_t *p_Block);
+static uint8_t HRS_LOG_EncodeRr(uint8_t *p_Data, uint16_t RrInterval, uint16_t PrevRr);
+static void HRS_LOG_Export_Process(void);
+static uint8_t HRS_LOG_Export_BuildSdu(void);
+static const HRS_LOG_Block_t *HRS_LOG_Export_NextBlock(void);
+static void HRS_LOG_Export_Stop(void);
+
+/* Exported Functions Definition -------------------------------------------- */
+
+/**
+ * @brief  Find where the log stopped before the reset and resume from there
+ * @param  None
+ * @retval None
+ */
+void HRS_LOG_Init(void)
+{
+  const HRS_LOG_PageHeader_t *p_header;
+  const HRS_LOG_Block_t *p_block;
+  uint8_t page;
+  uint8_t found = 0;
+
+  APPE_SEQ_RegTask(1U << CFG_TASK_HRS_LOG_ID, UTIL_SEQ_RFU, HRS_LOG_Process);
+  APPE_SEQ_RegTask(1U << CFG_TASK_HRS_LOG_EXPORT_ID, UTIL_SEQ_RFU, HRS_LOG_Export_Process);
+
+  memset(&HRS_LOG_Context, 0, sizeof(HRS_LOG_Context));
+  memset(&HRS_LOG_Export, 0, sizeof(HRS_LOG_Export));
+  HRS_LOG_Context.Pending = HRS_LOG_NO_BUFFER;
+  memset(&HRS_LOG_Context.a_Buffer[0], 0xFF, sizeof(HRS_LOG_Context.a_Buffer));
+
+  /* The page written last has the highest sequence number */
+  for (page = 0; page < CFG_HRS_LOG_NBR_SECTORS; page++)
+  {
+    p_header = HRS_LOG_PAGE_HEADER(page);
+    if ((p_header->Magic == HRS_LOG_PAGE_MAGIC) &&
+        ((found == 0) || ((int32_t)(p_header->Sequence - HRS_LOG_Context.Sequence) > 0)))
+    {
+      found = 1;
+      HRS_LOG_Context.Page = page;
+      HRS_LOG_Context.Sequence = p_header->Sequence;
+    }
+  }
+
+  if (found == 0)
+  {
+    /* Empty log: act as if the last page was full so that page 0 is erased first */
+    HRS_LOG_Context.Page = CFG_HRS_LOG_NBR_SECTORS - 1;
+    HRS_LOG_Context.Sequence = HRS_LOG_ERASED_WORD;
+    HRS_LOG_Context.Block = HRS_LOG_BLOCKS_PER_PAGE;
+  }
+  else
+  {
+    HRS_LOG_Context.PageReady = 1;
+    while ((HRS_LOG_Context.Block < HRS_LOG_BLOCKS_PER_PAGE) &&
+           (HRS_LOG_BLOCK(HRS_LOG_Context.Page, HRS_LOG_Context.Block)->Time != HRS_LOG_ERASED_WORD))
+    {
+      HRS_LOG_Context.Block++;
+    }
+
+    /* Keep the log time increasing across resets */
+    p_block = NULL;
+    if (HRS_LOG_Context.Block != 0)
+    {
+      p_block = HRS_LOG_BLOCK(HRS_LOG_Context.Page, HRS_LOG_Context.Block - 1);
+    }
+    else
+    {
+      page = (HRS_LOG_Context.Page + CFG_HRS_LOG_NBR_SECTORS - 1) % CFG_HRS_LOG_NBR_SECTORS;
+      p_header = HRS_LOG_PAGE_HEADER(page);
+      if ((p_header->Magic == HRS_LOG_PAGE_MAGIC) && (p_header->Sequence == (HRS_LOG_Context.Sequence - 1)))
+      {
+        p_block = HRS_LOG_BLOCK(page, HRS_LOG_BLOCKS_PER_PAGE - 1);
+      }
+    }
+    if ((p_block != NULL) && (p_block->Time != HRS_LOG_ERASED_WORD))
+    {
+      HRS_LOG_Context.TimeBase = HRS_LOG_DecodeBlock(p_block, NULL, NULL) + 1;
+    }
+  }
+
+  LOG_INFO_APP("HRS log: page %d, sequence %d, block %d, log time %d s\n",
+               HRS_LOG_Context.Page,
+               HRS_LOG_Context.Sequence,
+               HRS_LOG_Context.Block,
+               HRS_LOG_Context.TimeBase);
+
+  return;
+}
+
+/**
+ * @brief  Add a measurement and the RR intervals taken with it to the log
+ * @param  HeartRate: Heart rate, in bpm
+ * @param  p_RrInterval: RR intervals, in 1/1024 s
+ * @param  NbRr: Number of RR intervals
+ * @retval None
+ */
+void HRS_LOG_Add(uint8_t HeartRate, const uint16_t *p_RrInterval, uint8_t NbRr)
+{
+  HRS_LOG_Block_t *p_block = &HRS_LOG_Context.a_Buffer[HRS_LOG_Context.Fill].Block;
+  uint32_t time;
+  uint16_t prev_rr;
+  uint8_t length;
+  uint8_t index;
+
+  time = HRS_LOG_Context.TimeBase + (UTIL_TIMER_GetCurrentTime() / 1000);
+
+  /* Size of the measurement, to keep it and its RR intervals in the same block */
+  if (p_block->Time == HRS_LOG_ERASED_WORD)
+  {
+    length = 0;
+  }
+  else
+  {
+    length = HRS_LOG_EncodeMeas(NULL, time, HeartRate, p_block);
+  }
+  prev_rr = HRS_LOG_Context.LastRr;
+  for (index = 0; index < NbRr; index++)
+  {
+    length += HRS_LOG_EncodeRr(NULL, p_RrInterval[index], prev_rr);
+    prev_rr = p_RrInterval[index];
+  }
+
+  if ((p_block->Time != HRS_LOG_ERASED_WORD) &&
+      ((length > (HRS_LOG_BLOCK_PAYLOAD_SIZE - p_block->Length)) ||
+       ((time - p_block->Time) > UINT16_MAX)))
+  {
+    if (HRS_LOG_Context.Pending != HRS_LOG_NO_BUFFER)
+    {
+      /* Previous block still not written, the flash cannot keep up */
+      HRS_LOG_Context.Stats.Dropped++;
+      return;
+    }
+    HRS_LOG_BlockClose();
+    p_block = &HRS_LOG_Context.a_Buffer[HRS_LOG_Context.Fill].Block;
+  }
+
+  if (p_block->Time == HRS_LOG_ERASED_WORD)
+  {
+    HRS_LOG_BlockStart(p_block, time, HeartRate);
+  }
+  else
+  {
+    p_block->Length += HRS_LOG_EncodeMeas(&p_block->a_Payload[p_block->Length], time, HeartRate, p_block);
+  }
+
+  for (index = 0; index < NbRr; index++)
+  {
+    p_block->Length += HRS_LOG_EncodeRr(&p_block->a_Payload[p_block->Length],
+                                        p_RrInterval[index],
+                                        HRS_LOG_Context.LastRr);
+    HRS_LOG_Context.LastRr = p_RrInterval[index];
+  }
+
+  HRS_LOG_Context.LastTime = time;
+  HRS_LOG_Context.LastHeartRate = HeartRate;
+  HRS_LOG_Context.Stats.Samples++;
+
+  return;
+}
+
+/**
+ * @brief  Decode a block of the log
+ * @param  p_Block: Block to decode
+ * @param  SampleCb: Called for each sample, may be NULL
+ * @param  p_Context: Passed to SampleCb
+ * @retval Time of the last measurement of the block
+ */
+uint32_t HRS_LOG_DecodeBlock(const HRS_LOG_Block_t *p_Block, HRS_LOG_SampleCb_t SampleCb, void *p_Context)
+{
+  const uint8_t *p_data = p_Block->a_Payload;
+  uint32_t time = p_Block->Time;
+  uint16_t rr = p_Block->RrRef;
+  uint8_t heart_rate = p_Block->HeartRate;
+  uint8_t length = MIN(p_Block->Length, HRS_LOG_BLOCK_PAYLOAD_SIZE);
+  uint8_t token;
+  uint8_t index = 0;
+
+  if (SampleCb != NULL)
+  {
+    SampleCb(HRS_LOG_SAMPLE_HEART_RATE, time, heart_rate, p_Context);
+  }
+
+  while (index < length)
+  {
+    token = p_data[index++];
+    if (token < 0x80)
+    {
+      /* Zigzag: even values are positive deltas, odd values negative ones */
+      rr += (token & 1) ? -(int16_t)((token + 1) >> 1) : (int16_t)(token >> 1);
+      if (SampleCb != NULL)
+      {
+        SampleCb(HRS_LOG_SAMPLE_RR_INTERVAL, time, rr, p_Context);
+      }
+    }
+    else if (token < HRS_LOG_TOKEN_RR_ABS)
+    {
+      token &= 0x3F;
+      heart_rate += (token & 1) ? -(int8_t)((token + 1) >> 1) : (int8_t)(token >> 1);
+      time++;
+      if (SampleCb != NULL)
+      {
+        SampleCb(HRS_LOG_SAMPLE_HEART_RATE, time, heart_rate, p_Context);
+      }
+    }
+    else if ((token == HRS_LOG_TOKEN_RR_ABS) && ((index + 2) <= length))
+    {
+      rr = p_data[index] | (p_data[index + 1] << 8);
+      index += 2;
+      if (SampleCb != NULL)
+      {
+        SampleCb(HRS_LOG_SAMPLE_RR_INTERVAL, time, rr, p_Context);
+      }
+    }
+    else if ((token == HRS_LOG_TOKEN_MEAS_ABS) && ((index + 3) <= length))
+    {
+      heart_rate = p_data[index];
+      time = p_Block->Time + (p_data[index + 1] | (p_data[index + 2] << 8));
+      index += 3;
+      if (SampleCb != NULL)
+      {
+        SampleCb(HRS_LOG_SAMPLE_HEART_RATE, time, heart_rate, p_Context);
+      }
+    }
+    else
+    {
+      /* Unknown or truncated token */
+      break;
+    }
+  }
+
+  return time;
+}
+
+/**
+ * @brief  Close the export channel of a link that has been disconnected
+ * @param  ConnHdl: Connection handle of the link
+ * @retval None
+ */
+void HRS_LOG_LinkDown(uint16_t ConnHdl)
+{
+  if ((HRS_LOG_Export.State != HRS_LOG_EXPORT_CLOSED) && (HRS_LOG_Export.ConnHdl == ConnHdl))
+  {
+    HRS_LOG_Export_Stop();
+    HRS_LOG_Export.State = HRS_LOG_EXPORT_CLOSED;
+  }
+
+  return;
+}
+
+/**
+ * @brief  Accept or refuse a credit based connection request
+ * @param  ConnHdl: Connection handle of the link
+ * @param  Spsm: Protocol requested
+ * @param  Mtu: Largest SDU the collector can receive
+ * @param  Mps: Largest K-frame the collector can receive
+ * @param  Credits: Number of K-frames the collector can receive
+ * @param  ChannelNumber: Number of channels requested, 0 for an LE credit based channel
+ * @retval None
+ */
+void HRS_LOG_CocConnect(uint16_t ConnHdl, uint16_t Spsm, uint16_t Mtu, uint16_t Mps, uint16_t Credits, uint8_t ChannelNumber)
+{
+  tBleStatus ret;
+  uint16_t result = HRS_LOG_COC_SUCCESS;
+  uint8_t a_channel_index[5];
+  uint8_t channel_number = 0;
+
+  if (Spsm != HRS_LOG_SPSM)
+  {
+    result = HRS_LOG_COC_SPSM_NOT_SUPPORTED;
+  }
+  else if ((HRS_LOG_Export.State != HRS_LOG_EXPORT_CLOSED) || (ChannelNumber > 1))
+  {
+    result = HRS_LOG_COC_NO_RESOURCES;
+  }
+  else if (Mtu < (1 + HRS_LOG_BLOCK_SIZE))
+  {
+    /* A block is never split across SDUs */
+    result = HRS_LOG_COC_UNACCEPTABLE_PARAMETERS;
+  }
+
+  ret = aci_l2cap_coc_connect_confirm(ConnHdl,
+                                      HRS_LOG_COC_MTU,
+                                      HRS_LOG_COC_MPS,
+                                      HRS_LOG_COC_RX_CREDITS,
+                                      result,
+                                      &channel_number,
+                                      &a_channel_index[0]);
+  if ((ret != BLE_STATUS_SUCCESS) || (result != HRS_LOG_COC_SUCCESS) || (channel_number == 0))
+  {
+    LOG_INFO_APP("HRS log: channel refused, result 0x%04X, status 0x%02X\n", result, ret);
+    return;
+  }
+
+  memset(&HRS_LOG_Export, 0, sizeof(HRS_LOG_Export));
+  HRS_LOG_Export.State = HRS_LOG_EXPORT_OPEN;
+  HRS_LOG_Export.ConnHdl = ConnHdl;
+  HRS_LOG_Export.ChannelIndex = a_channel_index[0];
+  HRS_LOG_Export.PeerMtu = Mtu;
+  HRS_LOG_Export.PeerMps = MIN(Mps, CFG_BLE_COC_MPS_MAX);
+  HRS_LOG_Export.Credits = Credits;
+  LOG_INFO_APP("HRS log: channel %d open, MTU %d, MPS %d, credits %d\n",
+               HRS_LOG_Export.ChannelIndex, Mtu, Mps, Credits);
+
+  return;
+}
+
+/**
+ * @brief  Handle the disconnection of a channel
+ * @param  ChannelIndex: Index of the channel
+ * @retval None
+ */
+void HRS_LOG_CocDisconnect(uint8_t ChannelIndex)
+{
+  if ((HRS_LOG_Export.State != HRS_LOG_EXPORT_CLOSED) && (HRS_LOG_Export.ChannelIndex == ChannelIndex))
+  {
+    HRS_LOG_Export_Stop();
+    HRS_LOG_Export.State = HRS_LOG_EXPORT_CLOSED;
+    LOG_INFO_APP("HRS log: channel %d closed\n", ChannelIndex);
+  }
+
+  return;
+}
+
+/**
+ * @brief  Account the credits granted by the collector and resume the export
+ * @param  ChannelIndex: Index of the channel
+ * @param  Credits: Number of K-frames the collector can receive in addition
+ * @retval None
+ */
+void HRS_LOG_CocFlowControl(uint8_t ChannelIndex, uint16_t Credits)
+{
+  if ((HRS_LOG_Export.State != HRS_LOG_EXPORT_CLOSED) && (HRS_LOG_Export.ChannelIndex == ChannelIndex))
+  {
+    HRS_LOG_Export.Credits += Credits;
+    UTIL_SEQ_SetTask(1U << CFG_TASK_HRS_LOG_EXPORT_ID, CFG_SEQ_PRIO_0);
+  }
+
+  return;
+}
+
+/**
+ * @brief  Handle a command of the collector
+ * @param  ChannelIndex: Index of the channel
+ * @param  Length: Length of the K-frame
+ * @param  p_Data: K-frame, starting with the SDU length
+ * @retval None
+ */
+void HRS_LOG_CocRxData(uint8_t ChannelIndex, uint16_t Length, const uint8_t *p_Data)
+{
+  if ((HRS_LOG_Export.State == HRS_LOG_EXPORT_CLOSED) || (HRS_LOG_Export.ChannelIndex != ChannelIndex))
+  {
+    return;
+  }
+
+  if (Length >= 3)
+  {
+    switch (p_Data[2])
+    {
+      case HRS_LOG_CMD_EXPORT:
+        if (HRS_LOG_Export.State == HRS_LOG_EXPORT_OPEN)
+        {
+          /* Oldest page first: the one after the page being written */
+          HRS_LOG_Export.Page = HRS_LOG_Context.Page;
+          HRS_LOG_Export.Block = HRS_LOG_BLOCKS_PER_PAGE;
+          HRS_LOG_Export.Sequence = HRS_LOG_Context.Sequence - CFG_HRS_LOG_NBR_SECTORS;
+          HRS_LOG_Export.SduLength = 0;
+          HRS_LOG_Export.SduOffset = 0;
+          HRS_LOG_Export.StartTime = UTIL_TIMER_GetCurrentTime();
+          HRS_LOG_Export.BlocksSent = 0;
+          HRS_LOG_Export.Bytes = 0;
+          HRS_LOG_Export.KFrames = 0;
+          HRS_LOG_Export.CreditStalls = 0;
+          HRS_LOG_Export.TxPoolStalls = 0;
+          HRS_LOG_Export.State = HRS_LOG_EXPORT_FLASH;
+          UTIL_SEQ_SetTask(1U << CFG_TASK_HRS_LOG_EXPORT_ID, CFG_SEQ_PRIO_0);
+        }
+        break;
+
+      case HRS_LOG_CMD_ABORT:
+        /* The SDU in progress is completed, then the end of the export is sent */
+        if ((HRS_LOG_Export.State == HRS_LOG_EXPORT_FLASH) || (HRS_LOG_Export.State == HRS_LOG_EXPORT_LAST_BLOCK))
+        {
+          HRS_LOG_Export.State = HRS_LOG_EXPORT_END;
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  /* Give the credit of the command back */
+  aci_l2cap_coc_flow_control(ChannelIndex, 1);
+
+  return;
+}
+
+/**
+ * @brief  Resume the export stopped on a full TX pool
+ * @param  None
+ * @retval None
+ */
+void HRS_LOG_CocTxPoolAvailable(void)
+{
+  if (HRS_LOG_Export.TxPoolFull != 0)
+  {
+    HRS_LOG_Export.TxPoolFull = 0;
+    UTIL_SEQ_SetTask(1U << CFG_TASK_HRS_LOG_EXPORT_ID, CFG_SEQ_PRIO_0);
+  }
+
+  return;
+}
+
+/* Private Functions Definition --------------------------------------------- */
+
+/**
+ * @brief  Write the pending block, erasing and formatting a new page first
+ *         when needed
+ * @param  None
+ * @retval None
+ */
+static void HRS_LOG_Process(void)
+{
+  if (HRS_LOG_Context.FlashState != HRS_LOG_FLASH_IDLE)
+  {
+    if (HRS_LOG_Context.FlashRetry != 0)
+    {
+      HRS_LOG_Context.FlashRetry = 0;
+      HRS_LOG_FlashStart();
+      return;
+    }
+    if (HRS_LOG_Context.FlashDone == 0)
+    {
+      return;
+    }
+    HRS_LOG_Context.FlashDone = 0;
+
+    switch (HRS_LOG_Context.FlashState)
+    {
+      case HRS_LOG_FLASH_ERASE:
+        HRS_LOG_Context.PageHeader.Magic = HRS_LOG_PAGE_MAGIC;
+        HRS_LOG_Context.PageHeader.Sequence = HRS_LOG_Context.Sequence;
+        HRS_LOG_Context.PageHeader.a_Reserved[0] = HRS_LOG_ERASED_WORD;
+        HRS_LOG_Context.PageHeader.a_Reserved[1] = HRS_LOG_ERASED_WORD;
+        HRS_LOG_Context.FlashState = HRS_LOG_FLASH_HEADER;
+        HRS_LOG_FlashStart();
+        return;
+
+      case HRS_LOG_FLASH_HEADER:
+        HRS_LOG_Context.PageReady = 1;
+        break;
+
+      case HRS_LOG_FLASH_BLOCK:
+        memset(&HRS_LOG_Context.a_Buffer[HRS_LOG_Context.Pending], 0xFF, sizeof(HRS_LOG_Buffer_t));
+        HRS_LOG_Context.Pending = HRS_LOG_NO_BUFFER;
+        HRS_LOG_Context.Block++;
+        HRS_LOG_Context.Stats.Blocks++;
+        /* An export waiting for this block to reach the flash can go on */
+        if (HRS_LOG_Export.State == HRS_LOG_EXPORT_FLASH)
+        {
+          UTIL_SEQ_SetTask(1U << CFG_TASK_HRS_LOG_EXPORT_ID, CFG_SEQ_PRIO_0);
+        }
+        break;
+
+      default:
+        break;
+    }
+    HRS_LOG_Context.FlashState = HRS_LOG_FLASH_IDLE;
+  }
+
+  if (HRS_LOG_Context.Pending == HRS_LOG_NO_BUFFER)
+  {
+    return;
+  }
+
+  if (HRS_LOG_Context.Block >= HRS_LOG_BLOCKS_PER_PAGE)
+  {
+    /* Page full: recycle the oldest one */
+    HRS_LOG_Context.Page = (HRS_LOG_Context.Page + 1) % CFG_HRS_LOG_NBR_SECTORS;
+    HRS_LOG_Context.Sequence++;
+    HRS_LOG_Context.Block = 0;
+    HRS_LOG_Context.PageReady = 0;
+  }
+
+  if (HRS_LOG_Context.PageReady == 0)
+  {
+    HRS_LOG_Context.FlashState = HRS_LOG_FLASH_ERASE;
+  }
+  else
+  {
+    HRS_LOG_Context.FlashState = HRS_LOG_FLASH_BLOCK;
+  }
+  HRS_LOG_FlashStart();
+
+  return;
+}
+
+/**
+ * @brief  Request the flash operation of the current state
+ * @param  None
+ * @retval None
+ */
+static void HRS_LOG_FlashStart(void)
+{
+  FM_Cmd_Status_t status;
+
+  switch (HRS_LOG_Context.FlashState)
+  {
+    case HRS_LOG_FLASH_ERASE:
+      status = FM_Erase(CFG_HRS_LOG_START_SECTOR_ID + HRS_LOG_Context.Page, 1, &HRS_LOG_FlashCallbackNode);
+      break;
+
+    case HRS_LOG_FLASH_HEADER:
+      status = FM_Write((uint32_t *)&HRS_LOG_Context.PageHeader,
+                        (uint32_t *)HRS_LOG_PAGE_ADDRESS(HRS_LOG_Context.Page),
+                        sizeof(HRS_LOG_PageHeader_t) / 4,
+                        &HRS_LOG_FlashCallbackNode);
+      break;
+
+    case HRS_LOG_FLASH_BLOCK:
+    default:
+      status = FM_Write(HRS_LOG_Context.a_Buffer[HRS_LOG_Context.Pending].a_Word,
+                        (uint32_t *)HRS_LOG_BLOCK(HRS_LOG_Context.Page, HRS_LOG_Context.Block),
+                        HRS_LOG_BLOCK_SIZE / 4,
+                        &HRS_LOG_FlashCallbackNode);
+      break;
+  }
+
+  if (status == FM_ERROR)
+  {
+    /* Page formatted again, or block dropped */
+    HRS_LOG_Context.Stats.FlashErrors++;
+    if (HRS_LOG_Context.FlashState == HRS_LOG_FLASH_BLOCK)
+    {
+      memset(&HRS_LOG_Context.a_Buffer[HRS_LOG_Context.Pending], 0xFF, sizeof(HRS_LOG_Buffer_t));
+      HRS_LOG_Context.Pending = HRS_LOG_NO_BUFFER;
+    }
+    HRS_LOG_Context.FlashState = HRS_LOG_FLASH_IDLE;
+    if (HRS_LOG_Export.State == HRS_LOG_EXPORT_FLASH)
+    {
+      UTIL_SEQ_SetTask(1U << CFG_TASK_HRS_LOG_EXPORT_ID, CFG_SEQ_PRIO_0);
+    }
+    LOG_INFO_APP("HRS log: flash error\n");
+  }
+
+  /* FM_BUSY: requested again on FM_OPERATION_AVAILABLE */
+
+  return;
+}
+
+/**
+ * @brief  Flash manager callback
+ * @param  Status: Operation complete or flash manager available again
+ * @retval None
+ */
+static void HRS_LOG_FlashCallback(FM_FlashOp_Status_t Status)
+{
+  if (Status == FM_OPERATION_COMPLETE)
+  {
+    HRS_LOG_Context.FlashDone = 1;
+  }
+  else
+  {
+    HRS_LOG_Context.FlashRetry = 1;
+  }
+  UTIL_SEQ_SetTask(1U << CFG_TASK_HRS_LOG_ID, CFG_SEQ_PRIO_0);
+
+  return;
+}
+
+/**
+ * @brief  Start a block with a measurement
+ * @param  p_Block: Erased block
+ * @param  Time: Time of the measurement
+ * @param  HeartRate: Heart rate, in bpm
+ * @retval None
+ */
+static void HRS_LOG_BlockStart(HRS_LOG_Block_t *p_Block, uint32_t Time, uint8_t HeartRate)
+{
+  p_Block->Time = Time;
+  p_Block->RrRef = HRS_LOG_Context.LastRr;
+  p_Block->HeartRate = HeartRate;
+  p_Block->Length = 0;
+
+  return;
+}
+
+/**
+ * @brief  Hand the block being filled over to the flash and fill the other one
+ * @param  None
+ * @retval None
+ */
+static void HRS_LOG_BlockClose(void)
+{
+  HRS_LOG_Context.Pending = HRS_LOG_Context.Fill;
+  HRS_LOG_Context.Fill ^= 1;
+  UTIL_SEQ_SetTask(1U << CFG_TASK_HRS_LOG_ID, CFG_SEQ_PRIO_0);
+
+  return;
+}
+
+/**
+ * @brief  Encode a measurement following another one in the block
+ * @param  p_Data: Where to encode, NULL to get the size only
+ * @param  Time: Time of the measurement
+ * @param  HeartRate: Heart rate, in bpm
+ * @param  p_Block: Block the measurement is added to
+ * @retval Size of the token
+ */
+static uint8_t HRS_LOG_EncodeMeas(uint8_t *p_Data, uint32_t Time, uint8_t HeartRate, const HRS_LOG_Block_t *p_Block)
+{
+  int16_t delta = (int16_t)HeartRate - HRS_LOG_Context.LastHeartRate;
+  uint16_t offset;
+
+  if (((Time - HRS_LOG_Context.LastTime) == 1) && (delta >= -32) && (delta <= 31))
+  {
+    if (p_Data != NULL)
+    {
+      p_Data[0] = 0x80 | (uint8_t)((delta < 0) ? ((-delta * 2) - 1) : (delta * 2));
+    }
+    return 1;
+  }
+
+  if (p_Data != NULL)
+  {
+    offset = (uint16_t)(Time - p_Block->Time);
+    p_Data[0] = HRS_LOG_TOKEN_MEAS_ABS;
+    p_Data[1] = HeartRate;
+    p_Data[2] = (uint8_t)(offset & 0xFF);
+    p_Data[3] = (uint8_t)(offset >> 8);
+  }
+  return 4;
+}
+
+/**
+ * @brief  Encode an RR interval
+ * @param  p_Data: Where to encode, NULL to get the size only
+ * @param  RrInterval: RR interval, in 1/1024 s
+ * @param  PrevRr: Previous RR interval, 0 when unknown
+ * @retval Size of the token
+ */
+static uint8_t HRS_LOG_EncodeRr(uint8_t *p_Data, uint16_t RrInterval, uint16_t PrevRr)
+{
+  int32_t delta = (int32_t)RrInterval - PrevRr;
+
+  if ((PrevRr != 0) && (delta >= -64) && (delta <= 63))
+  {
+    if (p_Data != NULL)
+    {
+      p_Data[0] = (uint8_t)((delta < 0) ? ((-delta * 2) - 1) : (delta * 2));
+    }
+    return 1;
+  }
+
+  if (p_Data != NULL)
+  {
+    p_Data[0] = HRS_LOG_TOKEN_RR_ABS;
+    p_Data[1] = (uint8_t)(RrInterval & 0xFF);
+    p_Data[2] = (uint8_t)(RrInterval >> 8);
+  }
+  return 3;
+}
+
+/**
+ * @brief  Send the log as K-frames while the collector grants credits
+ * @param  None
+ * @retval None
+ */
+static void HRS_LOG_Export_Process(void)
+{
+  tBleStatus ret;
+  uint16_t length;
+
+  while ((HRS_LOG_Export.State >= HRS_LOG_EXPORT_FLASH) && (HRS_LOG_Export.TxPoolFull == 0))
+  {
+    if (HRS_LOG_Export.SduOffset == HRS_LOG_Export.SduLength)
+    {
+      if (HRS_LOG_Export_BuildSdu() == 0)
+      {
+        /* Done, or waiting for a block to reach the flash */
+        break;
+      }
+    }
+
+    if (HRS_LOG_Export.Credits == 0)
+    {
+      /* Resumed on ACI_L2CAP_COC_FLOW_CONTROL_VSEVT */
+      HRS_LOG_Export.CreditStalls++;
+      break;
+    }
+
+    length = MIN(HRS_LOG_Export.SduLength - HRS_LOG_Export.SduOffset, HRS_LOG_Export.PeerMps);
+    ret = aci_l2cap_coc_tx_data(HRS_LOG_Export.ChannelIndex,
+                                length,
+                                &HRS_LOG_Export.a_Sdu[HRS_LOG_Export.SduOffset]);
+    if (ret == BLE_STATUS_INSUFFICIENT_RESOURCES)
+    {
+      /* Resumed on ACI_L2CAP_COC_TX_POOL_AVAILABLE_VSEVT */
+      HRS_LOG_Export.TxPoolFull = 1;
+      HRS_LOG_Export.TxPoolStalls++;
+    }
+    else if (ret != BLE_STATUS_SUCCESS)
+    {
+      LOG_INFO_APP("HRS log: aci_l2cap_coc_tx_data fails, status 0x%02X\n", ret);
+      HRS_LOG_Export_Stop();
+    }
+    else
+    {
+      HRS_LOG_Export.SduOffset += length;
+      HRS_LOG_Export.Credits--;
+      HRS_LOG_Export.KFrames++;
+      HRS_LOG_Export.Bytes += length;
+    }
+  }
+
+  return;
+}
+
+/**
+ * @brief  Build the next SDU: as many blocks as the collector MTU allows,
+ *         then the end of the export
+ * @param  None
+ * @retval 0 when there is nothing to send now
+ */
+static uint8_t HRS_LOG_Export_BuildSdu(void)
+{
+  const HRS_LOG_Block_t *p_block;
+  uint8_t *p_sdu = &HRS_LOG_Export.a_Sdu[2];
+  uint16_t length = 1;
+  uint8_t nb_blocks;
+  uint8_t max_blocks;
+
+  if (HRS_LOG_Export.State == HRS_LOG_EXPORT_DONE)
+  {
+    HRS_LOG_Export_Stop();
+    return 0;
+  }
+
+  max_blocks = MIN((HRS_LOG_Export.PeerMtu - 1) / HRS_LOG_BLOCK_SIZE, HRS_LOG_SDU_BLOCKS_MAX);
+
+  p_sdu[0] = HRS_LOG_SDU_DATA;
+  for (nb_blocks = 0; nb_blocks < max_blocks; nb_blocks++)
+  {
+    p_block = NULL;
+    if (HRS_LOG_Export.State == HRS_LOG_EXPORT_FLASH)
+    {
+      p_block = HRS_LOG_Export_NextBlock();
+      if (p_block == NULL)
+      {
+        if (HRS_LOG_Context.Pending != HRS_LOG_NO_BUFFER)
+        {
+          /* Wait for the pending block to be written to avoid sending it twice */
+          break;
+        }
+        HRS_LOG_Export.State = HRS_LOG_EXPORT_LAST_BLOCK;
+      }
+    }
+    if (HRS_LOG_Export.State == HRS_LOG_EXPORT_LAST_BLOCK)
+    {
+      HRS_LOG_Export.State = HRS_LOG_EXPORT_END;
+      if (HRS_LOG_Context.a_Buffer[HRS_LOG_Context.Fill].Block.Time != HRS_LOG_ERASED_WORD)
+      {
+        p_block = &HRS_LOG_Context.a_Buffer[HRS_LOG_Context.Fill].Block;
+      }
+    }
+    if (p_block == NULL)
+    {
+      break;
+    }
+    memcpy(&p_sdu[length], p_block, HRS_LOG_BLOCK_SIZE);
+    length += HRS_LOG_BLOCK_SIZE;
+  }
+  HRS_LOG_Export.BlocksSent += nb_blocks;
+
+  if ((nb_blocks == 0) && (HRS_LOG_Export.State == HRS_LOG_EXPORT_END))
+  {
+    p_sdu[0] = HRS_LOG_SDU_END;
+    p_sdu[1] = (uint8_t)(HRS_LOG_Export.BlocksSent & 0xFF);
+    p_sdu[2] = (uint8_t)((HRS_LOG_Export.BlocksSent >> 8) & 0xFF);
+    p_sdu[3] = (uint8_t)((HRS_LOG_Export.BlocksSent >> 16) & 0xFF);
+    p_sdu[4] = (uint8_t)(HRS_LOG_Export.BlocksSent >> 24);
+    length = 5;
+    HRS_LOG_Export.State = HRS_LOG_EXPORT_DONE;
+  }
+  else if (nb_blocks == 0)
+  {
+    return 0;
+  }
+
+  HRS_LOG_Export.a_Sdu[0] = (uint8_t)(length & 0xFF);
+  HRS_LOG_Export.a_Sdu[1] = (uint8_t)(length >> 8);
+  HRS_LOG_Export.SduLength = 2 + length;
+  HRS_LOG_Export.SduOffset = 0;
+
+  return 1;
+}
+
+/**
+ * @brief  Next block of the flash to export, in the order it has been written
+ * @param  None
+ * @retval Block, NULL once all the blocks in flash have been read
+ */
+static const HRS_LOG_Block_t *HRS_LOG_Export_NextBlock(void)
+{
+  const HRS_LOG_PageHeader_t *p_header;
+  const HRS_LOG_Block_t *p_block;
+  uint8_t pages = 0;
+
+  while (pages <= CFG_HRS_LOG_NBR_SECTORS)
+  {
+    if ((HRS_LOG_Export.Page == HRS_LOG_Context.Page) && (HRS_LOG_Export.Sequence == HRS_LOG_Context.Sequence))
+    {
+      /* Page being written: stop at its first free block */
+      if ((HRS_LOG_Context.PageReady != 0) && (HRS_LOG_Export.Block < HRS_LOG_Context.Block))
+      {
+        return HRS_LOG_BLOCK(HRS_LOG_Export.Page, HRS_LOG_Export.Block++);
+      }
+      return NULL;
+    }
+
+    /* Skip the pages recycled since the export has reached them */
+    p_header = HRS_LOG_PAGE_HEADER(HRS_LOG_Export.Page);
+    if ((p_header->Magic == HRS_LOG_PAGE_MAGIC) &&
+        (p_header->Sequence == HRS_LOG_Export.Sequence) &&
+        (HRS_LOG_Export.Block < HRS_LOG_BLOCKS_PER_PAGE))
+    {
+      p_block = HRS_LOG_BLOCK(HRS_LOG_Export.Page, HRS_LOG_Export.Block);
+      if (p_block->Time != HRS_LOG_ERASED_WORD)
+      {
+        HRS_LOG_Export.Block++;
+        return p_block;
+      }
+    }
+
+    HRS_LOG_Export.Page = (HRS_LOG_Export.Page + 1) % CFG_HRS_LOG_NBR_SECTORS;
+    HRS_LOG_Export.Block = 0;
+    HRS_LOG_Export.Sequence++;
+    pages++;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief  End the export in progress and log its throughput
+ * @param  None
+ * @retval None
+ */
+static void HRS_LOG_Export_Stop(void)
+{
+  uint32_t duration;
+
+  if (HRS_LOG_Export.State < HRS_LOG_EXPORT_FLASH)
+  {
+    return;
+  }
+
+  duration = UTIL_TIMER_GetElapsedTime(HRS_LOG_Export.StartTime);
+  LOG_INFO_APP("HRS log export: %d blocks, %d bytes in %d ms (%d B/s), %d K-frames, %d credit stalls, %d TX pool stalls\n",
+               HRS_LOG_Export.BlocksSent,
+               HRS_LOG_Export.Bytes,
+               duration,
+               (duration != 0) ? ((HRS_LOG_Export.Bytes * 1000) / duration) : 0,
+               HRS_LOG_Export.KFrames,
+               HRS_LOG_Export.CreditStalls,
+               HRS_LOG_Export.TxPoolStalls);
+  LOG_INFO_APP("HRS log: %d samples, %d blocks written, %d dropped, %d flash errors\n",
+               HRS_LOG_Context.Stats.Samples,
+               HRS_LOG_Context.Stats.Blocks,
+               HRS_LOG_Context.Stats.Dropped,
+               HRS_LOG_Context.Stats.FlashErrors);
+
+  HRS_LOG_Export.State = HRS_LOG_EXPORT_OPEN;
+
+  return;
+}
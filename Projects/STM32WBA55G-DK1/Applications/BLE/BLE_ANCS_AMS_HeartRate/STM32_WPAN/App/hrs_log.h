@@ -0,0 +1,110 @@
+/**
+  ******************************************************************************
+  * @file    hrs_log.h
+  * @author  MCD Application Team
+  * @brief   Header for the heart rate history log
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef HRS_LOG_H
+#define HRS_LOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Defines ------------------------------------------------------------------ */
+
+/**
+ * The log is a sequence of 64-byte blocks written in the flash pages
+ * reserved by CFG_HRS_LOG_START_SECTOR_ID, used as a ring. Each block is
+ * self-contained:
+ *   - Time      : time of the first measurement, in seconds of log time
+ *                 (uptime, carried on across resets)
+ *   - RrRef     : RR interval preceding the block, 0 when unknown
+ *   - HeartRate : heart rate of the first measurement, in bpm
+ *   - Length    : number of payload bytes used
+ *   - Payload   : tokens, decoded in order
+ *       0x00..0x7F : RR interval, zigzag delta on 7 bits to the previous one
+ *       0x80..0xBF : measurement 1 s after the previous one, zigzag delta
+ *                    on 6 bits to the previous heart rate
+ *       0xC0 L H   : RR interval, absolute, in 1/1024 s
+ *       0xC1 R L H : measurement, heart rate R at Time + (H << 8 | L) s
+ * RR intervals follow the measurement they have been taken with.
+ */
+#define HRS_LOG_BLOCK_SIZE                 (64)
+#define HRS_LOG_BLOCK_HEADER_SIZE          (8)
+#define HRS_LOG_BLOCK_PAYLOAD_SIZE         (HRS_LOG_BLOCK_SIZE - HRS_LOG_BLOCK_HEADER_SIZE)
+
+#define HRS_LOG_TOKEN_RR_ABS               (0xC0)
+#define HRS_LOG_TOKEN_MEAS_ABS             (0xC1)
+
+/**
+ * Export over an LE credit based L2CAP channel on HRS_LOG_SPSM.
+ * The collector sends single-byte SDUs:
+ *   - HRS_LOG_CMD_EXPORT : send the whole log, oldest block first
+ *   - HRS_LOG_CMD_ABORT  : stop the export in progress
+ * The device answers with SDUs made of a one-byte code followed by:
+ *   - HRS_LOG_SDU_DATA   : 1 to HRS_LOG_SDU_BLOCKS_MAX blocks
+ *   - HRS_LOG_SDU_END    : number of blocks sent, on 4 bytes
+ * The last block, still being filled, is sent as well. It is sent again,
+ * completed, by the next export: the samples are keyed by their time.
+ */
+#define HRS_LOG_SPSM                       (0x0081)
+#define HRS_LOG_SDU_BLOCKS_MAX             (3)
+
+#define HRS_LOG_CMD_EXPORT                 (0x01)
+#define HRS_LOG_CMD_ABORT                  (0x02)
+
+#define HRS_LOG_SDU_DATA                   (0x81)
+#define HRS_LOG_SDU_END                    (0x82)
+
+/* Exported Types ------------------------------------------------------------ */
+typedef struct
+{
+  uint32_t Time;
+  uint16_t RrRef;
+  uint8_t  HeartRate;
+  uint8_t  Length;
+  uint8_t  a_Payload[HRS_LOG_BLOCK_PAYLOAD_SIZE];
+} HRS_LOG_Block_t;
+
+typedef enum
+{
+  HRS_LOG_SAMPLE_HEART_RATE,
+  HRS_LOG_SAMPLE_RR_INTERVAL,
+} HRS_LOG_SampleType_t;
+
+/* Called for each sample of a decoded block, Value is in bpm or 1/1024 s */
+typedef void (*HRS_LOG_SampleCb_t)(HRS_LOG_SampleType_t Type, uint32_t Time, uint16_t Value, void *p_Context);
+
+/* Exported Functions Prototypes -------------------------------------------- */
+void HRS_LOG_Init(void);
+void HRS_LOG_Add(uint8_t HeartRate, const uint16_t *p_RrInterval, uint8_t NbRr);
+uint32_t HRS_LOG_DecodeBlock(const HRS_LOG_Block_t *p_Block, HRS_LOG_SampleCb_t SampleCb, void *p_Context);
+void HRS_LOG_LinkDown(uint16_t ConnHdl);
+void HRS_LOG_CocConnect(uint16_t ConnHdl, uint16_t Spsm, uint16_t Mtu, uint16_t Mps, uint16_t Credits, uint8_t ChannelNumber);
+void HRS_LOG_CocDisconnect(uint8_t ChannelIndex);
+void HRS_LOG_CocFlowControl(uint8_t ChannelIndex, uint16_t Credits);
+void HRS_LOG_CocRxData(uint8_t ChannelIndex, uint16_t Length, const uint8_t *p_Data);
+void HRS_LOG_CocTxPoolAvailable(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HRS_LOG_H */
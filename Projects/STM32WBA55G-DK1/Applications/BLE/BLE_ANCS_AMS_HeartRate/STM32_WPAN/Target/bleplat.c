@@ -24,6 +24,7 @@
 #include "baes.h"
 #include "bpka.h"
 #include "ble_timer.h"
+#include "ctr_drbg.h"
 
 /*****************************************************************************/
 
@@ -77,8 +78,13 @@ void BLEPLAT_NvmDiscard( uint8_t mode )
 void BLEPLAT_RngGet( uint8_t n,
                      uint32_t* val )
 {
+#if CFG_CTR_DRBG_SUPPORTED == 1
+  /* Read 32-bit random values from the DRBG */
+  CTR_DRBG_Get( (uint8_t*)val, (uint32_t)n * 4 );
+#else
   /* Read 32-bit random values from HW driver */
   HW_RNG_Get( n, val );
+#endif
 }
 
 /*****************************************************************************/
@@ -21,6 +21,18 @@
 #include "app_common.h"
 #include "bpka.h"
 
+#if CFG_BPKA_PAIR_NBR > 0
+#include "stm32_timer.h"
+#include "ll_intf.h"
+#include "ll_sys.h"
+#if CFG_CTR_DRBG_SUPPORTED == 1
+#include "ctr_drbg.h"
+#endif
+#if CFG_LPM_LEVEL != 0
+#include "stm32_lpm.h"
+#endif
+#endif /* CFG_BPKA_PAIR_NBR > 0 */
+
 /*****************************************************************************/
 
 enum
@@ -31,14 +43,142 @@ enum
   BPKA_RANGE_Y_CHECK,
   BPKA_POINT_CHECK,
   BPKA_DH_KEY_GEN,
+  BPKA_P256_KEY_READY,
+  BPKA_PRECOMPUTE,
+};
+
+/*****************************************************************************/
+
+#if CFG_BPKA_PAIR_NBR > 0
+
+enum
+{
+  BPKA_PAIR_FREE = 0,
+  BPKA_PAIR_COMPUTING,
+  BPKA_PAIR_READY,
+  BPKA_PAIR_BOUND,
 };
 
+typedef struct
+{
+  uint32_t private_key[8];
+  uint32_t public_key[16];
+  uint32_t time;             /* End of computation, in ms */
+  uint8_t  state;
+} BPKA_PAIR_T;
+
+#endif /* CFG_BPKA_PAIR_NBR > 0 */
+
 /*****************************************************************************/
 
 static uint8_t BPKA_state;
 static uint8_t BPKA_error;
 static uint32_t BPKA_buffer[24];
 
+#if CFG_BPKA_PAIR_NBR > 0
+
+/* Key pairs computed ahead */
+static BPKA_PAIR_T BPKA_pair[CFG_BPKA_PAIR_NBR];
+static uint8_t BPKA_pair_index;
+static BPKA_STATS_T BPKA_stats;
+
+/* Pair bound to the private key of the stack by BPKA_StartP256Key(), if any:
+   the stack gets the public key of the pair, and its DH keys are computed
+   with the private key of the pair (see bpka.h) */
+static BPKA_PAIR_T* BPKA_bound_pair;
+static uint32_t BPKA_bound_key[8];
+
+/*****************************************************************************/
+
+static void BPKA_PairFree( BPKA_PAIR_T* pp )
+{
+  memset( pp, 0, sizeof(BPKA_PAIR_T) );
+}
+
+/*****************************************************************************/
+
+static void BPKA_LpmVote( int enable )
+{
+#if CFG_LPM_LEVEL != 0
+  /* The PKA is not retained in stop and standby modes */
+  UTIL_LPM_SetStopMode( 1U << CFG_LPM_PKA,
+                        enable ? UTIL_LPM_ENABLE : UTIL_LPM_DISABLE );
+  UTIL_LPM_SetOffMode( 1U << CFG_LPM_PKA,
+                       enable ? UTIL_LPM_ENABLE : UTIL_LPM_DISABLE );
+#endif
+}
+
+/*****************************************************************************/
+
+/*
+ * Stops the pair computation, if any, so that the PKA can serve the stack.
+ */
+static void BPKA_PrecomputeAbort( void )
+{
+  if ( BPKA_state == BPKA_PRECOMPUTE )
+  {
+    HW_PKA_Disable( );
+
+    BPKA_PairFree( &BPKA_pair[BPKA_pair_index] );
+    BPKA_state = BPKA_IDLE;
+    BPKA_LpmVote( TRUE );
+
+    BPKA_stats.aborted++;
+  }
+}
+
+/*****************************************************************************/
+
+/*
+ * Binds a ready pair to the private key of the stack, releasing the pair
+ * bound to its previous key. Returns NULL when no pair is ready.
+ */
+static BPKA_PAIR_T* BPKA_PairBind( const uint32_t* local_private_key )
+{
+  uint8_t i;
+
+  if ( BPKA_bound_pair )
+  {
+    BPKA_PairFree( BPKA_bound_pair );
+    BPKA_bound_pair = NULL;
+  }
+
+  for ( i = 0; i < CFG_BPKA_PAIR_NBR; i++ )
+  {
+    if ( BPKA_pair[i].state == BPKA_PAIR_READY )
+    {
+      BPKA_pair[i].state = BPKA_PAIR_BOUND;
+      BPKA_bound_pair = &BPKA_pair[i];
+      memcpy( BPKA_bound_key, local_private_key, 32 );
+      break;
+    }
+  }
+
+  return BPKA_bound_pair;
+}
+
+/*****************************************************************************/
+
+/*
+ * Draws a private key in [2^224, n), n being the order of the P-256 curve:
+ * n is above 0xFFFFFFFF00000000 x 2^192, so any key with a most significant
+ * word different from 0 and 0xFFFFFFFF is valid.
+ */
+static void BPKA_NewPrivateKey( uint32_t* private_key )
+{
+  do
+  {
+#if CFG_CTR_DRBG_SUPPORTED == 1
+    CTR_DRBG_Get( (uint8_t*)private_key, 32 );
+#else
+    HW_RNG_Get( 8, private_key );
+#endif
+  }
+  while ( (private_key[7] == 0) || (private_key[7] == 0xFFFFFFFFUL) );
+}
+
+#endif /* CFG_BPKA_PAIR_NBR > 0 */
+
 /*****************************************************************************/
 
 void BPKA_Reset( void )
@@ -53,6 +193,30 @@ void BPKA_Reset( void )
 
 int BPKA_StartP256Key( const uint32_t* local_private_key )
 {
+#if CFG_BPKA_PAIR_NBR > 0
+
+  BPKA_PAIR_T* pp;
+
+  BPKA_PrecomputeAbort( );
+
+  pp = BPKA_PairBind( local_private_key );
+  if ( pp )
+  {
+    /* The public key has been computed ahead: complete at once */
+    memcpy( BPKA_buffer, pp->public_key, 64 );
+
+    BPKA_state = BPKA_P256_KEY_READY;
+    BPKA_stats.hits++;
+
+    BPKACB_Process( );
+
+    return BPKA_OK;
+  }
+
+  BPKA_stats.misses++;
+
+#endif /* CFG_BPKA_PAIR_NBR > 0 */
+
   /* Enable PKA hardware */
   if ( ! HW_PKA_Enable( ) )
     return BPKA_BUSY;
@@ -82,6 +246,31 @@ void BPKA_ReadP256Key( uint32_t* local_public_key )
 int BPKA_StartDhKey( const uint32_t* local_private_key,
                      const uint32_t* remote_public_key )
 {
+#if CFG_BPKA_PAIR_NBR > 0
+
+  BPKA_PrecomputeAbort( );
+
+  if ( BPKA_bound_pair )
+  {
+    if ( memcmp( BPKA_bound_key, local_private_key, 32 ) == 0 )
+    {
+      /* The stack announced the public key of the bound pair */
+      local_private_key = BPKA_bound_pair->private_key;
+    }
+    else
+    {
+      /* The stack uses a key it never passed to BPKA_StartP256Key(): no swap,
+         and the binding is released as the stack no longer holds its key */
+      BPKA_PairFree( BPKA_bound_pair );
+      BPKA_bound_pair = NULL;
+      memset( BPKA_bound_key, 0, 32 );
+      BPKA_stats.mismatched++;
+      LOG_INFO_APP( ">>== BPKA: DH key requested with an unbound private key\n" );
+    }
+  }
+
+#endif /* CFG_BPKA_PAIR_NBR > 0 */
+
   /* Enable PKA hardware */
   if ( ! HW_PKA_Enable( ) )
     return BPKA_BUSY;
@@ -135,12 +324,26 @@ int BPKA_Process( void )
     return BPKA_OK;
   }
 
+#if CFG_BPKA_PAIR_NBR > 0
+  /* The pair computation is polled by BPKA_Precompute() */
+  if ( BPKA_state == BPKA_PRECOMPUTE )
+  {
+    return BPKA_OK;
+  }
+#endif /* CFG_BPKA_PAIR_NBR > 0 */
+
   /* Check if the current operation is finished */
-  if ( ! HW_PKA_EndOfOperation( ) )
+  if ( (BPKA_state != BPKA_P256_KEY_READY) && ! HW_PKA_EndOfOperation( ) )
     return BPKA_BUSY;
 
   switch ( BPKA_state )
   {
+  case BPKA_P256_KEY_READY:
+
+    /* The local public key is already in the buffer */
+
+    break;
+
   case BPKA_P256_KEY_GEN:
 
     /* Read the PKA scalar multiplication result which is the local public
@@ -221,3 +424,105 @@ void BPKA_BG_Process( void )
 }
 
 /*****************************************************************************/
+
+#if CFG_BPKA_PAIR_NBR > 0
+
+/*****************************************************************************/
+
+void BPKA_Precompute( void )
+{
+  BPKA_PAIR_T* pp;
+  uint32_t radio_remaining_time = LL_DP_SLP_NO_WAKEUP;
+  uint8_t i, index = CFG_BPKA_PAIR_NBR;
+
+  if ( BPKA_state == BPKA_PRECOMPUTE )
+  {
+    if ( HW_PKA_EndOfOperation( ) )
+    {
+      pp = &BPKA_pair[BPKA_pair_index];
+
+      /* Read the public key, this disables the PKA */
+      HW_PKA_P256_ReadEccScalarMul( pp->public_key, pp->public_key + 8 );
+
+      pp->state = BPKA_PAIR_READY;
+      pp->time = UTIL_TIMER_GetCurrentTime( );
+
+      BPKA_state = BPKA_IDLE;
+      BPKA_LpmVote( TRUE );
+
+      BPKA_stats.computed++;
+    }
+    return;
+  }
+
+  /* Do not delay the stack operations */
+  if ( BPKA_state != BPKA_IDLE )
+    return;
+
+  /* Drop the pairs unused for too long, look for a free one */
+  for ( i = 0; i < CFG_BPKA_PAIR_NBR; i++ )
+  {
+    pp = &BPKA_pair[i];
+
+    if ( (pp->state == BPKA_PAIR_READY) &&
+         (UTIL_TIMER_GetElapsedTime( pp->time ) >= CFG_BPKA_PAIR_LIFETIME_MS) )
+    {
+      BPKA_PairFree( pp );
+      BPKA_stats.expired++;
+    }
+
+    if ( (pp->state == BPKA_PAIR_FREE) && (index == CFG_BPKA_PAIR_NBR) )
+      index = i;
+  }
+
+  if ( index == CFG_BPKA_PAIR_NBR )
+    return;
+
+  /* Only start when the radio is quiet */
+  if ( ll_sys_dp_slp_get_state( ) == LL_SYS_DP_SLP_DISABLED )
+  {
+    if ( ll_intf_le_get_remaining_time_for_next_event( &radio_remaining_time ) != SUCCESS )
+      return;
+
+    if ( (radio_remaining_time != LL_DP_SLP_NO_WAKEUP) &&
+         (radio_remaining_time < CFG_BPKA_RADIO_MARGIN_US) )
+      return;
+  }
+
+  if ( ! HW_PKA_Enable( ) )
+    return;
+
+  pp = &BPKA_pair[index];
+  BPKA_NewPrivateKey( pp->private_key );
+
+  /* Compute the public key of the new private key */
+  HW_PKA_P256_StartEccScalarMul( pp->private_key, NULL, NULL );
+
+  pp->state = BPKA_PAIR_COMPUTING;
+  BPKA_pair_index = index;
+  BPKA_state = BPKA_PRECOMPUTE;
+  BPKA_LpmVote( FALSE );
+}
+
+/*****************************************************************************/
+
+void BPKA_GetStats( BPKA_STATS_T* stats )
+{
+  *stats = BPKA_stats;
+}
+
+/*****************************************************************************/
+
+void BPKA_LogStats( void )
+{
+  BPKA_STATS_T stats;
+
+  BPKA_GetStats( &stats );
+  LOG_INFO_APP( "     - P-256 pairs: %d computed, %d used, %d computed on demand, %d expired, %d aborted, %d mismatched\n",
+                stats.computed, stats.hits, stats.misses,
+                stats.expired, stats.aborted, stats.mismatched );
+}
+
+/*****************************************************************************/
+
+#endif /* CFG_BPKA_PAIR_NBR > 0 */
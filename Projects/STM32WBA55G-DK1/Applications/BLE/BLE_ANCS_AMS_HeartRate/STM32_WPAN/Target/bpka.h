@@ -50,6 +50,36 @@ int BPKA_Process( void );
 
 void BPKA_BG_Process( void );
 
+/* P-256 key pairs computed at idle time, see CFG_BPKA_PAIR_NBR.
+ *
+ * The stack draws its private key, then only uses it through the two calls
+ * above: BPKA_StartP256Key() to get the public key it sends to the peer, and
+ * BPKA_StartDhKey() to compute the DH key. When a pair is ready, the former
+ * binds it to the private key of the stack and returns the public key of the
+ * pair; the latter then computes with the private key of the pair when it is
+ * given the bound key, so the DH key matches the public key the peer got.
+ * A DH request with any other key is computed as is, releases the binding
+ * and is counted in "mismatched".
+ */
+typedef struct
+{
+  uint32_t computed;   /* Pairs computed */
+  uint32_t hits;       /* Public keys requested by the stack, served by a pair */
+  uint32_t misses;     /* Public keys requested by the stack and computed */
+  uint32_t expired;    /* Pairs dropped at the end of their lifetime */
+  uint32_t aborted;    /* Computations stopped for a stack operation */
+  uint32_t mismatched; /* DH keys requested with a key other than the bound one */
+} BPKA_STATS_T;
+
+/* Polls the pair computation in progress, or starts a new one when a pair
+ * is missing and the radio is quiet. To be called when the system is idle
+ */
+void BPKA_Precompute( void );
+
+void BPKA_GetStats( BPKA_STATS_T* stats );
+
+void BPKA_LogStats( void );
+
 /* Callback used by BPKA_Process to indicate the end of the processing
  */
 void BPKACB_Complete( void );
@@ -25,11 +25,18 @@
 #include "stm32wbaxx_ll_rcc.h"
 #include "app_conf.h"
 #include "scm.h"
+#include "rf_timing_synchro.h"
 
 #if (CFG_LPM_LEVEL != 0)
 #include "stm32_lpm.h"
 #endif /* (CFG_LPM_LEVEL != 0) */
 /* USER CODE BEGIN Includes */
+#if (CFG_ENERGY_ACCT_SUPPORTED == 1)
+#include "energy_acct.h"
+#endif /* CFG_ENERGY_ACCT_SUPPORTED */
+#if (CFG_CTR_DRBG_SUPPORTED == 1)
+#include "ctr_drbg.h"
+#endif /* CFG_CTR_DRBG_SUPPORTED */
 
 /* USER CODE END Includes */
 
@@ -139,6 +146,9 @@ void LINKLAYER_PLAT_AclkCtrl(uint8_t enable)
   */
 void LINKLAYER_PLAT_GetRNG(uint8_t *ptr_rnd, uint32_t len)
 {
+#if (CFG_CTR_DRBG_SUPPORTED == 1)
+  CTR_DRBG_Get(ptr_rnd, len);
+#else
   uint32_t nb_remaining_rng = len;
   uint32_t generated_rng;
 
@@ -157,6 +167,7 @@ void LINKLAYER_PLAT_GetRNG(uint8_t *ptr_rnd, uint32_t len)
     HW_RNG_Get(1, &generated_rng);
     memcpy((ptr_rnd+(len-nb_remaining_rng)), &generated_rng, nb_remaining_rng);
   }
+#endif /* CFG_CTR_DRBG_SUPPORTED */
 }
 
 /**
@@ -401,6 +412,9 @@ void LINKLAYER_PLAT_StartRadioEvt(void)
 #if (CFG_SCM_SUPPORTED == 1)
   scm_notifyradiostate(SCM_RADIO_ACTIVE);
 #endif /* CFG_SCM_SUPPORTED */
+#if (CFG_ENERGY_ACCT_SUPPORTED == 1)
+  ENERGY_ACCT_RadioStart();
+#endif /* CFG_ENERGY_ACCT_SUPPORTED */
 }
 
 /**
@@ -415,6 +429,9 @@ void LINKLAYER_PLAT_StopRadioEvt(void)
 #if (CFG_SCM_SUPPORTED == 1)
   scm_notifyradiostate(SCM_RADIO_NOT_ACTIVE);
 #endif /* CFG_SCM_SUPPORTED */
+#if (CFG_ENERGY_ACCT_SUPPORTED == 1)
+  ENERGY_ACCT_RadioStop();
+#endif /* CFG_ENERGY_ACCT_SUPPORTED */
 }
 
 /**
@@ -489,4 +506,8 @@ void LINKLAYER_PLAT_DisableOSContextSwitch(void)
  */
 void LINKLAYER_PLAT_SCHLDR_TIMING_UPDATE_NOT(Evnt_timing_t * p_evnt_timing)
 {
+  /* Size the flash time windows according to the Link Layer scheduling timings */
+  RFTS_SchedulerTimingUpdate(p_evnt_timing->drift_time,
+                             p_evnt_timing->exec_time,
+                             p_evnt_timing->schdling_time);
 }
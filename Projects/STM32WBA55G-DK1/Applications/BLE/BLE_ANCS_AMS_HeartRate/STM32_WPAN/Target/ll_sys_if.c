@@ -24,6 +24,7 @@
 #include "ll_sys.h"
 #include "ll_sys_if.h"
 #include "stm32_seq.h"
+#include "app_entry.h"
 
 /* Private defines -----------------------------------------------------------*/
 
@@ -73,7 +74,7 @@
 void ll_sys_bg_process_init(void)
 {
   /* Tasks creation */
-  UTIL_SEQ_RegTask(1U << CFG_TASK_LINK_LAYER, UTIL_SEQ_RFU, ll_sys_bg_process);
+  APPE_SEQ_RegTask(1U << CFG_TASK_LINK_LAYER, UTIL_SEQ_RFU, ll_sys_bg_process);
 }
 
 /**
@@ -39,6 +39,23 @@ extern "C" {
  */
 #define CRCCTRL_HWADDR   CRC
 
+/**
+ * @brief Feed the CRC jobs by DMA, by the CPU otherwise
+ */
+#define CRCCTRL_DMA_SUPPORTED   (1)
+
+/**
+ * @brief DMA channel feeding the CRC jobs, and its interrupt
+ */
+#define CRCCTRL_DMA_CHANNEL     GPDMA1_Channel2
+#define CRCCTRL_DMA_IRQN        GPDMA1_Channel2_IRQn
+#define CRCCTRL_DMA_IRQ_PRIO    (7u)
+
+/**
+ * @brief Maximum size of a DMA block, in bytes
+ */
+#define CRCCTRL_DMA_BLOCK_SIZE  (0xFFFCu)
+
 /* Exported types ------------------------------------------------------------*/
 /* Exported constants --------------------------------------------------------*/
 /* External variables --------------------------------------------------------*/
@@ -67,6 +67,64 @@ extern "C" {
 #error NVM ID #1 => Not enough bank
 #endif
 
+/* ========================================================================== */
+/* +                      Delta log part - USER DEFINED                     + */
+/* ========================================================================== */
+
+/**
+ * @brief Enable the append-only delta log mode
+ *
+ * @details When enabled, a write request only appends the modified 128 bits lines
+ *          at the end of the bank in use. The whole bank is rewritten in the next
+ *          bank only once there is no more room for the delta records.
+ *
+ */
+#define SNVMA_DELTA_LOG_ENABLE          1u
+
+/**
+ * @brief Maximum number of 128 bits lines tracked by the delta log of a NVM
+ *
+ * @details NVMs whose registered buffers exceed this number of lines always
+ *          rely on full bank writes. Each line costs 2 bytes of RAM per NVM,
+ *          and 2 bytes of the CRC table written with each bank.
+ *
+ */
+#define SNVMA_DELTA_MAX_LINES           192u
+
+/* ========================================================================== */
+/* +                   Write coalescing part - USER DEFINED                 + */
+/* ========================================================================== */
+
+/**
+ * @brief Quiet period in ms before a write request is applied to the flash
+ *
+ * @details Every new write request restarts the quiet period, so that a burst of
+ *          requests on a buffer leads to a single flash operation.
+ *          Set to 0 to start the flash operation as soon as the request comes.
+ *
+ */
+#define SNVMA_WRITE_QUIET_PERIOD_MS     500u
+
+/**
+ * @brief Maximum delay in ms between the first request of a burst and its flash operation
+ *
+ */
+#define SNVMA_WRITE_MAX_DELAY_MS        3000u
+
+#if (SNVMA_WRITE_QUIET_PERIOD_MS != 0u) && (SNVMA_WRITE_MAX_DELAY_MS < SNVMA_WRITE_QUIET_PERIOD_MS)
+#error SNVMA_WRITE_MAX_DELAY_MS shall not be lower than SNVMA_WRITE_QUIET_PERIOD_MS
+#endif
+
+/* ========================================================================== */
+/* +                     Boot statistics part - USER DEFINED                + */
+/* ========================================================================== */
+
+/**
+ * @brief Measure the duration of the NVM validation done at init with the DWT cycle counter
+ *
+ */
+#define SNVMA_BOOT_STATS_ENABLE         1u
+
 /* ========================================================================== */
 /* +                       Check part - NOT USER DEFINED                    + */
 /* ========================================================================== */
@@ -101,6 +159,7 @@ extern "C" {
 typedef enum SNVMA_BufferId
 {
   APP_BLE_NvmBuffer,
+  APP_GATT_CacheBuffer,
   SNVMA_BufferId_Max  /* End of the enumeration */
 }SNVMA_BufferId_t;
 
@@ -371,6 +371,14 @@ extern void HW_RNG_Start( void );
 extern void HW_RNG_Get( uint8_t n,
                         uint32_t* val );
 
+/*
+ * HW_RNG_GetCount
+ *
+ * Returns the number of random 32-bit words currently held in the pool,
+ * i.e. how many words HW_RNG_Get() can return without pool underflow.
+ */
+extern int HW_RNG_GetCount( void );
+
 /*
  * HW_RNG_Process
  *
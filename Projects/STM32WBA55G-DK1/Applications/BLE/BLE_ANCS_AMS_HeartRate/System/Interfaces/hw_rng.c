@@ -282,6 +282,15 @@ void HW_RNG_Get( uint8_t n, uint32_t* val )
 
 /*****************************************************************************/
 
+int HW_RNG_GetCount( void )
+{
+  HW_RNG_VAR_T* pv = &HW_RNG_var;
+
+  return pv->size;
+}
+
+/*****************************************************************************/
+
 int HW_RNG_Process( void )
 {
   HW_RNG_VAR_T* pv = &HW_RNG_var;
@@ -36,6 +36,7 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "energy_acct.h"
 
 /* USER CODE END Includes */
 
@@ -398,6 +399,9 @@ void PWR_ExitStopMode( void )
 void PWR_EnterSleepMode( void )
 {
   /* USER CODE BEGIN PWR_EnterSleepMode_1 */
+#if (CFG_ENERGY_ACCT_SUPPORTED == 1)
+  ENERGY_ACCT_EnterLowPower(ENERGY_ACCT_SLEEP);
+#endif /* CFG_ENERGY_ACCT_SUPPORTED */
 
   /* USER CODE END PWR_EnterSleepMode_1 */
 
@@ -412,6 +416,9 @@ void PWR_EnterSleepMode( void )
 void PWR_ExitSleepMode( void )
 {
   /* USER CODE BEGIN PWR_ExitSleepMode */
+#if (CFG_ENERGY_ACCT_SUPPORTED == 1)
+  ENERGY_ACCT_ExitLowPower();
+#endif /* CFG_ENERGY_ACCT_SUPPORTED */
 
   /* USER CODE END PWR_ExitSleepMode */
 }
@@ -25,6 +25,7 @@
 #include "rf_timing_synchro.h"
 #include "flash_driver.h"
 #include "utilities_conf.h"
+#include "stm32_timer.h"
 
 #include "stm32wbaxx_hal.h"
 
@@ -67,6 +68,7 @@ typedef struct FM_FlashOpConfig
 #define ALIGNMENT_128  0x0000000F
 
 /* Private macros ------------------------------------------------------------*/
+
 /* Private variables ---------------------------------------------------------*/
 
 /**
@@ -114,10 +116,55 @@ static FM_FlashOpConfig_t fm_flashop_parameters;
  */
 static FM_BackGround_States_t FM_CurrentBackGroundState;
 
+/**
+  * @brief Cycle counter value when the time window has been granted
+  */
+static uint32_t fm_window_start;
+
+/**
+  * @brief System clock frequency when the time window has been granted
+  */
+static uint32_t fm_window_start_clock;
+
+/**
+  * @brief Duration in us of the time window in use
+  */
+static uint32_t fm_window_duration;
+
+/**
+  * @brief Duration in us of the last time window requested
+  */
+static uint32_t fm_window_requested;
+
+/**
+  * @brief Number of flash accesses done in the time window in use
+  */
+static uint32_t fm_window_accesses;
+
+/**
+  * @brief Time window statistics and learned flash operation durations
+  */
+static FM_Stats_t fm_stats =
+{
+  .WriteBlockTime = TIME_WINDOW_WRITE_DURATION,
+  .EraseSectorTime = TIME_WINDOW_ERASE_DURATION,
+};
+
+/**
+  * @brief Timer renewing a rejected time window request
+  */
+static UTIL_TIMER_Object_t fm_retry_timer;
+
 /* Private function prototypes -----------------------------------------------*/
 
 static FM_Cmd_Status_t FM_CheckFlashManagerState(FM_CallbackNode_t *CallbackNode);
 static void FM_WindowAllowed_Callback(void);
+static void FM_RequestWindow(void);
+static void FM_ReleaseWindow(void);
+static bool FM_IsWindowLeft(uint32_t Duration);
+static void FM_LearnDuration(uint32_t *LearnedDuration, uint32_t Duration);
+static uint32_t FM_ElapsedTimeUs(uint32_t StartCycles, uint32_t StartClock);
+static void FM_RetryTimer_Callback(void *Argument);
 
 /* Functions Definition ------------------------------------------------------*/
 
@@ -163,7 +210,14 @@ FM_Cmd_Status_t FM_Write(uint32_t *Src, uint32_t *Dest, int32_t Size, FM_Callbac
 
     fm_flashop = FM_WRITE_OP;
 
-    FM_CurrentBackGroundState = FM_BKGND_NOWINDOW_FLASHOP;
+    if (fm_window_granted == true)
+    { /* Time window of the previous operation still in use, write in it */
+      FM_CurrentBackGroundState = FM_BKGND_WINDOWED_FLASHOP;
+    }
+    else
+    {
+      FM_CurrentBackGroundState = FM_BKGND_NOWINDOW_FLASHOP;
+    }
 
     /* Window request to be executed in background */
     FM_ProcessRequest();
@@ -212,7 +266,14 @@ FM_Cmd_Status_t FM_Erase(uint32_t FirstSect, uint32_t NbrSect, FM_CallbackNode_t
 
     fm_flashop = FM_ERASE_OP;
 
-    FM_CurrentBackGroundState = FM_BKGND_NOWINDOW_FLASHOP;
+    if (fm_window_granted == true)
+    { /* Time window of the previous operation still in use, it will be released first */
+      FM_CurrentBackGroundState = FM_BKGND_WINDOWED_FLASHOP;
+    }
+    else
+    {
+      FM_CurrentBackGroundState = FM_BKGND_NOWINDOW_FLASHOP;
+    }
 
     /* Window request to be executed in background */
     FM_ProcessRequest();
@@ -230,8 +291,9 @@ FM_Cmd_Status_t FM_Erase(uint32_t FirstSect, uint32_t NbrSect, FM_CallbackNode_t
   */
 void FM_BackgroundProcess (void)
 {
-  static uint32_t duration;
   bool flashop_complete = false;
+  uint32_t access_start;
+  uint32_t access_clock;
   FD_FlashOp_Status_t fdReturnValue = FD_FLASHOP_SUCCESS;
   FM_CallbackNode_t *pCbNode = NULL;
 
@@ -245,9 +307,6 @@ void FM_BackgroundProcess (void)
       {
         LOG_INFO_SYSTEM("\r\nFM_BackgroundProcess - Case FM_BKGND_NOWINDOW_FLASHOP - Write operation");
 
-        /* Update duration time value */
-        duration = TIME_WINDOW_WRITE_REQUEST;
-
         /* Set the next possible state - App could stop at anytime no window operation */
         FM_CurrentBackGroundState = FM_BKGND_WINDOWED_FLASHOP;
 
@@ -279,9 +338,6 @@ void FM_BackgroundProcess (void)
       {
         LOG_INFO_SYSTEM("\r\nFM_BackgroundProcess - Case FM_BKGND_NOWINDOW_FLASHOP - Erase operation");
 
-        /* Update duration time value */
-        duration = TIME_WINDOW_ERASE_REQUEST;
-
         /* Set the next possible state */
         FM_CurrentBackGroundState = FM_BKGND_WINDOWED_FLASHOP;
 
@@ -313,12 +369,17 @@ void FM_BackgroundProcess (void)
     {
       LOG_INFO_SYSTEM("\r\nFM_BackgroundProcess - Case FM_BKGND_WINDOWED_FLASHOP");
 
+      if ((fm_window_granted == true) && (fm_flashop == FM_ERASE_OP) && (fm_window_accesses != 0))
+      {
+        /* Erase needs a time window of its own */
+        FM_ReleaseWindow();
+      }
+
       if (fm_window_granted == false)
       {
         LOG_INFO_SYSTEM("\r\nFM_BackgroundProcess - Case FM_BKGND_WINDOWED_FLASHOP - No time window granted yet, request one");
 
-        /* No time window granted yet, request one */
-        RFTS_ReqWindow(duration, &FM_WindowAllowed_Callback);
+        /* No time window granted yet, it is requested below */
       }
       else
       {
@@ -331,13 +392,27 @@ void FM_BackgroundProcess (void)
 
           HAL_FLASH_Unlock();
 
+          /* Write as many blocks as the time window allows */
           while((fm_flashop_parameters.writeSize > 0) &&
-                (FD_WriteData((uint32_t) fm_flashop_parameters.writeDest,
-                              (uint32_t) fm_flashop_parameters.writeSrc) == FD_FLASHOP_SUCCESS))
+                (FM_IsWindowLeft(fm_stats.WriteBlockTime) == true))
           {
-              fm_flashop_parameters.writeDest += FLASH_WRITE_BLOCK_SIZE;
-              fm_flashop_parameters.writeSrc += FLASH_WRITE_BLOCK_SIZE;
-              fm_flashop_parameters.writeSize -= FLASH_WRITE_BLOCK_SIZE;
+            access_start = DWT->CYCCNT;
+            access_clock = SystemCoreClock;
+
+            if (FD_WriteData((uint32_t) fm_flashop_parameters.writeDest,
+                             (uint32_t) fm_flashop_parameters.writeSrc) != FD_FLASHOP_SUCCESS)
+            {
+              /* Time window closed before the end of the write */
+              fm_stats.WindowOverruns++;
+              break;
+            }
+
+            FM_LearnDuration(&fm_stats.WriteBlockTime, FM_ElapsedTimeUs(access_start, access_clock));
+            fm_window_accesses++;
+
+            fm_flashop_parameters.writeDest += FLASH_WRITE_BLOCK_SIZE;
+            fm_flashop_parameters.writeSrc += FLASH_WRITE_BLOCK_SIZE;
+            fm_flashop_parameters.writeSize -= FLASH_WRITE_BLOCK_SIZE;
           }
 
           if (fm_flashop_parameters.writeSize <= 0)
@@ -345,36 +420,47 @@ void FM_BackgroundProcess (void)
             flashop_complete = true;
           }
 
-      HAL_FLASH_Lock();
+          HAL_FLASH_Lock();
+        }
+        else
+        {
+          /* Flash Erase operation */
+          LOG_INFO_SYSTEM("\r\nFM_BackgroundProcess - Case FM_BKGND_WINDOWED_FLASHOP - Erase operation");
 
-    }
-    else
-    {
-      /* Flash Erase operation */
-      LOG_INFO_SYSTEM("\r\nFM_BackgroundProcess - Case FM_BKGND_WINDOWED_FLASHOP - Erase operation");
+          HAL_FLASH_Unlock();
 
-      HAL_FLASH_Unlock();
+          access_start = DWT->CYCCNT;
+          access_clock = SystemCoreClock;
 
-      /* Erase only one sector in a single time window */
-      if (FD_EraseSectors(fm_flashop_parameters.eraseFirstSect) == FD_FLASHOP_SUCCESS)
-      {
-        fm_flashop_parameters.eraseNbrSect--;
-        fm_flashop_parameters.eraseFirstSect++;
-      }
+          /* Erase only one sector in a single time window */
+          if (FD_EraseSectors(fm_flashop_parameters.eraseFirstSect) == FD_FLASHOP_SUCCESS)
+          {
+            FM_LearnDuration(&fm_stats.EraseSectorTime, FM_ElapsedTimeUs(access_start, access_clock));
 
-      if (fm_flashop_parameters.eraseNbrSect == 0)
-      {
-        flashop_complete = true;
-      }
+            fm_flashop_parameters.eraseNbrSect--;
+            fm_flashop_parameters.eraseFirstSect++;
+          }
+          else
+          {
+            /* Time window closed before the erase */
+            fm_stats.WindowOverruns++;
+          }
 
-      HAL_FLASH_Lock();
-    }
+          fm_window_accesses++;
+
+          if (fm_flashop_parameters.eraseNbrSect == 0)
+          {
+            flashop_complete = true;
+          }
 
-        /* Release the time window */
-        RFTS_RelWindow();
+          HAL_FLASH_Lock();
+        }
 
-        /* Indicate that there is no more window */
-        fm_window_granted = false;
+        /* The time window is kept for the next write when the operation is complete */
+        if (flashop_complete == false)
+        {
+          FM_ReleaseWindow();
+        }
       }
 
       break;
@@ -412,6 +498,22 @@ void FM_BackgroundProcess (void)
       LST_remove_head (&fm_cb_pending_list, (tListNode**)&pCbNode);
       pCbNode->Callback(FM_OPERATION_AVAILABLE);
     }
+
+    if (fm_window_granted == true)
+    {
+      /* Has a write been requested meanwhile that fits in the time window left ? */
+      if ((flash_manager_busy == true) && (fm_flashop == FM_WRITE_OP) &&
+          (FM_IsWindowLeft(fm_stats.WriteBlockTime) == true))
+      {
+        LOG_INFO_SYSTEM("\r\nFM_BackgroundProcess - Next write packed in the current time window");
+
+        fm_stats.BatchedOps++;
+      }
+      else
+      {
+        FM_ReleaseWindow();
+      }
+    }
   }
   else
   {
@@ -419,7 +521,24 @@ void FM_BackgroundProcess (void)
     LOG_INFO_SYSTEM("\r\nFM_BackgroundProcess - Flash operation not complete yet, request a new time window");
 
     /* Request a new time window */
-    RFTS_ReqWindow(duration, &FM_WindowAllowed_Callback);
+    FM_RequestWindow();
+  }
+}
+
+/**
+  * @brief  Get the time window statistics and the learned flash operation durations
+  * @param  Stats: Pointer to the statistics to fill
+  * @retval None
+  */
+void FM_GetStats(FM_Stats_t *Stats)
+{
+  if (Stats != NULL)
+  {
+    UTILS_ENTER_CRITICAL_SECTION();
+
+    *Stats = fm_stats;
+
+    UTILS_EXIT_CRITICAL_SECTION();
   }
 }
 
@@ -441,6 +560,16 @@ static FM_Cmd_Status_t FM_CheckFlashManagerState(FM_CallbackNode_t *CallbackNode
   {
     LST_init_head(&fm_cb_pending_list);
     fm_cb_pending_list_init = true;
+
+    /* Start the cycle counter used to learn the flash operation durations */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    UTIL_TIMER_Create(&fm_retry_timer,
+                      TIME_WINDOW_RETRY_DELAY,
+                      UTIL_TIMER_ONESHOT,
+                      &FM_RetryTimer_Callback,
+                      NULL);
   }
   /* Check if semaphore on flash is available */
   if (busy_flash_sem == false)
@@ -505,6 +634,20 @@ static FM_Cmd_Status_t FM_CheckFlashManagerState(FM_CallbackNode_t *CallbackNode
   */
 static void FM_WindowAllowed_Callback(void)
 {
+  fm_window_start = DWT->CYCCNT;
+  fm_window_start_clock = SystemCoreClock;
+  fm_window_accesses = 0;
+
+  /* Use the requested duration when the grant is not limited */
+  fm_window_duration = RFTS_GetWindowDuration();
+  if ((fm_window_duration == 0) || (fm_window_duration > fm_window_requested))
+  {
+    fm_window_duration = fm_window_requested;
+  }
+
+  fm_stats.WindowGrants++;
+  fm_stats.GrantedTime += fm_window_duration;
+
   fm_window_granted = true;
 
   LOG_INFO_SYSTEM("\r\nFM_WindowAllowed_Callback");
@@ -512,3 +655,131 @@ static void FM_WindowAllowed_Callback(void)
   /* Flash operation to be executed in background */
   FM_ProcessRequest();
 }
+
+/**
+  * @brief  Request a time window sized on the learned duration of the flash operation
+  * @note   The minimum duration allows a single flash access, so that the window fits between
+  *         radio events. The Link Layer may extend it up to the whole operation duration.
+  * @param  None
+  * @retval None
+  */
+static void FM_RequestWindow(void)
+{
+  uint32_t duration_min;
+  uint32_t duration_max = 0;
+
+  if (fm_flashop == FM_WRITE_OP)
+  {
+    duration_min = fm_stats.WriteBlockTime + TIME_WINDOW_MARGIN;
+    duration_max = ((((uint32_t)fm_flashop_parameters.writeSize + FLASH_WRITE_BLOCK_SIZE - 1U) / FLASH_WRITE_BLOCK_SIZE) *
+                    fm_stats.WriteBlockTime) + TIME_WINDOW_MARGIN;
+
+    if (duration_max > TIME_WINDOW_WRITE_MAX_DURATION)
+    {
+      duration_max = TIME_WINDOW_WRITE_MAX_DURATION;
+    }
+  }
+  else
+  {
+    duration_min = fm_stats.EraseSectorTime + TIME_WINDOW_MARGIN;
+  }
+
+  fm_window_requested = (duration_max > duration_min) ? duration_max : duration_min;
+
+  fm_stats.WindowRequests++;
+
+  if (RFTS_ReqFlexWindow(duration_min, duration_max, &FM_WindowAllowed_Callback) != RFTS_CMD_OK)
+  {
+    LOG_ERROR_SYSTEM("\r\nFM_RequestWindow - Time window request rejected, retry later");
+
+    fm_stats.WindowDenials++;
+
+    /* Renew the request once the scheduler had a chance to free up */
+    (void)UTIL_TIMER_Start(&fm_retry_timer);
+  }
+}
+
+/**
+  * @brief  Callback called when the delay after a rejected time window request is over
+  * @param  Argument: Not used
+  * @retval None
+  */
+static void FM_RetryTimer_Callback(void *Argument)
+{
+  UNUSED(Argument);
+
+  /* Is the flash operation still waiting for a time window ? */
+  if ((flash_manager_busy == true) && (fm_window_granted == false) &&
+      (FM_CurrentBackGroundState == FM_BKGND_WINDOWED_FLASHOP))
+  {
+    /* Time window request to be renewed in background */
+    FM_ProcessRequest();
+  }
+}
+
+/**
+  * @brief  Release the time window in use and account for its unused part
+  * @param  None
+  * @retval None
+  */
+static void FM_ReleaseWindow(void)
+{
+  uint32_t used = FM_ElapsedTimeUs(fm_window_start, fm_window_start_clock);
+
+  if (used < fm_window_duration)
+  {
+    fm_stats.SlackTime += (fm_window_duration - used);
+  }
+
+  /* Release the time window */
+  RFTS_RelWindow();
+
+  /* Indicate that there is no more window */
+  fm_window_granted = false;
+}
+
+/**
+  * @brief  Check if a flash access fits in the time window left
+  * @note   The first access of a time window is always allowed
+  * @param  Duration: Duration in us of the flash access
+  * @retval True if the access can be done
+  */
+static bool FM_IsWindowLeft(uint32_t Duration)
+{
+  return ((fm_window_accesses == 0) ||
+          ((FM_ElapsedTimeUs(fm_window_start, fm_window_start_clock) + Duration + TIME_WINDOW_MARGIN) <= fm_window_duration));
+}
+
+/**
+  * @brief  Compute the time elapsed since a cycle counter value
+  * @note   The system clock may be changed meanwhile by the DVFS, the lower of the start and current
+  *         frequencies is used so that the elapsed time is never underestimated
+  * @param  StartCycles: Cycle counter value at the start of the measure
+  * @param  StartClock: System clock frequency in Hz at the start of the measure
+  * @retval Elapsed time in us
+  */
+static uint32_t FM_ElapsedTimeUs(uint32_t StartCycles, uint32_t StartClock)
+{
+  uint32_t clock = (SystemCoreClock < StartClock) ? SystemCoreClock : StartClock;
+
+  return ((DWT->CYCCNT - StartCycles) / (clock / 1000000U));
+}
+
+/**
+  * @brief  Update a learned flash operation duration with a new measure
+  * @note   The learned duration follows increases quickly and decreases slowly, to avoid window overruns
+  * @param  LearnedDuration: Pointer to the learned duration in us
+  * @param  Duration: Measured duration in us
+  * @retval None
+  */
+static void FM_LearnDuration(uint32_t *LearnedDuration, uint32_t Duration)
+{
+  if (Duration > *LearnedDuration)
+  {
+    *LearnedDuration = (*LearnedDuration + Duration + 1U) / 2U;
+  }
+  else
+  {
+    *LearnedDuration -= (*LearnedDuration - Duration) / 8U;
+  }
+}
@@ -56,6 +56,22 @@ typedef struct FM_CallbackNode
   void (*Callback)(FM_FlashOp_Status_t Status);  /* Callback function pointer for Flash Manager caller */
 }FM_CallbackNode_t;
 
+/**
+ * @brief  Flash Manager time window statistics
+ */
+typedef struct FM_Stats
+{
+  uint32_t WindowRequests;   /* Number of time windows requested to the RF Timing Synchro */
+  uint32_t WindowGrants;     /* Number of time windows granted */
+  uint32_t WindowDenials;    /* Number of time window requests rejected */
+  uint32_t WindowOverruns;   /* Number of flash operations stopped by the end of their time window */
+  uint32_t BatchedOps;       /* Number of flash operations executed in the time window of a previous one */
+  uint32_t GrantedTime;      /* Cumulated duration in us of the time windows granted */
+  uint32_t SlackTime;        /* Cumulated duration in us of the time windows granted but left unused */
+  uint32_t WriteBlockTime;   /* Learned duration in us of a 128 bits write */
+  uint32_t EraseSectorTime;  /* Learned duration in us of a sector erase */
+}FM_Stats_t;
+
 /* Exported constants --------------------------------------------------------*/
 
 #define TIME_WINDOW_ERASE_DURATION 4000U  /* Duration in us of the time window requested for Flash Erase */
@@ -64,6 +80,8 @@ typedef struct FM_CallbackNode
                                    /* As timers use ms, amount below 1000 is removed at conversion */
 #define TIME_WINDOW_ERASE_REQUEST  (TIME_WINDOW_ERASE_DURATION + TIME_WINDOW_MARGIN)
 #define TIME_WINDOW_WRITE_REQUEST  (TIME_WINDOW_WRITE_DURATION + TIME_WINDOW_MARGIN)
+#define TIME_WINDOW_WRITE_MAX_DURATION 4000U  /* Maximum duration in us of a time window packing several Flash Writes */
+#define TIME_WINDOW_RETRY_DELAY    10U  /* Delay in ms before a rejected time window request is renewed */
 
 /* Exported variables --------------------------------------------------------*/
 /* Exported macros -----------------------------------------------------------*/
@@ -72,6 +90,7 @@ FM_Cmd_Status_t FM_Write(uint32_t *Src, uint32_t *Dest, int32_t Size, FM_Callbac
 FM_Cmd_Status_t FM_Erase(uint32_t FirstSect, uint32_t NbrSect, FM_CallbackNode_t *CallbackNode);
 void FM_BackgroundProcess (void);
 void FM_ProcessRequest (void);
+void FM_GetStats(FM_Stats_t *Stats);
 
 #ifdef __cplusplus
 }
@@ -35,6 +35,11 @@
 /* Private macros ------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 
+/**
+  * @brief Time in us spent by the Firmware Link Layer scheduler around each of its events
+  */
+static uint32_t rfts_schdlr_overhead = 0;
+
 #if (DISABLE_RFTS_EXT_EVNT_HNDLR == 0u)
 /**
   * @brief Pointer to time window requester's callback
@@ -56,6 +61,11 @@ static UTIL_TIMER_Object_t rfts_timer;
   */
 static ext_evnt_hndl_t ext_event_handler;
 
+/**
+  * @brief Duration in us of the time window granted - 0 when the duration is not limited
+  */
+static uint32_t rfts_window_duration = 0;
+
 /* Private function prototypes -----------------------------------------------*/
 
 static void RFTS_WindowAllowed_Callback(void);
@@ -72,6 +82,20 @@ static uint32_t event_started_callback(ext_evnt_hndl_t evnt_hndl, uint32_t slot_
   * @retval RFTS_Cmd_Status_t: Success or failure of the window request
   */
 RFTS_Cmd_Status_t RFTS_ReqWindow(uint32_t Duration, void (*Callback)(void))
+{
+  return RFTS_ReqFlexWindow(Duration, 0, Callback);
+}
+
+/**
+  * @brief  Request a time window of flexible duration to the Firmware Link Layer
+  * @note   A short minimum duration lets the Link Layer fit the window in the gaps between its own events.
+  *         The duration actually granted is given by RFTS_GetWindowDuration once the window is allocated.
+  * @param  DurationMin: Minimum duration in us of the time window requested
+  * @param  DurationMax: Duration in us the time window may be extended to - 0 if not used
+  * @param  Callback: Callback to be called when time window is allocated
+  * @retval RFTS_Cmd_Status_t: Success or failure of the window request
+  */
+RFTS_Cmd_Status_t RFTS_ReqFlexWindow(uint32_t DurationMin, uint32_t DurationMax, void (*Callback)(void))
 {
 #if (DISABLE_RFTS_EXT_EVNT_HNDLR == 0u)
   extrnl_evnt_st_t extrnl_evnt_config;
@@ -105,8 +129,8 @@ RFTS_Cmd_Status_t RFTS_ReqWindow(uint32_t Duration, void (*Callback)(void))
   extrnl_evnt_config.deadline = 0;
   extrnl_evnt_config.strt_min = 0;
   extrnl_evnt_config.strt_max = 0;
-  extrnl_evnt_config.durn_min = Duration;
-  extrnl_evnt_config.durn_max = 0;
+  extrnl_evnt_config.durn_min = DurationMin + rfts_schdlr_overhead;
+  extrnl_evnt_config.durn_max = (DurationMax > DurationMin) ? (DurationMax + rfts_schdlr_overhead) : 0;
   extrnl_evnt_config.prdc_intrvl = 0;
   extrnl_evnt_config.priority = PRIORITY_DEFAULT;
   extrnl_evnt_config.blocked = STATE_NOT_BLOCKED;
@@ -115,8 +139,11 @@ RFTS_Cmd_Status_t RFTS_ReqWindow(uint32_t Duration, void (*Callback)(void))
   extrnl_evnt_config.evnt_blckd_cbk = NULL;
   extrnl_evnt_config.evnt_abortd_cbk = NULL;
 
+  /* Window duration until the grant */
+  rfts_window_duration = (DurationMax > DurationMin) ? DurationMax : DurationMin;
+
   UTIL_TIMER_Create(&rfts_timer,
-                    (Duration/1000),
+                    (rfts_window_duration/1000),
                     UTIL_TIMER_ONESHOT,
                     &RFTS_Timeout_Callback,
                     NULL);
@@ -171,6 +198,34 @@ RFTS_Cmd_Status_t RFTS_RelWindow(void)
 #endif /* (DISABLE_RFTS_EXT_EVNT_HNDLR == 0u) */
 }
 
+/**
+  * @brief  Get the duration of the time window granted
+  * @param  None
+  * @retval Duration in us usable by the requester - 0 when the duration is not limited
+  */
+uint32_t RFTS_GetWindowDuration(void)
+{
+#if (DISABLE_RFTS_EXT_EVNT_HNDLR == 0u)
+  return rfts_window_duration;
+#else
+  return 0;
+#endif /* (DISABLE_RFTS_EXT_EVNT_HNDLR == 0u) */
+}
+
+/**
+  * @brief  Update the Firmware Link Layer scheduling timings
+  * @note   Those timings are spent by the Link Layer around each of its events and are added to the
+  *         durations requested so that they do not eat the time window.
+  * @param  DriftTime: Drift time in us of the Link Layer scheduler
+  * @param  ExecTime: Time in us to get an event ready for air transmission
+  * @param  SchedulingTime: Time in us to serve a completed event and start the next one
+  * @retval None
+  */
+void RFTS_SchedulerTimingUpdate(uint32_t DriftTime, uint32_t ExecTime, uint32_t SchedulingTime)
+{
+  rfts_schdlr_overhead = DriftTime + ExecTime + SchedulingTime;
+}
+
 #if (DISABLE_RFTS_EXT_EVNT_HNDLR == 0u)
 /**
   * @brief  Callback called by Firmware Link Layer when a time window is available
@@ -208,6 +263,24 @@ static void RFTS_Timeout_Callback(void* Argument)
 
 static uint32_t event_started_callback(ext_evnt_hndl_t evnt_hndl, uint32_t slot_durn, void* priv_data_ptr)
 {
+  /* A null slot duration means that the grant is not limited */
+  if (slot_durn == 0)
+  {
+    rfts_window_duration = 0;
+  }
+  else if (slot_durn > rfts_schdlr_overhead)
+  {
+    rfts_window_duration = slot_durn - rfts_schdlr_overhead;
+
+    /* Window overrun protection follows the granted duration - At least 1ms as timers use ms */
+    UTIL_TIMER_SetPeriod(&rfts_timer,
+                         ((rfts_window_duration < 1000) ? 1 : (rfts_window_duration/1000)));
+  }
+  else
+  {
+    /* Keep the requested duration */
+  }
+
   RFTS_WindowAllowed_Callback();
   return 0;
 }
@@ -44,7 +44,10 @@ typedef enum
 /* Exported macros -----------------------------------------------------------*/
 /* Exported functions prototypes ---------------------------------------------*/
 RFTS_Cmd_Status_t RFTS_ReqWindow(uint32_t Duration, void (*Callback)(void));
+RFTS_Cmd_Status_t RFTS_ReqFlexWindow(uint32_t DurationMin, uint32_t DurationMax, void (*Callback)(void));
 RFTS_Cmd_Status_t RFTS_RelWindow(void);
+uint32_t RFTS_GetWindowDuration(void);
+void RFTS_SchedulerTimingUpdate(uint32_t DriftTime, uint32_t ExecTime, uint32_t SchedulingTime);
 
 #ifdef __cplusplus
 }
@@ -40,6 +40,7 @@
 /* Tools */
 #include "stm_list.h"
 #include "utilities_common.h"
+#include "stm32_timer.h"
 
 /* Debug */
 #include "log_module.h"
@@ -58,11 +59,27 @@ extern void Error_Handler(void);
 /* Flash memory erased content */
 #define SNVMA_ERASED_CONTENT  0xFFFFu
 
+/* Size of a flash line in bytes and in words */
+#define SNVMA_LINE_SIZE       16u
+#define SNVMA_LINE_WORDS      (SNVMA_LINE_SIZE / sizeof (uint32_t))
+
+/* Delta log record tags */
+#define SNVMA_DELTA_LINE_TAG    0xD1u
+#define SNVMA_DELTA_COMMIT_TAG  0xC0u
+
 /* Private macros ------------------------------------------------------------*/
 /* Align an address on a 128 bits boundary */
 #define SNVMA_ALIGN_128(p_Addr)  \
   ((p_Addr + SNVMA_MASK_ALIGNMENT_128) & ~SNVMA_MASK_ALIGNMENT_128)
 
+/* Number of 128 bits lines needed to store a buffer of Size words */
+#define SNVMA_LINE_NUMBER(Size)  \
+  (SNVMA_ALIGN_128 ((Size) * sizeof (uint32_t)) / SNVMA_LINE_SIZE)
+
+/* Number of 128 bits lines needed by the CRC table of LineNumber lines - The last word holds the CRC of the table */
+#define SNVMA_CRC_TABLE_LINES(LineNumber)  \
+  (((((LineNumber) + 2u) * sizeof (uint16_t)) + SNVMA_LINE_SIZE - 1u) / SNVMA_LINE_SIZE)
+
 /* Private typedef -----------------------------------------------------------*/
 
 /* Flash operation steps */
@@ -70,8 +87,12 @@ typedef enum SNVMA_FlashOpSteps
 {
   SNVMA_HEADER_WRITE,
   SNVMA_BUFFER_WRITE,
+  SNVMA_CRC_TABLE_WRITE,
   SNVMA_ERASE_BANK,
-  SNVMA_RETRY_WRITE
+  SNVMA_RETRY_WRITE,
+  SNVMA_BANK_CHECK,
+  SNVMA_DELTA_WRITE,
+  SNVMA_DELTA_COMMIT
 }SNVMA_FlashOpSteps_t;
 
 /* Flash operation information */
@@ -112,6 +133,72 @@ typedef __PACKED_STRUCT __ALIGNED(16) SNVMA_BankHeader
   uint16_t SizeId4;
 }SNVMA_BankHeader_t;
 
+/*
+ *  CRC table layout - Written after the buffers by a full bank write
+ *
+ *  -------------------------------------------------------------
+ *  + CRC16 of line 0 + ... + CRC16 of line N-1 + ... + Table CRC +
+ *  -------------------------------------------------------------
+ *
+ *  Each entry is the CRC16 of a 128 bits line of the buffers, unused words
+ *  of a partial line being taken as erased. The newest CRC of a line is the
+ *  one of its newest delta record, if any, else the one of the table.
+ *
+ *  Delta log layout - Appended after the CRC table of the bank in use
+ *
+ *  -------------------------------------------------------------
+ *  + Line record header + Line data + ... + Commit record header +
+ *  -------------------------------------------------------------
+ *
+ *  Line records of a batch are only taken into account once the commit
+ *  record of the same batch has been written.
+ */
+typedef __PACKED_STRUCT __ALIGNED(16) SNVMA_DeltaHeader
+{
+  /* Record tag - Line or commit record */
+  uint8_t Tag;
+  /* Counter of the bank the record belongs to */
+  uint8_t Counter;
+  /* Integrity check of the line data - CRC16 - Unused for commit records */
+  uint16_t Crc;
+  /* Index of the line in the bank - Number of lines of the batch for commit records */
+  uint16_t LineIdx;
+  /* Batch number */
+  uint16_t Batch;
+  /* Unused value - Only for padding */
+  uint32_t Reserved1;
+  /* Unused value - Only for padding */
+  uint32_t Reserved2;
+}SNVMA_DeltaHeader_t;
+
+/* Delta line record */
+typedef __PACKED_STRUCT __ALIGNED(16) SNVMA_DeltaRecord
+{
+  /* Record header */
+  SNVMA_DeltaHeader_t Header;
+  /* Line content */
+  uint32_t a_Data[SNVMA_LINE_WORDS];
+}SNVMA_DeltaRecord_t;
+
+/* Delta log information of a NVM */
+typedef struct SNVMA_DeltaLog
+{
+  /* Number of lines used by the buffers of the bank - 0 when the log can't be used */
+  uint16_t LineNumber;
+  /* Offset of the next free record, in lines from the bank start address */
+  uint16_t LogOffset;
+  /* Offset of the bank end, in lines from the bank start address */
+  uint16_t LogEnd;
+  /* Current batch number */
+  uint16_t Batch;
+  /* Number of lines written in the current batch */
+  uint16_t BatchLines;
+  /* Line being written */
+  uint16_t CurrentLine;
+  /* Offset of the newest copy of each line, 0 when the copy is the one of the buffer area */
+  uint16_t a_LineMap[SNVMA_DELTA_MAX_LINES];
+}SNVMA_DeltaLog_t;
+
 /* Private variables ---------------------------------------------------------*/
 /* Flag for module initialization */
 static uint8_t SNVMA_ModuleInit = FALSE;
@@ -134,6 +221,60 @@ static SNVMA_FlashOpInfo_t SNVMA_FlashInfo;
 /* Representation of the Bank configuration */
 static SNVMA_BankElt_t SNVMA_BankConfiguration[SNVMA_NUMBER_OF_BANKS];
 
+/* First sector used by the NVMs */
+static uint32_t SNVMA_StartSectorId = 0x00;
+
+/* Flash activity counters of the sectors in use, since boot */
+static SNVMA_SectorStats_t SNVMA_SectorStats[SNVMA_NUMBER_OF_SECTOR_NEEDED];
+
+#if (SNVMA_DELTA_LOG_ENABLE == 1u)
+/* Delta log of each NVM */
+static SNVMA_DeltaLog_t SNVMA_DeltaLog[SNVMA_NVM_NUMBER];
+
+/* Record for delta write operation */
+static SNVMA_DeltaRecord_t SNVMA_WriteDeltaRecord;
+
+/* CRC table of the bank being written */
+static uint32_t SNVMA_WriteCrcTable[SNVMA_CRC_TABLE_LINES (SNVMA_DELTA_MAX_LINES) * SNVMA_LINE_WORDS];
+
+/* Offset of the CRC table from the bank start address and its size, in lines - Size is 0 when the bank has no table */
+static uint16_t SNVMA_WriteCrcTableOffset = 0x00;
+static uint16_t SNVMA_WriteCrcTableLines = 0x00;
+
+/* Flag for a batch without modified line, whose completion is reported by the background process */
+static uint8_t SNVMA_DeltaCompletePending = FALSE;
+#endif /* SNVMA_DELTA_LOG_ENABLE == 1u */
+
+#if (SNVMA_WRITE_QUIET_PERIOD_MS != 0u)
+/* Timer of the write coalescing period */
+static UTIL_TIMER_Object_t SNVMA_CoalescingTimer;
+
+/* Flag for coalescing period on going */
+static uint8_t SNVMA_CoalescingOngoing = FALSE;
+
+/* Start time of the coalescing period */
+static UTIL_TIMER_Time_t SNVMA_CoalescingStartTime = 0x00;
+
+/* Bitmask of the NVMs whose coalescing period is over */
+static uint32_t SNVMA_FlushBitmask = 0x00000000;
+
+/* Number of write requests merged in the coming flash operation */
+static uint32_t SNVMA_CoalescedRequests = 0x00;
+#endif /* SNVMA_WRITE_QUIET_PERIOD_MS != 0u */
+
+/* Cost of the NVM validation done at init */
+static SNVMA_BootStats_t SNVMA_BootStats;
+
+/* CRC job checking the bank just written, and its scatter-gather list */
+static CRCCTRL_Job_t SNVMA_CrcJob;
+static CRCCTRL_Segment_t SNVMA_CrcSegments[SNVMA_MAX_NUMBER_BUFFER];
+
+/* CRC expected for the bank being checked */
+static uint32_t SNVMA_BankCheckCrc = 0x00;
+
+/* Result of the check of the bank just written */
+static uint8_t SNVMA_BankCheckOk = FALSE;
+
 /* Callback prototypes -----------------------------------------------*/
 
 /**
@@ -146,6 +287,25 @@ static SNVMA_BankElt_t SNVMA_BankConfiguration[SNVMA_NUMBER_OF_BANKS];
  */
 void SNVMA_FlashManagerCallback(FM_FlashOp_Status_t Status);
 
+/**
+ * @brief Callback to be invoked by the CRC controller
+ *
+ * @details Informs about the result of the bank integrity check
+ *
+ * @param p_Job: CRC job checking the bank
+ */
+static void SNVMA_CrcJobCallback (CRCCTRL_Job_t * const p_Job);
+
+#if (SNVMA_WRITE_QUIET_PERIOD_MS != 0u)
+/**
+ * @brief Callback to be invoked at the end of the coalescing period
+ *
+ * @param p_Arg: Not used
+ *
+ */
+static void SNVMA_CoalescingTimerCallback (void * p_Arg);
+#endif /* SNVMA_WRITE_QUIET_PERIOD_MS != 0u */
+
 /* Private function prototypes -----------------------------------------------*/
 
 /**
@@ -170,6 +330,45 @@ static inline uint8_t IsHeaderOk (const uint32_t * const p_BankStartAddress, con
  */
 static inline uint8_t IsCrcOk (const uint32_t * const p_BankStartAddress);
 
+/**
+ * @brief Start the background integrity check of the bank just written
+ *
+ * @details The result is reported to SNVMA_FlashManagerCallback in the SNVMA_BANK_CHECK state
+ *
+ * @param p_BankStartAddress: Start address of the bank
+ */
+static void StartBankCheck (const uint32_t * const p_BankStartAddress);
+
+/**
+ * @brief Verify that a bank is fully erased
+ *
+ * @param p_BankStartAddress: Start address of the bank
+ * @param NvmId: Id of the NVM the bank belongs to
+ *
+ * @return State of the bank
+ * @retval TRUE: Bank is erased
+ * @retval FALSE: Bank is programmed
+ */
+static inline uint8_t IsErasedBank (const uint32_t * const p_BankStartAddress, const uint8_t NvmId);
+
+/**
+ * @brief Get the size of the buffers stored in a bank
+ *
+ * @param p_BankStartAddress: Start address of the bank - Its header shall be OK
+ *
+ * @return Size in bytes of the buffers, padding included
+ */
+static inline uint32_t GetBankPayloadSize (const uint32_t * const p_BankStartAddress);
+
+/**
+ * @brief Determine the newest bank of a NVM, based on the bank headers only
+ *
+ * @param NvmId: Id of the NVM
+ *
+ * @return Pointer onto the newest bank - NULL if no bank has a good header
+ */
+static inline SNVMA_BankElt_t * GetNewestHeaderBank (const uint8_t NvmId);
+
 /**
  * @brief Verify that the source and the destination content are the same
  *
@@ -215,6 +414,15 @@ static inline uint8_t EraseSector (const uint32_t SectorId, const uint32_t Secto
  */
 static inline FM_Cmd_Status_t StartFlashWrite (const uint8_t NvmId);
 
+/**
+ * @brief Start a full bank write sequence with the header creation and write request
+ *
+ * @param NvmId: Id of the NVM in use
+ *
+ * @return State of the flash write operation
+ */
+static inline FM_Cmd_Status_t StartBankWrite (const uint8_t NvmId);
+
 /**
  * @brief Invoke all the NVM pending buffer registered callbacks
  *
@@ -225,6 +433,217 @@ static inline FM_Cmd_Status_t StartFlashWrite (const uint8_t NvmId);
  */
 static inline void InvokeBufferCallback (const uint8_t NvmId, const SNVMA_Callback_Status_t CallbackStatus);
 
+/**
+ * @brief Complete the ongoing write operation and start the next pending one, if any
+ *
+ * @return None
+ */
+static inline void ProcessPendingRequest (void);
+
+/**
+ * @brief Start the write operation of the first pending NVM among the ones given in parameter
+ *
+ * @details The command pending flag shall be set by the caller
+ *
+ * @param NvmMask: Bitmask of the NVMs allowed to be written
+ *
+ * @return None
+ */
+static inline void StartPendingRequest (const uint32_t NvmMask);
+
+#if (SNVMA_WRITE_QUIET_PERIOD_MS != 0u)
+/**
+ * @brief Start or extend the coalescing period following a new write request
+ *
+ * @return None
+ */
+static inline void ArmCoalescingTimer (void);
+
+/**
+ * @brief Close the coalescing period and ask for the background process scheduling
+ *
+ * @return None
+ */
+static inline void CloseCoalescingPeriod (void);
+#endif /* SNVMA_WRITE_QUIET_PERIOD_MS != 0u */
+
+/**
+ * @brief Abort the ongoing write operation and notify the pending buffers
+ *
+ * @return None
+ */
+static inline void AbortFlashWrite (void);
+
+/**
+ * @brief Update the erase counters of the sector(s) given in parameter
+ *
+ * @param SectorId: First erased sector ID
+ * @param SectorNumber: Number of erased sectors
+ *
+ * @return None
+ */
+static inline void CountSectorErase (const uint32_t SectorId, const uint32_t SectorNumber);
+
+/**
+ * @brief Update the write counters of the sector(s) holding the lines given in parameter
+ *
+ * @param p_Addr: Address of the first programmed line
+ * @param LineNumber: Number of programmed lines
+ *
+ * @return None
+ */
+static inline void CountSectorWrite (const uint32_t * const p_Addr, const uint32_t LineNumber);
+
+#if (SNVMA_DELTA_LOG_ENABLE == 1u)
+/**
+ * @brief Reset the delta log of a NVM after a full bank write
+ *
+ * @param NvmId: Id of the NVM in use
+ * @param LineNumber: Number of lines used by the buffers of the bank
+ *
+ * @return None
+ */
+static inline void DeltaLogReset (const uint8_t NvmId, const uint16_t LineNumber);
+
+/**
+ * @brief Rebuild the delta log of a NVM from the bank in use
+ *
+ * @details Only committed batches are taken into account. Any inconsistency
+ *          marks the log as full so that the next write is a full bank write.
+ *
+ * @param NvmId: Id of the NVM in use
+ *
+ * @return None
+ */
+static inline void DeltaLogLoad (const uint8_t NvmId);
+
+/**
+ * @brief Apply the delta log lines of a buffer after its restoration
+ *
+ * @param NvmId: Id of the NVM in use
+ * @param BufferIdx: Index of the buffer in the NVM
+ * @param PaddingOffset: Offset of the buffer from the bank start address
+ *
+ * @return None
+ */
+static inline void DeltaLogRestore (const uint8_t NvmId,
+                                    const uint8_t BufferIdx,
+                                    const uint32_t PaddingOffset);
+
+/**
+ * @brief Check if a write request can be performed by appending delta records
+ *
+ * @param NvmId: Id of the NVM in use
+ *
+ * @return State of the check
+ * @retval TRUE: Delta write possible
+ * @retval FALSE: A full bank write is needed
+ */
+static inline uint8_t IsDeltaWritePossible (const uint8_t NvmId);
+
+/**
+ * @brief Check if a line differs between RAM and its newest copy in flash
+ *
+ * @param NvmId: Id of the NVM in use
+ * @param LineIdx: Index of the line in the bank
+ *
+ * @return Result of the comparison
+ * @retval TRUE: Line has changed
+ * @retval FALSE: Line is the same or is not part of a buffer
+ */
+static inline uint8_t IsLineChanged (const uint8_t NvmId, const uint16_t LineIdx);
+
+/**
+ * @brief Get the RAM content of a line of the bank
+ *
+ * @param NvmId: Id of the NVM in use
+ * @param LineIdx: Index of the line in the bank
+ * @param pp_Source: Address of the line in RAM
+ * @param p_WordNumber: Number of meaningful words in the line
+ *
+ * @return State of the operation
+ * @retval TRUE: Line belongs to a registered buffer
+ * @retval FALSE: Line does not belong to a registered buffer
+ */
+static inline uint8_t GetLineSource (const uint8_t NvmId,
+                                     const uint16_t LineIdx,
+                                     uint32_t ** pp_Source,
+                                     uint32_t * p_WordNumber);
+
+/**
+ * @brief Append the next modified line, or the commit record, to the delta log
+ *
+ * @param NvmId: Id of the NVM in use
+ *
+ * @return State of the flash write operation
+ */
+static inline FM_Cmd_Status_t DeltaWriteNext (const uint8_t NvmId);
+
+/**
+ * @brief Compute the CRC of a flash line
+ *
+ * @param p_Line: Address of the line
+ *
+ * @return CRC16 of the line
+ */
+static inline uint16_t ComputeLineCrc (const uint32_t * const p_Line);
+
+/**
+ * @brief Compute the CRC of a line in RAM, the unused words of a partial line being taken as erased
+ *
+ * @param p_Source: Address of the line in RAM
+ * @param WordNumber: Number of meaningful words in the line
+ *
+ * @return CRC16 of the line
+ */
+static inline uint16_t ComputeSourceLineCrc (const uint32_t * const p_Source, const uint32_t WordNumber);
+
+/**
+ * @brief Compute the CRC of a CRC table, its last word excluded
+ *
+ * @param p_Table: Address of the table
+ * @param TableLines: Size of the table in lines
+ *
+ * @return CRC16 of the table
+ */
+static inline uint16_t ComputeCrcTableCrc (const uint32_t * const p_Table, const uint16_t TableLines);
+
+/**
+ * @brief Build the CRC table of the bank to write from the registered buffers
+ *
+ * @details No table is built when the lines of the buffers do not fit in the delta log map
+ *          or when the table does not fit in the bank
+ *
+ * @param NvmId: Id of the NVM in use
+ *
+ * @return None
+ */
+static inline void BuildCrcTable (const uint8_t NvmId);
+
+/**
+ * @brief Verify the integrity of the CRC table of a bank
+ *
+ * @param p_BankStartAddress: Start address of the bank
+ * @param LineNumber: Number of lines used by the buffers of the bank
+ *
+ * @return State of the table
+ * @retval TRUE: Table is OK
+ * @retval FALSE: Table is NOK or missing
+ */
+static inline uint8_t IsCrcTableOk (const uint32_t * const p_BankStartAddress, const uint16_t LineNumber);
+
+/**
+ * @brief Check if a flash line is erased
+ *
+ * @param p_Line: Address of the line
+ *
+ * @return State of the line
+ * @retval TRUE: Line is erased
+ * @retval FALSE: Line is programmed
+ */
+static inline uint8_t IsErasedLine (const uint32_t * const p_Line);
+#endif /* SNVMA_DELTA_LOG_ENABLE == 1u */
+
 /* Functions Definition ------------------------------------------------------*/
 SNVMA_Cmd_Status_t SNVMA_Init (const uint32_t * p_NvmStartAddress)
 {
@@ -238,7 +657,9 @@ SNVMA_Cmd_Status_t SNVMA_Init (const uint32_t * p_NvmStartAddress)
 
   CRCCTRL_Cmd_Status_t crcCtrlStatus = CRCCTRL_UNKNOWN;
 
-  SNVMA_BankElt_t * p_currentRestoreBank = NULL;
+#if (SNVMA_BOOT_STATS_ENABLE == 1u)
+  uint32_t startCycle = 0x00;
+#endif /* SNVMA_BOOT_STATS_ENABLE == 1u */
 
   /* Check if not already initialized */
   if (SNVMA_ModuleInit == TRUE)
@@ -283,11 +704,25 @@ SNVMA_Cmd_Status_t SNVMA_Init (const uint32_t * p_NvmStartAddress)
       /* Compute nvm implantation offset */
       nvmOffset = (uint32_t)p_NvmStartAddress - FLASH_BASE_NS;
 
+      /* Keep the first sector in use for the activity counters */
+      SNVMA_StartSectorId = nvmOffset / FLASH_PAGE_SIZE;
+
       /* Ensure all variable are initialized: Banks */
       memset ((void *)SNVMA_BankConfiguration,
               0x00,
               (sizeof(SNVMA_BankElt_t) * SNVMA_NUMBER_OF_BANKS));
 
+      memset ((void *)&SNVMA_BootStats,
+              0x00,
+              sizeof (SNVMA_BootStats_t));
+
+#if (SNVMA_BOOT_STATS_ENABLE == 1u)
+      /* Start the cycle counter to measure the validation cost */
+      CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+      DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+      startCycle = DWT->CYCCNT;
+#endif /* SNVMA_BOOT_STATS_ENABLE == 1u */
+
       /* For each NVM */
       for (uint8_t nvmIdx = 0x00;
            (nvmIdx < SNVMA_NVM_NUMBER) && (error == SNVMA_ERROR_NOK);
@@ -311,8 +746,6 @@ SNVMA_Cmd_Status_t SNVMA_Init (const uint32_t * p_NvmStartAddress)
         }
         else
         {
-          p_currentRestoreBank = NULL;
-
           /* Get the first bank element of our NVM - Will be used as the bank list of the NVM */
           SNVMA_NvmConfiguration[nvmIdx].p_BankList = &SNVMA_BankConfiguration[bankConfIdx];
 
@@ -324,74 +757,17 @@ SNVMA_Cmd_Status_t SNVMA_Init (const uint32_t * p_NvmStartAddress)
             /* ... compute bank addresses */
             SNVMA_BankConfiguration[bankConfIdx].p_StartAddr = (uint32_t *)((uint32_t)p_NvmStartAddress + addressOffset);
 
-            /* Shall this bank be the one in use */
-            if (IsHeaderOk (SNVMA_BankConfiguration[bankConfIdx].p_StartAddr,
-                            nvmIdx) == FALSE)
+            /* Shall this bank be erased - Erased banks are left as they are */
+            if ((IsHeaderOk (SNVMA_BankConfiguration[bankConfIdx].p_StartAddr, nvmIdx) == FALSE) &&
+                (IsErasedBank (SNVMA_BankConfiguration[bankConfIdx].p_StartAddr, nvmIdx) == FALSE))
             {
               /* Erase the bank */
               while (EraseSector (((nvmOffset + addressOffset) / FLASH_PAGE_SIZE),
                                   SNVMA_NvmConfiguration[nvmIdx].BankSize) == FALSE);
 
-              LOG_ERROR_SYSTEM("\r\nSNVMA_Init - Corrupted banks erases [IsHeaderOk]");
-            }
-            /* Check if CRC OK */
-            else if (IsCrcOk (SNVMA_BankConfiguration[bankConfIdx].p_StartAddr) == FALSE)
-            {
-              /* Erase the bank */
-              while (EraseSector (((nvmOffset + addressOffset) / FLASH_PAGE_SIZE),
-                                  SNVMA_NvmConfiguration[nvmIdx].BankSize) == FALSE);
-
-              LOG_ERROR_SYSTEM("\r\nSNVMA_Init - Corrupted banks erases [IsCrcOk]");
-            }
-            /* Valid bank */
-            else
-            {
-              /* Compute buffer addresses in the bank */
-              if (SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore == NULL)
-              {
-                SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore = &SNVMA_BankConfiguration[bankConfIdx];
-              }
-              else
-              {
-                /* Get the current bank in use for this NVM */
-                p_currentRestoreBank = SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore;
-
-                /* Already have a valid bank in use, determine which bank is the newest */
-                SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore = GetNewestBank (p_currentRestoreBank,
-                                                                                &SNVMA_BankConfiguration[bankConfIdx]);
-
-                if (SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore == p_currentRestoreBank)
-                {
-                  /* Erase &SNVMA_BankConfiguration[bankConfIdx] */
-                  while (EraseSector (((nvmOffset + addressOffset) / FLASH_PAGE_SIZE),
-                                      SNVMA_NvmConfiguration[nvmIdx].BankSize) == FALSE);
-                }
-                else
-                {
-                  /* Erase p_currentRestoreBank */
-                  while (EraseSector ((((uint32_t)p_currentRestoreBank->p_StartAddr - FLASH_BASE_NS) / FLASH_PAGE_SIZE),
-                                      SNVMA_NvmConfiguration[nvmIdx].BankSize) == FALSE);
-                }
-              }
-            }
+              SNVMA_BootStats.ErasedBanks++;
 
-            /* Determine the next write bank, is there any bank for restore ? */
-            if (SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore == NULL)
-            {
-              /* The bank for write will be the first of list */
-              SNVMA_NvmConfiguration[nvmIdx].p_BankForWrite = &SNVMA_NvmConfiguration[nvmIdx].p_BankList[0];
-            }
-            /* Is the bank to restore the last one in the bank list */
-            else if (SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore ==
-                    &SNVMA_NvmConfiguration[nvmIdx].p_BankList[SNVMA_NvmConfiguration[nvmIdx].BankNumber - 1])
-            {
-              /* The bank for write will be the first of list */
-              SNVMA_NvmConfiguration[nvmIdx].p_BankForWrite = &SNVMA_NvmConfiguration[nvmIdx].p_BankList[0];
-            }
-            else
-            {
-              /* The bank for write will be the one after the restore list */
-              SNVMA_NvmConfiguration[nvmIdx].p_BankForWrite = SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore + 1;
+              LOG_ERROR_SYSTEM("\r\nSNVMA_Init - Corrupted banks erases [IsHeaderOk]");
             }
 
             /* Add the bank size to the address offset */
@@ -400,11 +776,98 @@ SNVMA_Cmd_Status_t SNVMA_Init (const uint32_t * p_NvmStartAddress)
             /* Update bank conf index */
             bankConfIdx++;
           }
+
+          /* Only the CRC of the newest bank is checked, older banks are checked if it is corrupted */
+          SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore = GetNewestHeaderBank (nvmIdx);
+
+          while ((SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore != NULL) &&
+                 (IsCrcOk (SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore->p_StartAddr) == FALSE))
+          {
+            SNVMA_BootStats.CheckedBanks++;
+            SNVMA_BootStats.CheckedBytes += GetBankPayloadSize (SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore->p_StartAddr);
+
+            /* Erase the bank */
+            while (EraseSector ((((uint32_t)SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore->p_StartAddr - FLASH_BASE_NS) /
+                                 FLASH_PAGE_SIZE),
+                                SNVMA_NvmConfiguration[nvmIdx].BankSize) == FALSE);
+
+            SNVMA_BootStats.ErasedBanks++;
+
+            LOG_ERROR_SYSTEM("\r\nSNVMA_Init - Corrupted banks erases [IsCrcOk]");
+
+            /* Fall back on the next newest bank */
+            SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore = GetNewestHeaderBank (nvmIdx);
+          }
+
+          if (SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore != NULL)
+          {
+            SNVMA_BootStats.CheckedBanks++;
+            SNVMA_BootStats.CheckedBytes += GetBankPayloadSize (SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore->p_StartAddr);
+          }
+
+          /* Erase the outdated banks */
+          for (uint8_t bankIdx = 0x00;
+              bankIdx < SNVMA_NvmConfiguration[nvmIdx].BankNumber;
+              bankIdx++)
+          {
+            if ((&SNVMA_NvmConfiguration[nvmIdx].p_BankList[bankIdx] != SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore) &&
+                (IsHeaderOk (SNVMA_NvmConfiguration[nvmIdx].p_BankList[bankIdx].p_StartAddr, nvmIdx) == TRUE))
+            {
+              while (EraseSector ((((uint32_t)SNVMA_NvmConfiguration[nvmIdx].p_BankList[bankIdx].p_StartAddr -
+                                    FLASH_BASE_NS) / FLASH_PAGE_SIZE),
+                                  SNVMA_NvmConfiguration[nvmIdx].BankSize) == FALSE);
+
+              SNVMA_BootStats.ErasedBanks++;
+            }
+          }
+
+          /* Determine the next write bank, is there any bank for restore ? */
+          if (SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore == NULL)
+          {
+            /* The bank for write will be the first of list */
+            SNVMA_NvmConfiguration[nvmIdx].p_BankForWrite = &SNVMA_NvmConfiguration[nvmIdx].p_BankList[0];
+          }
+          /* Is the bank to restore the last one in the bank list */
+          else if (SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore ==
+                  &SNVMA_NvmConfiguration[nvmIdx].p_BankList[SNVMA_NvmConfiguration[nvmIdx].BankNumber - 1])
+          {
+            /* The bank for write will be the first of list */
+            SNVMA_NvmConfiguration[nvmIdx].p_BankForWrite = &SNVMA_NvmConfiguration[nvmIdx].p_BankList[0];
+          }
+          else
+          {
+            /* The bank for write will be the one after the restore list */
+            SNVMA_NvmConfiguration[nvmIdx].p_BankForWrite = SNVMA_NvmConfiguration[nvmIdx].p_BankForRestore + 1;
+          }
+
+#if (SNVMA_DELTA_LOG_ENABLE == 1u)
+          /* Rebuild the delta log of the bank in use */
+          DeltaLogLoad (nvmIdx);
+#endif /* SNVMA_DELTA_LOG_ENABLE == 1u */
         }
       }
 
+#if (SNVMA_BOOT_STATS_ENABLE == 1u)
+      SNVMA_BootStats.Cycles = DWT->CYCCNT - startCycle;
+
+      LOG_INFO_SYSTEM("\r\nSNVMA_Init - %d banks / %d bytes checked, %d banks erased, in %d cycles",
+                      SNVMA_BootStats.CheckedBanks,
+                      SNVMA_BootStats.CheckedBytes,
+                      SNVMA_BootStats.ErasedBanks,
+                      SNVMA_BootStats.Cycles);
+#endif /* SNVMA_BOOT_STATS_ENABLE == 1u */
+
       if (error == SNVMA_ERROR_NOK)
       {
+#if (SNVMA_WRITE_QUIET_PERIOD_MS != 0u)
+        /* Create the timer of the coalescing period */
+        (void)UTIL_TIMER_Create (&SNVMA_CoalescingTimer,
+                                 SNVMA_WRITE_QUIET_PERIOD_MS,
+                                 UTIL_TIMER_ONESHOT,
+                                 &SNVMA_CoalescingTimerCallback,
+                                 NULL);
+#endif /* SNVMA_WRITE_QUIET_PERIOD_MS != 0u */
+
         /* Init is over, all OK */
         SNVMA_ModuleInit = TRUE;
 
@@ -575,17 +1038,13 @@ SNVMA_Cmd_Status_t SNVMA_Restore (const SNVMA_BufferId_t BufferId)
     /* Set that a command is pending */
     SNVMA_CommandPending = TRUE;
 
-    /* Check bank integrity - Header plausibility */
+    /* Check bank integrity - Header plausibility
+     * The CRC of the bank in use has already been checked, either by SNVMA_Init or at the end of its write operation */
     if (IsHeaderOk (SNVMA_NvmConfiguration[nvmId].p_BankForRestore->p_StartAddr,
                     nvmId) == FALSE)
     {
       error = SNVMA_ERROR_NVM_BANK_CORRUPTED;
     }
-    /* Check bank integrity - CRC value */
-    else if (IsCrcOk (SNVMA_NvmConfiguration[nvmId].p_BankForRestore->p_StartAddr) == FALSE)
-    {
-      error = SNVMA_ERROR_NVM_BANK_CORRUPTED;
-    }
     else
     {
       /* Get the bank header */
@@ -636,6 +1095,11 @@ SNVMA_Cmd_Status_t SNVMA_Restore (const SNVMA_BufferId_t BufferId)
                 (void *)p_bufferFlashAddr,
                 (SNVMA_NvmConfiguration[nvmId].a_Buffers[idxBuf].Size * sizeof (uint32_t)));
 
+#if (SNVMA_DELTA_LOG_ENABLE == 1u)
+        /* Apply the newest copies of the lines from the delta log */
+        DeltaLogRestore (nvmId, idxBuf, paddingOffset);
+#endif /* SNVMA_DELTA_LOG_ENABLE == 1u */
+
         error = SNVMA_ERROR_OK;
       }
     }
@@ -693,9 +1157,21 @@ SNVMA_Cmd_Status_t SNVMA_Write (const SNVMA_BufferId_t BufferId,
     /* ... and the callback - Can be NULL */
     SNVMA_NvmConfiguration[nvmId].a_Callback[idxBuf] = Callback;
 
+#if (SNVMA_WRITE_QUIET_PERIOD_MS != 0u)
+    /* One more request merged */
+    SNVMA_CoalescedRequests++;
+#endif /* SNVMA_WRITE_QUIET_PERIOD_MS != 0u */
+
     /* Leave critical section */
     UTILS_EXIT_CRITICAL_SECTION ();
 
+#if (SNVMA_WRITE_QUIET_PERIOD_MS != 0u)
+    /* Postpone the flash operation until the requests stop coming */
+    ArmCoalescingTimer ();
+
+    /* Request information are registered, it will dealt later on */
+    error = SNVMA_ERROR_OK;
+#else
     /* Check if there is only one operation on going */
     if (SNVMA_CommandPending == FALSE)
     {
@@ -738,10 +1214,9 @@ SNVMA_Cmd_Status_t SNVMA_Write (const SNVMA_BufferId_t BufferId,
         /* Enter critical section */
         UTILS_ENTER_CRITICAL_SECTION();
 
-        /* Flash op started */
+        /* Flash op started - Its state has been set by StartFlashWrite */
         SNVMA_FlashInfo.NvmId = nvmId;
         SNVMA_FlashInfo.BufferId = idxBuf;
-        SNVMA_FlashInfo.FlashOpState = SNVMA_HEADER_WRITE;
 
         /* Set request active */
         SNVMA_NvmConfiguration[nvmId].PendingBufferWriteOp =
@@ -760,12 +1235,153 @@ SNVMA_Cmd_Status_t SNVMA_Write (const SNVMA_BufferId_t BufferId,
       /* Request information are registered, it will dealt later on */
       error = SNVMA_ERROR_OK;
     }
+#endif /* SNVMA_WRITE_QUIET_PERIOD_MS != 0u */
   }
 
   return error;
 }
 
+SNVMA_Cmd_Status_t SNVMA_GetSectorStats (const uint32_t SectorIdx,
+                                         SNVMA_SectorStats_t * const p_Stats)
+{
+  SNVMA_Cmd_Status_t error = SNVMA_ERROR_NOK;
+
+  /* Check if initialized */
+  if (SNVMA_ModuleInit == FALSE)
+  {
+    error = SNVMA_ERROR_NOT_INIT;
+  }
+  /* Check parameters */
+  else if ((p_Stats == NULL) || (SectorIdx >= SNVMA_NUMBER_OF_SECTOR_NEEDED))
+  {
+    error = SNVMA_ERROR_NOK;
+  }
+  else
+  {
+    /* Enter critical section */
+    UTILS_ENTER_CRITICAL_SECTION();
+
+    *p_Stats = SNVMA_SectorStats[SectorIdx];
+
+    /* Leave critical section */
+    UTILS_EXIT_CRITICAL_SECTION ();
+
+    error = SNVMA_ERROR_OK;
+  }
+
+  return error;
+}
+
+SNVMA_Cmd_Status_t SNVMA_GetBootStats (SNVMA_BootStats_t * const p_Stats)
+{
+  SNVMA_Cmd_Status_t error = SNVMA_ERROR_NOK;
+
+  /* Check if initialized */
+  if (SNVMA_ModuleInit == FALSE)
+  {
+    error = SNVMA_ERROR_NOT_INIT;
+  }
+  /* Check parameter */
+  else if (p_Stats == NULL)
+  {
+    error = SNVMA_ERROR_NOK;
+  }
+  else
+  {
+    *p_Stats = SNVMA_BootStats;
+
+    error = SNVMA_ERROR_OK;
+  }
+
+  return error;
+}
+
+SNVMA_Cmd_Status_t SNVMA_Flush (void)
+{
+  SNVMA_Cmd_Status_t error = SNVMA_ERROR_NOK;
+
+  /* Check if initialized */
+  if (SNVMA_ModuleInit == FALSE)
+  {
+    error = SNVMA_ERROR_NOT_INIT;
+  }
+  /* Check if there is anything left to write */
+  else if ((SNVMA_IdBitmask == 0x00000000) && (SNVMA_CommandPending == FALSE))
+  {
+    error = SNVMA_ERROR_OK;
+  }
+  else
+  {
+#if (SNVMA_WRITE_QUIET_PERIOD_MS != 0u)
+    /* Do not wait for the end of the coalescing period */
+    if (SNVMA_CoalescingOngoing == TRUE)
+    {
+      (void)UTIL_TIMER_Stop (&SNVMA_CoalescingTimer);
+
+      CloseCoalescingPeriod ();
+    }
+#endif /* SNVMA_WRITE_QUIET_PERIOD_MS != 0u */
+
+    error = SNVMA_ERROR_CMD_PENDING;
+  }
+
+  return error;
+}
+
+void SNVMA_BackgroundProcess (void)
+{
+#if (SNVMA_WRITE_QUIET_PERIOD_MS != 0u)
+  uint8_t startWrite = FALSE;
+#endif /* SNVMA_WRITE_QUIET_PERIOD_MS != 0u */
+
+#if (SNVMA_DELTA_LOG_ENABLE == 1u)
+  /* Is there a batch without modified line to complete ? - Flag is only cleared here */
+  if (SNVMA_DeltaCompletePending == TRUE)
+  {
+    SNVMA_DeltaCompletePending = FALSE;
+
+    /* Complete the operation as if the commit had been written */
+    SNVMA_FlashManagerCallback (FM_OPERATION_COMPLETE);
+  }
+#endif /* SNVMA_DELTA_LOG_ENABLE == 1u */
+
+#if (SNVMA_WRITE_QUIET_PERIOD_MS != 0u)
+  /* Enter critical section */
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  /* Is there any NVM to write and no operation on going ? */
+  if (((SNVMA_FlushBitmask & SNVMA_IdBitmask) != 0x00000000) && (SNVMA_CommandPending == FALSE))
+  {
+    /* Set that a command is pending */
+    SNVMA_CommandPending = TRUE;
+
+    startWrite = TRUE;
+  }
+
+  /* Leave critical section */
+  UTILS_EXIT_CRITICAL_SECTION ();
+
+  if (startWrite == TRUE)
+  {
+    LOG_INFO_SYSTEM("\r\nSNVMA_BackgroundProcess - Start the write of %d merged requests", SNVMA_CoalescedRequests);
+
+    /* Start the write operation */
+    StartPendingRequest (SNVMA_FlushBitmask);
+  }
+#endif /* SNVMA_WRITE_QUIET_PERIOD_MS != 0u */
+}
+
 /* Callback Definition ------------------------------------------------------*/
+#if (SNVMA_WRITE_QUIET_PERIOD_MS != 0u)
+static void SNVMA_CoalescingTimerCallback (void * p_Arg)
+{
+  UNUSED(p_Arg);
+
+  /* Quiet period is over */
+  CloseCoalescingPeriod ();
+}
+#endif /* SNVMA_WRITE_QUIET_PERIOD_MS != 0u */
+
 void SNVMA_FlashManagerCallback(FM_FlashOp_Status_t Status)
 {
   FM_Cmd_Status_t flashFunRet = FM_ERROR;
@@ -774,6 +1390,11 @@ void SNVMA_FlashManagerCallback(FM_FlashOp_Status_t Status)
 
   static SNVMA_BankElt_t * tmpBank = NULL;
 
+#if (SNVMA_DELTA_LOG_ENABLE == 1u)
+  SNVMA_DeltaLog_t * p_deltaLog = NULL;
+  uint32_t * p_logAddr = NULL;
+#endif /* SNVMA_DELTA_LOG_ENABLE == 1u */
+
   /* Check Flash operation state */
   switch (SNVMA_FlashInfo.FlashOpState)
   {
@@ -825,6 +1446,9 @@ void SNVMA_FlashManagerCallback(FM_FlashOp_Status_t Status)
         }
         else
         {
+          /* Update activity counters */
+          CountSectorWrite (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->p_StartAddr, 1u);
+
           /* Enter critical section */
           UTILS_ENTER_CRITICAL_SECTION();
 
@@ -905,6 +1529,10 @@ void SNVMA_FlashManagerCallback(FM_FlashOp_Status_t Status)
       /* Check flash operation status */
       if (Status == FM_OPERATION_COMPLETE)
       {
+        /* Update activity counters */
+        CountSectorWrite (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->ap_BufferAddr[SNVMA_FlashInfo.BufferId],
+                          SNVMA_LINE_NUMBER (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].a_Buffers[SNVMA_FlashInfo.BufferId].Size));
+
         /* Enter critical section */
         UTILS_ENTER_CRITICAL_SECTION();
 
@@ -956,231 +1584,44 @@ void SNVMA_FlashManagerCallback(FM_FlashOp_Status_t Status)
             UTILS_EXIT_CRITICAL_SECTION ();
           }
         }
-        /* Buffer write is over */
-        else
+#if (SNVMA_DELTA_LOG_ENABLE == 1u)
+        /* Buffer write is over, pursue with the CRC table */
+        else if (SNVMA_WriteCrcTableLines != 0x00)
         {
-          /* Check the integrity of the whole write operation */
-          if (IsCrcOk (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->p_StartAddr) == FALSE)
-          {
-            /* Enter critical section */
-            UTILS_ENTER_CRITICAL_SECTION();
-
-            /* Reschedule the whole write operation but first erase the bank */
-            SNVMA_FlashInfo.FlashOpState = SNVMA_RETRY_WRITE;
-
-            /* Leave critical section */
-            UTILS_EXIT_CRITICAL_SECTION ();
-
-            flashFunRet = FM_Erase ((((uint32_t)
-                                      SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->p_StartAddr -
-                                        FLASH_BASE_NS) / FLASH_PAGE_SIZE),
-                                      SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].BankSize,
-                                      &SNVMA_FlashCallback);
-
-            /* Check flash operation */
-            if (flashFunRet == FM_ERROR)
-            {
-              /* Notify buffers callbacks */
-              InvokeBufferCallback (SNVMA_FlashInfo.NvmId, SNVMA_OPERATION_FAILED);
+          /* Enter critical section */
+          UTILS_ENTER_CRITICAL_SECTION();
 
-              /* Enter critical section */
-              UTILS_ENTER_CRITICAL_SECTION();
+          SNVMA_FlashInfo.FlashOpState = SNVMA_CRC_TABLE_WRITE;
 
-              /* Clear the NVM bitmask */
-              SNVMA_IdBitmask &= ~(1u << SNVMA_FlashInfo.NvmId);
+          /* Leave critical section */
+          UTILS_EXIT_CRITICAL_SECTION ();
 
-              /* Reset command pending flag */
-              SNVMA_CommandPending = FALSE;
+          flashFunRet = FM_Write (SNVMA_WriteCrcTable,
+                                  SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->p_StartAddr +
+                                    (SNVMA_WriteCrcTableOffset * SNVMA_LINE_WORDS),
+                                  (SNVMA_WriteCrcTableLines * SNVMA_LINE_WORDS),
+                                  &SNVMA_FlashCallback);
 
-              /* Leave critical section */
-              UTILS_EXIT_CRITICAL_SECTION ();
-            }
-          }
-          else
+          /* Check flash operation */
+          if (flashFunRet == FM_ERROR)
           {
-            /* Enter critical section */
-            UTILS_ENTER_CRITICAL_SECTION();
-
-            /* Pursue with a bank swap */
-            tmpBank = SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForRestore;
-
-            /* Make the restore bank pointing the new valid bank */
-            SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForRestore =
-              SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite;
-
-            /* Check if it is the last bank element of the list */
-            if (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite ==
-                &SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].
-                  p_BankList[(SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].BankNumber - 1)])
-            {
-              SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite =
-                &SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankList[0x00];
-            }
-            else
-            {
-              SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite++;
-            }
-
-            /* Update buffer addresses from old write bank */
-            for (uint8_t cnt = 0x00;
-                 cnt < SNVMA_MAX_NUMBER_BUFFER;
-                 cnt++)
-            {
-              if (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForRestore->ap_BufferAddr[cnt] != NULL)
-              {
-                SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->ap_BufferAddr[cnt] =
-                  SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForRestore->ap_BufferAddr[cnt] -
-                  SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForRestore->p_StartAddr +
-                  SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->p_StartAddr;
-              }
-            }
-
-            /* Leave critical section */
-            UTILS_EXIT_CRITICAL_SECTION ();
-
-            /* Erase the old restore bank */
-            if (tmpBank != NULL)
-            {
-              /* Enter critical section */
-              UTILS_ENTER_CRITICAL_SECTION();
-
-              /* Update flash operation information */
-              SNVMA_FlashInfo.FlashOpState = SNVMA_ERASE_BANK;
-
-              /* Leave critical section */
-              UTILS_EXIT_CRITICAL_SECTION ();
-
-              flashFunRet = FM_Erase ((((uint32_t)tmpBank->p_StartAddr - FLASH_BASE_NS) / FLASH_PAGE_SIZE),
-                                                  SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].BankSize,
-                                                  &SNVMA_FlashCallback);
-
-              /* Check flash operation */
-              if (flashFunRet == FM_ERROR)
-              {
-                /* Notify buffers callbacks */
-                InvokeBufferCallback (SNVMA_FlashInfo.NvmId, SNVMA_OPERATION_FAILED);
-
-                /* Enter critical section */
-                UTILS_ENTER_CRITICAL_SECTION();
+            AbortFlashWrite ();
+          }
+        }
+#endif /* SNVMA_DELTA_LOG_ENABLE == 1u */
+        /* Buffer write is over */
+        else
+        {
+          /* Enter critical section */
+          UTILS_ENTER_CRITICAL_SECTION();
 
-                /* Clear the NVM bitmask */
-                SNVMA_IdBitmask &= ~(1u << SNVMA_FlashInfo.NvmId);
+          /* Check the integrity of the whole write operation in background */
+          SNVMA_FlashInfo.FlashOpState = SNVMA_BANK_CHECK;
 
-                /* Reset command pending flag */
-                SNVMA_CommandPending = FALSE;
+          /* Leave critical section */
+          UTILS_EXIT_CRITICAL_SECTION ();
 
-                /* Leave critical section */
-                UTILS_EXIT_CRITICAL_SECTION ();
-              }
-            }
-            else
-            {
-              /* Notify buffers callbacks */
-              InvokeBufferCallback (SNVMA_FlashInfo.NvmId, SNVMA_OPERATION_COMPLETE);
-
-              /* Is there any new request ? */
-              if (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp == 0x00)
-              {
-                /* Enter critical section */
-                UTILS_ENTER_CRITICAL_SECTION();
-
-                /* No more action on this NVM, clear the NVM bitmask */
-                SNVMA_IdBitmask &= ~(1u << SNVMA_FlashInfo.NvmId);
-
-                /* Leave critical section */
-                UTILS_EXIT_CRITICAL_SECTION ();
-              }
-
-              /* Check whether there is another pending requests */
-              if (SNVMA_IdBitmask != 0x00000000)
-              {
-                /* Determine which NVM is impacted */
-                for (uint8_t cnt = 0x00;
-                     cnt < SNVMA_MAX_NUMBER_NVM;
-                     cnt++)
-                {
-                  if ((SNVMA_IdBitmask & (1u << cnt)) != 0x00)
-                  {
-                    /* Enter critical section */
-                    UTILS_ENTER_CRITICAL_SECTION();
-
-                    /* Update flash information */
-                    SNVMA_FlashInfo.NvmId = cnt;
-                    SNVMA_FlashInfo.FlashOpState = SNVMA_HEADER_WRITE;
-
-                    /* Determine which buffer is impacted */
-                    for (uint8_t idx = 0x00;
-                        idx < SNVMA_MAX_NUMBER_BUFFER;
-                        idx++)
-                    {
-                      if ((SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp & (1u << idx)) != 0x00)
-                      {
-                        SNVMA_FlashInfo.BufferId = idx;
-
-                        break;
-                      }
-                    }
-
-                    /* Leave critical section */
-                    UTILS_EXIT_CRITICAL_SECTION ();
-
-                    break;
-                  }
-                }
-
-                LOG_INFO_SYSTEM("\r\nSNVMA_FlashManagerCallback - Flash operation state : SNVMA_BUFFER_WRITE - Start the pending write operation");
-
-                /* Start the pending write operation */
-                flashFunRet = StartFlashWrite (SNVMA_FlashInfo.NvmId);
-
-                /* Check flash operation */
-                if (flashFunRet == FM_ERROR)
-                {
-                  /* Notify buffers callbacks */
-                  InvokeBufferCallback (SNVMA_FlashInfo.NvmId, SNVMA_OPERATION_FAILED);
-
-                  /* Enter critical section */
-                  UTILS_ENTER_CRITICAL_SECTION();
-
-                  /* Clear the NVM bitmask */
-                  SNVMA_IdBitmask &= ~(1u << SNVMA_FlashInfo.NvmId);
-
-                  /* Reset command pending flag */
-                  SNVMA_CommandPending = FALSE;
-
-                  /* Leave critical section */
-                  UTILS_EXIT_CRITICAL_SECTION ();
-                }
-                else
-                {
-                  /* Enter critical section */
-                  UTILS_ENTER_CRITICAL_SECTION();
-
-                  /* Set requests active */
-                  SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp |=
-                    (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp << SNVMA_MAX_NUMBER_BUFFER);
-
-                  /* Erase pendings requests */
-                  SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp &= 0xF0;
-
-                  /* Leave critical section */
-                  UTILS_EXIT_CRITICAL_SECTION ();
-                }
-              }
-              /* No more stuff to do */
-              else
-              {
-                /* Enter critical section */
-                UTILS_ENTER_CRITICAL_SECTION();
-
-                /* Reset command pending flag */
-                SNVMA_CommandPending = FALSE;
-
-                /* Leave critical section */
-                UTILS_EXIT_CRITICAL_SECTION ();
-              }
-            }
-          }
+          StartBankCheck (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->p_StartAddr);
         }
       }
       /* Status == FM_OPERATION_AVAILABLE */
@@ -1217,180 +1658,99 @@ void SNVMA_FlashManagerCallback(FM_FlashOp_Status_t Status)
       break;
     }
 
-    case SNVMA_ERASE_BANK:
+#if (SNVMA_DELTA_LOG_ENABLE == 1u)
+    case SNVMA_CRC_TABLE_WRITE:
     {
-      LOG_INFO_SYSTEM("\r\nSNVMA_FlashManagerCallback - Flash operation state : SNVMA_ERASE_BANK");
+      LOG_INFO_SYSTEM("\r\nSNVMA_FlashManagerCallback - Flash operation state : SNVMA_CRC_TABLE_WRITE");
+
+      p_logAddr = SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->p_StartAddr +
+                  (SNVMA_WriteCrcTableOffset * SNVMA_LINE_WORDS);
 
       /* Check flash operation status */
       if (Status == FM_OPERATION_COMPLETE)
       {
-        /* Notify buffers callbacks */
-        InvokeBufferCallback (SNVMA_FlashInfo.NvmId, SNVMA_OPERATION_COMPLETE);
+        /* Update activity counters */
+        CountSectorWrite (p_logAddr, SNVMA_WriteCrcTableLines);
 
-        /* Is there any new request ? */
-        if (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp == 0x00)
+        /* Check that the table has been written correctly */
+        if (IsSameContent (SNVMA_WriteCrcTable,
+                           p_logAddr,
+                           (SNVMA_WriteCrcTableLines * SNVMA_LINE_WORDS)) == FALSE)
         {
           /* Enter critical section */
           UTILS_ENTER_CRITICAL_SECTION();
 
-          /* No more action on this NVM, clear the NVM bitmask */
-          SNVMA_IdBitmask &= ~(1u << SNVMA_FlashInfo.NvmId);
+          /* Reschedule the whole write operation but first erase the bank */
+          SNVMA_FlashInfo.FlashOpState = SNVMA_RETRY_WRITE;
 
           /* Leave critical section */
           UTILS_EXIT_CRITICAL_SECTION ();
-        }
-
-        /* Check whether there is another pending requests */
-        if (SNVMA_IdBitmask != 0x00000000)
-        {
-          /* Determine which NVM is impacted */
-          for (uint8_t cnt = 0x00;
-                cnt < SNVMA_MAX_NUMBER_NVM;
-                cnt++)
-          {
-            if ((SNVMA_IdBitmask & (1u << cnt)) != 0x00)
-            {
-              /* Enter critical section */
-              UTILS_ENTER_CRITICAL_SECTION();
-
-              /* Update flash information */
-              SNVMA_FlashInfo.NvmId = cnt;
-              SNVMA_FlashInfo.FlashOpState = SNVMA_HEADER_WRITE;
-
-              /* Determine which buffer is impacted */
-              for (uint8_t idx = 0x00;
-                   idx < SNVMA_MAX_NUMBER_BUFFER;
-                   idx++)
-              {
-                if ((SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp & (1u << idx)) != 0x00)
-                {
-                  SNVMA_FlashInfo.BufferId = idx;
-
-                  break;
-                }
-              }
-
-              /* Leave critical section */
-              UTILS_EXIT_CRITICAL_SECTION ();
-
-              break;
-            }
-          }
-
-          LOG_INFO_SYSTEM("\r\nSNVMA_FlashManagerCallback - Flash operation state : SNVMA_ERASE_BANK - Start the pending write operation");
-
-          /* Start the pending write operation */
-          flashFunRet = StartFlashWrite (SNVMA_FlashInfo.NvmId);
-
-          /* Check flash operation */
-          if (flashFunRet == FM_ERROR)
-          {
-            /* Notify buffers callbacks */
-            InvokeBufferCallback (SNVMA_FlashInfo.NvmId, SNVMA_OPERATION_FAILED);
-
-            /* Enter critical section */
-            UTILS_ENTER_CRITICAL_SECTION();
-
-            /* Clear the NVM bitmask */
-            SNVMA_IdBitmask &= ~(1u << SNVMA_FlashInfo.NvmId);
-
-            /* Reset command pending flag */
-            SNVMA_CommandPending = FALSE;
-
-            /* Leave critical section */
-            UTILS_EXIT_CRITICAL_SECTION ();
-          }
-          else
-          {
-            /* Enter critical section */
-            UTILS_ENTER_CRITICAL_SECTION();
 
-            /* Set requests active */
-            SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp |=
-              (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp << SNVMA_MAX_NUMBER_BUFFER);
-
-            /* Erase pendings requests */
-            SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp &= 0xF0;
-
-            /* Leave critical section */
-            UTILS_EXIT_CRITICAL_SECTION ();
-          }
+          flashFunRet = FM_Erase ((((uint32_t)
+                                    SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->p_StartAddr -
+                                      FLASH_BASE_NS) / FLASH_PAGE_SIZE),
+                                    SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].BankSize,
+                                    &SNVMA_FlashCallback);
         }
-        /* No more stuff to do */
         else
         {
           /* Enter critical section */
           UTILS_ENTER_CRITICAL_SECTION();
 
-          /* Reset command pending flag */
-          SNVMA_CommandPending = FALSE;
+          /* Check the integrity of the whole write operation in background */
+          SNVMA_FlashInfo.FlashOpState = SNVMA_BANK_CHECK;
 
           /* Leave critical section */
           UTILS_EXIT_CRITICAL_SECTION ();
+
+          flashFunRet = FM_OK;
+
+          StartBankCheck (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->p_StartAddr);
         }
       }
       /* Status == FM_OPERATION_AVAILABLE */
       else
       {
-        flashFunRet = FM_Erase ((((uint32_t)tmpBank->p_StartAddr - FLASH_PAGE_SIZE) / FLASH_PAGE_SIZE),
-                                            SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].BankSize,
-                                            &SNVMA_FlashCallback);
-
-        /* Check flash operation */
-        if (flashFunRet == FM_ERROR)
-        {
-          /* Notify buffers callbacks */
-          InvokeBufferCallback (SNVMA_FlashInfo.NvmId, SNVMA_OPERATION_FAILED);
+        LOG_INFO_SYSTEM("\r\nSNVMA_FlashManagerCallback - Flash operation state : SNVMA_CRC_TABLE_WRITE - Retry write operation");
 
-          /* Enter critical section */
-          UTILS_ENTER_CRITICAL_SECTION();
-
-          /* Clear the NVM bitmask */
-          SNVMA_IdBitmask &= ~(1u << SNVMA_FlashInfo.NvmId);
-
-         /* Reset command pending flag */
-          SNVMA_CommandPending = FALSE;
+        /* Retry the table write */
+        flashFunRet = FM_Write (SNVMA_WriteCrcTable,
+                                p_logAddr,
+                                (SNVMA_WriteCrcTableLines * SNVMA_LINE_WORDS),
+                                &SNVMA_FlashCallback);
+      }
 
-          /* Leave critical section */
-          UTILS_EXIT_CRITICAL_SECTION ();
-        }
+      /* Check flash operation */
+      if (flashFunRet == FM_ERROR)
+      {
+        AbortFlashWrite ();
       }
 
       break;
     }
+#endif /* SNVMA_DELTA_LOG_ENABLE == 1u */
 
-    case SNVMA_RETRY_WRITE:
+    case SNVMA_BANK_CHECK:
     {
-      LOG_INFO_SYSTEM("\r\nSNVMA_FlashManagerCallback - Flash operation state : SNVMA_RETRY_WRITE");
+      LOG_INFO_SYSTEM("\r\nSNVMA_FlashManagerCallback - Flash operation state : SNVMA_BANK_CHECK");
 
-      /* Check flash operation status */
-      if (Status == FM_OPERATION_COMPLETE)
+      /* Check the integrity of the whole write operation */
+      if (SNVMA_BankCheckOk == FALSE)
       {
         /* Enter critical section */
         UTILS_ENTER_CRITICAL_SECTION();
 
-        /* Erase OK, restart the write from the start */
-        SNVMA_FlashInfo.FlashOpState = SNVMA_HEADER_WRITE;
-
-        /* Determine which buffer is impacted */
-        for (uint8_t idx = 0x00;
-              idx < SNVMA_MAX_NUMBER_BUFFER;
-              idx++)
-        {
-          if ((SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp & (1u << idx)) != 0x00)
-          {
-
-            SNVMA_FlashInfo.BufferId = idx;
-
-            break;
-          }
-        }
+        /* Reschedule the whole write operation but first erase the bank */
+        SNVMA_FlashInfo.FlashOpState = SNVMA_RETRY_WRITE;
 
         /* Leave critical section */
         UTILS_EXIT_CRITICAL_SECTION ();
 
-        /* Retry write operation of the header */
-        flashFunRet = StartFlashWrite (SNVMA_FlashInfo.NvmId);
+        flashFunRet = FM_Erase ((((uint32_t)
+                                  SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->p_StartAddr -
+                                    FLASH_BASE_NS) / FLASH_PAGE_SIZE),
+                                  SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].BankSize,
+                                  &SNVMA_FlashCallback);
 
         /* Check flash operation */
         if (flashFunRet == FM_ERROR)
@@ -1410,14 +1770,210 @@ void SNVMA_FlashManagerCallback(FM_FlashOp_Status_t Status)
           /* Leave critical section */
           UTILS_EXIT_CRITICAL_SECTION ();
         }
-        else
-        {
-          /* Enter critical section */
-          UTILS_ENTER_CRITICAL_SECTION();
+      }
+      else
+      {
+        /* Enter critical section */
+        UTILS_ENTER_CRITICAL_SECTION();
 
-          /* Set requests active */
-          SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp |=
-            (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp << SNVMA_MAX_NUMBER_BUFFER);
+        /* Pursue with a bank swap */
+        tmpBank = SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForRestore;
+
+        /* Make the restore bank pointing the new valid bank */
+        SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForRestore =
+          SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite;
+
+        /* Check if it is the last bank element of the list */
+        if (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite ==
+            &SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].
+              p_BankList[(SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].BankNumber - 1)])
+        {
+          SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite =
+            &SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankList[0x00];
+        }
+        else
+        {
+          SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite++;
+        }
+
+        /* Update buffer addresses from old write bank */
+        for (uint8_t cnt = 0x00;
+             cnt < SNVMA_MAX_NUMBER_BUFFER;
+             cnt++)
+        {
+          if (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForRestore->ap_BufferAddr[cnt] != NULL)
+          {
+            SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->ap_BufferAddr[cnt] =
+              SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForRestore->ap_BufferAddr[cnt] -
+              SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForRestore->p_StartAddr +
+              SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->p_StartAddr;
+          }
+        }
+
+#if (SNVMA_DELTA_LOG_ENABLE == 1u)
+        /* The new bank in use starts with an empty delta log */
+        DeltaLogReset (SNVMA_FlashInfo.NvmId,
+                       (uint16_t)(SNVMA_LINE_NUMBER (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].a_Buffers[0x00].Size) +
+                                  SNVMA_LINE_NUMBER (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].a_Buffers[0x01].Size) +
+                                  SNVMA_LINE_NUMBER (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].a_Buffers[0x02].Size) +
+                                  SNVMA_LINE_NUMBER (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].a_Buffers[0x03].Size)));
+#endif /* SNVMA_DELTA_LOG_ENABLE == 1u */
+
+        /* Leave critical section */
+        UTILS_EXIT_CRITICAL_SECTION ();
+
+        /* Erase the old restore bank */
+        if (tmpBank != NULL)
+        {
+          /* Enter critical section */
+          UTILS_ENTER_CRITICAL_SECTION();
+
+          /* Update flash operation information */
+          SNVMA_FlashInfo.FlashOpState = SNVMA_ERASE_BANK;
+
+          /* Leave critical section */
+          UTILS_EXIT_CRITICAL_SECTION ();
+
+          flashFunRet = FM_Erase ((((uint32_t)tmpBank->p_StartAddr - FLASH_BASE_NS) / FLASH_PAGE_SIZE),
+                                              SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].BankSize,
+                                              &SNVMA_FlashCallback);
+
+          /* Check flash operation */
+          if (flashFunRet == FM_ERROR)
+          {
+            /* Notify buffers callbacks */
+            InvokeBufferCallback (SNVMA_FlashInfo.NvmId, SNVMA_OPERATION_FAILED);
+
+            /* Enter critical section */
+            UTILS_ENTER_CRITICAL_SECTION();
+
+            /* Clear the NVM bitmask */
+            SNVMA_IdBitmask &= ~(1u << SNVMA_FlashInfo.NvmId);
+
+            /* Reset command pending flag */
+            SNVMA_CommandPending = FALSE;
+
+            /* Leave critical section */
+            UTILS_EXIT_CRITICAL_SECTION ();
+          }
+        }
+        else
+        {
+          /* Notify buffers callbacks and start the pending write operation, if any */
+          ProcessPendingRequest ();
+        }
+      }
+      break;
+    }
+
+    case SNVMA_ERASE_BANK:
+    {
+      LOG_INFO_SYSTEM("\r\nSNVMA_FlashManagerCallback - Flash operation state : SNVMA_ERASE_BANK");
+
+      /* Check flash operation status */
+      if (Status == FM_OPERATION_COMPLETE)
+      {
+        /* Update activity counters */
+        CountSectorErase ((((uint32_t)tmpBank->p_StartAddr - FLASH_BASE_NS) / FLASH_PAGE_SIZE),
+                          SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].BankSize);
+
+        /* Notify buffers callbacks and start the pending write operation, if any */
+        ProcessPendingRequest ();
+      }
+      /* Status == FM_OPERATION_AVAILABLE */
+      else
+      {
+        flashFunRet = FM_Erase ((((uint32_t)tmpBank->p_StartAddr - FLASH_BASE_NS) / FLASH_PAGE_SIZE),
+                                            SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].BankSize,
+                                            &SNVMA_FlashCallback);
+
+        /* Check flash operation */
+        if (flashFunRet == FM_ERROR)
+        {
+          /* Notify buffers callbacks */
+          InvokeBufferCallback (SNVMA_FlashInfo.NvmId, SNVMA_OPERATION_FAILED);
+
+          /* Enter critical section */
+          UTILS_ENTER_CRITICAL_SECTION();
+
+          /* Clear the NVM bitmask */
+          SNVMA_IdBitmask &= ~(1u << SNVMA_FlashInfo.NvmId);
+
+         /* Reset command pending flag */
+          SNVMA_CommandPending = FALSE;
+
+          /* Leave critical section */
+          UTILS_EXIT_CRITICAL_SECTION ();
+        }
+      }
+
+      break;
+    }
+
+    case SNVMA_RETRY_WRITE:
+    {
+      LOG_INFO_SYSTEM("\r\nSNVMA_FlashManagerCallback - Flash operation state : SNVMA_RETRY_WRITE");
+
+      /* Check flash operation status */
+      if (Status == FM_OPERATION_COMPLETE)
+      {
+        /* Update activity counters */
+        CountSectorErase ((((uint32_t)SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->p_StartAddr -
+                            FLASH_BASE_NS) / FLASH_PAGE_SIZE),
+                          SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].BankSize);
+
+        /* Enter critical section */
+        UTILS_ENTER_CRITICAL_SECTION();
+
+        /* Erase OK, restart the write from the start */
+        SNVMA_FlashInfo.FlashOpState = SNVMA_HEADER_WRITE;
+
+        /* Determine which buffer is impacted */
+        for (uint8_t idx = 0x00;
+              idx < SNVMA_MAX_NUMBER_BUFFER;
+              idx++)
+        {
+          if ((SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp & (1u << idx)) != 0x00)
+          {
+
+            SNVMA_FlashInfo.BufferId = idx;
+
+            break;
+          }
+        }
+
+        /* Leave critical section */
+        UTILS_EXIT_CRITICAL_SECTION ();
+
+        /* Retry write operation of the header */
+        flashFunRet = StartFlashWrite (SNVMA_FlashInfo.NvmId);
+
+        /* Check flash operation */
+        if (flashFunRet == FM_ERROR)
+        {
+          /* Notify buffers callbacks */
+          InvokeBufferCallback (SNVMA_FlashInfo.NvmId, SNVMA_OPERATION_FAILED);
+
+          /* Enter critical section */
+          UTILS_ENTER_CRITICAL_SECTION();
+
+          /* Clear the NVM bitmask */
+          SNVMA_IdBitmask &= ~(1u << SNVMA_FlashInfo.NvmId);
+
+          /* Reset command pending flag */
+          SNVMA_CommandPending = FALSE;
+
+          /* Leave critical section */
+          UTILS_EXIT_CRITICAL_SECTION ();
+        }
+        else
+        {
+          /* Enter critical section */
+          UTILS_ENTER_CRITICAL_SECTION();
+
+          /* Set requests active */
+          SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp |=
+            (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp << SNVMA_MAX_NUMBER_BUFFER);
 
           /* Erase pendings requests */
           SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp &= 0xF0;
@@ -1433,7 +1989,7 @@ void SNVMA_FlashManagerCallback(FM_FlashOp_Status_t Status)
 
         /* Retry erase operation */
         flashFunRet = FM_Erase ((((uint32_t)SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForWrite->p_StartAddr -
-                                            FLASH_PAGE_SIZE) / FLASH_PAGE_SIZE),
+                                            FLASH_BASE_NS) / FLASH_PAGE_SIZE),
                                             SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].BankSize,
                                             &SNVMA_FlashCallback);
 
@@ -1460,6 +2016,159 @@ void SNVMA_FlashManagerCallback(FM_FlashOp_Status_t Status)
       break;
     }
 
+#if (SNVMA_DELTA_LOG_ENABLE == 1u)
+    case SNVMA_DELTA_WRITE:
+    {
+      LOG_INFO_SYSTEM("\r\nSNVMA_FlashManagerCallback - Flash operation state : SNVMA_DELTA_WRITE");
+
+      p_deltaLog = &SNVMA_DeltaLog[SNVMA_FlashInfo.NvmId];
+      p_logAddr = SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForRestore->p_StartAddr +
+                  (p_deltaLog->LogOffset * SNVMA_LINE_WORDS);
+
+      /* Check flash operation status */
+      if (Status == FM_OPERATION_COMPLETE)
+      {
+        /* Update activity counters */
+        CountSectorWrite (p_logAddr, (sizeof (SNVMA_DeltaRecord_t) / SNVMA_LINE_SIZE));
+
+        /* Check that the record has been written correctly */
+        if (IsSameContent ((uint32_t *)&SNVMA_WriteDeltaRecord,
+                           p_logAddr,
+                           (sizeof (SNVMA_DeltaRecord_t) / sizeof (uint32_t))) == FALSE)
+        {
+          LOG_ERROR_SYSTEM("\r\nSNVMA_FlashManagerCallback - Delta record corrupted, fall back on a bank write");
+
+          /* Enter critical section */
+          UTILS_ENTER_CRITICAL_SECTION();
+
+          /* The log can't be trusted anymore, the whole bank has to be rewritten */
+          p_deltaLog->LogOffset = p_deltaLog->LogEnd;
+
+          /* Leave critical section */
+          UTILS_EXIT_CRITICAL_SECTION ();
+
+          flashFunRet = StartFlashWrite (SNVMA_FlashInfo.NvmId);
+        }
+        else
+        {
+          /* Enter critical section */
+          UTILS_ENTER_CRITICAL_SECTION();
+
+          /* The newest copy of the line is now the one of the record */
+          p_deltaLog->a_LineMap[p_deltaLog->CurrentLine] = p_deltaLog->LogOffset + 1u;
+          p_deltaLog->LogOffset += (sizeof (SNVMA_DeltaRecord_t) / SNVMA_LINE_SIZE);
+          p_deltaLog->BatchLines++;
+          p_deltaLog->CurrentLine++;
+
+          /* Leave critical section */
+          UTILS_EXIT_CRITICAL_SECTION ();
+
+          /* Pursue with the next modified line */
+          flashFunRet = DeltaWriteNext (SNVMA_FlashInfo.NvmId);
+        }
+      }
+      /* Status == FM_OPERATION_AVAILABLE */
+      else
+      {
+        LOG_INFO_SYSTEM("\r\nSNVMA_FlashManagerCallback - Flash operation state : SNVMA_DELTA_WRITE - Retry write operation");
+
+        /* Retry the record write */
+        flashFunRet = FM_Write ((uint32_t *)&SNVMA_WriteDeltaRecord,
+                                p_logAddr,
+                                (sizeof (SNVMA_DeltaRecord_t) / sizeof (uint32_t)),
+                                &SNVMA_FlashCallback);
+      }
+
+      /* Check flash operation */
+      if (flashFunRet == FM_ERROR)
+      {
+        AbortFlashWrite ();
+      }
+
+      break;
+    }
+
+    case SNVMA_DELTA_COMMIT:
+    {
+      LOG_INFO_SYSTEM("\r\nSNVMA_FlashManagerCallback - Flash operation state : SNVMA_DELTA_COMMIT");
+
+      p_deltaLog = &SNVMA_DeltaLog[SNVMA_FlashInfo.NvmId];
+      p_logAddr = SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].p_BankForRestore->p_StartAddr +
+                  (p_deltaLog->LogOffset * SNVMA_LINE_WORDS);
+
+      /* Check flash operation status */
+      if (Status == FM_OPERATION_COMPLETE)
+      {
+        /* Nothing has been appended when no line has changed, completion is reported by the background process */
+        if (p_deltaLog->BatchLines == 0x00)
+        {
+          flashFunRet = FM_OK;
+
+          ProcessPendingRequest ();
+        }
+        /* Check that the commit record has been written correctly */
+        else if (IsSameContent ((uint32_t *)&SNVMA_WriteDeltaRecord.Header,
+                                p_logAddr,
+                                (sizeof (SNVMA_DeltaHeader_t) / sizeof (uint32_t))) == FALSE)
+        {
+          LOG_ERROR_SYSTEM("\r\nSNVMA_FlashManagerCallback - Commit record corrupted, fall back on a bank write");
+
+          CountSectorWrite (p_logAddr, 1u);
+
+          /* Enter critical section */
+          UTILS_ENTER_CRITICAL_SECTION();
+
+          /* The log can't be trusted anymore, the whole bank has to be rewritten */
+          p_deltaLog->LogOffset = p_deltaLog->LogEnd;
+
+          /* Leave critical section */
+          UTILS_EXIT_CRITICAL_SECTION ();
+
+          flashFunRet = StartFlashWrite (SNVMA_FlashInfo.NvmId);
+        }
+        else
+        {
+          CountSectorWrite (p_logAddr, 1u);
+
+          /* Enter critical section */
+          UTILS_ENTER_CRITICAL_SECTION();
+
+          /* Batch is committed */
+          p_deltaLog->LogOffset++;
+          p_deltaLog->Batch++;
+
+          /* Leave critical section */
+          UTILS_EXIT_CRITICAL_SECTION ();
+
+          LOG_INFO_SYSTEM("\r\nSNVMA_FlashManagerCallback - Delta batch committed, lines : %d", p_deltaLog->BatchLines);
+
+          flashFunRet = FM_OK;
+
+          ProcessPendingRequest ();
+        }
+      }
+      /* Status == FM_OPERATION_AVAILABLE */
+      else
+      {
+        LOG_INFO_SYSTEM("\r\nSNVMA_FlashManagerCallback - Flash operation state : SNVMA_DELTA_COMMIT - Retry write operation");
+
+        /* Retry the commit write */
+        flashFunRet = FM_Write ((uint32_t *)&SNVMA_WriteDeltaRecord.Header,
+                                p_logAddr,
+                                (sizeof (SNVMA_DeltaHeader_t) / sizeof (uint32_t)),
+                                &SNVMA_FlashCallback);
+      }
+
+      /* Check flash operation */
+      if (flashFunRet == FM_ERROR)
+      {
+        AbortFlashWrite ();
+      }
+
+      break;
+    }
+#endif /* SNVMA_DELTA_LOG_ENABLE == 1u */
+
     default:
     {
       /* Do nothing */
@@ -1468,6 +2177,24 @@ void SNVMA_FlashManagerCallback(FM_FlashOp_Status_t Status)
   }
 }
 
+void SNVMA_CrcJobCallback (CRCCTRL_Job_t * const p_Job)
+{
+  /* Compare the CRC values */
+  if ((CRCCTRL_OK == p_Job->Status) && (p_Job->ComputedValue == SNVMA_BankCheckCrc))
+  {
+    SNVMA_BankCheckOk = TRUE;
+  }
+  else
+  {
+    SNVMA_BankCheckOk = FALSE;
+  }
+
+  LOG_INFO_SYSTEM("\r\nEnd of CRC job, value : %d", p_Job->ComputedValue);
+
+  /* Pursue the write operation */
+  SNVMA_FlashManagerCallback (FM_OPERATION_COMPLETE);
+}
+
 /* Private functions Definition ------------------------------------------------------*/
 
 uint8_t IsHeaderOk (const uint32_t * const p_BankStartAddress, const uint8_t NvmId)
@@ -1685,9 +2412,101 @@ uint8_t IsCrcOk (const uint32_t * const p_BankStartAddress)
   return error;
 }
 
-uint8_t IsSameContent (uint32_t * p_Source, uint32_t * p_Destination, uint32_t Size)
+void StartBankCheck (const uint32_t * const p_BankStartAddress)
 {
-  uint8_t error = TRUE;
+  const SNVMA_BankHeader_t * p_header = (const SNVMA_BankHeader_t *)p_BankStartAddress;
+  const uint32_t a_size[SNVMA_MAX_NUMBER_BUFFER] = {p_header->SizeId1,
+                                                    p_header->SizeId2,
+                                                    p_header->SizeId3,
+                                                    p_header->SizeId4};
+  uint32_t payloadAddr = (uint32_t)(p_BankStartAddress) + sizeof (SNVMA_BankHeader_t);
+  uint8_t segmentNumber = 0x00;
+
+  /* Gather the buffers of the bank, in the order used for the CRC computation */
+  for (uint8_t cnt = 0x00; cnt < SNVMA_MAX_NUMBER_BUFFER; cnt++)
+  {
+    if (0x00 != a_size[cnt])
+    {
+      SNVMA_CrcSegments[segmentNumber].p_Data = (const void *)payloadAddr;
+      SNVMA_CrcSegments[segmentNumber].Size = a_size[cnt];
+      segmentNumber++;
+
+      payloadAddr += SNVMA_ALIGN_128(a_size[cnt] * sizeof (uint32_t));
+    }
+  }
+
+  SNVMA_BankCheckCrc = p_header->Crc;
+
+  SNVMA_CrcJob.p_Handle = &SNVMA_Handle;
+  SNVMA_CrcJob.a_Segments = SNVMA_CrcSegments;
+  SNVMA_CrcJob.SegmentNumber = segmentNumber;
+  SNVMA_CrcJob.Accumulate = FALSE;
+  SNVMA_CrcJob.Callback = SNVMA_CrcJobCallback;
+
+  LOG_INFO_SYSTEM("\r\nStart of CRC job");
+
+  if ((0x00 == segmentNumber) || (CRCCTRL_OK != CRCCTRL_SubmitJob (&SNVMA_CrcJob)))
+  {
+    /* Fall back on the blocking check */
+    SNVMA_BankCheckOk = IsCrcOk (p_BankStartAddress);
+
+    SNVMA_FlashManagerCallback (FM_OPERATION_COMPLETE);
+  }
+}
+
+uint8_t IsErasedBank (const uint32_t * const p_BankStartAddress, const uint8_t NvmId)
+{
+  uint8_t error = TRUE;
+
+  /* Blank check is much faster than an erase */
+  for (uint32_t cnt = 0x00;
+       (cnt < ((SNVMA_NvmConfiguration[NvmId].BankSize * FLASH_PAGE_SIZE) / sizeof (uint32_t))) && (error == TRUE);
+       cnt++)
+  {
+    if (p_BankStartAddress[cnt] != 0xFFFFFFFFu)
+    {
+      error = FALSE;
+    }
+  }
+
+  return error;
+}
+
+uint32_t GetBankPayloadSize (const uint32_t * const p_BankStartAddress)
+{
+  return (SNVMA_ALIGN_128(((SNVMA_BankHeader_t *)p_BankStartAddress)->SizeId1 * sizeof (uint32_t)) +
+          SNVMA_ALIGN_128(((SNVMA_BankHeader_t *)p_BankStartAddress)->SizeId2 * sizeof (uint32_t)) +
+          SNVMA_ALIGN_128(((SNVMA_BankHeader_t *)p_BankStartAddress)->SizeId3 * sizeof (uint32_t)) +
+          SNVMA_ALIGN_128(((SNVMA_BankHeader_t *)p_BankStartAddress)->SizeId4 * sizeof (uint32_t)));
+}
+
+SNVMA_BankElt_t * GetNewestHeaderBank (const uint8_t NvmId)
+{
+  SNVMA_BankElt_t * error = NULL;
+
+  for (uint8_t bankIdx = 0x00;
+       bankIdx < SNVMA_NvmConfiguration[NvmId].BankNumber;
+       bankIdx++)
+  {
+    if (IsHeaderOk (SNVMA_NvmConfiguration[NvmId].p_BankList[bankIdx].p_StartAddr, NvmId) == TRUE)
+    {
+      if (error == NULL)
+      {
+        error = &SNVMA_NvmConfiguration[NvmId].p_BankList[bankIdx];
+      }
+      else
+      {
+        error = GetNewestBank (error, &SNVMA_NvmConfiguration[NvmId].p_BankList[bankIdx]);
+      }
+    }
+  }
+
+  return error;
+}
+
+uint8_t IsSameContent (uint32_t * p_Source, uint32_t * p_Destination, uint32_t Size)
+{
+  uint8_t error = TRUE;
 
   /* Compare both contents */
   for (uint32_t cnt = 0x00;
@@ -1750,6 +2569,9 @@ uint8_t EraseSector (const uint32_t SectorId, const uint32_t SectorNumber)
   }
   else
   {
+    /* Update activity counters */
+    CountSectorErase (SectorId, SectorNumber);
+
     error = TRUE;
   }
 
@@ -1759,6 +2581,35 @@ uint8_t EraseSector (const uint32_t SectorId, const uint32_t SectorNumber)
 }
 
 FM_Cmd_Status_t StartFlashWrite (const uint8_t NvmId)
+{
+  FM_Cmd_Status_t error = FM_ERROR;
+
+#if (SNVMA_DELTA_LOG_ENABLE == 1u)
+  /* Only append the modified lines when the bank in use has enough room left */
+  if (IsDeltaWritePossible (NvmId) == TRUE)
+  {
+    /* Enter critical section */
+    UTILS_ENTER_CRITICAL_SECTION();
+
+    /* Start a new batch from the first line */
+    SNVMA_DeltaLog[NvmId].CurrentLine = 0x00;
+    SNVMA_DeltaLog[NvmId].BatchLines = 0x00;
+
+    /* Leave critical section */
+    UTILS_EXIT_CRITICAL_SECTION ();
+
+    error = DeltaWriteNext (NvmId);
+  }
+  else
+#endif /* SNVMA_DELTA_LOG_ENABLE == 1u */
+  {
+    error = StartBankWrite (NvmId);
+  }
+
+  return error;
+}
+
+FM_Cmd_Status_t StartBankWrite (const uint8_t NvmId)
 {
   FM_Cmd_Status_t error = FM_ERROR;
 
@@ -1850,9 +2701,17 @@ FM_Cmd_Status_t StartFlashWrite (const uint8_t NvmId)
   SNVMA_WriteBankHeader.BufferId4 = (NvmId * SNVMA_MAX_NUMBER_BUFFER) + 3u;
   SNVMA_WriteBankHeader.SizeId4 = SNVMA_NvmConfiguration[NvmId].a_Buffers[0x03].Size;
 
+  /* Full bank write starts with the header */
+  SNVMA_FlashInfo.FlashOpState = SNVMA_HEADER_WRITE;
+
   /* Leave critical section */
   UTILS_EXIT_CRITICAL_SECTION ();
 
+#if (SNVMA_DELTA_LOG_ENABLE == 1u)
+  /* The CRC table is written after the buffers, from the same content as the bank CRC */
+  BuildCrcTable (NvmId);
+#endif /* SNVMA_DELTA_LOG_ENABLE == 1u */
+
   /* Write the header */
   error = FM_Write ((uint32_t *)&SNVMA_WriteBankHeader,
                                 SNVMA_NvmConfiguration[NvmId].p_BankForWrite->p_StartAddr,
@@ -1914,3 +2773,799 @@ void InvokeBufferCallback (const uint8_t NvmId, const SNVMA_Callback_Status_t Ca
     }
   }
 }
+
+void ProcessPendingRequest (void)
+{
+  /* Notify buffers callbacks */
+  InvokeBufferCallback (SNVMA_FlashInfo.NvmId, SNVMA_OPERATION_COMPLETE);
+
+  /* Is there any new request ? */
+  if (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp == 0x00)
+  {
+    /* Enter critical section */
+    UTILS_ENTER_CRITICAL_SECTION();
+
+    /* No more action on this NVM, clear the NVM bitmask */
+    SNVMA_IdBitmask &= ~(1u << SNVMA_FlashInfo.NvmId);
+
+    /* Leave critical section */
+    UTILS_EXIT_CRITICAL_SECTION ();
+  }
+
+#if (SNVMA_WRITE_QUIET_PERIOD_MS != 0u)
+  /* Check whether there is another pending request whose coalescing period is over */
+  if ((SNVMA_IdBitmask & SNVMA_FlushBitmask) != 0x00000000)
+  {
+    StartPendingRequest (SNVMA_FlushBitmask);
+  }
+#else
+  /* Check whether there is another pending requests */
+  if (SNVMA_IdBitmask != 0x00000000)
+  {
+    StartPendingRequest (0xFFFFFFFFu);
+  }
+#endif /* SNVMA_WRITE_QUIET_PERIOD_MS != 0u */
+  /* No more stuff to do */
+  else
+  {
+    /* Enter critical section */
+    UTILS_ENTER_CRITICAL_SECTION();
+
+    /* Reset command pending flag */
+    SNVMA_CommandPending = FALSE;
+
+    /* Leave critical section */
+    UTILS_EXIT_CRITICAL_SECTION ();
+  }
+}
+
+void StartPendingRequest (const uint32_t NvmMask)
+{
+  FM_Cmd_Status_t flashFunRet = FM_ERROR;
+
+  /* Determine which NVM is impacted */
+  for (uint8_t cnt = 0x00;
+        cnt < SNVMA_MAX_NUMBER_NVM;
+        cnt++)
+  {
+    if ((SNVMA_IdBitmask & NvmMask & (1u << cnt)) != 0x00)
+    {
+      /* Enter critical section */
+      UTILS_ENTER_CRITICAL_SECTION();
+
+      /* Update flash information */
+      SNVMA_FlashInfo.NvmId = cnt;
+      SNVMA_FlashInfo.FlashOpState = SNVMA_HEADER_WRITE;
+
+      /* Determine which buffer is impacted */
+      for (uint8_t idx = 0x00;
+           idx < SNVMA_MAX_NUMBER_BUFFER;
+           idx++)
+      {
+        if ((SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp & (1u << idx)) != 0x00)
+        {
+          SNVMA_FlashInfo.BufferId = idx;
+
+          break;
+        }
+      }
+
+#if (SNVMA_WRITE_QUIET_PERIOD_MS != 0u)
+      /* Requests coming from now on will wait for a new coalescing period */
+      SNVMA_FlushBitmask &= ~(1u << cnt);
+      SNVMA_CoalescedRequests = 0x00;
+#endif /* SNVMA_WRITE_QUIET_PERIOD_MS != 0u */
+
+      /* Set requests active */
+      SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp |=
+        (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp << SNVMA_MAX_NUMBER_BUFFER);
+
+      /* Erase pendings requests */
+      SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp &= 0xF0;
+
+      /* Leave critical section */
+      UTILS_EXIT_CRITICAL_SECTION ();
+
+      break;
+    }
+  }
+
+  LOG_INFO_SYSTEM("\r\nStartPendingRequest - Start the pending write operation");
+
+  /* Start the pending write operation */
+  flashFunRet = StartFlashWrite (SNVMA_FlashInfo.NvmId);
+
+  /* Check flash operation */
+  if (flashFunRet == FM_ERROR)
+  {
+    /* Notify buffers callbacks */
+    InvokeBufferCallback (SNVMA_FlashInfo.NvmId, SNVMA_OPERATION_FAILED);
+
+    /* Enter critical section */
+    UTILS_ENTER_CRITICAL_SECTION();
+
+    /* Clear the NVM bitmask, unless a callback has already asked for a retry */
+    if (SNVMA_NvmConfiguration[SNVMA_FlashInfo.NvmId].PendingBufferWriteOp == 0x00)
+    {
+      SNVMA_IdBitmask &= ~(1u << SNVMA_FlashInfo.NvmId);
+    }
+
+    /* Reset command pending flag */
+    SNVMA_CommandPending = FALSE;
+
+    /* Leave critical section */
+    UTILS_EXIT_CRITICAL_SECTION ();
+  }
+}
+
+#if (SNVMA_WRITE_QUIET_PERIOD_MS != 0u)
+void ArmCoalescingTimer (void)
+{
+  uint32_t elapsedTime = 0x00;
+  uint32_t quietPeriod = SNVMA_WRITE_QUIET_PERIOD_MS;
+
+  /* Enter critical section */
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  /* Is it the first request of the burst ? */
+  if (SNVMA_CoalescingOngoing == FALSE)
+  {
+    SNVMA_CoalescingOngoing = TRUE;
+    SNVMA_CoalescingStartTime = UTIL_TIMER_GetCurrentTime ();
+  }
+  else
+  {
+    elapsedTime = UTIL_TIMER_GetElapsedTime (SNVMA_CoalescingStartTime);
+
+    /* Do not exceed the maximum delay of the burst */
+    if (elapsedTime >= SNVMA_WRITE_MAX_DELAY_MS)
+    {
+      quietPeriod = 0x00;
+    }
+    else if ((SNVMA_WRITE_MAX_DELAY_MS - elapsedTime) < quietPeriod)
+    {
+      quietPeriod = SNVMA_WRITE_MAX_DELAY_MS - elapsedTime;
+    }
+  }
+
+  /* Leave critical section */
+  UTILS_EXIT_CRITICAL_SECTION ();
+
+  if (quietPeriod == 0x00)
+  {
+    /* Maximum delay reached, write now */
+    (void)UTIL_TIMER_Stop (&SNVMA_CoalescingTimer);
+
+    CloseCoalescingPeriod ();
+  }
+  else
+  {
+    /* (Re)start the quiet period */
+    (void)UTIL_TIMER_StartWithPeriod (&SNVMA_CoalescingTimer, quietPeriod);
+  }
+}
+
+void CloseCoalescingPeriod (void)
+{
+  /* Enter critical section */
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  /* All the NVMs requested so far can be written */
+  SNVMA_FlushBitmask |= SNVMA_IdBitmask;
+  SNVMA_CoalescingOngoing = FALSE;
+
+  /* Leave critical section */
+  UTILS_EXIT_CRITICAL_SECTION ();
+
+  /* Ask for background process scheduling */
+  SNVMA_ProcessRequest ();
+}
+#endif /* SNVMA_WRITE_QUIET_PERIOD_MS != 0u */
+
+void AbortFlashWrite (void)
+{
+  /* Notify buffers callbacks */
+  InvokeBufferCallback (SNVMA_FlashInfo.NvmId, SNVMA_OPERATION_FAILED);
+
+  /* Enter critical section */
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  /* Clear the NVM bitmask */
+  SNVMA_IdBitmask &= ~(1u << SNVMA_FlashInfo.NvmId);
+
+  /* Reset command pending flag */
+  SNVMA_CommandPending = FALSE;
+
+  /* Leave critical section */
+  UTILS_EXIT_CRITICAL_SECTION ();
+}
+
+void CountSectorErase (const uint32_t SectorId, const uint32_t SectorNumber)
+{
+  /* Enter critical section */
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  for (uint32_t cnt = 0x00;
+       cnt < SectorNumber;
+       cnt++)
+  {
+    /* Only sectors of the NVMs are tracked */
+    if (((SectorId + cnt) >= SNVMA_StartSectorId) &&
+        ((SectorId + cnt - SNVMA_StartSectorId) < SNVMA_NUMBER_OF_SECTOR_NEEDED))
+    {
+      SNVMA_SectorStats[SectorId + cnt - SNVMA_StartSectorId].EraseCount++;
+    }
+  }
+
+  /* Leave critical section */
+  UTILS_EXIT_CRITICAL_SECTION ();
+}
+
+void CountSectorWrite (const uint32_t * const p_Addr, const uint32_t LineNumber)
+{
+  uint32_t sectorId = 0x00;
+
+  /* Enter critical section */
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  for (uint32_t cnt = 0x00;
+       cnt < LineNumber;
+       cnt++)
+  {
+    sectorId = ((uint32_t)p_Addr + (cnt * SNVMA_LINE_SIZE) - FLASH_BASE_NS) / FLASH_PAGE_SIZE;
+
+    /* Only sectors of the NVMs are tracked */
+    if ((sectorId >= SNVMA_StartSectorId) &&
+        ((sectorId - SNVMA_StartSectorId) < SNVMA_NUMBER_OF_SECTOR_NEEDED))
+    {
+      SNVMA_SectorStats[sectorId - SNVMA_StartSectorId].WriteCount++;
+    }
+  }
+
+  /* Leave critical section */
+  UTILS_EXIT_CRITICAL_SECTION ();
+}
+
+#if (SNVMA_DELTA_LOG_ENABLE == 1u)
+void DeltaLogReset (const uint8_t NvmId, const uint16_t LineNumber)
+{
+  SNVMA_DeltaLog_t * p_deltaLog = &SNVMA_DeltaLog[NvmId];
+
+  /* Clean the log information */
+  memset ((void *)p_deltaLog,
+          0x00,
+          sizeof (SNVMA_DeltaLog_t));
+
+  /* Log starts right after the header, the buffers and the CRC table, and ends with the bank */
+  p_deltaLog->LogOffset = LineNumber + 1u + SNVMA_CRC_TABLE_LINES (LineNumber);
+  p_deltaLog->LogEnd = (uint16_t)((SNVMA_NvmConfiguration[NvmId].BankSize * FLASH_PAGE_SIZE) / SNVMA_LINE_SIZE);
+
+  /* Check that the log can be used - Map large enough and room left for at least one batch */
+  if ((LineNumber != 0x00) &&
+      (LineNumber <= SNVMA_DELTA_MAX_LINES) &&
+      ((p_deltaLog->LogOffset + (sizeof (SNVMA_DeltaRecord_t) / SNVMA_LINE_SIZE)) < p_deltaLog->LogEnd))
+  {
+    p_deltaLog->LineNumber = LineNumber;
+  }
+}
+
+void DeltaLogLoad (const uint8_t NvmId)
+{
+  SNVMA_DeltaLog_t * p_deltaLog = &SNVMA_DeltaLog[NvmId];
+  SNVMA_BankHeader_t * p_bankHeader = NULL;
+  SNVMA_DeltaHeader_t * p_record = NULL;
+  uint32_t * p_bankStart = NULL;
+
+  uint16_t offset = 0x00;
+  uint16_t batchStart = 0x00;
+  uint16_t batchLines = 0x00;
+  uint16_t batch = 0x00;
+  uint8_t scanOver = FALSE;
+  uint8_t logOk = TRUE;
+
+  /* Nothing to load without bank in use */
+  if (SNVMA_NvmConfiguration[NvmId].p_BankForRestore == NULL)
+  {
+    DeltaLogReset (NvmId, 0x00);
+  }
+  else
+  {
+    p_bankStart = SNVMA_NvmConfiguration[NvmId].p_BankForRestore->p_StartAddr;
+    p_bankHeader = (SNVMA_BankHeader_t *)p_bankStart;
+
+    DeltaLogReset (NvmId,
+                   (uint16_t)(SNVMA_LINE_NUMBER (p_bankHeader->SizeId1) +
+                              SNVMA_LINE_NUMBER (p_bankHeader->SizeId2) +
+                              SNVMA_LINE_NUMBER (p_bankHeader->SizeId3) +
+                              SNVMA_LINE_NUMBER (p_bankHeader->SizeId4)));
+
+    offset = p_deltaLog->LogOffset;
+    batchStart = offset;
+
+    /* Change detection relies on the CRC table, it shall be sound */
+    if ((p_deltaLog->LineNumber != 0x00) &&
+        (IsCrcTableOk (p_bankStart, p_deltaLog->LineNumber) == FALSE))
+    {
+      logOk = FALSE;
+      scanOver = TRUE;
+    }
+
+    /* Go through the records until the first erased line */
+    while ((p_deltaLog->LineNumber != 0x00) && (offset < p_deltaLog->LogEnd) && (scanOver == FALSE))
+    {
+      p_record = (SNVMA_DeltaHeader_t *)(p_bankStart + (offset * SNVMA_LINE_WORDS));
+
+      if (IsErasedLine ((uint32_t *)p_record) == TRUE)
+      {
+        scanOver = TRUE;
+      }
+      /* Line record of the ongoing batch */
+      else if ((p_record->Tag == SNVMA_DELTA_LINE_TAG) &&
+               (p_record->Counter == p_bankHeader->Counter) &&
+               (p_record->LineIdx < p_deltaLog->LineNumber) &&
+               ((batchLines == 0x00) || (p_record->Batch == batch)) &&
+               ((offset + 1u) < p_deltaLog->LogEnd) &&
+               (p_record->Crc == ComputeLineCrc (p_bankStart + ((offset + 1u) * SNVMA_LINE_WORDS))))
+      {
+        batch = p_record->Batch;
+        batchLines++;
+        offset += (sizeof (SNVMA_DeltaRecord_t) / SNVMA_LINE_SIZE);
+      }
+      /* Commit record of the ongoing batch */
+      else if ((p_record->Tag == SNVMA_DELTA_COMMIT_TAG) &&
+               (p_record->Counter == p_bankHeader->Counter) &&
+               (batchLines != 0x00) &&
+               (p_record->Batch == batch) &&
+               (p_record->LineIdx == batchLines))
+      {
+        /* Apply the lines of the batch */
+        for (uint16_t recordOffset = batchStart;
+             recordOffset < offset;
+             recordOffset += (sizeof (SNVMA_DeltaRecord_t) / SNVMA_LINE_SIZE))
+        {
+          p_deltaLog->a_LineMap[((SNVMA_DeltaHeader_t *)(p_bankStart + (recordOffset * SNVMA_LINE_WORDS)))->LineIdx] =
+            recordOffset + 1u;
+        }
+
+        p_deltaLog->Batch = batch + 1u;
+
+        offset++;
+        batchStart = offset;
+        batchLines = 0x00;
+      }
+      else
+      {
+        logOk = FALSE;
+        scanOver = TRUE;
+      }
+    }
+
+    /* A torn or unknown record has been found, force a full bank write on next request */
+    if ((logOk == FALSE) || (batchLines != 0x00))
+    {
+      p_deltaLog->LogOffset = p_deltaLog->LogEnd;
+
+      LOG_ERROR_SYSTEM("\r\nSNVMA_Init - Delta log of NVM %d not valid, next write rewrites the bank", NvmId);
+    }
+    else
+    {
+      p_deltaLog->LogOffset = offset;
+    }
+  }
+}
+
+void DeltaLogRestore (const uint8_t NvmId, const uint8_t BufferIdx, const uint32_t PaddingOffset)
+{
+  SNVMA_DeltaLog_t * p_deltaLog = &SNVMA_DeltaLog[NvmId];
+  uint32_t firstLine = (PaddingOffset - sizeof (SNVMA_BankHeader_t)) / SNVMA_LINE_SIZE;
+  uint32_t wordNumber = 0x00;
+
+  for (uint32_t line = 0x00;
+       (p_deltaLog->LineNumber != 0x00) &&
+       (line < SNVMA_LINE_NUMBER (SNVMA_NvmConfiguration[NvmId].a_Buffers[BufferIdx].Size));
+       line++)
+  {
+    /* Is there a newer copy of the line in the log ? */
+    if (p_deltaLog->a_LineMap[firstLine + line] != 0x00)
+    {
+      wordNumber = SNVMA_NvmConfiguration[NvmId].a_Buffers[BufferIdx].Size - (line * SNVMA_LINE_WORDS);
+
+      if (wordNumber > SNVMA_LINE_WORDS)
+      {
+        wordNumber = SNVMA_LINE_WORDS;
+      }
+
+      memcpy ((void *)(SNVMA_NvmConfiguration[NvmId].a_Buffers[BufferIdx].p_Addr + (line * SNVMA_LINE_WORDS)),
+              (void *)(SNVMA_NvmConfiguration[NvmId].p_BankForRestore->p_StartAddr +
+                       (p_deltaLog->a_LineMap[firstLine + line] * SNVMA_LINE_WORDS)),
+              (wordNumber * sizeof (uint32_t)));
+    }
+  }
+}
+
+uint8_t IsDeltaWritePossible (const uint8_t NvmId)
+{
+  uint8_t error = FALSE;
+
+  SNVMA_DeltaLog_t * p_deltaLog = &SNVMA_DeltaLog[NvmId];
+  SNVMA_BankHeader_t * p_bankHeader = NULL;
+  uint32_t neededLines = 0x00;
+
+  /* Is the log usable and not full ? */
+  if ((p_deltaLog->LineNumber == 0x00) ||
+      (p_deltaLog->LogOffset >= p_deltaLog->LogEnd) ||
+      (SNVMA_NvmConfiguration[NvmId].p_BankForRestore == NULL))
+  {
+    error = FALSE;
+  }
+  else
+  {
+    p_bankHeader = (SNVMA_BankHeader_t *)SNVMA_NvmConfiguration[NvmId].p_BankForRestore->p_StartAddr;
+
+    /* Buffers layout shall be the same as the one of the bank in use */
+    if ((p_bankHeader->SizeId1 != SNVMA_NvmConfiguration[NvmId].a_Buffers[0x00].Size) ||
+        (p_bankHeader->SizeId2 != SNVMA_NvmConfiguration[NvmId].a_Buffers[0x01].Size) ||
+        (p_bankHeader->SizeId3 != SNVMA_NvmConfiguration[NvmId].a_Buffers[0x02].Size) ||
+        (p_bankHeader->SizeId4 != SNVMA_NvmConfiguration[NvmId].a_Buffers[0x03].Size))
+    {
+      error = FALSE;
+    }
+    else
+    {
+      /* Count the modified lines */
+      for (uint16_t line = 0x00;
+           line < p_deltaLog->LineNumber;
+           line++)
+      {
+        if (IsLineChanged (NvmId, line) == TRUE)
+        {
+          neededLines += (sizeof (SNVMA_DeltaRecord_t) / SNVMA_LINE_SIZE);
+        }
+      }
+
+      /* Add the commit record */
+      if (neededLines != 0x00)
+      {
+        neededLines++;
+      }
+
+      /* Check there is enough room left for the whole batch */
+      if (neededLines <= (uint32_t)(p_deltaLog->LogEnd - p_deltaLog->LogOffset))
+      {
+        error = TRUE;
+      }
+
+      LOG_INFO_SYSTEM("\r\nSNVMA - Delta lines needed : %d, room left : %d",
+                      neededLines, (p_deltaLog->LogEnd - p_deltaLog->LogOffset));
+    }
+  }
+
+  return error;
+}
+
+uint8_t IsLineChanged (const uint8_t NvmId, const uint16_t LineIdx)
+{
+  uint8_t error = FALSE;
+
+  uint32_t * p_source = NULL;
+  uint32_t * p_flash = NULL;
+  uint32_t * p_bankStart = SNVMA_NvmConfiguration[NvmId].p_BankForRestore->p_StartAddr;
+  uint32_t wordNumber = 0x00;
+  uint16_t flashCrc = 0x00;
+
+  if (GetLineSource (NvmId, LineIdx, &p_source, &wordNumber) == TRUE)
+  {
+    /* Get the newest copy of the line and its CRC - From its log record or from the buffer area and the CRC table */
+    if (SNVMA_DeltaLog[NvmId].a_LineMap[LineIdx] != 0x00)
+    {
+      p_flash = p_bankStart + (SNVMA_DeltaLog[NvmId].a_LineMap[LineIdx] * SNVMA_LINE_WORDS);
+      flashCrc = ((SNVMA_DeltaHeader_t *)(p_flash - SNVMA_LINE_WORDS))->Crc;
+    }
+    else
+    {
+      p_flash = p_bankStart + ((LineIdx + 1u) * SNVMA_LINE_WORDS);
+      flashCrc = ((uint16_t *)(p_bankStart + ((SNVMA_DeltaLog[NvmId].LineNumber + 1u) * SNVMA_LINE_WORDS)))[LineIdx];
+    }
+
+    /* Different CRCs prove a change, equal CRCs are confirmed on the content as a CRC16 can collide */
+    if ((ComputeSourceLineCrc (p_source, wordNumber) != flashCrc) ||
+        (IsSameContent (p_source, p_flash, wordNumber) == FALSE))
+    {
+      error = TRUE;
+    }
+  }
+
+  return error;
+}
+
+uint8_t GetLineSource (const uint8_t NvmId,
+                       const uint16_t LineIdx,
+                       uint32_t ** pp_Source,
+                       uint32_t * p_WordNumber)
+{
+  uint8_t error = FALSE;
+
+  uint32_t firstLine = 0x00;
+  uint32_t lineNumber = 0x00;
+
+  for (uint8_t cnt = 0x00;
+       (cnt < SNVMA_MAX_NUMBER_BUFFER) && (error == FALSE);
+       cnt++)
+  {
+    lineNumber = SNVMA_LINE_NUMBER (SNVMA_NvmConfiguration[NvmId].a_Buffers[cnt].Size);
+
+    /* Does the line belong to this buffer ? */
+    if ((SNVMA_NvmConfiguration[NvmId].a_Buffers[cnt].p_Addr != NULL) &&
+        (LineIdx >= firstLine) && (LineIdx < (firstLine + lineNumber)))
+    {
+      *pp_Source = SNVMA_NvmConfiguration[NvmId].a_Buffers[cnt].p_Addr + ((LineIdx - firstLine) * SNVMA_LINE_WORDS);
+      *p_WordNumber = SNVMA_NvmConfiguration[NvmId].a_Buffers[cnt].Size - ((LineIdx - firstLine) * SNVMA_LINE_WORDS);
+
+      /* Last line of a buffer can be partially used */
+      if (*p_WordNumber > SNVMA_LINE_WORDS)
+      {
+        *p_WordNumber = SNVMA_LINE_WORDS;
+      }
+
+      error = TRUE;
+    }
+
+    firstLine += lineNumber;
+  }
+
+  return error;
+}
+
+FM_Cmd_Status_t DeltaWriteNext (const uint8_t NvmId)
+{
+  FM_Cmd_Status_t error = FM_ERROR;
+
+  SNVMA_DeltaLog_t * p_deltaLog = &SNVMA_DeltaLog[NvmId];
+  uint32_t * p_bankStart = SNVMA_NvmConfiguration[NvmId].p_BankForRestore->p_StartAddr;
+  uint32_t * p_source = NULL;
+  uint32_t wordNumber = 0x00;
+  uint16_t line = p_deltaLog->CurrentLine;
+
+  /* Search for the next modified line */
+  while ((line < p_deltaLog->LineNumber) && (IsLineChanged (NvmId, line) == FALSE))
+  {
+    line++;
+  }
+
+  /* Enter critical section */
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  /* Prepare the record header */
+  memset ((void *)&SNVMA_WriteDeltaRecord,
+          0x00,
+          sizeof (SNVMA_DeltaRecord_t));
+
+  SNVMA_WriteDeltaRecord.Header.Counter = ((SNVMA_BankHeader_t *)p_bankStart)->Counter;
+  SNVMA_WriteDeltaRecord.Header.Batch = p_deltaLog->Batch;
+
+  /* Leave critical section */
+  UTILS_EXIT_CRITICAL_SECTION ();
+
+  if (line < p_deltaLog->LineNumber)
+  {
+    /* Buffer content may have grown since the request, check there is still room for the record and the commit */
+    if ((p_deltaLog->LogOffset + (sizeof (SNVMA_DeltaRecord_t) / SNVMA_LINE_SIZE)) >= p_deltaLog->LogEnd)
+    {
+      /* Enter critical section */
+      UTILS_ENTER_CRITICAL_SECTION();
+
+      /* Log is full, the whole bank has to be rewritten */
+      p_deltaLog->LogOffset = p_deltaLog->LogEnd;
+
+      /* Leave critical section */
+      UTILS_EXIT_CRITICAL_SECTION ();
+
+      error = StartBankWrite (NvmId);
+    }
+    else
+    {
+      (void)GetLineSource (NvmId, line, &p_source, &wordNumber);
+
+      /* Enter critical section */
+      UTILS_ENTER_CRITICAL_SECTION();
+
+      /* Build the line record - Unused words of a partial line are left erased */
+      memset ((void *)SNVMA_WriteDeltaRecord.a_Data,
+              0xFF,
+              sizeof (SNVMA_WriteDeltaRecord.a_Data));
+
+      memcpy ((void *)SNVMA_WriteDeltaRecord.a_Data,
+              (void *)p_source,
+              (wordNumber * sizeof (uint32_t)));
+
+      SNVMA_WriteDeltaRecord.Header.Tag = SNVMA_DELTA_LINE_TAG;
+      SNVMA_WriteDeltaRecord.Header.LineIdx = line;
+
+      p_deltaLog->CurrentLine = line;
+
+      SNVMA_FlashInfo.FlashOpState = SNVMA_DELTA_WRITE;
+
+      /* Leave critical section */
+      UTILS_EXIT_CRITICAL_SECTION ();
+
+      SNVMA_WriteDeltaRecord.Header.Crc = ComputeLineCrc (SNVMA_WriteDeltaRecord.a_Data);
+
+      error = FM_Write ((uint32_t *)&SNVMA_WriteDeltaRecord,
+                        p_bankStart + (p_deltaLog->LogOffset * SNVMA_LINE_WORDS),
+                        (sizeof (SNVMA_DeltaRecord_t) / sizeof (uint32_t)),
+                        &SNVMA_FlashCallback);
+    }
+  }
+  else
+  {
+    /* Enter critical section */
+    UTILS_ENTER_CRITICAL_SECTION();
+
+    /* All modified lines are written, commit the batch */
+    SNVMA_WriteDeltaRecord.Header.Tag = SNVMA_DELTA_COMMIT_TAG;
+    SNVMA_WriteDeltaRecord.Header.LineIdx = p_deltaLog->BatchLines;
+
+    SNVMA_FlashInfo.FlashOpState = SNVMA_DELTA_COMMIT;
+
+    /* Nothing to commit if no line has changed, the flash is left untouched */
+    if (p_deltaLog->BatchLines == 0x00)
+    {
+      SNVMA_DeltaCompletePending = TRUE;
+    }
+
+    /* Leave critical section */
+    UTILS_EXIT_CRITICAL_SECTION ();
+
+    if (p_deltaLog->BatchLines == 0x00)
+    {
+      LOG_INFO_SYSTEM("\r\nDeltaWriteNext - No line modified, no flash operation needed");
+
+      /* Report the completion from the background process, out of the caller context */
+      SNVMA_ProcessRequest ();
+
+      error = FM_OK;
+    }
+    else
+    {
+      error = FM_Write ((uint32_t *)&SNVMA_WriteDeltaRecord.Header,
+                        p_bankStart + (p_deltaLog->LogOffset * SNVMA_LINE_WORDS),
+                        (sizeof (SNVMA_DeltaHeader_t) / sizeof (uint32_t)),
+                        &SNVMA_FlashCallback);
+    }
+  }
+
+  return error;
+}
+
+uint16_t ComputeLineCrc (const uint32_t * const p_Line)
+{
+  uint32_t crcValue = 0x00;
+  CRCCTRL_Cmd_Status_t eReturn = CRCCTRL_BUSY;
+
+  while (CRCCTRL_BUSY == eReturn)
+  {
+    eReturn = CRCCTRL_Calculate (&SNVMA_Handle,
+                                 (uint32_t *)p_Line,
+                                 SNVMA_LINE_WORDS,
+                                 &crcValue);
+  }
+
+  if (CRCCTRL_OK != eReturn)
+  {
+    Error_Handler();
+  }
+
+  return (uint16_t)(crcValue & 0x0000FFFF);
+}
+
+uint16_t ComputeSourceLineCrc (const uint32_t * const p_Source, const uint32_t WordNumber)
+{
+  uint32_t a_line[SNVMA_LINE_WORDS];
+
+  /* Same content as the one of a delta record */
+  memset ((void *)a_line,
+          0xFF,
+          sizeof (a_line));
+
+  memcpy ((void *)a_line,
+          (void *)p_Source,
+          (WordNumber * sizeof (uint32_t)));
+
+  return ComputeLineCrc (a_line);
+}
+
+uint16_t ComputeCrcTableCrc (const uint32_t * const p_Table, const uint16_t TableLines)
+{
+  uint32_t crcValue = 0x00;
+  CRCCTRL_Cmd_Status_t eReturn = CRCCTRL_BUSY;
+
+  while (CRCCTRL_BUSY == eReturn)
+  {
+    eReturn = CRCCTRL_Calculate (&SNVMA_Handle,
+                                 (uint32_t *)p_Table,
+                                 ((TableLines * SNVMA_LINE_WORDS) - 1u),
+                                 &crcValue);
+  }
+
+  if (CRCCTRL_OK != eReturn)
+  {
+    Error_Handler();
+  }
+
+  return (uint16_t)(crcValue & 0x0000FFFF);
+}
+
+void BuildCrcTable (const uint8_t NvmId)
+{
+  uint16_t * p_entry = (uint16_t *)SNVMA_WriteCrcTable;
+  uint32_t * p_source = NULL;
+  uint32_t wordNumber = 0x00;
+  uint16_t lineNumber = (uint16_t)(SNVMA_LINE_NUMBER (SNVMA_NvmConfiguration[NvmId].a_Buffers[0x00].Size) +
+                                   SNVMA_LINE_NUMBER (SNVMA_NvmConfiguration[NvmId].a_Buffers[0x01].Size) +
+                                   SNVMA_LINE_NUMBER (SNVMA_NvmConfiguration[NvmId].a_Buffers[0x02].Size) +
+                                   SNVMA_LINE_NUMBER (SNVMA_NvmConfiguration[NvmId].a_Buffers[0x03].Size));
+
+  SNVMA_WriteCrcTableOffset = lineNumber + 1u;
+  SNVMA_WriteCrcTableLines = 0x00;
+
+  /* Is there a table to write ? */
+  if ((lineNumber != 0x00) &&
+      (lineNumber <= SNVMA_DELTA_MAX_LINES) &&
+      ((SNVMA_WriteCrcTableOffset + SNVMA_CRC_TABLE_LINES (lineNumber)) <=
+       ((SNVMA_NvmConfiguration[NvmId].BankSize * FLASH_PAGE_SIZE) / SNVMA_LINE_SIZE)))
+  {
+    SNVMA_WriteCrcTableLines = SNVMA_CRC_TABLE_LINES (lineNumber);
+
+    /* Unused entries are left erased */
+    memset ((void *)SNVMA_WriteCrcTable,
+            0xFF,
+            sizeof (SNVMA_WriteCrcTable));
+
+    for (uint16_t line = 0x00;
+         line < lineNumber;
+         line++)
+    {
+      (void)GetLineSource (NvmId, line, &p_source, &wordNumber);
+
+      p_entry[line] = ComputeSourceLineCrc (p_source, wordNumber);
+    }
+
+    /* Protect the table itself */
+    SNVMA_WriteCrcTable[(SNVMA_WriteCrcTableLines * SNVMA_LINE_WORDS) - 1u] =
+      ComputeCrcTableCrc (SNVMA_WriteCrcTable, SNVMA_WriteCrcTableLines);
+  }
+}
+
+uint8_t IsCrcTableOk (const uint32_t * const p_BankStartAddress, const uint16_t LineNumber)
+{
+  uint8_t error = FALSE;
+
+  const uint32_t * p_table = p_BankStartAddress + ((LineNumber + 1u) * SNVMA_LINE_WORDS);
+
+  /* Banks written without table hold erased lines or delta records there */
+  if (p_table[(SNVMA_CRC_TABLE_LINES (LineNumber) * SNVMA_LINE_WORDS) - 1u] ==
+      (uint32_t)ComputeCrcTableCrc (p_table, SNVMA_CRC_TABLE_LINES (LineNumber)))
+  {
+    error = TRUE;
+  }
+
+  return error;
+}
+
+uint8_t IsErasedLine (const uint32_t * const p_Line)
+{
+  uint8_t error = TRUE;
+
+  for (uint32_t cnt = 0x00;
+       (cnt < SNVMA_LINE_WORDS) && (error == TRUE);
+       cnt++)
+  {
+    if (p_Line[cnt] != 0xFFFFFFFFu)
+    {
+      error = FALSE;
+    }
+  }
+
+  return error;
+}
+#endif /* SNVMA_DELTA_LOG_ENABLE == 1u */
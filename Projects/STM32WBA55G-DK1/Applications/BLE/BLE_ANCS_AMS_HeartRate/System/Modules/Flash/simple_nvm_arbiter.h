@@ -111,6 +111,10 @@ SNVMA_Cmd_Status_t SNVMA_Restore (const SNVMA_BufferId_t BufferId);
  * @details A buffer write request cannot be scheduled once its NVM is already on a write operation. This will lead
  *          to a SNVMA_OPERATION_FAILED callback status.
  *
+ * @details When SNVMA_WRITE_QUIET_PERIOD_MS is not null, the flash operation is postponed until no new request
+ *          has come for the quiet period, or SNVMA_WRITE_MAX_DELAY_MS is reached. Requests on the same buffer
+ *          are merged and the callback is invoked once the merged operation is over.
+ *
  * @param BufferId: Id of the user which ask for buffer registration
  * @param Callback: Callback function for operation status return - Can be NULL
  *
@@ -125,6 +129,69 @@ SNVMA_Cmd_Status_t SNVMA_Restore (const SNVMA_BufferId_t BufferId);
 SNVMA_Cmd_Status_t SNVMA_Write (const SNVMA_BufferId_t BufferId,
                                 void (* Callback) (SNVMA_Callback_Status_t));
 
+/**
+ * @brief  Get the flash activity counters of a sector managed by the Simple NVM Arbiter
+ *
+ * @details Counters are kept in RAM and are cleared on reset, they only reflect the
+ *          activity since boot and are not meant to drive any wear levelling
+ *
+ * @param SectorIdx: Index of the sector, relative to the NVM start address
+ * @param p_Stats: Pointer onto the statistics to fill
+ *
+ * @return Status of the command
+ * @retval SNVMA_Cmd_Status_t::SNVMA_ERROR_OK
+ * @retval SNVMA_Cmd_Status_t::SNVMA_ERROR_NOK
+ * @retval SNVMA_Cmd_Status_t::SNVMA_ERROR_NOT_INIT
+ */
+SNVMA_Cmd_Status_t SNVMA_GetSectorStats (const uint32_t SectorIdx,
+                                         SNVMA_SectorStats_t * const p_Stats);
+
+/**
+ * @brief  Get the cost of the NVM validation done by SNVMA_Init
+ *
+ * @details Only the newest bank of each NVM has its CRC checked, older banks are only checked
+ *          when the newest one is corrupted
+ *
+ * @param p_Stats: Pointer onto the statistics to fill
+ *
+ * @return Status of the command
+ * @retval SNVMA_Cmd_Status_t::SNVMA_ERROR_OK
+ * @retval SNVMA_Cmd_Status_t::SNVMA_ERROR_NOK
+ * @retval SNVMA_Cmd_Status_t::SNVMA_ERROR_NOT_INIT
+ */
+SNVMA_Cmd_Status_t SNVMA_GetBootStats (SNVMA_BootStats_t * const p_Stats);
+
+/**
+ * @brief  Apply the postponed write requests without waiting for the end of the quiet period
+ *
+ * @details To be used on a disconnection, on a bond update and before a reset or a standby entry.
+ *          The flash operation is started by SNVMA_BackgroundProcess and its end is notified through
+ *          the buffer callbacks.
+ *
+ * @return Status of the command
+ * @retval SNVMA_Cmd_Status_t::SNVMA_ERROR_OK - No write operation left
+ * @retval SNVMA_Cmd_Status_t::SNVMA_ERROR_NOT_INIT
+ * @retval SNVMA_Cmd_Status_t::SNVMA_ERROR_CMD_PENDING - Write operation scheduled or on going
+ */
+SNVMA_Cmd_Status_t SNVMA_Flush (void);
+
+/**
+ * @brief  Background process of the Simple NVM Arbiter
+ *
+ * @details Starts the write operations whose coalescing period is over and reports the end
+ *          of the write requests that left the flash untouched
+ *
+ */
+void SNVMA_BackgroundProcess (void);
+
+/**
+ * @brief  Request the scheduling of SNVMA_BackgroundProcess - Implemented by the user
+ *
+ * @details May be called under interrupt context
+ *
+ */
+void SNVMA_ProcessRequest (void);
+
 #ifdef __cplusplus
 }
 #endif
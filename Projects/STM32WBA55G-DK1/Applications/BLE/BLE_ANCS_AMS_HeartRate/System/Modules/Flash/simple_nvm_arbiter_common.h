@@ -76,6 +76,28 @@ typedef enum SNVMA_Callback_Status
   SNVMA_OPERATION_FAILED
 }SNVMA_Callback_Status_t;
 
+/* Sector flash activity counters, since boot */
+typedef struct SNVMA_SectorStats
+{
+  /* Number of erase cycles applied on the sector */
+  uint32_t EraseCount;
+  /* Number of 128 bits lines programmed in the sector */
+  uint32_t WriteCount;
+}SNVMA_SectorStats_t;
+
+/* NVM validation statistics of the init */
+typedef struct SNVMA_BootStats
+{
+  /* Number of banks whose CRC has been checked */
+  uint32_t CheckedBanks;
+  /* Number of bytes whose CRC has been checked */
+  uint32_t CheckedBytes;
+  /* Number of banks erased */
+  uint32_t ErasedBanks;
+  /* Duration of the validation in CPU cycles - 0 when not measured */
+  uint32_t Cycles;
+}SNVMA_BootStats_t;
+
 /* Buffer Element */
 typedef struct SNVMA_BufferElt
 {
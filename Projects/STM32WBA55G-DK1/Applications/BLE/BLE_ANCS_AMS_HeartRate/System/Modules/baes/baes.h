@@ -34,6 +34,7 @@
  *
  * Notes:
  *   - only 128-bit key is supported
+ *   - the CMAC subkey is kept until the CMAC key changes
  *   - re-entrance is not supported
  */
 
@@ -48,6 +49,13 @@ extern void BAES_EcbCrypt( const uint8_t* key,
                            uint8_t* output,
                            int enc );
 
+/* Processes "nb" consecutive 16-byte blocks with the same key */
+extern void BAES_EcbCryptBlocks( const uint8_t* key,
+                                 const uint8_t* input,
+                                 uint8_t* output,
+                                 uint32_t nb,
+                                 int enc );
+
 /* AES CMAC interface */
 
 extern void BAES_CmacSetKey( const uint8_t* key );
@@ -56,4 +64,19 @@ extern void BAES_CmacCompute( const uint8_t* input,
                               uint32_t size,
                               uint8_t* output );
 
+/* Statistics interface */
+
+typedef struct
+{
+  uint32_t blocks;         /* Blocks processed */
+  uint32_t key_loads;      /* AES key loads or key schedules */
+  uint32_t cmac_key_hits;  /* CMAC keys set again, subkey reused */
+  uint64_t cycles;         /* CPU cycles spent in the module (DWT) */
+
+} BAES_STATS_T;
+
+extern void BAES_GetStats( BAES_STATS_T* stats );
+
+extern void BAES_LogStats( void );
+
 #endif /* BAES_H__ */
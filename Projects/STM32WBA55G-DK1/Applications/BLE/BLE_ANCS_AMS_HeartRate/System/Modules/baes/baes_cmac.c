@@ -25,6 +25,9 @@
 typedef struct
 {
   uint32_t iv[4];          /* Temporary result/IV */
+  uint32_t key[4];         /* Key of the subkey below */
+  uint32_t k1[4];          /* Subkey K1 */
+  int      valid;
 
 #if CFG_BAES_SW != 0
 
@@ -75,6 +78,8 @@ static void BAES_CmacRawEncrypt( const uint32_t* input,
   BAES_RawEncrypt( input, output, av->exp_key );
 
 #endif /* CFG_BAES_SW != 0 */
+
+  BAES_stats.blocks++;
 }
 
 /*****************************************************************************/
@@ -82,11 +87,15 @@ static void BAES_CmacRawEncrypt( const uint32_t* input,
 /*
  * Initialization for AES-CMAC for Authentication TAG Generation.
  * Must be called each time a new CMAC has to be computed.
+ * When the key is the same as in the previous call, the subkey K1 (and the
+ * expanded key in S/W) are not computed again.
  */
 
 void BAES_CmacSetKey( const uint8_t* key )
 {
   BAES_CMAC_t *av = &BAES_CMAC_var;
+  uint32_t start = BAES_CYCLES( );
+  int hit = av->valid && (memcmp( av->key, key, 16 ) == 0);
 
   /* Initialize for ECB encoding */
 
@@ -94,19 +103,41 @@ void BAES_CmacSetKey( const uint8_t* key )
 
   HW_AES_Enable( );
   HW_AES_SetKey( HW_AES_ENC, key );
+  BAES_stats.key_loads++;
 
 #else /* CFG_BAES_SW != 0 */
 
-  uint32_t tmp[4];
-  memcpy( tmp, key, 16 );
-  BAES_COPY_REV( av->exp_key, tmp );
+  if ( !hit )
+  {
+    uint32_t tmp[4];
+    memcpy( tmp, key, 16 );
+    BAES_COPY_REV( av->exp_key, tmp );
 
-  BAES_EncKeySchedule( av->exp_key );
+    BAES_EncKeySchedule( av->exp_key );
+    BAES_stats.key_loads++;
+  }
 
 #endif /* CFG_BAES_SW != 0 */
 
+  if ( hit )
+  {
+    BAES_stats.cmac_key_hits++;
+  }
+  else
+  {
+    memcpy( av->key, key, 16 );
+
+    /* Compute K1 */
+    av->k1[0] = av->k1[1] = av->k1[2] = av->k1[3] = 0;
+    BAES_CmacRawEncrypt( av->k1, av->k1 );
+    BAES_CmacKeyRoll( av->k1 );
+    av->valid = TRUE;
+  }
+
   /* set IV to zero */
   av->iv[0] = av->iv[1] = av->iv[2] = av->iv[3] = 0;
+
+  BAES_stats.cycles += BAES_CYCLES( ) - start;
 }
 
 /*****************************************************************************/
@@ -128,6 +159,7 @@ void BAES_CmacCompute( const uint8_t* input,
   uint32_t i, last_size;
   uint32_t tmp[4], key[4];
   const uint8_t* ptr = input;
+  uint32_t start = BAES_CYCLES( );
 
   if ( output )
   {
@@ -162,10 +194,8 @@ void BAES_CmacCompute( const uint8_t* input,
       BAES_OR_BYTE_BE( tmp, i, ptr[i] );
     }
 
-    /* Compute K1 */
-    key[0] = key[1] = key[2] = key[3] = 0;
-    BAES_CmacRawEncrypt( key, key );
-    BAES_CmacKeyRoll( key );
+    /* K1, computed at key setting */
+    memcpy( key, av->k1, 16 );
 
     /* Add padding and compute K2 if the last block is not full */
     if ( last_size < 16 )
@@ -193,6 +223,8 @@ void BAES_CmacCompute( const uint8_t* input,
     BAES_COPY_REV( tmp, av->iv );
     memcpy( output, tmp, 16 );
   }
+
+  BAES_stats.cycles += BAES_CYCLES( ) - start;
 }
 
 /*****************************************************************************/
@@ -22,6 +22,25 @@
 
 /*****************************************************************************/
 
+#if CFG_BAES_SW != 0
+
+typedef struct
+{
+  uint32_t key[4];         /* Key of the expanded key below */
+  uint32_t exp_key[44];    /* Expanded AES key */
+  int      enc;            /* Direction of the expanded key */
+  int      valid;
+
+} BAES_ECB_t;
+
+static BAES_ECB_t BAES_ECB_var;
+
+#endif /* CFG_BAES_SW != 0 */
+
+BAES_STATS_T BAES_stats;
+
+/*****************************************************************************/
+
 void BAES_Reset( void )
 {
 #if CFG_BAES_SW == 0
@@ -33,59 +52,158 @@ void BAES_Reset( void )
 
 /*****************************************************************************/
 
-void BAES_EcbCrypt( const uint8_t* key,
-                    const uint8_t* input,
-                    uint8_t* output,
-                    int enc )
-{
-  uint32_t tmp[4];
+/*
+ * Loads the key for ECB mode. With the H/W accelerator, the AES is enabled
+ * until BAES_EcbRelease(). In S/W, the expanded key of the last call is
+ * reused when the key and the direction are the same.
+ */
 
+static void BAES_EcbSetKey( const uint8_t* key,
+                            int enc )
+{
 #if CFG_BAES_SW == 0
 
   HW_AES_Enable( );
   HW_AES_SetKey( (enc ? (HW_AES_ENC | HW_AES_REV) : (HW_AES_DEC | HW_AES_REV)),
                  key );
+  BAES_stats.key_loads++;
 
 #else /* CFG_BAES_SW != 0 */
 
-  uint32_t exp_key[44];
+  BAES_ECB_t *av = &BAES_ECB_var;
+
+  if ( av->valid && (av->enc == enc) && (memcmp( av->key, key, 16 ) == 0) )
+  {
+    return;
+  }
 
   /* Retrieve all bytes from key */
-  memcpy( exp_key, key, 16 );
-  BAES_SWAP( exp_key );
+  memcpy( av->key, key, 16 );
+  memcpy( av->exp_key, key, 16 );
+  BAES_SWAP( av->exp_key );
 
 #if CFG_BAES_SW_DECRYPTION != 0
   if ( !enc )
-    BAES_DecKeySchedule( exp_key );
+    BAES_DecKeySchedule( av->exp_key );
   else
 #endif /* CFG_BAES_SW_DECRYPTION != 0 */
-    BAES_EncKeySchedule( exp_key );
+    BAES_EncKeySchedule( av->exp_key );
+
+  av->enc = enc;
+  av->valid = TRUE;
+  BAES_stats.key_loads++;
 
 #endif /* CFG_BAES_SW != 0 */
+}
+
+/*****************************************************************************/
 
-  /* Retrieve all bytes from input */
-  memcpy( tmp, input, 16 );
-  BAES_SWAP( tmp );
+/*
+ * Processes one block, words already reversed, with the key loaded by
+ * BAES_EcbSetKey().
+ */
 
+static void BAES_EcbRawCrypt( uint32_t* tmp,
+                              int enc )
+{
 #if CFG_BAES_SW == 0
 
+  (void)enc;
   HW_AES_Crypt( tmp, tmp );
-  HW_AES_Disable( );
 
 #else /* CFG_BAES_SW != 0 */
 
+  BAES_ECB_t *av = &BAES_ECB_var;
+
 #if CFG_BAES_SW_DECRYPTION != 0
   if ( !enc )
-    BAES_RawDecrypt( tmp, tmp, exp_key );
+    BAES_RawDecrypt( tmp, tmp, av->exp_key );
   else
 #endif /* CFG_BAES_SW_DECRYPTION != 0 */
-    BAES_RawEncrypt( tmp, tmp, exp_key );
+    BAES_RawEncrypt( tmp, tmp, av->exp_key );
 
 #endif /* CFG_BAES_SW != 0 */
 
-  /* Write all bytes to output */
-  BAES_SWAP( tmp );
-  memcpy( output, tmp, 16 );
+  BAES_stats.blocks++;
+}
+
+/*****************************************************************************/
+
+static void BAES_EcbRelease( void )
+{
+#if CFG_BAES_SW == 0
+
+  HW_AES_Disable( );
+
+#endif /* CFG_BAES_SW == 0 */
+}
+
+/*****************************************************************************/
+
+void BAES_EcbCrypt( const uint8_t* key,
+                    const uint8_t* input,
+                    uint8_t* output,
+                    int enc )
+{
+  BAES_EcbCryptBlocks( key, input, output, 1, enc );
+}
+
+/*****************************************************************************/
+
+/*
+ * AES ECB of "nb" consecutive blocks with the same key: the key is loaded
+ * once for all the blocks.
+ */
+
+void BAES_EcbCryptBlocks( const uint8_t* key,
+                          const uint8_t* input,
+                          uint8_t* output,
+                          uint32_t nb,
+                          int enc )
+{
+  uint32_t tmp[4];
+  uint32_t start = BAES_CYCLES( );
+
+  BAES_EcbSetKey( key, enc );
+
+  while ( nb-- )
+  {
+    /* Retrieve all bytes from input */
+    memcpy( tmp, input, 16 );
+    BAES_SWAP( tmp );
+
+    BAES_EcbRawCrypt( tmp, enc );
+
+    /* Write all bytes to output */
+    BAES_SWAP( tmp );
+    memcpy( output, tmp, 16 );
+
+    input += 16;
+    output += 16;
+  }
+
+  BAES_EcbRelease( );
+
+  BAES_stats.cycles += BAES_CYCLES( ) - start;
+}
+
+/*****************************************************************************/
+
+void BAES_GetStats( BAES_STATS_T* stats )
+{
+  *stats = BAES_stats;
+}
+
+/*****************************************************************************/
+
+void BAES_LogStats( void )
+{
+  BAES_STATS_T stats;
+
+  BAES_GetStats( &stats );
+  LOG_INFO_APP( "     - AES: %d blocks, %d key loads, %d CMAC subkeys reused, %d cycles per block\n",
+                stats.blocks, stats.key_loads, stats.cmac_key_hits,
+                (stats.blocks != 0) ? (uint32_t)(stats.cycles / stats.blocks) : 0 );
 }
 
 /*****************************************************************************/
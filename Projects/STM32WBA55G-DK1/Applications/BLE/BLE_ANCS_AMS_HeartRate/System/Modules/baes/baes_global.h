@@ -99,6 +99,13 @@
 /* Note: BYTE0, BYTE1, BYTE2, BYTE3 and BTOW macros are also used
    but they should be defined in "common.h" */
 
+/* CPU cycle counter, counting once enabled in the DWT */
+#define BAES_CYCLES( )       (DWT->CYCCNT)
+
+/* Internal variables */
+
+extern BAES_STATS_T BAES_stats;
+
 /* Internal functions */
 
 extern void BAES_EncKeySchedule( uint32_t* p_exp_key );
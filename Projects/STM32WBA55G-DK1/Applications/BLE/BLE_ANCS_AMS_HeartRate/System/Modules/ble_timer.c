@@ -23,74 +23,81 @@
 #include "blestack.h"
 #include "stm32_timer.h"
 #include "bleplat.h"
-#include "stm_list.h"
 #include "ble_timer.h"
-#include "advanced_memory_manager.h"
 #include "app_conf.h"
 #include "ll_sys.h"
 #include "stm32_seq.h"
+#include "app_entry.h"
 
 /* Private typedef -----------------------------------------------------------*/
 typedef struct
 {
-  tListNode           node;         /* Actual node in the list */
   uint16_t            id;           /* Id of the timer */
+  uint8_t             used;         /* Set from the start to the stop or the expiry handling */
+  uint8_t             expired;      /* Set from the expiry to its handling */
+  uint8_t             queued;       /* Set while in the expiry queue */
+  uint32_t            expiryTime;   /* Time of the expiry, in ms */
   UTIL_TIMER_Object_t timerObject;  /* Timer Server object */
 }BLE_TIMER_t;
 
 /* Private defines -----------------------------------------------------------*/
 
 /* Private variables ---------------------------------------------------------*/
-tListNode BLE_TIMER_List;
-static BLE_TIMER_t* BLE_TIMER_timer;
+/* Timers, a timer is first looked for at the index given by its id */
+static BLE_TIMER_t BLE_TIMER_Pool[CFG_BLE_TIMER_NBR];
+
+/* Expired timers, in expiry order. A timer is queued once at most, the queue
+ * cannot overflow and no expiry is lost whatever the background task delay */
+static uint8_t BLE_TIMER_Queue[CFG_BLE_TIMER_NBR];
+static uint8_t BLE_TIMER_QueueHead;
+static uint8_t BLE_TIMER_QueueCount;
+
+static BLE_TIMER_Stats_t BLE_TIMER_Stats;
 
 /* Private functions prototype------------------------------------------------*/
 void BLE_TIMER_Background(void);
 static void BLE_TIMER_Callback(void* arg);
-static BLE_TIMER_t* BLE_TIMER_GetFromList(tListNode * listHead, uint16_t id);
+static BLE_TIMER_t* BLE_TIMER_Find(uint16_t id);
+static BLE_TIMER_t* BLE_TIMER_Alloc(uint16_t id);
 
 void BLE_TIMER_Init(void)
 {
-  /* This function initializes the timer Queue */
-  LST_init_head(&BLE_TIMER_List);
-
-  /* Register Timer background task */
-  UTIL_SEQ_RegTask(1U << CFG_TASK_BLE_TIMER_BCKGND, UTIL_SEQ_RFU, BLE_TIMER_Background);
-
   /* Initialize the Timer Server */
   UTIL_TIMER_Init();
+
+  /* The timer objects are created once, they are only started and stopped */
+  for(uint8_t index = 0; index < CFG_BLE_TIMER_NBR; index++)
+  {
+    BLE_TIMER_Pool[index].used = 0;
+    BLE_TIMER_Pool[index].expired = 0;
+    BLE_TIMER_Pool[index].queued = 0;
+    (void)UTIL_TIMER_Create(&BLE_TIMER_Pool[index].timerObject, 0, UTIL_TIMER_ONESHOT,
+                            &BLE_TIMER_Callback, &BLE_TIMER_Pool[index]);
+  }
+  BLE_TIMER_QueueHead = 0;
+  BLE_TIMER_QueueCount = 0;
+
+  /* Register Timer background task */
+  APPE_SEQ_RegTask(1U << CFG_TASK_BLE_TIMER_BCKGND, UTIL_SEQ_RFU, BLE_TIMER_Background);
 }
 
 uint8_t BLE_TIMER_Start(uint16_t id, uint32_t timeout)
 {
+  BLE_TIMER_t *timer;
+
   /* If the timer's id already exists, stop it */
   BLE_TIMER_Stop(id);
 
-  /* Create a new timer instance and add it to the list */
-  BLE_TIMER_t *timer = NULL;
-
-  if(AMM_ERROR_OK != AMM_Alloc (CFG_AMM_VIRTUAL_STACK_BLE,
-                                DIVC(sizeof(BLE_TIMER_t), sizeof(uint32_t)),
-                                (uint32_t **)&timer,
-                                NULL))
+  timer = BLE_TIMER_Alloc(id);
+  if(NULL == timer)
   {
+    BLE_TIMER_Stats.PoolFull++;
     return BLE_STATUS_INSUFFICIENT_RESOURCES;
   }
 
-  timer->id = id;
-  LST_insert_tail(&BLE_TIMER_List, (tListNode *)timer);
-
-  if(UTIL_TIMER_Create(&timer->timerObject, timeout, UTIL_TIMER_ONESHOT, &BLE_TIMER_Callback, timer) != UTIL_TIMER_OK)
+  if(UTIL_TIMER_StartWithPeriod(&timer->timerObject, timeout) != UTIL_TIMER_OK)
   {
-    LST_remove_node ((tListNode *)timer);
-    (void)AMM_Free((uint32_t *)timer);
-    return BLE_STATUS_FAILED;
-  }
-
-  if(UTIL_TIMER_Start(&timer->timerObject) != UTIL_TIMER_OK)
-  {
-    LST_remove_node ((tListNode *)timer);
-    (void)AMM_Free((uint32_t *)timer);
+    timer->used = 0;
     return BLE_STATUS_FAILED;
   }
 
@@ -98,48 +105,147 @@ uint8_t BLE_TIMER_Start(uint16_t id, uint32_t timeout)
 }
 
 void BLE_TIMER_Stop(uint16_t id){
-  /* Search for the id in the timers list */
-  BLE_TIMER_t* timer = BLE_TIMER_GetFromList(&BLE_TIMER_List, id);
+  /* Search for the id in the timers pool */
+  BLE_TIMER_t* timer = BLE_TIMER_Find(id);
 
   /* If the timer's id exists, stop it */
   if(NULL != timer)
   {
     UTIL_TIMER_Stop(&timer->timerObject);
-    LST_remove_node((tListNode *)timer);
 
-    (void)AMM_Free((uint32_t *)timer);
+    /* An expiry already queued is dropped when dequeued */
+    UTILS_ENTER_CRITICAL_SECTION();
+    timer->expired = 0;
+    UTILS_EXIT_CRITICAL_SECTION();
+
+    timer->used = 0;
   }
 }
 
+void BLE_TIMER_GetStats(BLE_TIMER_Stats_t *p_Stats)
+{
+  UTILS_ENTER_CRITICAL_SECTION();
+  *p_Stats = BLE_TIMER_Stats;
+  UTILS_EXIT_CRITICAL_SECTION();
+}
+
+void BLE_TIMER_LogStats(void)
+{
+  BLE_TIMER_Stats_t stats;
+
+  BLE_TIMER_GetStats(&stats);
+  LOG_INFO_APP("     - Stack timers: %d expiries, %d late, %d coalesced, max delay %d ms, max queued %d, pool full %d\n",
+               stats.Expiries, stats.Late, stats.Coalesced,
+               stats.MaxDelay, stats.MaxQueued, stats.PoolFull);
+}
+
 void BLE_TIMER_Background(void)
 {
-  BLEPLATCB_TimerExpiry( (uint16_t)BLE_TIMER_timer->id);
-  HostStack_Process( );
+  BLE_TIMER_t *timer;
+  uint16_t id = 0;
+  uint32_t delay = 0;
+  uint8_t expired;
+  uint8_t handled = 0;
+
+  /* All the expiries queued since the last run are handled */
+  while(1)
+  {
+    UTILS_ENTER_CRITICAL_SECTION();
+    if(BLE_TIMER_QueueCount == 0)
+    {
+      UTILS_EXIT_CRITICAL_SECTION();
+      break;
+    }
+    timer = &BLE_TIMER_Pool[BLE_TIMER_Queue[BLE_TIMER_QueueHead]];
+    BLE_TIMER_QueueHead = (BLE_TIMER_QueueHead + 1) % CFG_BLE_TIMER_NBR;
+    BLE_TIMER_QueueCount--;
+    timer->queued = 0;
+    expired = timer->expired;
+    if(expired != 0)
+    {
+      timer->expired = 0;
+      timer->used = 0;
+      id = timer->id;
+      delay = UTIL_TIMER_GetElapsedTime(timer->expiryTime);
+    }
+    UTILS_EXIT_CRITICAL_SECTION();
 
-  /* Delete the BLE_TIMER_timer from the list */
-  LST_remove_node((tListNode *)BLE_TIMER_timer);
+    if(expired != 0)
+    {
+      BLE_TIMER_Stats.Expiries++;
+      if(delay > CFG_BLE_TIMER_LATE_THRESHOLD)
+      {
+        BLE_TIMER_Stats.Late++;
+      }
+      if(delay > BLE_TIMER_Stats.MaxDelay)
+      {
+        BLE_TIMER_Stats.MaxDelay = delay;
+      }
+      if(handled != 0)
+      {
+        BLE_TIMER_Stats.Coalesced++;
+      }
+      handled++;
+
+      BLEPLATCB_TimerExpiry(id);
+    }
+  }
 
-  (void)AMM_Free((uint32_t *)BLE_TIMER_timer);
+  if(handled != 0)
+  {
+    HostStack_Process( );
+  }
 }
 
 static void BLE_TIMER_Callback(void* arg)
 {
-  BLE_TIMER_timer = (BLE_TIMER_t*)arg;
+  BLE_TIMER_t *timer = (BLE_TIMER_t*)arg;
+
+  timer->expired = 1;
+  timer->expiryTime = UTIL_TIMER_GetCurrentTime();
+  if(timer->queued == 0)
+  {
+    timer->queued = 1;
+    BLE_TIMER_Queue[(BLE_TIMER_QueueHead + BLE_TIMER_QueueCount) % CFG_BLE_TIMER_NBR] = (uint8_t)(timer - BLE_TIMER_Pool);
+    BLE_TIMER_QueueCount++;
+    if(BLE_TIMER_QueueCount > BLE_TIMER_Stats.MaxQueued)
+    {
+      BLE_TIMER_Stats.MaxQueued = BLE_TIMER_QueueCount;
+    }
+  }
 
   UTIL_SEQ_SetTask( 1U << CFG_TASK_BLE_TIMER_BCKGND, CFG_SEQ_PRIO_0);
 }
 
-static BLE_TIMER_t* BLE_TIMER_GetFromList(tListNode * listHead, uint16_t id)
+static BLE_TIMER_t* BLE_TIMER_Find(uint16_t id)
 {
-  BLE_TIMER_t* currentNode = (BLE_TIMER_t*)listHead->next;
-  while((tListNode *)currentNode != listHead)
+  uint8_t index = id % CFG_BLE_TIMER_NBR;
+
+  /* Found at once unless two ids share the same index */
+  for(uint8_t count = 0; count < CFG_BLE_TIMER_NBR; count++)
   {
-    if(currentNode->id == id)
+    if((BLE_TIMER_Pool[index].used != 0) && (BLE_TIMER_Pool[index].id == id))
     {
-      return currentNode;
+      return &BLE_TIMER_Pool[index];
     }
-    LST_get_next_node((tListNode *)currentNode, (tListNode **)&currentNode);
+    index = (index + 1) % CFG_BLE_TIMER_NBR;
   }
   return NULL;
 }
 
+static BLE_TIMER_t* BLE_TIMER_Alloc(uint16_t id)
+{
+  uint8_t index = id % CFG_BLE_TIMER_NBR;
+
+  for(uint8_t count = 0; count < CFG_BLE_TIMER_NBR; count++)
+  {
+    if(BLE_TIMER_Pool[index].used == 0)
+    {
+      BLE_TIMER_Pool[index].used = 1;
+      BLE_TIMER_Pool[index].id = id;
+      return &BLE_TIMER_Pool[index];
+    }
+    index = (index + 1) % CFG_BLE_TIMER_NBR;
+  }
+  return NULL;
+}
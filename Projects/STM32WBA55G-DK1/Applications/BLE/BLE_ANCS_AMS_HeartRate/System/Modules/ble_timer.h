@@ -21,6 +21,20 @@
 #ifndef BLE_TIMER_H__
 #define BLE_TIMER_H__
 
+#include <stdint.h>
+
+/* Counters of the stack timer expiries
+ */
+typedef struct
+{
+  uint32_t Expiries;   /* Expiries handled */
+  uint32_t Late;       /* Handled more than CFG_BLE_TIMER_LATE_THRESHOLD ms after the expiry */
+  uint32_t Coalesced;  /* Handled in the same background run as a previous one */
+  uint32_t MaxDelay;   /* Longest delay between an expiry and its handling, in ms */
+  uint32_t PoolFull;   /* Starts refused, all the timers being used */
+  uint8_t  MaxQueued;  /* Most expiries waiting at the same time */
+} BLE_TIMER_Stats_t;
+
 void BLE_TIMER_Init( void );
 
 uint8_t BLE_TIMER_Start( uint16_t id,
@@ -28,6 +42,10 @@ uint8_t BLE_TIMER_Start( uint16_t id,
 
 void BLE_TIMER_Stop( uint16_t id );
 
+void BLE_TIMER_GetStats( BLE_TIMER_Stats_t *p_Stats );
+
+void BLE_TIMER_LogStats( void );
+
 /* Callback
  */
 void BLE_TIMERCB_Expiry( uint16_t id );
@@ -30,6 +30,17 @@
 /* HAL CRC header */
 #include "stm32wbaxx_hal_crc.h"
 
+#if (CRCCTRL_DMA_SUPPORTED == 1)
+/* HAL DMA headers */
+#include "stm32wbaxx_hal_dma.h"
+#include "stm32wbaxx_hal_cortex.h"
+#endif /* CRCCTRL_DMA_SUPPORTED == 1 */
+
+#if (CFG_LPM_LEVEL != 0)
+/* Low power manager */
+#include "stm32_lpm.h"
+#endif /* CFG_LPM_LEVEL != 0 */
+
 /* Private defines -----------------------------------------------------------*/
 /**
  * @brief Initial value define for configuration tracking number
@@ -58,6 +69,32 @@ static CRC_HandleTypeDef CRCHandle =
   .Instance = CRCCTRL_HWADDR,
 };
 
+/**
+ * @brief Queue of the CRC jobs, the head being the job in progress
+ */
+static CRCCTRL_Job_t * p_JobQueueHead = NULL;
+static CRCCTRL_Job_t * p_JobQueueTail = NULL;
+
+/**
+ * @brief Job being fed to the CRC, NULL if none
+ */
+static CRCCTRL_Job_t * volatile p_ActiveJob = NULL;
+
+#if (CRCCTRL_DMA_SUPPORTED == 1)
+/**
+ * @brief Handle of the DMA channel feeding the CRC
+ */
+static DMA_HandleTypeDef CRCDmaHandle =
+{
+  .Instance = CRCCTRL_DMA_CHANNEL,
+};
+
+/**
+ * @brief Size of the input data elements, in bytes
+ */
+static uint32_t CRCElementSize = 0x00u;
+#endif /* CRCCTRL_DMA_SUPPORTED == 1 */
+
 /* Global variables ----------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 /**
@@ -67,6 +104,68 @@ static CRC_HandleTypeDef CRCHandle =
   */
 static inline HAL_StatusTypeDef CrcConfigure (CRCCTRL_Handle_t * const p_Handle);
 
+/**
+  * @brief  Remove the completed job from the head of the queue
+  * @retval Completed job, NULL if none
+  */
+static CRCCTRL_Job_t * JobDequeue (void);
+
+/**
+  * @brief  Mark the job at the head of the queue as running
+  * @retval Job to start, NULL if none
+  */
+static CRCCTRL_Job_t * JobNext (void);
+
+/**
+  * @brief  Configure the CRC and start feeding the job
+  * @param  p_Job: CRC job
+  * @retval None
+  */
+static void JobStart (CRCCTRL_Job_t * const p_Job);
+
+/**
+  * @brief  Read the job result and release the CRC
+  * @param  p_Job: CRC job
+  * @retval None
+  */
+static void JobComplete (CRCCTRL_Job_t * const p_Job);
+
+#if (CRCCTRL_DMA_SUPPORTED == 1)
+/**
+  * @brief  Allow or forbid the low power modes stopping the job transfer
+  * @param  Enable: TRUE to allow the stop and standby modes
+  * @retval None
+  */
+static inline void JobLowPower (const uint8_t Enable);
+
+/**
+  * @brief  Configure the DMA for the input data format of the CRC
+  * @retval State of the configuration
+  */
+static inline HAL_StatusTypeDef DmaConfigure (void);
+
+/**
+  * @brief  Start the DMA transfer of the next block of the job
+  * @param  p_Job: CRC job
+  * @retval TRUE if a transfer has been started, FALSE once the list is over
+  */
+static uint8_t JobFeed (CRCCTRL_Job_t * const p_Job);
+
+/**
+  * @brief  DMA transfer complete callback
+  * @param  p_Hdma: DMA handle
+  * @retval None
+  */
+static void DmaTransferComplete (DMA_HandleTypeDef * p_Hdma);
+
+/**
+  * @brief  DMA transfer error callback
+  * @param  p_Hdma: DMA handle
+  * @retval None
+  */
+static void DmaTransferError (DMA_HandleTypeDef * p_Hdma);
+#endif /* CRCCTRL_DMA_SUPPORTED == 1 */
+
 /* Functions Definition ------------------------------------------------------*/
 __WEAK CRCCTRL_Cmd_Status_t CRCCTRL_Init (void)
 {
@@ -83,6 +182,13 @@ __WEAK CRCCTRL_Cmd_Status_t CRCCTRL_Init (void)
 
     CRCHandle.Instance = CRCCTRL_HWADDR;
 
+#if (CRCCTRL_DMA_SUPPORTED == 1)
+    /* The DMA channel has to be configured again */
+    CRCDmaHandle.State = HAL_DMA_STATE_RESET;
+
+    CRCDmaHandle.Instance = CRCCTRL_DMA_CHANNEL;
+#endif /* CRCCTRL_DMA_SUPPORTED == 1 */
+
     /* Release the mutex */
     CRCCTRL_MutexRelease ();
   }
@@ -150,6 +256,11 @@ __WEAK CRCCTRL_Cmd_Status_t CRCCTRL_Calculate (CRCCTRL_Handle_t * const p_Handle
   {
     error = CRCCTRL_HANDLE_NOT_VALID;
   }
+  /* CRC fed by DMA for a job */
+  else if (NULL != p_ActiveJob)
+  {
+    error = CRCCTRL_BUSY;
+  }
   else
   {
     /* Try to take the CRC mutex */
@@ -207,6 +318,11 @@ __WEAK CRCCTRL_Cmd_Status_t CRCCTRL_Accumulate (CRCCTRL_Handle_t * const p_Handl
   {
     error = CRCCTRL_HANDLE_NOT_VALID;
   }
+  /* CRC fed by DMA for a job */
+  else if (NULL != p_ActiveJob)
+  {
+    error = CRCCTRL_BUSY;
+  }
   else
   {
     /* Try to take the CRC mutex */
@@ -250,7 +366,415 @@ __WEAK CRCCTRL_Cmd_Status_t CRCCTRL_Accumulate (CRCCTRL_Handle_t * const p_Handl
   return error;
 }
 
+__WEAK CRCCTRL_Cmd_Status_t CRCCTRL_SubmitJob (CRCCTRL_Job_t * const p_Job)
+{
+  CRCCTRL_Cmd_Status_t error = CRCCTRL_OK;
+
+  /* Null pointer for job, handle, list or callback */
+  if ((NULL == p_Job) || (NULL == p_Job->p_Handle) ||
+      (NULL == p_Job->a_Segments) || (NULL == p_Job->Callback))
+  {
+    error = CRCCTRL_ERROR_NULL_POINTER;
+  }
+  /* Handle not init */
+  else if (HANDLE_NOT_REG == p_Job->p_Handle->State)
+  {
+    error = CRCCTRL_HANDLE_NOT_REGISTERED;
+  }
+  /* Handle not in the range */
+  else if ((MaxRegisteredId < p_Job->p_Handle->Uid) ||
+           (CRCCTRL_NO_CONFIG >= p_Job->p_Handle->Uid))
+  {
+    error = CRCCTRL_HANDLE_NOT_VALID;
+  }
+  /* Empty list */
+  else if (0x00u == p_Job->SegmentNumber)
+  {
+    error = CRCCTRL_NOK;
+  }
+  /* Job already queued */
+  else if (CRCCTRL_JOB_IDLE != p_Job->State)
+  {
+    error = CRCCTRL_BUSY;
+  }
+  else
+  {
+    p_Job->Status = CRCCTRL_OK;
+    p_Job->ComputedValue = 0x00u;
+    p_Job->SegmentId = 0x00u;
+    p_Job->Offset = 0x00u;
+    p_Job->p_Next = NULL;
+    p_Job->State = CRCCTRL_JOB_QUEUED;
+
+    /* Enter critical section */
+    UTILS_ENTER_CRITICAL_SECTION();
+
+    /* Append the job to the queue */
+    if (NULL == p_JobQueueHead)
+    {
+      p_JobQueueHead = p_Job;
+    }
+    else
+    {
+      p_JobQueueTail->p_Next = p_Job;
+    }
+    p_JobQueueTail = p_Job;
+
+    /* Leave critical section */
+    UTILS_EXIT_CRITICAL_SECTION();
+
+    CRCCTRL_JobProcessReq ();
+  }
+
+  return error;
+}
+
+__WEAK void CRCCTRL_JobProcess (void)
+{
+  CRCCTRL_Job_t * p_job = JobDequeue ();
+
+  if (NULL != p_job)
+  {
+    /* The job can be submitted again from its callback */
+    p_job->State = CRCCTRL_JOB_IDLE;
+    p_job->Callback (p_job);
+  }
+
+  /* Start the next job */
+  p_job = JobNext ();
+
+  if (NULL != p_job)
+  {
+    JobStart (p_job);
+  }
+}
+
+__WEAK void CRCCTRL_DMA_IRQHandler (void)
+{
+#if (CRCCTRL_DMA_SUPPORTED == 1)
+  HAL_DMA_IRQHandler (&CRCDmaHandle);
+#endif /* CRCCTRL_DMA_SUPPORTED == 1 */
+}
+
 /* Private function Definition -----------------------------------------------*/
+static CRCCTRL_Job_t * JobDequeue (void)
+{
+  CRCCTRL_Job_t * p_job = NULL;
+
+  /* Enter critical section */
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  if ((NULL != p_JobQueueHead) && (CRCCTRL_JOB_DONE == p_JobQueueHead->State))
+  {
+    p_job = p_JobQueueHead;
+    p_JobQueueHead = p_job->p_Next;
+    p_job->p_Next = NULL;
+  }
+
+  /* Leave critical section */
+  UTILS_EXIT_CRITICAL_SECTION();
+
+  return p_job;
+}
+
+static CRCCTRL_Job_t * JobNext (void)
+{
+  CRCCTRL_Job_t * p_job = NULL;
+
+  /* Enter critical section */
+  UTILS_ENTER_CRITICAL_SECTION();
+
+  if ((NULL != p_JobQueueHead) && (CRCCTRL_JOB_QUEUED == p_JobQueueHead->State))
+  {
+    p_job = p_JobQueueHead;
+    p_job->State = CRCCTRL_JOB_RUNNING;
+  }
+
+  /* Leave critical section */
+  UTILS_EXIT_CRITICAL_SECTION();
+
+  return p_job;
+}
+
+static void JobStart (CRCCTRL_Job_t * const p_Job)
+{
+  CRCCTRL_Handle_t * p_handle = p_Job->p_Handle;
+  uint32_t initValue;
+
+  /* Try to take the CRC mutex */
+  if (CRCCTRL_OK != CRCCTRL_MutexTake ())
+  {
+    /* Retry later */
+    p_Job->State = CRCCTRL_JOB_QUEUED;
+  }
+  else
+  {
+    /* Is the current config IS NOT the same as the one requested ? */
+    if ((CurrentConfig != p_handle->Uid) && (HAL_OK != CrcConfigure (p_handle)))
+    {
+      p_Job->Status = CRCCTRL_ERROR_CONFIG;
+    }
+#if (CRCCTRL_DMA_SUPPORTED == 1)
+    else if (HAL_OK != DmaConfigure ())
+    {
+      p_Job->Status = CRCCTRL_NOK;
+    }
+#endif /* CRCCTRL_DMA_SUPPORTED == 1 */
+    else
+    {
+      if (TRUE == p_Job->Accumulate)
+      {
+        initValue = p_handle->PreviousComputedValue;
+      }
+      else if (DEFAULT_INIT_VALUE_ENABLE == p_handle->Configuration.DefaultInitValueUse)
+      {
+        initValue = DEFAULT_CRC_INITVALUE;
+      }
+      else
+      {
+        initValue = p_handle->Configuration.InitValue;
+      }
+
+      /* Load the init value in the data register */
+      CRCHandle.Instance->INIT = initValue;
+      __HAL_CRC_DR_RESET (&CRCHandle);
+
+      /* The job owns the CRC until its completion, the mutex is released by JobComplete */
+      p_ActiveJob = p_Job;
+    }
+
+    if (CRCCTRL_OK != p_Job->Status)
+    {
+      /* Release the mutex */
+      CRCCTRL_MutexRelease ();
+    }
+  }
+
+  if (CRCCTRL_JOB_QUEUED == p_Job->State)
+  {
+    CRCCTRL_JobProcessReq ();
+  }
+  else if (CRCCTRL_OK == p_Job->Status)
+  {
+#if (CRCCTRL_DMA_SUPPORTED == 1)
+    JobLowPower (FALSE);
+
+    /* The job completes from the DMA interrupt */
+    if (FALSE == JobFeed (p_Job))
+    {
+      JobComplete (p_Job);
+    }
+#else
+    /* Feed the whole list by CPU */
+    for (uint8_t cnt = 0x00u; cnt < p_Job->SegmentNumber; cnt++)
+    {
+      if (0x00u != p_Job->a_Segments[cnt].Size)
+      {
+        (void)HAL_CRC_Accumulate (&CRCHandle,
+                                  (uint32_t *)p_Job->a_Segments[cnt].p_Data,
+                                  p_Job->a_Segments[cnt].Size);
+      }
+    }
+
+    JobComplete (p_Job);
+#endif /* CRCCTRL_DMA_SUPPORTED == 1 */
+  }
+  else
+  {
+    p_Job->State = CRCCTRL_JOB_DONE;
+    CRCCTRL_JobProcessReq ();
+  }
+}
+
+static void JobComplete (CRCCTRL_Job_t * const p_Job)
+{
+  if (CRCCTRL_OK == p_Job->Status)
+  {
+    p_Job->ComputedValue = CRCHandle.Instance->DR;
+
+    /* Update the handle with the computed value */
+    p_Job->p_Handle->PreviousComputedValue = p_Job->ComputedValue;
+  }
+
+  /* The init register has been overwritten, configure the CRC on next use */
+  CurrentConfig = CRCCTRL_NO_CONFIG;
+
+  p_ActiveJob = NULL;
+
+  /* Release the mutex taken by JobStart */
+  CRCCTRL_MutexRelease ();
+
+#if (CRCCTRL_DMA_SUPPORTED == 1)
+  JobLowPower (TRUE);
+#endif /* CRCCTRL_DMA_SUPPORTED == 1 */
+
+  p_Job->State = CRCCTRL_JOB_DONE;
+  CRCCTRL_JobProcessReq ();
+}
+
+#if (CRCCTRL_DMA_SUPPORTED == 1)
+void JobLowPower (const uint8_t Enable)
+{
+#if (CFG_LPM_LEVEL != 0)
+  /* The DMA does not run in stop and standby modes */
+  UTIL_LPM_SetStopMode (1U << CFG_LPM_CRC,
+                        (TRUE == Enable) ? UTIL_LPM_ENABLE : UTIL_LPM_DISABLE);
+  UTIL_LPM_SetOffMode (1U << CFG_LPM_CRC,
+                       (TRUE == Enable) ? UTIL_LPM_ENABLE : UTIL_LPM_DISABLE);
+#else
+  UNUSED (Enable);
+#endif /* CFG_LPM_LEVEL != 0 */
+}
+
+HAL_StatusTypeDef DmaConfigure (void)
+{
+  HAL_StatusTypeDef error = HAL_OK;
+  uint32_t elementSize;
+
+  switch (CRCHandle.InputDataFormat)
+  {
+    case CRC_INPUTDATA_FORMAT_WORDS:
+    {
+      elementSize = sizeof (uint32_t);
+      break;
+    }
+
+    case CRC_INPUTDATA_FORMAT_HALFWORDS:
+    {
+      elementSize = sizeof (uint16_t);
+      break;
+    }
+
+    default:
+    {
+      elementSize = sizeof (uint8_t);
+      break;
+    }
+  }
+
+  /* Data width of the channel to change ? */
+  if ((HAL_DMA_STATE_RESET == CRCDmaHandle.State) || (CRCElementSize != elementSize))
+  {
+    __HAL_RCC_GPDMA1_CLK_ENABLE();
+
+    /* Memory to memory transfer towards the fixed CRC data register */
+    CRCDmaHandle.Init.Request = DMA_REQUEST_SW;
+    CRCDmaHandle.Init.BlkHWRequest = DMA_BREQ_SINGLE_BURST;
+    CRCDmaHandle.Init.Direction = DMA_MEMORY_TO_MEMORY;
+    CRCDmaHandle.Init.SrcInc = DMA_SINC_INCREMENTED;
+    CRCDmaHandle.Init.DestInc = DMA_DINC_FIXED;
+    CRCDmaHandle.Init.SrcDataWidth = (elementSize == sizeof (uint32_t)) ? DMA_SRC_DATAWIDTH_WORD :
+                                     ((elementSize == sizeof (uint16_t)) ? DMA_SRC_DATAWIDTH_HALFWORD :
+                                                                           DMA_SRC_DATAWIDTH_BYTE);
+    CRCDmaHandle.Init.DestDataWidth = (elementSize == sizeof (uint32_t)) ? DMA_DEST_DATAWIDTH_WORD :
+                                      ((elementSize == sizeof (uint16_t)) ? DMA_DEST_DATAWIDTH_HALFWORD :
+                                                                            DMA_DEST_DATAWIDTH_BYTE);
+    CRCDmaHandle.Init.Priority = DMA_LOW_PRIORITY_LOW_WEIGHT;
+    CRCDmaHandle.Init.SrcBurstLength = 1;
+    CRCDmaHandle.Init.DestBurstLength = 1;
+    CRCDmaHandle.Init.TransferAllocatedPort = DMA_SRC_ALLOCATED_PORT0 | DMA_DEST_ALLOCATED_PORT0;
+    CRCDmaHandle.Init.TransferEventMode = DMA_TCEM_BLOCK_TRANSFER;
+    CRCDmaHandle.Init.Mode = DMA_NORMAL;
+
+    error = HAL_DMA_Init (&CRCDmaHandle);
+
+    if (HAL_OK == error)
+    {
+      error = HAL_DMA_ConfigChannelAttributes (&CRCDmaHandle, DMA_CHANNEL_NPRIV);
+    }
+
+    if (HAL_OK == error)
+    {
+      CRCDmaHandle.XferCpltCallback = DmaTransferComplete;
+      CRCDmaHandle.XferHalfCpltCallback = NULL;
+      CRCDmaHandle.XferErrorCallback = DmaTransferError;
+      CRCDmaHandle.XferAbortCallback = NULL;
+
+      HAL_NVIC_SetPriority (CRCCTRL_DMA_IRQN, CRCCTRL_DMA_IRQ_PRIO, 0);
+      HAL_NVIC_EnableIRQ (CRCCTRL_DMA_IRQN);
+
+      CRCElementSize = elementSize;
+    }
+    else
+    {
+      CRCDmaHandle.State = HAL_DMA_STATE_RESET;
+    }
+  }
+
+  return error;
+}
+
+uint8_t JobFeed (CRCCTRL_Job_t * const p_Job)
+{
+  uint8_t started = FALSE;
+  uint32_t segmentSize;
+  uint32_t blockSize;
+
+  while ((FALSE == started) && (p_Job->SegmentId < p_Job->SegmentNumber))
+  {
+    segmentSize = p_Job->a_Segments[p_Job->SegmentId].Size * CRCElementSize;
+
+    /* Segment over, go to the next one */
+    if (p_Job->Offset >= segmentSize)
+    {
+      p_Job->SegmentId++;
+      p_Job->Offset = 0x00u;
+    }
+    else
+    {
+      blockSize = segmentSize - p_Job->Offset;
+
+      if (blockSize > CRCCTRL_DMA_BLOCK_SIZE)
+      {
+        blockSize = CRCCTRL_DMA_BLOCK_SIZE;
+      }
+
+      if (HAL_OK == HAL_DMA_Start_IT (&CRCDmaHandle,
+                                      (uint32_t)p_Job->a_Segments[p_Job->SegmentId].p_Data + p_Job->Offset,
+                                      (uint32_t)&CRCHandle.Instance->DR,
+                                      blockSize))
+      {
+        p_Job->Offset += blockSize;
+        started = TRUE;
+      }
+      else
+      {
+        /* Stop the job */
+        p_Job->Status = CRCCTRL_NOK;
+        p_Job->SegmentId = p_Job->SegmentNumber;
+      }
+    }
+  }
+
+  return started;
+}
+
+void DmaTransferComplete (DMA_HandleTypeDef * p_Hdma)
+{
+  CRCCTRL_Job_t * p_job = p_ActiveJob;
+
+  UNUSED (p_Hdma);
+
+  if ((NULL != p_job) && (FALSE == JobFeed (p_job)))
+  {
+    JobComplete (p_job);
+  }
+}
+
+void DmaTransferError (DMA_HandleTypeDef * p_Hdma)
+{
+  CRCCTRL_Job_t * p_job = p_ActiveJob;
+
+  UNUSED (p_Hdma);
+
+  if (NULL != p_job)
+  {
+    p_job->Status = CRCCTRL_NOK;
+    JobComplete (p_job);
+  }
+}
+#endif /* CRCCTRL_DMA_SUPPORTED == 1 */
+
 HAL_StatusTypeDef CrcConfigure (CRCCTRL_Handle_t * const p_Handle)
 {
   HAL_StatusTypeDef error = HAL_OK;
@@ -307,3 +831,9 @@ __WEAK CRCCTRL_Cmd_Status_t CRCCTRL_MutexRelease (void)
 {
   return CRCCTRL_OK;
 }
+
+__WEAK void CRCCTRL_JobProcessReq (void)
+{
+  /* Process the job in the caller context */
+  CRCCTRL_JobProcess ();
+}
@@ -128,6 +128,57 @@ typedef struct CRCCTRL_Handle
   CRCCTRL_Config_t Configuration;         /* Configuration of the CRC */
 } CRCCTRL_Handle_t;
 
+/**
+ * @brief CRC job states
+ */
+typedef enum CRCCTRL_JobState
+{
+  CRCCTRL_JOB_IDLE,
+  CRCCTRL_JOB_QUEUED,
+  CRCCTRL_JOB_RUNNING,
+  CRCCTRL_JOB_DONE,
+} CRCCTRL_JobState_t;
+
+/**
+ * @brief Element of the scatter-gather list of a CRC job
+ */
+typedef struct CRCCTRL_Segment
+{
+  const void * p_Data;                    /* Address of the data, aligned on the input data format */
+  uint32_t Size;                          /* Size of the data, in elements of the input data format */
+} CRCCTRL_Segment_t;
+
+typedef struct CRCCTRL_Job CRCCTRL_Job_t;
+
+/**
+ * @brief Callback invoked from the CRC job task once the job is over
+ */
+typedef void (* CRCCTRL_JobCallback_t) (CRCCTRL_Job_t * const p_Job);
+
+/**
+ * @brief CRC job
+ *
+ * @details The job shall stay allocated, with its segments, until its callback is invoked
+ */
+struct CRCCTRL_Job
+{
+  /* Filled by the user */
+  CRCCTRL_Handle_t * p_Handle;            /* CRC handle to use */
+  const CRCCTRL_Segment_t * a_Segments;   /* Scatter-gather list of the data */
+  uint8_t SegmentNumber;                  /* Number of segments of the list */
+  uint8_t Accumulate;                     /* TRUE: start from the previous computed value of the handle */
+  CRCCTRL_JobCallback_t Callback;         /* Callback invoked once the job is over */
+  void * p_Context;                       /* User context, not used by the CRC controller */
+
+  /* Filled by the CRC controller */
+  CRCCTRL_Cmd_Status_t Status;            /* Status of the job */
+  uint32_t ComputedValue;                 /* Computed CRC (LSBs for CRC shorter than 32 bits) */
+  volatile CRCCTRL_JobState_t State;      /* State of the job */
+  uint8_t SegmentId;                      /* Segment in progress */
+  uint32_t Offset;                        /* Bytes of the segment in progress already fed */
+  CRCCTRL_Job_t * p_Next;                 /* Next job of the queue */
+};
+
 /* Exported constants --------------------------------------------------------*/
 /* External variables --------------------------------------------------------*/
 /* Exported macros -----------------------------------------------------------*/
@@ -182,7 +233,39 @@ CRCCTRL_Cmd_Status_t CRCCTRL_Accumulate (CRCCTRL_Handle_t * const p_Handle,
                                          const uint32_t PayloadSize,
                                          uint32_t * const p_ConmputedValue);
 
+/**
+  * @brief  Queue a CRC job
+  *
+  * @details The segments are fed to the CRC by DMA when CRCCTRL_DMA_SUPPORTED is set,
+  *          by the CPU from the CRC job task otherwise. The synchronous APIs return
+  *          CRCCTRL_BUSY while a job is fed by DMA.
+  *
+  * @param p_Job: Job to queue, its State shall be CRCCTRL_JOB_IDLE
+  *
+  * @return State of the operation
+  */
+CRCCTRL_Cmd_Status_t CRCCTRL_SubmitJob (CRCCTRL_Job_t * const p_Job);
+
+/**
+  * @brief  Report the completed job and start the next queued one
+  *
+  * @details This function shall be called from the task scheduled by CRCCTRL_JobProcessReq
+  */
+void CRCCTRL_JobProcess (void);
+
+/**
+  * @brief  Handle the interrupt of the DMA channel feeding the CRC
+  */
+void CRCCTRL_DMA_IRQHandler (void);
+
 /* Exported functions to be implemented by the user ------------------------- */
+/**
+ * @brief  Request CRCCTRL_JobProcess to be called
+ *
+ * @details This function shall be implemented by the user, it is called from interrupt context
+ */
+extern void CRCCTRL_JobProcessReq (void);
+
 /**
  * @brief  Take ownership on the CRC mutex
  *
@@ -197,7 +280,8 @@ extern CRCCTRL_Cmd_Status_t CRCCTRL_MutexTake (void);
 /**
  * @brief  Release ownership on the CRC mutex
  *
- * @details This function shall be implemented by the user
+ * @details This function shall be implemented by the user, it is called from interrupt context
+ *          at the end of a DMA fed job, the mutex being held for the whole job
  *
  * @return Status of the command
  * @retval CRCCTRL_Cmd_Status_t::CRCCTRL_OK
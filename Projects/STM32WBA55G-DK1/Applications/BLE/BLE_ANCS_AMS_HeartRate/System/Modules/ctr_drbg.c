@@ -0,0 +1,455 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file    ctr_drbg.c
+  * @author  MCD Application Team
+  * @brief   AES-128 CTR_DRBG (NIST SP 800-90A, no derivation function) run
+  *          on the AES peripheral, seeded and reseeded from the RNG pool
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "app_common.h"
+#include "stm32wbaxx_ll_utils.h"
+#include "ctr_drbg.h"
+#include "log_module.h"
+
+#if (CFG_CTR_DRBG_SUPPORTED == 1)
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint8_t  a_Key[16];
+  uint8_t  a_V[16];
+  uint32_t ReseedCounter;   /* Generates since the last (re)seed, plus one */
+} CTR_DRBG_Ctx_t;
+
+typedef enum
+{
+  CTR_DRBG_RESET,
+  CTR_DRBG_READY,
+  CTR_DRBG_FAILED
+} CTR_DRBG_State_t;
+
+/* Private defines -----------------------------------------------------------*/
+#define CTR_DRBG_BLOCK_SIZE        (16U)
+/* Seed length: key and V */
+#define CTR_DRBG_SEED_SIZE         (32U)
+#define CTR_DRBG_SEED_WORDS        (CTR_DRBG_SEED_SIZE / 4U)
+/* Self-test output different from the known answer */
+#define CTR_DRBG_KAT_ERROR         (-1)
+
+#if ((CFG_CTR_DRBG_RESERVE_SIZE % CTR_DRBG_BLOCK_SIZE) != 0U)
+#error "CFG_CTR_DRBG_RESERVE_SIZE must be a multiple of the AES block size"
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+/* Known-answer vector, computed with a reference AES-128 CTR_DRBG (no df,
+ * no prediction resistance, no additional input):
+ * instantiate with entropy 00..1F, generate 64 bytes twice, reseed with
+ * entropy 20..3F, generate 16 bytes */
+static const uint8_t CTR_DRBG_KatGenerate[32] =
+{
+  0x79, 0x60, 0x37, 0xFE, 0x48, 0xC3, 0x9B, 0xF6,
+  0x10, 0xF8, 0xA8, 0x5A, 0x98, 0x56, 0x5D, 0x96,
+  0x09, 0x4B, 0x2D, 0x53, 0x59, 0x5F, 0xFE, 0x0F,
+  0xC6, 0x1B, 0xE7, 0x39, 0xC2, 0x1D, 0x93, 0x94
+};
+
+static const uint8_t CTR_DRBG_KatReseed[16] =
+{
+  0xA9, 0xE5, 0x06, 0x48, 0xBB, 0x96, 0xB4, 0x7B,
+  0xEA, 0xCC, 0xA0, 0x0F, 0x9B, 0xEE, 0xF5, 0xFE
+};
+
+static CTR_DRBG_Ctx_t CTR_DRBG_Ctx;
+static uint8_t CTR_DRBG_State;
+static volatile uint8_t CTR_DRBG_Lock;
+
+/* Output generated ahead, served from the end */
+static uint8_t CTR_DRBG_Reserve[CFG_CTR_DRBG_RESERVE_SIZE];
+static volatile uint32_t CTR_DRBG_ReserveCount;
+static uint8_t CTR_DRBG_LastBlock[CTR_DRBG_BLOCK_SIZE];
+
+static CTR_DRBG_Stats_t CTR_DRBG_Stats;
+
+/* Private functions prototype------------------------------------------------*/
+static void CTR_DRBG_Block(CTR_DRBG_Ctx_t *p_Ctx, uint8_t *p_Out);
+static void CTR_DRBG_Update(CTR_DRBG_Ctx_t *p_Ctx, const uint8_t *p_Data);
+static int CTR_DRBG_Seed(CTR_DRBG_Ctx_t *p_Ctx, const uint8_t *p_Seed);
+static int CTR_DRBG_Generate(CTR_DRBG_Ctx_t *p_Ctx, uint8_t *p_Out, uint32_t Size);
+static int CTR_DRBG_SelfTest(void);
+static void CTR_DRBG_Reseed(void);
+static int CTR_DRBG_Refill(void);
+
+/**
+ * @brief  Run the known-answer self-test, then instantiate the DRBG from
+ *         the RNG pool, personalized with the device unique ID. To be called
+ *         once from task context after HW_RNG_Start(): the pool is filled here
+ *         when needed. While not instantiated, CTR_DRBG_Get() uses the pool.
+ * @param  None
+ * @retval None
+ */
+void CTR_DRBG_Init( void )
+{
+  uint32_t a_seed[CTR_DRBG_SEED_WORDS];
+  int status;
+
+  if (CTR_DRBG_State != CTR_DRBG_RESET)
+  {
+    return;
+  }
+
+  if (CTR_DRBG_Stats.SelfTest != CTR_DRBG_SELFTEST_PASSED)
+  {
+    status = CTR_DRBG_SelfTest();
+    if (status == HW_BUSY)
+    {
+      return;
+    }
+    if (status != HW_OK)
+    {
+      CTR_DRBG_Stats.SelfTest = CTR_DRBG_SELFTEST_FAILED;
+      CTR_DRBG_State = CTR_DRBG_FAILED;
+      LOG_INFO_APP(">>== CTR_DRBG self-test failed, RNG pool used instead\n");
+      return;
+    }
+    CTR_DRBG_Stats.SelfTest = CTR_DRBG_SELFTEST_PASSED;
+  }
+
+  while ((HW_RNG_GetCount() < (int)CTR_DRBG_SEED_WORDS) && (HW_RNG_Process() == HW_BUSY))
+  {
+  }
+
+  UTILS_ENTER_CRITICAL_SECTION();
+  status = (HW_RNG_GetCount() >= (int)CTR_DRBG_SEED_WORDS) ? HW_OK : HW_BUSY;
+  if (status == HW_OK)
+  {
+    HW_RNG_Get(CTR_DRBG_SEED_WORDS, a_seed);
+  }
+  UTILS_EXIT_CRITICAL_SECTION();
+
+  if (status == HW_OK)
+  {
+    a_seed[0] ^= LL_GetUID_Word0();
+    a_seed[1] ^= LL_GetUID_Word1();
+    a_seed[2] ^= LL_GetUID_Word2();
+
+    memset(&CTR_DRBG_Ctx, 0, sizeof(CTR_DRBG_Ctx));
+    if (CTR_DRBG_Seed(&CTR_DRBG_Ctx, (const uint8_t *)a_seed) == HW_OK)
+    {
+      CTR_DRBG_State = CTR_DRBG_READY;
+    }
+    memset(a_seed, 0, sizeof(a_seed));
+  }
+}
+
+/**
+ * @brief  Fill a buffer of any size with random bytes. Never blocks: when
+ *         the DRBG cannot run (used by the interrupted context, AES in use,
+ *         not instantiated), the bytes are read from the RNG pool instead.
+ * @param  p_Data: buffer to fill
+ * @param  Size: number of bytes
+ * @retval None
+ */
+void CTR_DRBG_Get( uint8_t *p_Data, uint32_t Size )
+{
+  uint32_t chunk;
+  uint32_t word;
+  uint8_t locked;
+
+  while (Size > 0U)
+  {
+    UTILS_ENTER_CRITICAL_SECTION();
+    chunk = MIN(Size, CTR_DRBG_ReserveCount);
+    CTR_DRBG_ReserveCount -= chunk;
+    memcpy(p_Data, &CTR_DRBG_Reserve[CTR_DRBG_ReserveCount], chunk);
+    memset(&CTR_DRBG_Reserve[CTR_DRBG_ReserveCount], 0, chunk);
+    CTR_DRBG_Stats.Bytes += chunk;
+    locked = CTR_DRBG_Lock;
+    if ((chunk == 0U) && (locked == 0U))
+    {
+      CTR_DRBG_Lock = 1;
+    }
+    UTILS_EXIT_CRITICAL_SECTION();
+
+    if (chunk > 0U)
+    {
+      p_Data += chunk;
+      Size -= chunk;
+    }
+    else if (locked != 0U)
+    {
+      break;
+    }
+    else
+    {
+      chunk = (uint32_t)CTR_DRBG_Refill();
+      CTR_DRBG_Lock = 0;
+      if (chunk == 0U)
+      {
+        break;
+      }
+    }
+  }
+
+  while (Size > 0U)
+  {
+    HW_RNG_Get(1, &word);
+    chunk = MIN(Size, sizeof(word));
+    memcpy(p_Data, &word, chunk);
+    p_Data += chunk;
+    Size -= chunk;
+
+    UTILS_ENTER_CRITICAL_SECTION();
+    CTR_DRBG_Stats.FallbackBytes += chunk;
+    UTILS_EXIT_CRITICAL_SECTION();
+  }
+}
+
+void CTR_DRBG_GetStats( CTR_DRBG_Stats_t *p_Stats )
+{
+  UTILS_ENTER_CRITICAL_SECTION();
+  *p_Stats = CTR_DRBG_Stats;
+  UTILS_EXIT_CRITICAL_SECTION();
+}
+
+void CTR_DRBG_LogStats( void )
+{
+  CTR_DRBG_Stats_t stats;
+
+  CTR_DRBG_GetStats(&stats);
+  LOG_INFO_APP("     - DRBG self-test %d: %d bytes, %d generates, %d reseeds, %d deferred\n",
+               stats.SelfTest, stats.Bytes, stats.Generates,
+               stats.Reseeds, stats.ReseedsDeferred);
+  LOG_INFO_APP("       %d AES busy, %d repeats, %d bytes from the RNG pool\n",
+               stats.AesBusy, stats.Repeats, stats.FallbackBytes);
+}
+
+/* Private functions ----------------------------------------------------------*/
+/* Increment V, big endian, and encrypt it with the key loaded in the AES */
+static void CTR_DRBG_Block(CTR_DRBG_Ctx_t *p_Ctx, uint8_t *p_Out)
+{
+  uint32_t a_in[4];
+  uint32_t a_out[4];
+  int index = CTR_DRBG_BLOCK_SIZE;
+
+  do
+  {
+    index--;
+    p_Ctx->a_V[index]++;
+  } while ((p_Ctx->a_V[index] == 0U) && (index > 0));
+
+  memcpy(a_in, p_Ctx->a_V, CTR_DRBG_BLOCK_SIZE);
+  HW_AES_Crypt(a_in, a_out);
+  memcpy(p_Out, a_out, CTR_DRBG_BLOCK_SIZE);
+}
+
+/* CTR_DRBG_Update: new key and V from two blocks, xored with the provided
+ * data when any. The current key must be loaded in the AES */
+static void CTR_DRBG_Update(CTR_DRBG_Ctx_t *p_Ctx, const uint8_t *p_Data)
+{
+  uint8_t a_temp[CTR_DRBG_SEED_SIZE];
+
+  CTR_DRBG_Block(p_Ctx, &a_temp[0]);
+  CTR_DRBG_Block(p_Ctx, &a_temp[CTR_DRBG_BLOCK_SIZE]);
+
+  if (p_Data != NULL)
+  {
+    for (uint8_t index = 0; index < CTR_DRBG_SEED_SIZE; index++)
+    {
+      a_temp[index] ^= p_Data[index];
+    }
+  }
+
+  memcpy(p_Ctx->a_Key, &a_temp[0], CTR_DRBG_BLOCK_SIZE);
+  memcpy(p_Ctx->a_V, &a_temp[CTR_DRBG_BLOCK_SIZE], CTR_DRBG_BLOCK_SIZE);
+  memset(a_temp, 0, sizeof(a_temp));
+}
+
+/* Instantiate (from a zeroed context) or reseed with CTR_DRBG_SEED_SIZE
+ * bytes of seed material */
+static int CTR_DRBG_Seed(CTR_DRBG_Ctx_t *p_Ctx, const uint8_t *p_Seed)
+{
+  if (HW_AES_Enable() == FALSE)
+  {
+    return HW_BUSY;
+  }
+  /* Byte swapping: the blocks are byte arrays, most significant byte first */
+  HW_AES_SetKey(HW_AES_ENC | HW_AES_SWAP, p_Ctx->a_Key);
+  CTR_DRBG_Update(p_Ctx, p_Seed);
+  HW_AES_Disable();
+
+  p_Ctx->ReseedCounter = 1;
+
+  return HW_OK;
+}
+
+static int CTR_DRBG_Generate(CTR_DRBG_Ctx_t *p_Ctx, uint8_t *p_Out, uint32_t Size)
+{
+  uint8_t a_block[CTR_DRBG_BLOCK_SIZE];
+  uint32_t chunk;
+
+  if (HW_AES_Enable() == FALSE)
+  {
+    return HW_BUSY;
+  }
+  HW_AES_SetKey(HW_AES_ENC | HW_AES_SWAP, p_Ctx->a_Key);
+
+  while (Size > 0U)
+  {
+    CTR_DRBG_Block(p_Ctx, a_block);
+    chunk = MIN(Size, CTR_DRBG_BLOCK_SIZE);
+    memcpy(p_Out, a_block, chunk);
+    p_Out += chunk;
+    Size -= chunk;
+  }
+
+  /* Backtracking resistance */
+  CTR_DRBG_Update(p_Ctx, NULL);
+  HW_AES_Disable();
+  memset(a_block, 0, sizeof(a_block));
+
+  p_Ctx->ReseedCounter++;
+
+  return HW_OK;
+}
+
+/* Instantiate, generate, generate, reseed and generate against the
+ * known-answer vector, on a context of its own */
+static int CTR_DRBG_SelfTest(void)
+{
+  CTR_DRBG_Ctx_t ctx;
+  uint8_t a_seed[CTR_DRBG_SEED_SIZE];
+  uint8_t a_out[64];
+  int status;
+
+  for (uint8_t index = 0; index < CTR_DRBG_SEED_SIZE; index++)
+  {
+    a_seed[index] = index;
+  }
+  memset(&ctx, 0, sizeof(ctx));
+
+  status = CTR_DRBG_Seed(&ctx, a_seed);
+  if (status == HW_OK)
+  {
+    status = CTR_DRBG_Generate(&ctx, a_out, sizeof(a_out));
+  }
+  if (status == HW_OK)
+  {
+    status = CTR_DRBG_Generate(&ctx, a_out, sizeof(a_out));
+  }
+  if ((status == HW_OK)
+      && (memcmp(a_out, CTR_DRBG_KatGenerate, sizeof(CTR_DRBG_KatGenerate)) != 0))
+  {
+    status = CTR_DRBG_KAT_ERROR;
+  }
+
+  if (status == HW_OK)
+  {
+    for (uint8_t index = 0; index < CTR_DRBG_SEED_SIZE; index++)
+    {
+      a_seed[index] = CTR_DRBG_SEED_SIZE + index;
+    }
+    status = CTR_DRBG_Seed(&ctx, a_seed);
+  }
+  if (status == HW_OK)
+  {
+    status = CTR_DRBG_Generate(&ctx, a_out, sizeof(CTR_DRBG_KatReseed));
+  }
+  if ((status == HW_OK)
+      && (memcmp(a_out, CTR_DRBG_KatReseed, sizeof(CTR_DRBG_KatReseed)) != 0))
+  {
+    status = CTR_DRBG_KAT_ERROR;
+  }
+
+  memset(&ctx, 0, sizeof(ctx));
+
+  return status;
+}
+
+/* Reseed from the RNG pool, unless it is short of words: the DRBG then goes
+ * on with its current seed until the pool has been refilled */
+static void CTR_DRBG_Reseed(void)
+{
+  uint32_t a_seed[CTR_DRBG_SEED_WORDS];
+  int status;
+
+  UTILS_ENTER_CRITICAL_SECTION();
+  status = (HW_RNG_GetCount() >= (int)CTR_DRBG_SEED_WORDS) ? HW_OK : HW_BUSY;
+  if (status == HW_OK)
+  {
+    HW_RNG_Get(CTR_DRBG_SEED_WORDS, a_seed);
+  }
+  UTILS_EXIT_CRITICAL_SECTION();
+
+  if (status != HW_OK)
+  {
+    CTR_DRBG_Stats.ReseedsDeferred++;
+    HWCB_RNG_Process();
+    return;
+  }
+
+  if (CTR_DRBG_Seed(&CTR_DRBG_Ctx, (const uint8_t *)a_seed) == HW_OK)
+  {
+    CTR_DRBG_Stats.Reseeds++;
+  }
+  else
+  {
+    CTR_DRBG_Stats.AesBusy++;
+  }
+  memset(a_seed, 0, sizeof(a_seed));
+}
+
+/* Refill the reserve, the DRBG lock being held. Returns 0 when it could not */
+static int CTR_DRBG_Refill(void)
+{
+  uint32_t offset;
+
+  if (CTR_DRBG_State != CTR_DRBG_READY)
+  {
+    return 0;
+  }
+
+  if (CTR_DRBG_Ctx.ReseedCounter > CFG_CTR_DRBG_RESEED_INTERVAL)
+  {
+    CTR_DRBG_Reseed();
+  }
+
+  if (CTR_DRBG_Generate(&CTR_DRBG_Ctx, CTR_DRBG_Reserve, CFG_CTR_DRBG_RESERVE_SIZE) != HW_OK)
+  {
+    CTR_DRBG_Stats.AesBusy++;
+    return 0;
+  }
+  CTR_DRBG_Stats.Generates++;
+
+  /* Continuous test: no output block may repeat the previous one */
+  for (offset = 0; offset < CFG_CTR_DRBG_RESERVE_SIZE; offset += CTR_DRBG_BLOCK_SIZE)
+  {
+    if (memcmp(&CTR_DRBG_Reserve[offset], CTR_DRBG_LastBlock, CTR_DRBG_BLOCK_SIZE) == 0)
+    {
+      CTR_DRBG_Stats.Repeats++;
+      CTR_DRBG_Ctx.ReseedCounter = CFG_CTR_DRBG_RESEED_INTERVAL + 1U;
+      memset(CTR_DRBG_Reserve, 0, sizeof(CTR_DRBG_Reserve));
+      return 0;
+    }
+    memcpy(CTR_DRBG_LastBlock, &CTR_DRBG_Reserve[offset], CTR_DRBG_BLOCK_SIZE);
+  }
+
+  UTILS_ENTER_CRITICAL_SECTION();
+  CTR_DRBG_ReserveCount = CFG_CTR_DRBG_RESERVE_SIZE;
+  UTILS_EXIT_CRITICAL_SECTION();
+
+  return 1;
+}
+#endif /* CFG_CTR_DRBG_SUPPORTED == 1 */
@@ -0,0 +1,57 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file    ctr_drbg.h
+  * @author  MCD Application Team
+  * @brief   This header defines the AES-128 CTR_DRBG functions
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef CTR_DRBG_H__
+#define CTR_DRBG_H__
+
+#include <stdint.h>
+
+/* Result of the known-answer self-test run at instantiation
+ */
+typedef enum
+{
+  CTR_DRBG_SELFTEST_NOT_RUN,
+  CTR_DRBG_SELFTEST_PASSED,
+  CTR_DRBG_SELFTEST_FAILED
+} CTR_DRBG_SelfTest_t;
+
+/* Health counters, accumulated since the reset
+ */
+typedef struct
+{
+  uint32_t Generates;        /* Generate calls, each refilling the reserve */
+  uint32_t Bytes;            /* Bytes served from the DRBG */
+  uint32_t Reseeds;          /* Reseeds from the RNG pool */
+  uint32_t ReseedsDeferred;  /* Reseeds due while the RNG pool was short */
+  uint32_t AesBusy;          /* Refills skipped, the AES being in use */
+  uint32_t Repeats;          /* Output blocks equal to the previous one */
+  uint32_t FallbackBytes;    /* Bytes served straight from the RNG pool */
+  uint8_t  SelfTest;         /* CTR_DRBG_SelfTest_t */
+} CTR_DRBG_Stats_t;
+
+void CTR_DRBG_Init( void );
+
+void CTR_DRBG_Get( uint8_t *p_Data, uint32_t Size );
+
+void CTR_DRBG_GetStats( CTR_DRBG_Stats_t *p_Stats );
+
+void CTR_DRBG_LogStats( void );
+
+#endif /* CTR_DRBG_H__ */
@@ -0,0 +1,261 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file    dvfs.c
+  * @author  MCD Application Team
+  * @brief   This module votes for the system clock on behalf of the
+  *          application, from the sequencer load
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "stm32wbaxx.h"
+#include "app_conf.h"
+#include "scm.h"
+#include "dvfs.h"
+#include "stm32_timer.h"
+#include "timer_if.h"
+#include "log_module.h"
+
+#if (CFG_DVFS_SUPPORTED == 1) && (CFG_SCM_SUPPORTED == 1)
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  scm_clockconfig_t Config;
+  uint32_t          Latency;    /* In us */
+} DVFS_Switch_t;
+
+/* Private defines -----------------------------------------------------------*/
+/* Switches kept until logged */
+#define DVFS_LOG_NBR               (4U)
+
+/* Private variables ---------------------------------------------------------*/
+/* PLL at 64 MHz from HSE 32 MHz: VCO input 16 MHz, VCO 256 MHz, R = 4.
+ * The LCD SPI clock, SYSCLK / 8, stays at 8 MHz */
+static const scm_pll_config_t DVFS_PllConfig =
+{
+  .pll_mode = PLL_INTEGER_MODE,
+  .PLLM = 2,
+  .PLLN = 16,
+  .PLLP = 4,
+  .PLLQ = 4,
+  .PLLR = 4,
+  .PLLFractional = 0,
+  .AHB5_PLL1_CLKDivider = LL_RCC_AHB5_DIV_2,
+};
+
+static scm_clockconfig_t DVFS_Vote;
+static uint32_t DVFS_BusyStart;                 /* End of the last idle, in us */
+static UTIL_TIMER_Time_t DVFS_LastBurst;        /* In ms */
+static uint32_t DVFS_TaskStartTime;
+static uint32_t DVFS_TaskAverage[CFG_TASK_NBR]; /* Run time, in us */
+static volatile uint32_t DVFS_PllRequest;
+static volatile uint8_t DVFS_PllPending;
+
+static DVFS_Switch_t DVFS_Log[DVFS_LOG_NBR];
+static volatile uint8_t DVFS_LogCount;
+static DVFS_Stats_t DVFS_Stats;
+
+/* Private functions prototype------------------------------------------------*/
+static uint32_t DVFS_GetTimeUs(void);
+static void DVFS_SetClock(scm_clockconfig_t Config);
+static void DVFS_LogSwitch(scm_clockconfig_t Config, uint32_t Latency);
+
+void DVFS_Init( void )
+{
+  scm_pll_setconfig(&DVFS_PllConfig);
+
+  DVFS_BusyStart = DVFS_GetTimeUs();
+  DVFS_LastBurst = UTIL_TIMER_GetCurrentTime();
+  DVFS_Vote = HSE_16MHZ;
+  scm_setsystemclock(SCM_USER_APP, HSE_16MHZ);
+}
+
+/**
+ * @brief  Vote for the PLL before a task when the sequencer has been busy
+ *         for CFG_DVFS_BURST_US or when the task usually runs that long.
+ * @param  TaskId: index of the task about to run
+ * @retval None
+ */
+void DVFS_TaskStart( uint32_t TaskId )
+{
+  uint32_t now = DVFS_GetTimeUs();
+
+  DVFS_TaskStartTime = now;
+  if (((now - DVFS_BusyStart) >= CFG_DVFS_BURST_US)
+      || ((TaskId < CFG_TASK_NBR) && (DVFS_TaskAverage[TaskId] >= CFG_DVFS_BURST_US)))
+  {
+    DVFS_LastBurst = UTIL_TIMER_GetCurrentTime();
+    if (DVFS_Vote != SYS_PLL)
+    {
+      DVFS_SetClock(SYS_PLL);
+    }
+  }
+}
+
+/**
+ * @brief  Update the average run time of the task.
+ * @param  TaskId: index of the task that ran
+ * @retval None
+ */
+void DVFS_TaskEnd( uint32_t TaskId )
+{
+  uint32_t run_time = DVFS_GetTimeUs() - DVFS_TaskStartTime;
+
+  if (TaskId < CFG_TASK_NBR)
+  {
+    /* Running average over the last 4 runs */
+    DVFS_TaskAverage[TaskId] = (uint32_t)((int32_t)DVFS_TaskAverage[TaskId]
+                                          + (((int32_t)run_time - (int32_t)DVFS_TaskAverage[TaskId]) / 4));
+  }
+  if (run_time >= CFG_DVFS_BURST_US)
+  {
+    DVFS_LastBurst = UTIL_TIMER_GetCurrentTime();
+  }
+}
+
+/**
+ * @brief  Release the PLL once no burst has been seen for CFG_DVFS_HOLD_MS,
+ *         or when the coming idle lasts at least as long. Log the switches.
+ * @param  None
+ * @retval None
+ */
+void DVFS_PreIdle( void )
+{
+  DVFS_Switch_t log[DVFS_LOG_NBR];
+  uint8_t count;
+
+  if (DVFS_Vote == SYS_PLL)
+  {
+    if ((UTIL_TIMER_GetElapsedTime(DVFS_LastBurst) >= CFG_DVFS_HOLD_MS)
+        || (UTIL_TIMER_GetFirstRemainingTime() >= TIMER_IF_Convert_ms2Tick(CFG_DVFS_HOLD_MS)))
+    {
+      DVFS_SetClock(HSE_16MHZ);
+    }
+  }
+
+  UTILS_ENTER_CRITICAL_SECTION();
+  count = DVFS_LogCount;
+  memcpy(log, DVFS_Log, count * sizeof(DVFS_Switch_t));
+  DVFS_LogCount = 0;
+  UTILS_EXIT_CRITICAL_SECTION();
+
+  for (uint8_t index = 0; index < count; index++)
+  {
+    LOG_INFO_APP(">>== Clock %s in %d us\n",
+                 (log[index].Config == SYS_PLL) ? "PLL" : "HSE 16 MHz", log[index].Latency);
+  }
+}
+
+/**
+ * @brief  Restart the busy time measurement at the end of an idle.
+ * @param  None
+ * @retval None
+ */
+void DVFS_PostIdle( void )
+{
+  DVFS_BusyStart = DVFS_GetTimeUs();
+}
+
+void DVFS_GetStats( DVFS_Stats_t *p_Stats )
+{
+  UTILS_ENTER_CRITICAL_SECTION();
+  *p_Stats = DVFS_Stats;
+  UTILS_EXIT_CRITICAL_SECTION();
+}
+
+/**
+ * @brief  The system clock runs on the PLL, completing the PLL vote.
+ * @param  None
+ * @retval None
+ */
+void scm_pllready(void)
+{
+  uint32_t latency;
+
+  if (DVFS_PllPending != 0U)
+  {
+    DVFS_PllPending = 0;
+    latency = DVFS_GetTimeUs() - DVFS_PllRequest;
+    if (latency > DVFS_Stats.MaxLatencyUp)
+    {
+      DVFS_Stats.MaxLatencyUp = latency;
+    }
+    DVFS_LogSwitch(SYS_PLL, latency);
+  }
+}
+
+/* Private functions ----------------------------------------------------------*/
+/* Time in us from the SysTick, clocked by the LSE whatever the system clock */
+static uint32_t DVFS_GetTimeUs(void)
+{
+  uint32_t load = SysTick->LOAD + 1U;
+  uint32_t tick;
+  uint32_t count;
+
+  UTILS_ENTER_CRITICAL_SECTION();
+  tick = HAL_GetTick();
+  count = load - SysTick->VAL;
+  if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0U)
+  {
+    /* Reloaded, the tick interrupt is pending */
+    tick++;
+    count = load - SysTick->VAL;
+  }
+  UTILS_EXIT_CRITICAL_SECTION();
+
+  return (tick * 1000U) + ((count * 1000U) / load);
+}
+
+static void DVFS_SetClock(scm_clockconfig_t Config)
+{
+  uint32_t start = DVFS_GetTimeUs();
+  uint32_t latency;
+
+  DVFS_Vote = Config;
+  if (Config == SYS_PLL)
+  {
+    /* The switch completes in scm_pllready(), from the PLL ready interrupt */
+    DVFS_Stats.SwitchesUp++;
+    DVFS_PllRequest = start;
+    DVFS_PllPending = 1;
+    scm_setsystemclock(SCM_USER_APP, SYS_PLL);
+  }
+  else
+  {
+    DVFS_Stats.SwitchesDown++;
+    DVFS_PllPending = 0;
+    scm_setsystemclock(SCM_USER_APP, Config);
+    latency = DVFS_GetTimeUs() - start;
+    if (latency > DVFS_Stats.MaxLatencyDown)
+    {
+      DVFS_Stats.MaxLatencyDown = latency;
+    }
+    DVFS_LogSwitch(Config, latency);
+  }
+}
+
+static void DVFS_LogSwitch(scm_clockconfig_t Config, uint32_t Latency)
+{
+  UTILS_ENTER_CRITICAL_SECTION();
+  if (DVFS_LogCount < DVFS_LOG_NBR)
+  {
+    DVFS_Log[DVFS_LogCount].Config = Config;
+    DVFS_Log[DVFS_LogCount].Latency = Latency;
+    DVFS_LogCount++;
+  }
+  UTILS_EXIT_CRITICAL_SECTION();
+}
+#endif /* (CFG_DVFS_SUPPORTED == 1) && (CFG_SCM_SUPPORTED == 1) */
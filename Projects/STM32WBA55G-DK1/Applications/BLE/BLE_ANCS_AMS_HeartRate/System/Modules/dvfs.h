@@ -0,0 +1,48 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file    dvfs.h
+  * @author  MCD Application Team
+  * @brief   This header defines the dynamic clock scaling functions
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef DVFS_H__
+#define DVFS_H__
+
+#include <stdint.h>
+
+/* Counters of the clock switches
+ */
+typedef struct
+{
+  uint32_t SwitchesUp;     /* Votes for the PLL */
+  uint32_t SwitchesDown;   /* Votes for HSE 16 MHz */
+  uint32_t MaxLatencyUp;   /* Longest time from the vote to the PLL running, in us */
+  uint32_t MaxLatencyDown; /* Longest time to switch back to HSE 16 MHz, in us */
+} DVFS_Stats_t;
+
+void DVFS_Init( void );
+
+void DVFS_TaskStart( uint32_t TaskId );
+
+void DVFS_TaskEnd( uint32_t TaskId );
+
+void DVFS_PreIdle( void );
+
+void DVFS_PostIdle( void );
+
+void DVFS_GetStats( DVFS_Stats_t *p_Stats );
+
+#endif /* DVFS_H__ */
@@ -0,0 +1,340 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file    energy_acct.c
+  * @author  MCD Application Team
+  * @brief   This module accounts for the time and the estimated charge spent
+  *          in each power state, with the radio active and in each task
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32wbaxx.h"
+#include "app_conf.h"
+#include "energy_acct.h"
+#include "timer_if.h"
+#include "stm32_timer.h"
+#include "stm32_seq.h"
+#include "app_entry.h"
+#include "log_module.h"
+
+#if (CFG_ENERGY_ACCT_SUPPORTED == 1)
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint64_t Time;    /* In ns */
+  uint32_t Count;   /* Runs */
+} ENERGY_ACCT_Task_t;
+
+/* Private defines -----------------------------------------------------------*/
+/* Nesting of the tasks run from UTIL_SEQ_WaitEvt() */
+#define ENERGY_ACCT_TASK_DEPTH     (4U)
+
+/* Charge in uC of a time in RTC ticks at a current in uA */
+#define ENERGY_ACCT_CHARGE_UC(ticks, current_ua)  ((uint32_t)(((ticks) * (current_ua)) >> RTC_N_PREDIV_S))
+
+#define ENERGY_ACCT_TICKS2MS(ticks)               ((uint32_t)(((ticks) * 1000U) >> RTC_N_PREDIV_S))
+
+/* Time in ns of a number of cycles at a system clock frequency in Hz */
+#define ENERGY_ACCT_CYCLES2NS(cycles, clock)      ((((uint64_t)(cycles)) * 1000U) / ((clock) / 1000000U))
+
+/* Private variables ---------------------------------------------------------*/
+static const uint32_t ENERGY_ACCT_Current[ENERGY_ACCT_STATE_NBR] =
+{
+  CFG_ENERGY_ACCT_RUN_UA,
+  CFG_ENERGY_ACCT_SLEEP_UA,
+};
+
+static const char * const ENERGY_ACCT_StateName[ENERGY_ACCT_STATE_NBR] =
+{
+  "run", "sleep"
+};
+
+static ENERGY_ACCT_Report_t ENERGY_ACCT_Report;
+static ENERGY_ACCT_State_t ENERGY_ACCT_State;
+static uint32_t ENERGY_ACCT_StateStart;
+static uint32_t ENERGY_ACCT_RadioStartTime;
+static uint8_t ENERGY_ACCT_RadioActive;
+static uint64_t ENERGY_ACCT_RadioTimeAtLastEnd;
+
+static ENERGY_ACCT_Task_t ENERGY_ACCT_Tasks[CFG_TASK_NBR];
+static uint32_t ENERGY_ACCT_TaskCycles[ENERGY_ACCT_TASK_DEPTH];
+static uint32_t ENERGY_ACCT_TaskClock[ENERGY_ACCT_TASK_DEPTH];     /* System clock when the task started, DVFS may change it */
+static uint64_t ENERGY_ACCT_TaskNested[ENERGY_ACCT_TASK_DEPTH];    /* In ns, each nested task converted at its own clock */
+static uint8_t ENERGY_ACCT_TaskDepth;
+
+static UTIL_TIMER_Object_t ENERGY_ACCT_ReportTimer;
+
+/* Private functions prototype------------------------------------------------*/
+static void ENERGY_ACCT_ReportTimerCb(void *arg);
+static void ENERGY_ACCT_ReportTask(void);
+static uint64_t ENERGY_ACCT_RadioTime(void);
+
+void ENERGY_ACCT_Init( void )
+{
+  /* Cycle counter for the task run times */
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  ENERGY_ACCT_State = ENERGY_ACCT_RUN;
+  ENERGY_ACCT_StateStart = TIMER_IF_GetTimerValue();
+  ENERGY_ACCT_Report.a_StateCount[ENERGY_ACCT_RUN] = 1;
+
+  APPE_SEQ_RegTask(1U << CFG_TASK_ENERGY_ACCT_ID, UTIL_SEQ_RFU, ENERGY_ACCT_ReportTask);
+  (void)UTIL_TIMER_Create(&ENERGY_ACCT_ReportTimer, CFG_ENERGY_ACCT_REPORT_PERIOD_MS,
+                          UTIL_TIMER_PERIODIC, &ENERGY_ACCT_ReportTimerCb, NULL);
+  (void)UTIL_TIMER_Start(&ENERGY_ACCT_ReportTimer);
+}
+
+/**
+ * @brief  Account for the time spent in run mode and switch to a low power
+ *         state. Called from the low power mode entry, in critical section.
+ * @param  State: low power state entered
+ * @retval None
+ */
+void ENERGY_ACCT_EnterLowPower( ENERGY_ACCT_State_t State )
+{
+  uint32_t now = TIMER_IF_GetTimerValue();
+
+  ENERGY_ACCT_Report.a_StateTime[ENERGY_ACCT_State] += (uint32_t)(now - ENERGY_ACCT_StateStart);
+  ENERGY_ACCT_Report.a_StateCount[State]++;
+  ENERGY_ACCT_State = State;
+  ENERGY_ACCT_StateStart = now;
+}
+
+/**
+ * @brief  Account for the time spent in the low power state and switch back
+ *         to run mode. Called from the low power mode exit, in critical section.
+ * @param  None
+ * @retval None
+ */
+void ENERGY_ACCT_ExitLowPower( void )
+{
+  uint32_t now = TIMER_IF_GetTimerValue();
+
+  ENERGY_ACCT_Report.a_StateTime[ENERGY_ACCT_State] += (uint32_t)(now - ENERGY_ACCT_StateStart);
+  ENERGY_ACCT_Report.a_StateCount[ENERGY_ACCT_RUN]++;
+  ENERGY_ACCT_State = ENERGY_ACCT_RUN;
+  ENERGY_ACCT_StateStart = now;
+}
+
+/**
+ * @brief  Link Layer radio activity start, called from the radio interrupt.
+ * @param  None
+ * @retval None
+ */
+void ENERGY_ACCT_RadioStart( void )
+{
+  if (ENERGY_ACCT_RadioActive == 0U)
+  {
+    ENERGY_ACCT_RadioStartTime = TIMER_IF_GetTimerValue();
+    ENERGY_ACCT_RadioActive = 1U;
+  }
+}
+
+/**
+ * @brief  Link Layer radio activity end, called from the radio interrupt.
+ * @param  None
+ * @retval None
+ */
+void ENERGY_ACCT_RadioStop( void )
+{
+  if (ENERGY_ACCT_RadioActive != 0U)
+  {
+    ENERGY_ACCT_Report.RadioTime += (uint32_t)(TIMER_IF_GetTimerValue() - ENERGY_ACCT_RadioStartTime);
+    ENERGY_ACCT_RadioActive = 0U;
+  }
+}
+
+/**
+ * @brief  End of a radio activity reported by the stack: the radio time since
+ *         the previous report is assigned to the activity.
+ * @param  LastState: Last_State of the end of radio activity event
+ * @retval None
+ */
+void ENERGY_ACCT_RadioActivityEnd( uint8_t LastState )
+{
+  uint8_t activity = LastState % ENERGY_ACCT_RADIO_ACTIVITY_NBR;
+  uint64_t radio_time;
+
+  UTILS_ENTER_CRITICAL_SECTION();
+  radio_time = ENERGY_ACCT_RadioTime();
+  UTILS_EXIT_CRITICAL_SECTION();
+
+  ENERGY_ACCT_Report.a_RadioActivityTime[activity] += radio_time - ENERGY_ACCT_RadioTimeAtLastEnd;
+  ENERGY_ACCT_Report.a_RadioActivityCount[activity]++;
+  ENERGY_ACCT_RadioTimeAtLastEnd = radio_time;
+}
+
+/**
+ * @brief  Get the times accumulated so far, including the current state.
+ * @param  p_Report: report filled
+ * @retval None
+ */
+void ENERGY_ACCT_GetReport( ENERGY_ACCT_Report_t *p_Report )
+{
+  UTILS_ENTER_CRITICAL_SECTION();
+  *p_Report = ENERGY_ACCT_Report;
+  p_Report->a_StateTime[ENERGY_ACCT_State] += (uint32_t)(TIMER_IF_GetTimerValue() - ENERGY_ACCT_StateStart);
+  p_Report->RadioTime = ENERGY_ACCT_RadioTime();
+  UTILS_EXIT_CRITICAL_SECTION();
+}
+
+/**
+ * @brief  Get the run time of a sequencer task, excluding the tasks it waited for.
+ * @param  TaskId: index of the task
+ * @param  p_Count: number of runs, may be NULL
+ * @retval Run time in us
+ */
+uint64_t ENERGY_ACCT_GetTaskTime( uint32_t TaskId, uint32_t *p_Count )
+{
+  uint64_t time = 0;
+
+  if (TaskId < CFG_TASK_NBR)
+  {
+    time = ENERGY_ACCT_Tasks[TaskId].Time / 1000U;
+    if (p_Count != NULL)
+    {
+      *p_Count = ENERGY_ACCT_Tasks[TaskId].Count;
+    }
+  }
+
+  return time;
+}
+
+/**
+ * @brief  Start the run time measurement of a sequencer task.
+ * @param  TaskId: index of the task about to run
+ * @retval None
+ */
+void ENERGY_ACCT_TaskStart( uint32_t TaskId )
+{
+  (void)TaskId;
+
+  if (ENERGY_ACCT_TaskDepth < ENERGY_ACCT_TASK_DEPTH)
+  {
+    ENERGY_ACCT_TaskCycles[ENERGY_ACCT_TaskDepth] = DWT->CYCCNT;
+    ENERGY_ACCT_TaskClock[ENERGY_ACCT_TaskDepth] = SystemCoreClock;
+    ENERGY_ACCT_TaskNested[ENERGY_ACCT_TaskDepth] = 0;
+  }
+  ENERGY_ACCT_TaskDepth++;
+}
+
+/**
+ * @brief  Account for the run time of a sequencer task.
+ * @param  TaskId: index of the task that ran
+ * @retval None
+ */
+void ENERGY_ACCT_TaskEnd( uint32_t TaskId )
+{
+  uint64_t elapsed;
+
+  ENERGY_ACCT_TaskDepth--;
+  if (ENERGY_ACCT_TaskDepth < ENERGY_ACCT_TASK_DEPTH)
+  {
+    elapsed = ENERGY_ACCT_CYCLES2NS(DWT->CYCCNT - ENERGY_ACCT_TaskCycles[ENERGY_ACCT_TaskDepth],
+                                    ENERGY_ACCT_TaskClock[ENERGY_ACCT_TaskDepth]);
+    if (TaskId < CFG_TASK_NBR)
+    {
+      if (elapsed > ENERGY_ACCT_TaskNested[ENERGY_ACCT_TaskDepth])
+      {
+        ENERGY_ACCT_Tasks[TaskId].Time += elapsed - ENERGY_ACCT_TaskNested[ENERGY_ACCT_TaskDepth];
+      }
+      ENERGY_ACCT_Tasks[TaskId].Count++;
+    }
+    if (ENERGY_ACCT_TaskDepth != 0U)
+    {
+      ENERGY_ACCT_TaskNested[ENERGY_ACCT_TaskDepth - 1U] += elapsed;
+    }
+  }
+}
+
+/* Private functions ----------------------------------------------------------*/
+/* Radio time including the activity in progress, to be called in critical section */
+static uint64_t ENERGY_ACCT_RadioTime(void)
+{
+  uint64_t radio_time = ENERGY_ACCT_Report.RadioTime;
+
+  if (ENERGY_ACCT_RadioActive != 0U)
+  {
+    radio_time += (uint32_t)(TIMER_IF_GetTimerValue() - ENERGY_ACCT_RadioStartTime);
+  }
+
+  return radio_time;
+}
+
+static void ENERGY_ACCT_ReportTimerCb(void *arg)
+{
+  (void)arg;
+
+  UTIL_SEQ_SetTask(1U << CFG_TASK_ENERGY_ACCT_ID, CFG_SEQ_PRIO_1);
+}
+
+static void ENERGY_ACCT_ReportTask(void)
+{
+  ENERGY_ACCT_Report_t report;
+  uint64_t total_time = 0;
+  uint64_t charge = 0;
+  uint32_t count;
+  uint64_t task_time;
+
+  ENERGY_ACCT_GetReport(&report);
+
+  for (uint8_t state = 0; state < ENERGY_ACCT_STATE_NBR; state++)
+  {
+    total_time += report.a_StateTime[state];
+    charge += report.a_StateTime[state] * ENERGY_ACCT_Current[state];
+  }
+  charge += report.RadioTime * CFG_ENERGY_ACCT_RADIO_UA;
+
+  LOG_INFO_APP("==>> Energy: %d s, %d uC, average %d uA\n",
+               (uint32_t)(total_time >> RTC_N_PREDIV_S),
+               (uint32_t)(charge >> RTC_N_PREDIV_S),
+               (total_time != 0U) ? (uint32_t)(charge / total_time) : 0U);
+  for (uint8_t state = 0; state < ENERGY_ACCT_STATE_NBR; state++)
+  {
+    LOG_INFO_APP("     - %s: %d ms, %d entries, %d uC\n",
+                 ENERGY_ACCT_StateName[state],
+                 ENERGY_ACCT_TICKS2MS(report.a_StateTime[state]),
+                 report.a_StateCount[state],
+                 ENERGY_ACCT_CHARGE_UC(report.a_StateTime[state], ENERGY_ACCT_Current[state]));
+  }
+  LOG_INFO_APP("     - radio: %d ms, %d uC\n",
+               ENERGY_ACCT_TICKS2MS(report.RadioTime),
+               ENERGY_ACCT_CHARGE_UC(report.RadioTime, CFG_ENERGY_ACCT_RADIO_UA));
+  for (uint8_t activity = 0; activity < ENERGY_ACCT_RADIO_ACTIVITY_NBR; activity++)
+  {
+    if (report.a_RadioActivityCount[activity] != 0U)
+    {
+      LOG_INFO_APP("       activity 0x%02X: %d events, %d ms\n", activity,
+                   report.a_RadioActivityCount[activity],
+                   ENERGY_ACCT_TICKS2MS(report.a_RadioActivityTime[activity]));
+    }
+  }
+  for (uint32_t task = 0; task < CFG_TASK_NBR; task++)
+  {
+    task_time = ENERGY_ACCT_GetTaskTime(task, &count);
+    if (count != 0U)
+    {
+      LOG_INFO_APP("     - task %d: %d runs, %d us\n", task, count, (uint32_t)task_time);
+    }
+  }
+
+  ENERGY_ACCTCB_Report();
+}
+
+__WEAK void ENERGY_ACCTCB_Report( void )
+{
+}
+#endif /* (CFG_ENERGY_ACCT_SUPPORTED == 1) */
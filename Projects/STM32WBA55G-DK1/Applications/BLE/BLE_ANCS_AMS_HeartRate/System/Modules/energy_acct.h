@@ -0,0 +1,76 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file    energy_acct.h
+  * @author  MCD Application Team
+  * @brief   This header defines the energy accounting functions
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef ENERGY_ACCT_H__
+#define ENERGY_ACCT_H__
+
+#include <stdint.h>
+
+/* Power states of the device. Stop mode and standby are not accounted:
+ * this application does not enable them (CFG_LPM_LEVEL)
+ */
+typedef enum
+{
+  ENERGY_ACCT_RUN,
+  ENERGY_ACCT_SLEEP,
+  ENERGY_ACCT_STATE_NBR
+} ENERGY_ACCT_State_t;
+
+/* Radio activities, as reported by the end of radio activity event
+ */
+#define ENERGY_ACCT_RADIO_ACTIVITY_NBR   (16U)
+
+/* Time and estimated charge accumulated since the initialization
+ */
+typedef struct
+{
+  uint64_t a_StateTime[ENERGY_ACCT_STATE_NBR];                  /* In RTC ticks */
+  uint64_t RadioTime;                                           /* In RTC ticks */
+  uint64_t a_RadioActivityTime[ENERGY_ACCT_RADIO_ACTIVITY_NBR]; /* In RTC ticks */
+  uint32_t a_RadioActivityCount[ENERGY_ACCT_RADIO_ACTIVITY_NBR];
+  uint32_t a_StateCount[ENERGY_ACCT_STATE_NBR];                 /* Entries in the state */
+} ENERGY_ACCT_Report_t;
+
+void ENERGY_ACCT_Init( void );
+
+void ENERGY_ACCT_EnterLowPower( ENERGY_ACCT_State_t State );
+
+void ENERGY_ACCT_ExitLowPower( void );
+
+void ENERGY_ACCT_RadioStart( void );
+
+void ENERGY_ACCT_RadioStop( void );
+
+void ENERGY_ACCT_RadioActivityEnd( uint8_t LastState );
+
+void ENERGY_ACCT_TaskStart( uint32_t TaskId );
+
+void ENERGY_ACCT_TaskEnd( uint32_t TaskId );
+
+void ENERGY_ACCT_GetReport( ENERGY_ACCT_Report_t *p_Report );
+
+uint64_t ENERGY_ACCT_GetTaskTime( uint32_t TaskId, uint32_t *p_Count );
+
+/* Callback called at the end of each periodic report, for the other modules
+ * to log their statistics
+ */
+void ENERGY_ACCTCB_Report( void );
+
+#endif /* ENERGY_ACCT_H__ */
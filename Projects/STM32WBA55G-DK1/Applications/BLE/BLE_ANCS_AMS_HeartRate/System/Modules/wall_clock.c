@@ -0,0 +1,229 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file    wall_clock.c
+  * @author  MCD Application Team
+  * @brief   This module keeps a calendar clock on the RTC, disciplined from
+  *          the references of a remote time source
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32wbaxx.h"
+#include "app_conf.h"
+#include "wall_clock.h"
+#include "stm32_systime.h"
+#include "log_module.h"
+
+#if (CFG_WALL_CLOCK_SUPPORTED == 1)
+/* Private defines -----------------------------------------------------------*/
+#define WALL_CLOCK_PPB            (1000000000LL)
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t WALL_CLOCK_Synced;
+static uint8_t WALL_CLOCK_DriftKnown;
+static SysTime_t WALL_CLOCK_SyncTime;       /* RTC time of the last reference */
+static SysTime_t WALL_CLOCK_DriftStart;     /* RTC time starting the drift measurement */
+static int64_t WALL_CLOCK_DriftCorrections; /* Corrections since the drift measurement start, in ms */
+static uint32_t WALL_CLOCK_ResidualPpb;
+static WALL_CLOCK_Stats_t WALL_CLOCK_Stats;
+
+/* Private functions prototype------------------------------------------------*/
+static uint64_t WALL_CLOCK_ElapsedMs(SysTime_t Since);
+static int64_t WALL_CLOCK_ToMs(SysTime_t Time);
+static SysTime_t WALL_CLOCK_FromMs(int64_t TimeMs);
+static uint32_t WALL_CLOCK_ErrorMs(void);
+
+void WALL_CLOCK_Init( void )
+{
+  WALL_CLOCK_Synced = 0;
+  WALL_CLOCK_DriftKnown = 0;
+  WALL_CLOCK_DriftCorrections = 0;
+  WALL_CLOCK_ResidualPpb = 0;
+  WALL_CLOCK_Stats = (WALL_CLOCK_Stats_t){0};
+}
+
+/**
+ * @brief  Apply a reference time. References close to the clock update the
+ *         drift estimate once CFG_WALL_CLOCK_MIN_INTERVAL_S has elapsed since
+ *         the start of the measurement, the others are applied as a step.
+ * @param  Reference: time of the remote source
+ * @param  Step: set when the remote source has been adjusted, the reference
+ *         is then not used for the drift estimate
+ * @retval Correction applied to the clock, in ms
+ */
+int32_t WALL_CLOCK_Sync( SysTime_t Reference, uint8_t Step )
+{
+  int64_t correction = 0;
+  uint64_t interval;
+  int64_t residual;
+
+  if (WALL_CLOCK_Synced != 0U)
+  {
+    correction = WALL_CLOCK_ToMs(Reference) - WALL_CLOCK_ToMs(WALL_CLOCK_Get());
+  }
+
+  if ((WALL_CLOCK_Synced == 0U) || (Step != 0U)
+      || (correction >= (int64_t)CFG_WALL_CLOCK_STEP_MS) || (correction <= -(int64_t)CFG_WALL_CLOCK_STEP_MS))
+  {
+    /* Restart the drift measurement from this reference */
+    WALL_CLOCK_Stats.Steps++;
+    WALL_CLOCK_DriftStart = SysTimeGetMcuTime();
+    WALL_CLOCK_DriftCorrections = 0;
+  }
+  else
+  {
+    WALL_CLOCK_DriftCorrections += correction;
+    if ((uint32_t)((correction < 0) ? -correction : correction) > WALL_CLOCK_Stats.MaxCorrectionMs)
+    {
+      WALL_CLOCK_Stats.MaxCorrectionMs = (uint32_t)((correction < 0) ? -correction : correction);
+    }
+
+    interval = WALL_CLOCK_ElapsedMs(WALL_CLOCK_DriftStart);
+    if (interval >= ((uint64_t)CFG_WALL_CLOCK_MIN_INTERVAL_S * 1000U))
+    {
+      /* Drift left uncorrected over the measurement */
+      residual = (WALL_CLOCK_DriftCorrections * WALL_CLOCK_PPB) / (int64_t)interval;
+      WALL_CLOCK_ResidualPpb = (uint32_t)((residual < 0) ? -residual : residual);
+
+      /* The first measurement sets the estimate, the next ones refine it */
+      residual = (WALL_CLOCK_DriftKnown != 0U) ? (residual / 2) : residual;
+      residual += WALL_CLOCK_Stats.DriftPpb;
+      if (residual > CFG_WALL_CLOCK_MAX_DRIFT_PPB)
+      {
+        residual = CFG_WALL_CLOCK_MAX_DRIFT_PPB;
+      }
+      else if (residual < -CFG_WALL_CLOCK_MAX_DRIFT_PPB)
+      {
+        residual = -CFG_WALL_CLOCK_MAX_DRIFT_PPB;
+      }
+      WALL_CLOCK_Stats.DriftPpb = (int32_t)residual;
+      WALL_CLOCK_DriftKnown = 1;
+
+      WALL_CLOCK_DriftStart = SysTimeGetMcuTime();
+      WALL_CLOCK_DriftCorrections = 0;
+    }
+  }
+
+  SysTimeSet(Reference);
+  WALL_CLOCK_SyncTime = SysTimeGetMcuTime();
+  WALL_CLOCK_Synced = 1;
+  WALL_CLOCK_Stats.Syncs++;
+  WALL_CLOCK_Stats.LastCorrectionMs = (int32_t)correction;
+
+  LOG_INFO_APP(">>== Wall clock corrected by %d ms, drift %d ppb\n",
+               WALL_CLOCK_Stats.LastCorrectionMs, WALL_CLOCK_Stats.DriftPpb);
+
+  return (int32_t)correction;
+}
+
+uint8_t WALL_CLOCK_IsSynced( void )
+{
+  return WALL_CLOCK_Synced;
+}
+
+/**
+ * @brief  Tell whether the clock needs a reference, the error bound of the
+ *         clock having reached CFG_WALL_CLOCK_MAX_ERROR_MS.
+ * @param  None
+ * @retval 1 if a reference is needed
+ */
+uint8_t WALL_CLOCK_SyncNeeded( void )
+{
+  return ((WALL_CLOCK_Synced == 0U) || (WALL_CLOCK_ErrorMs() >= CFG_WALL_CLOCK_MAX_ERROR_MS)) ? 1U : 0U;
+}
+
+/**
+ * @brief  Get the time of the clock, corrected by the estimated drift since
+ *         the last reference.
+ * @param  None
+ * @retval Time, in seconds and milliseconds since the epoch of the source
+ */
+SysTime_t WALL_CLOCK_Get( void )
+{
+  SysTime_t time = SysTimeGet();
+  int64_t correction;
+
+  if (WALL_CLOCK_Synced != 0U)
+  {
+    correction = ((int64_t)WALL_CLOCK_ElapsedMs(WALL_CLOCK_SyncTime) * WALL_CLOCK_Stats.DriftPpb) / WALL_CLOCK_PPB;
+    time = WALL_CLOCK_FromMs(WALL_CLOCK_ToMs(time) + correction);
+  }
+
+  return time;
+}
+
+void WALL_CLOCK_GetLocalTime( struct tm *p_LocalTime )
+{
+  SysTimeLocalTime(WALL_CLOCK_Get().Seconds, p_LocalTime);
+}
+
+void WALL_CLOCK_GetStats( WALL_CLOCK_Stats_t *p_Stats )
+{
+  *p_Stats = WALL_CLOCK_Stats;
+  p_Stats->ErrorMs = WALL_CLOCK_ErrorMs();
+}
+
+void WALL_CLOCK_LogStats( void )
+{
+  WALL_CLOCK_Stats_t stats;
+
+  WALL_CLOCK_GetStats(&stats);
+  LOG_INFO_APP("     - Wall clock: %d syncs, %d steps, drift %d ppb, max correction %d ms, error %d ms\n",
+               stats.Syncs, stats.Steps, stats.DriftPpb,
+               stats.MaxCorrectionMs, stats.ErrorMs);
+}
+
+/* Private functions ----------------------------------------------------------*/
+static uint64_t WALL_CLOCK_ElapsedMs(SysTime_t Since)
+{
+  SysTime_t elapsed = SysTimeSub(SysTimeGetMcuTime(), Since);
+
+  return ((uint64_t)elapsed.Seconds * 1000U) + (uint64_t)elapsed.SubSeconds;
+}
+
+static int64_t WALL_CLOCK_ToMs(SysTime_t Time)
+{
+  return ((int64_t)Time.Seconds * 1000) + Time.SubSeconds;
+}
+
+static SysTime_t WALL_CLOCK_FromMs(int64_t TimeMs)
+{
+  SysTime_t time;
+
+  time.Seconds = (uint32_t)(TimeMs / 1000);
+  time.SubSeconds = (int16_t)(TimeMs % 1000);
+
+  return time;
+}
+
+/* Error bound, growing with the time elapsed since the last reference */
+static uint32_t WALL_CLOCK_ErrorMs(void)
+{
+  uint64_t bound_ppb = CFG_WALL_CLOCK_DRIFT_BOUND_PPB;
+
+  if (WALL_CLOCK_Synced == 0U)
+  {
+    return UINT32_MAX;
+  }
+
+  if (WALL_CLOCK_DriftKnown != 0U)
+  {
+    bound_ppb = (WALL_CLOCK_ResidualPpb > CFG_WALL_CLOCK_RESIDUAL_PPB) ? WALL_CLOCK_ResidualPpb
+                                                                       : CFG_WALL_CLOCK_RESIDUAL_PPB;
+  }
+
+  return (uint32_t)((WALL_CLOCK_ElapsedMs(WALL_CLOCK_SyncTime) * bound_ppb) / (uint64_t)WALL_CLOCK_PPB);
+}
+#endif /* CFG_WALL_CLOCK_SUPPORTED == 1 */
@@ -0,0 +1,55 @@
+/* USER CODE BEGIN Header */
+/**
+  ******************************************************************************
+  * @file    wall_clock.h
+  * @author  MCD Application Team
+  * @brief   This header defines the wall clock functions
+  ******************************************************************************
+  * @attention
+  *
+  * Copyright (c) 2024 STMicroelectronics.
+  * All rights reserved.
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+/* USER CODE END Header */
+
+#ifndef WALL_CLOCK_H__
+#define WALL_CLOCK_H__
+
+#include <stdint.h>
+#include "stm32_systime.h"
+
+/* Discipline counters, accumulated since the initialization
+ */
+typedef struct
+{
+  uint32_t Syncs;              /* References applied */
+  uint32_t Steps;              /* References applied as a step, without drift update */
+  int32_t  DriftPpb;           /* Estimated drift of the RTC, added to its time */
+  int32_t  LastCorrectionMs;   /* Difference between the last reference and the clock */
+  uint32_t MaxCorrectionMs;    /* Largest correction, steps excluded */
+  uint32_t ErrorMs;            /* Error bound of the clock at the time of the call */
+} WALL_CLOCK_Stats_t;
+
+void WALL_CLOCK_Init( void );
+
+int32_t WALL_CLOCK_Sync( SysTime_t Reference, uint8_t Step );
+
+uint8_t WALL_CLOCK_IsSynced( void );
+
+uint8_t WALL_CLOCK_SyncNeeded( void );
+
+SysTime_t WALL_CLOCK_Get( void );
+
+void WALL_CLOCK_GetLocalTime( struct tm *p_LocalTime );
+
+void WALL_CLOCK_GetStats( WALL_CLOCK_Stats_t *p_Stats );
+
+void WALL_CLOCK_LogStats( void );
+
+#endif /* WALL_CLOCK_H__ */